@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Shared bits of the benchmark executables. Every benchmark takes --quick,
+// which ctest passes so the benchmarks keep building and running without
+// taking the time real measurements need.
+inline bool quickRun(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Keeps the compiler from discarding a result the benchmark doesn't use
+template <typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
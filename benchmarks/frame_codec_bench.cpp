@@ -0,0 +1,81 @@
+// FrameEncoder and FrameDecoder on 1920x1080 presentation content:
+// compression ratio, encode and decode frames/s and raw MB/s, and how the
+// tiles were coded. Only encode() and decode() are timed, not rendering.
+#include <vector>
+#include "bench_util.h"
+#include "frame_codec.h"
+#include "synthetic_frame_source.h"
+#include "task_pool.h"
+
+namespace {
+    struct Scenario {
+        const char* name;
+        uint32_t scrollPixels;
+        bool regions;       // Pass on the source's dirty regions, as desktop duplication does
+        uint32_t tileSize;
+    };
+
+    void run(const Scenario& scenario, uint32_t frames) {
+        SyntheticFrameSourceConfig sourceConfig;
+        sourceConfig.paced = false;
+        sourceConfig.slideFrames = 90;
+        sourceConfig.scrollPixels = scenario.scrollPixels;
+        SyntheticFrameSource source(sourceConfig);
+
+        FrameCodecConfig config;
+        config.tileSize = scenario.tileSize;
+        FrameEncoder encoder(config);
+        FrameBuffer frame;
+        FrameInfo info;
+        std::vector<std::vector<uint8_t>> packets(frames);
+        double encodeSeconds = 0;
+        for (uint32_t i = 0; i < frames; ++i) {
+            source.capture(frame, info, std::chrono::milliseconds(0));
+            info.sequence = i + 1;
+            if (!scenario.regions) {
+                info.regions.clear();
+            }
+            auto start = std::chrono::steady_clock::now();
+            encoder.encode(frame, info, packets[i]);
+            encodeSeconds += secondsSince(start);
+        }
+
+        FrameDecoder decoder;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::vector<uint8_t>& packet : packets) {
+            keep(decoder.decode(packet.data(), packet.size()));
+        }
+        double decodeSeconds = secondsSince(start);
+
+        const FrameEncoderStats& stats = encoder.stats();
+        double tiles = double(stats.sameTiles + stats.referenceTiles + stats.literalTiles + stats.storedTiles);
+        std::printf("  %-22s %4u %7.1f %9.1f %8.0f %9.1f %8.0f   %4.1f%% %4.1f%% %4.1f%% %4.1f%%\n",
+                    scenario.name, scenario.tileSize, double(stats.rawBytes) / stats.packetBytes,
+                    frames / encodeSeconds, stats.rawBytes / encodeSeconds / 1e6,
+                    frames / decodeSeconds, stats.rawBytes / decodeSeconds / 1e6,
+                    100 * stats.sameTiles / tiles, 100 * stats.referenceTiles / tiles,
+                    100 * stats.literalTiles / tiles, 100 * stats.storedTiles / tiles);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    uint32_t frames = quick ? 10 : 300;
+
+    static const Scenario SCENARIOS[] = {
+        {"slides", 0, true, 64},
+        {"slides", 0, true, 32},
+        {"slides, no regions", 0, false, 64},
+        {"scrolling 4 px/frame", 4, true, 64},
+        {"scrolling 64 px/frame", 64, true, 64},
+    };
+
+    std::printf("%u frames of 1920x1080, slide change every 90 frames, %zu threads\n",
+                frames, TaskPool::getInstance().concurrency());
+    std::printf("  %-22s %4s %7s %9s %8s %9s %8s   %5s %5s %5s %5s\n", "content", "tile", "ratio",
+                "enc fps", "enc MB/s", "dec fps", "dec MB/s", "same", "ref", "lit", "store");
+    for (const Scenario& scenario : SCENARIOS) {
+        run(scenario, frames);
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Throughput of each frame kernel on a 1920x1080 frame, for every ISA this
+// CPU supports. GB/s counts the source bytes a kernel reads, so the ISAs
+// can be compared directly and against memory bandwidth.
+#include <functional>
+#include <random>
+#include <vector>
+#include "bench_util.h"
+#include "frame_kernels.h"
+
+namespace {
+    const uint32_t WIDTH = 1920;
+    const uint32_t HEIGHT = 1080;
+
+    struct Kernel {
+        const char* name;
+        double sourceBytes;
+        std::function<void(const KernelTable&)> run;
+    };
+
+    // Repeats run until minSeconds have passed; returns seconds per call
+    double timeCalls(const std::function<void()>& run, double minSeconds) {
+        run();
+        size_t calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds;
+        do {
+            run();
+            ++calls;
+            seconds = secondsSince(start);
+        } while (seconds < minSeconds);
+        return seconds / calls;
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    double minSeconds = quick ? 0.01 : 0.5;
+
+    std::mt19937 random(7);
+    std::vector<uint8_t> bgra(size_t(WIDTH) * HEIGHT * 4);
+    std::vector<uint8_t> previous(bgra.size());
+    for (size_t i = 0; i < bgra.size(); ++i) {
+        bgra[i] = static_cast<uint8_t>(random());
+        previous[i] = static_cast<uint8_t>(bgra[i] ^ (random() & 0x0f));
+    }
+    std::vector<uint8_t> gray(size_t(WIDTH) * HEIGHT);
+    std::vector<uint8_t> y(gray.size());
+    std::vector<uint8_t> u(gray.size() / 4);
+    std::vector<uint8_t> v(gray.size() / 4);
+    std::vector<uint8_t> small(gray.size());
+    for (size_t i = 0; i < gray.size(); ++i) {
+        gray[i] = bgra[i];
+    }
+
+    const size_t stride = size_t(WIDTH) * 4;
+    const double frameBytes = double(bgra.size());
+    const double grayBytes = double(gray.size());
+    std::vector<Kernel> kernels = {
+        {"sumAbsDiff", 2 * frameBytes, [&](const KernelTable& table) {
+             keep(table.sumAbsDiff(bgra.data(), stride, previous.data(), stride, WIDTH * 4, HEIGHT));
+         }},
+        {"bgraToGray", frameBytes, [&](const KernelTable& table) {
+             table.bgraToGray(bgra.data(), stride, y.data(), WIDTH, WIDTH, HEIGHT);
+         }},
+        {"bgraToI420", frameBytes, [&](const KernelTable& table) {
+             table.bgraToI420(bgra.data(), stride, y.data(), WIDTH, u.data(), v.data(), WIDTH / 2, WIDTH, HEIGHT);
+         }},
+        {"boxDownscale/2", grayBytes, [&](const KernelTable& table) {
+             table.boxDownscaleGray(gray.data(), WIDTH, WIDTH, HEIGHT, 2, small.data(), WIDTH / 2);
+         }},
+        {"boxDownscale/8", grayBytes, [&](const KernelTable& table) {
+             table.boxDownscaleGray(gray.data(), WIDTH, WIDTH, HEIGHT, 8, small.data(), WIDTH / 8);
+         }},
+        {"bilinear 0.75x", grayBytes, [&](const KernelTable& table) {
+             table.bilinearScaleGray(gray.data(), WIDTH, WIDTH, HEIGHT, small.data(), 1440, 1440, 810);
+         }},
+    };
+
+    std::printf("%ux%u frame, GB/s of source read\n", WIDTH, HEIGHT);
+    std::printf("  %-16s", "kernel");
+    KernelIsa best = detectKernelIsa();
+    for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::Sse41, KernelIsa::Avx2}) {
+        if (isa <= best) {
+            std::printf(" %9s", kernelIsaName(isa));
+        }
+    }
+    std::printf("\n");
+
+    for (const Kernel& kernel : kernels) {
+        std::printf("  %-16s", kernel.name);
+        for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::Sse41, KernelIsa::Avx2}) {
+            if (isa > best) {
+                continue;
+            }
+            const KernelTable& table = kernelTable(isa);
+            double seconds = timeCalls([&]() { kernel.run(table); }, minSeconds);
+            std::printf(" %9.2f", kernel.sourceBytes / seconds / 1e9);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
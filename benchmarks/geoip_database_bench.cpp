@@ -0,0 +1,131 @@
+// GeoIpDatabase::lookup on databases written by geoip_builder: random
+// IPv4 and IPv6 addresses, mostly inside a range, against databases small
+// enough to stay in cache and large enough not to. Reports ns per lookup,
+// to check that an offline lookup stays well under a microsecond. The
+// first pass over a freshly opened file also pays for faulting in the
+// mapping and is reported as cold. The time to build the database is not
+// counted.
+//
+//   geoip_database_bench <geoip_builder> [--quick]
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "geoip_database.h"
+
+namespace {
+    const uint64_t MAPPED_LO = 0xffff00000000ull;
+
+    std::string text(const GeoIpKey& key) {
+        uint8_t bytes[16];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<uint8_t>(key.hi >> (56 - 8 * i));
+            bytes[8 + i] = static_cast<uint8_t>(key.lo >> (56 - 8 * i));
+        }
+        return IpAddress::fromV6(bytes).toString();
+    }
+
+    // count ranges, half IPv4 and half IPv6, each followed by a gap. The
+    // IPv4 ranges cover most of the IPv4 space, as real databases do;
+    // the IPv6 ones are /48s spread over 2000::/3.
+    std::vector<GeoIpKey> writeDatabase(const std::string& builder, const std::string& path, uint32_t count,
+                                        std::mt19937_64& random) {
+        std::vector<GeoIpKey> starts;
+        std::string csv = path + ".csv";
+        {
+            std::ofstream out(csv);
+            uint32_t v4 = count / 2;
+            uint64_t step = (uint64_t(1) << 32) / v4;
+            for (uint32_t i = 0; i < v4; ++i) {
+                GeoIpKey first{0, MAPPED_LO | (i * step)};
+                GeoIpKey last{0, first.lo + step - 1 - random() % (step / 8 + 1)};
+                starts.push_back(first);
+                out << text(first) << ',' << text(last) << ",XX,Country,R,Region,City" << i % 5000
+                    << ",0000,UTC,0,0\n";
+            }
+            for (uint32_t i = v4; i < count; ++i) {
+                uint64_t hi = (0x2000000000000000ull + (uint64_t(i - v4) << 40)) & ~0xffffull;
+                GeoIpKey first{hi, 0};
+                GeoIpKey last{hi | 0xffff, ~0ull};
+                starts.push_back(first);
+                out << text(first) << ',' << text(last) << ",XX,Country,R,Region,City" << i % 5000
+                    << ",0000,UTC,0,0\n";
+            }
+        }
+        std::string command = "\"" + builder + "\" \"" + csv + "\" \"" + path + "\" > " +
+#ifdef _WIN32
+                              "NUL";
+#else
+                              "/dev/null";
+#endif
+        bool built = std::system(command.c_str()) == 0;
+        std::filesystem::remove(csv);
+        return built ? starts : std::vector<GeoIpKey>();
+    }
+
+    void run(const GeoIpDatabase& database, const char* name, const std::vector<GeoIpKey>& keys) {
+        GeoIpLocation location;
+        size_t hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const GeoIpKey& key : keys) {
+            hits += database.lookup(key, location) ? 1 : 0;
+            keep(location.city.size());
+        }
+        double lookups = double(keys.size());
+        double seconds = secondsSince(start);
+        std::printf("  %9zu  %-24s %9.1f %10.1f%%\n", database.rangeCount(), name, seconds * 1e9 / lookups,
+                    100.0 * hits / lookups);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string builder;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) != "--quick") {
+            builder = argv[i];
+        }
+    }
+    if (builder.empty()) {
+        std::fprintf(stderr, "usage: geoip_database_bench <geoip_builder> [--quick]\n");
+        return 2;
+    }
+    bool quick = quickRun(argc, argv);
+    std::vector<uint32_t> sizes = quick ? std::vector<uint32_t>{1000, 20000}
+                                        : std::vector<uint32_t>{1000, 100000, 2000000};
+    size_t lookups = quick ? 20000 : 2000000;
+
+    std::mt19937_64 random(3);
+    std::string path = (std::filesystem::temp_directory_path() / "geoip_database_bench.madb").string();
+    std::printf("ns per lookup of random addresses\n");
+    std::printf("  %9s  %-24s %9s %11s\n", "ranges", "addresses", "ns", "found");
+    for (uint32_t size : sizes) {
+        std::vector<GeoIpKey> starts = writeDatabase(builder, path, size, random);
+        GeoIpDatabase database;
+        if (starts.empty() || !database.open(path)) {
+            std::printf("cannot build %s\n", path.c_str());
+            return 1;
+        }
+
+        // Random IPv4 addresses anywhere; IPv6 addresses near a range
+        // start, in it or just before it, and anywhere in the space
+        std::vector<GeoIpKey> v4(lookups);
+        std::vector<GeoIpKey> v6(lookups);
+        std::vector<GeoIpKey> anywhere(lookups);
+        for (size_t i = 0; i < lookups; ++i) {
+            v4[i] = GeoIpKey{0, MAPPED_LO | (random() & 0xffffffffull)};
+            GeoIpKey near = starts[size / 2 + random() % (size - size / 2)];
+            v6[i] = random() % 8 ? GeoIpKey{near.hi | (random() & 0xffff), random()} : GeoIpKey{near.hi - 1, random()};
+            anywhere[i] = GeoIpKey{random(), random()};
+        }
+        run(database, "IPv4, cold mapping", v4);
+        run(database, "IPv4", v4);
+        run(database, "IPv6 near ranges", v6);
+        run(database, "IPv6 anywhere", anywhere);
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
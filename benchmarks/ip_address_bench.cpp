@@ -0,0 +1,107 @@
+// IpAddress::parse and format against the regex validation they replaced
+// in LocationService, on the answers the IP services return.
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "ip_address.h"
+
+// LocationService::validateIPFormat before IpAddress, verbatim
+static bool validateIPFormat(const std::string& ip) {
+    std::regex ipPattern("^(?:[0-9]{1,3}\\.){3}[0-9]{1,3}$");
+
+    if (std::regex_match(ip, ipPattern)) {
+        std::stringstream ss(ip);
+        std::string octet;
+        while (std::getline(ss, octet, '.')) {
+            try {
+                int value = std::stoi(octet);
+                if (value < 0 || value > 255) {
+                    return false;
+                }
+            }
+            catch (...) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+template <typename F>
+static void measure(const char* name, const std::vector<std::string>& inputs, size_t rounds, F&& run) {
+    auto start = std::chrono::steady_clock::now();
+    size_t accepted = 0;
+    for (size_t round = 0; round < rounds; ++round) {
+        for (const std::string& input : inputs) {
+            accepted += run(input);
+        }
+    }
+    double seconds = secondsSince(start);
+    double calls = double(rounds) * inputs.size();
+    std::printf("  %-34s %9.1f ns/call %7.2f M/s  (%zu accepted)\n", name, seconds * 1e9 / calls,
+                calls / seconds / 1e6, accepted / rounds);
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    std::mt19937 random(7);
+
+    // Dotted quads like the services return, some with the whitespace and
+    // junk a misbehaving service sends, and IPv6 answers
+    std::vector<std::string> v4;
+    std::vector<std::string> v6;
+    for (int i = 0; i < 1000; ++i) {
+        std::string text = std::to_string(random() % 256) + "." + std::to_string(random() % 256) + "." +
+                           std::to_string(random() % 256) + "." + std::to_string(random() % 256);
+        if (i % 10 == 0) {
+            text += "\n";
+        }
+        v4.push_back(text);
+
+        IpAddress address;
+        for (uint8_t& byte : address.bytes) {
+            byte = static_cast<uint8_t>(random() % 4 == 0 ? 0 : random());
+        }
+        address.family = IpAddress::Family::V6;
+        v6.push_back(address.toString());
+    }
+
+    size_t rounds = quick ? 2 : 200;
+    std::printf("IPv4 answers (%zu inputs x %zu rounds)\n", v4.size(), rounds);
+    measure("regex validateIPFormat (old)", v4, quick ? 1 : 20, [](const std::string& text) {
+        return validateIPFormat(text);
+    });
+    measure("IpAddress::parse", v4, rounds, [](const std::string& text) {
+        IpAddress address;
+        bool ok = IpAddress::parse(text, address);
+        keep(address);
+        return ok;
+    });
+    measure("IpAddress::parse + format", v4, rounds, [](const std::string& text) {
+        IpAddress address;
+        char out[IpAddress::MAX_TEXT_LENGTH];
+        bool ok = IpAddress::parse(text, address) && address.format(out) > 0;
+        keep(out);
+        return ok;
+    });
+
+    std::printf("IPv6 answers (the regex path rejected all of these)\n");
+    measure("IpAddress::parse", v6, rounds, [](const std::string& text) {
+        IpAddress address;
+        bool ok = IpAddress::parse(text, address);
+        keep(address);
+        return ok;
+    });
+    measure("IpAddress::parse + format", v6, rounds, [](const std::string& text) {
+        IpAddress address;
+        char out[IpAddress::MAX_TEXT_LENGTH];
+        bool ok = IpAddress::parse(text, address) && address.format(out) > 0;
+        keep(out);
+        return ok;
+    });
+    return 0;
+}
@@ -0,0 +1,178 @@
+// Copying LocationInfo, as getLocationInfo, the signup panel and the
+// activation email do, against the ten-string layout it replaced. Reports
+// the time per copy, both into a new object and over an existing one,
+// and the memory each copy takes: the struct itself plus the heap blocks
+// its strings allocate, counted by replacing operator new. The interned
+// layout's text lives once in the shared table instead, shown separately.
+//
+//   location_info_bench [--quick]
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "location_info.h"
+
+// Heap use of the whole program; the benchmark is single-threaded
+static size_t g_allocations = 0;
+static size_t g_allocatedBytes = 0;
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    g_allocatedBytes += size;
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    std::free(block);
+}
+
+namespace {
+    // LocationInfo before it was interned, verbatim
+    struct LegacyLocationInfo {
+        std::string ip;
+        std::string country;
+        std::string country_code;
+        std::string region;
+        std::string region_code;
+        std::string city;
+        std::string zip;
+        std::string timezone;
+        std::string currency;
+        std::string currency_symbol;
+        double latitude;
+        double longitude;
+
+        // Constructor with default values
+        LegacyLocationInfo() :
+            latitude(0.0),
+            longitude(0.0) {
+            ip = "Detecting...";
+            country = "Detecting...";
+            country_code = "Detecting...";
+            region = "Detecting...";
+            region_code = "Detecting...";
+            city = "Detecting...";
+            zip = "Detecting...";
+            timezone = "Detecting...";
+            currency = "USD";
+            currency_symbol = "$";
+        }
+    };
+
+    struct Place {
+        const char* name;
+        const char* ip;
+        const char* country;
+        const char* countryCode;
+        const char* region;
+        const char* regionCode;
+        const char* city;
+        const char* zip;
+        const char* timezone;
+        const char* currency;
+        const char* symbol;
+        double latitude;
+        double longitude;
+    };
+
+    const Place PLACES[] = {
+        {"Montreal", "24.48.0.1", "Canada", "CA", "Quebec", "QC", "Montreal", "H1K", "America/Toronto", "CAD",
+         "$", 45.6085, -73.5493},
+        {"long names, IPv6", "2a02:c7c:9c2a:7b00:1d2e:3f40:5a6b:7c8d",
+         "United Kingdom of Great Britain and Northern Ireland", "GB", "Wales", "WLS",
+         "Llanfairpwllgwyngyllgogerychwyrndrobwllllantysiliogogogoch", "LL61 5UJ", "Europe/London", "GBP",
+         "\xc2\xa3", 53.2210, -4.2097},
+    };
+
+    LegacyLocationInfo legacy(const Place& place) {
+        LegacyLocationInfo info;
+        info.ip = place.ip;
+        info.country = place.country;
+        info.country_code = place.countryCode;
+        info.region = place.region;
+        info.region_code = place.regionCode;
+        info.city = place.city;
+        info.zip = place.zip;
+        info.timezone = place.timezone;
+        info.currency = place.currency;
+        info.currency_symbol = place.symbol;
+        info.latitude = place.latitude;
+        info.longitude = place.longitude;
+        return info;
+    }
+
+    LocationInfo interned(const Place& place) {
+        LocationInfo info;
+        IpAddress::parse(place.ip, info.ip);
+        info.state = LocationState::Resolved;
+        info.country_code.assign(place.countryCode);
+        info.region_code.assign(place.regionCode);
+        info.currency.assign(place.currency);
+        info.country = InternedString::intern(place.country);
+        info.region = InternedString::intern(place.region);
+        info.city = InternedString::intern(place.city);
+        info.zip = InternedString::intern(place.zip);
+        info.timezone = InternedString::intern(place.timezone);
+        info.currency_symbol = InternedString::intern(place.symbol);
+        info.latitude = place.latitude;
+        info.longitude = place.longitude;
+        return info;
+    }
+
+    // ns per copy constructed from source, ns per copy assigned over an
+    // existing object, and heap blocks and bytes per constructed copy
+    template <typename Info>
+    void measure(const char* layout, const char* name, const Info& source, size_t copies) {
+        size_t allocations = g_allocations;
+        size_t bytes = g_allocatedBytes;
+        {
+            Info copy(source);
+            keep(copy);
+        }
+        allocations = g_allocations - allocations;
+        bytes = g_allocatedBytes - bytes;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < copies; ++i) {
+            Info copy(source);
+            keep(copy);
+        }
+        double constructNs = secondsSince(start) / copies * 1e9;
+
+        std::vector<Info> targets(64);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < copies; ++i) {
+            Info& target = targets[i % targets.size()];
+            target = source;
+            keep(target);
+        }
+        double assignNs = secondsSince(start) / copies * 1e9;
+
+        std::printf("  %-9s %-18s %8.1f %8.1f %6zu %7zu %7zu\n", layout, name, constructNs, assignNs, sizeof(Info),
+                    allocations, sizeof(Info) + bytes);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t copies = quickRun(argc, argv) ? 10000 : 5000000;
+
+    std::printf("  %-9s %-18s %8s %8s %6s %7s %7s\n", "layout", "snapshot", "new ns", "over ns", "sizeof", "allocs",
+                "bytes");
+    measure("strings", "detecting", LegacyLocationInfo(), copies);
+    measure("interned", "detecting", LocationInfo(), copies);
+    for (const Place& place : PLACES) {
+        measure("strings", place.name, legacy(place), copies);
+        measure("interned", place.name, interned(place), copies);
+    }
+    std::printf("shared table: %zu strings, %zu bytes of text, held once for every copy\n",
+                InternedString::tableSize(), InternedString::tableBytes());
+    return 0;
+}
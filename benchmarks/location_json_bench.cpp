@@ -0,0 +1,137 @@
+// decodeIpApiResponse and decodeRestCountriesCurrency against the DOM
+// parse they replaced, json::parse followed by lookups of the same keys,
+// over the ip-api.com and restcountries.com responses in the test corpus.
+// Reports ns per response and MB/s for each. Both decode from memory, so
+// only the JSON handling is measured.
+//
+//   location_json_bench <corpus dir> [--quick]
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "bench_util.h"
+#include "location_json.h"
+
+using json = nlohmann::json;
+
+namespace {
+    struct Response {
+        std::string name;
+        std::string body;
+        bool ipApi;
+    };
+
+    std::string text(const json& data, const char* key) {
+        auto it = data.find(key);
+        return it != data.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    double number(const json& data, const char* key) {
+        auto it = data.find(key);
+        return it != data.end() && it->is_number() ? it->get<double>() : 0.0;
+    }
+
+    // getLocationDetails before the SAX decoder, without the exceptions
+    // on missing keys
+    size_t domIpApi(std::string_view body, LocationInfo& info) {
+        json data = json::parse(body.begin(), body.end(), nullptr, false);
+        if (!data.is_object() || text(data, "status") != "success") {
+            return 0;
+        }
+        info.country = InternedString::intern(text(data, "country"));
+        info.country_code.assign(text(data, "countryCode"));
+        info.region = InternedString::intern(text(data, "regionName"));
+        info.region_code.assign(text(data, "region"));
+        info.city = InternedString::intern(text(data, "city"));
+        info.zip = InternedString::intern(text(data, "zip"));
+        info.timezone = InternedString::intern(text(data, "timezone"));
+        info.latitude = number(data, "lat");
+        info.longitude = number(data, "lon");
+        return info.city.size();
+    }
+
+    // parseCurrencyInfo before the SAX decoder
+    size_t domCurrency(std::string_view body, std::string& code, std::string& symbol) {
+        json data = json::parse(body.begin(), body.end(), nullptr, false);
+        const json& country = data.is_array() && !data.empty() ? data[0] : data;
+        auto currencies = country.is_object() ? country.find("currencies") : country.end();
+        if (currencies != country.end() && currencies->is_object()) {
+            for (auto& [name, currency] : currencies->items()) {
+                code = name;
+                symbol = currency.is_object() ? text(currency, "symbol") : std::string();
+                break;
+            }
+        }
+        return code.size();
+    }
+
+    size_t sax(const Response& response) {
+        if (response.ipApi) {
+            LocationInfo info;
+            return decodeIpApiResponse(response.body, info).fields;
+        }
+        std::string code;
+        std::string symbol;
+        decodeRestCountriesCurrency(response.body, code, symbol);
+        return code.size();
+    }
+
+    size_t dom(const Response& response) {
+        if (response.ipApi) {
+            LocationInfo info;
+            return domIpApi(response.body, info);
+        }
+        std::string code;
+        std::string symbol;
+        return domCurrency(response.body, code, symbol);
+    }
+
+    template <typename Decode>
+    double nsPerResponse(const Response& response, size_t rounds, Decode&& decode) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rounds; ++i) {
+            keep(decode(response));
+        }
+        return secondsSince(start) * 1e9 / rounds;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string corpus;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) != "--quick") {
+            corpus = argv[i];
+        }
+    }
+    if (corpus.empty()) {
+        std::fprintf(stderr, "usage: location_json_bench <corpus dir> [--quick]\n");
+        return 2;
+    }
+    bool quick = quickRun(argc, argv);
+
+    std::vector<Response> responses;
+    for (const auto& entry : std::filesystem::directory_iterator(corpus)) {
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::string body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::string name = entry.path().stem().string();
+        responses.push_back(Response{name, body, name.compare(0, 7, "ip_api_") == 0});
+    }
+    std::sort(responses.begin(), responses.end(), [](const Response& a, const Response& b) {
+        return a.name < b.name;
+    });
+
+    std::printf("ns per response and MB/s, SAX decoder against DOM parse\n");
+    std::printf("  %-32s %7s %9s %9s %8s %8s\n", "response", "bytes", "SAX ns", "DOM ns", "SAX MB/s", "DOM MB/s");
+    for (const Response& response : responses) {
+        size_t rounds = std::max<size_t>(1, (quick ? 200000 : 50000000) / (response.body.size() + 64));
+        double saxNs = nsPerResponse(response, rounds, sax);
+        double domNs = nsPerResponse(response, rounds, dom);
+        double bytes = double(response.body.size());
+        std::printf("  %-32s %7zu %9.0f %9.0f %8.0f %8.0f\n", response.name.c_str(), response.body.size(), saxNs,
+                    domNs, bytes * 1e3 / saxNs, bytes * 1e3 / domNs);
+    }
+    return 0;
+}
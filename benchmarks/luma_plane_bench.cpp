@@ -0,0 +1,145 @@
+// LumaPlane kept current from each frame's regions against converting
+// every frame in full, in CPU time per frame. The CPU time is the whole
+// process's, so work the task pool does on other threads counts too.
+//
+// Each kind of content is recorded from SyntheticFrameSource as Y4M and
+// replayed through Y4mFrameSource, which finds dirty rects by comparing
+// blocks, as a real session would be replayed. The scrolling content is
+// also run straight from the synthetic source, which reports the scroll
+// as a move the way desktop duplication does, so moved areas are copied
+// instead of converted. Every incremental plane is checked against the
+// full conversion.
+//
+//   luma_plane_bench [--quick]
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "frame_kernels.h"
+#include "luma_plane.h"
+#include "synthetic_frame_source.h"
+#include "y4m_frame_source.h"
+
+namespace {
+    const uint32_t TILE_SIZE = 64;
+
+    struct Content {
+        const char* name;
+        uint32_t slideFrames;
+        uint32_t scrollPixels;
+    };
+
+    SyntheticFrameSourceConfig sourceConfig(const Content& content, uint32_t width, uint32_t height,
+                                            uint64_t frames) {
+        SyntheticFrameSourceConfig config;
+        config.width = width;
+        config.height = height;
+        config.frameCount = frames;
+        config.slideFrames = content.slideFrames;
+        config.scrollPixels = content.scrollPixels;
+        config.paced = false;
+        return config;
+    }
+
+    void writeRecording(const std::string& path, const SyntheticFrameSourceConfig& config) {
+        SyntheticFrameSource source(config);
+        std::ofstream out(path, std::ios::binary);
+        out << "YUV4MPEG2 W" << config.width << " H" << config.height << " F30:1 Ip A1:1 C420jpeg\n";
+        std::vector<uint8_t> planes(size_t(config.width) * config.height * 3 / 2);
+        uint8_t* y = planes.data();
+        uint8_t* u = y + size_t(config.width) * config.height;
+        uint8_t* v = u + size_t(config.width / 2) * (config.height / 2);
+        FrameBuffer frame;
+        FrameInfo info;
+        while (source.capture(frame, info, std::chrono::milliseconds(0)) == CaptureStatus::Captured) {
+            bgraToI420(frame.data(), frame.stride(), y, config.width, u, v, config.width / 2, config.width,
+                       config.height);
+            out << "FRAME\n";
+            out.write(reinterpret_cast<const char*>(planes.data()), static_cast<std::streamsize>(planes.size()));
+        }
+    }
+
+    // Feeds every frame of source to an incremental plane and to one told
+    // each frame is full, timing each update on its own
+    void run(FrameSource& source, const char* name, uint32_t width, uint32_t height) {
+        LumaPlane incremental(TILE_SIZE);
+        LumaPlane full(TILE_SIZE);
+        FrameBuffer frame;
+        FrameInfo info;
+        FrameInfo fullInfo;
+        uint64_t frames = 0;
+        uint64_t converted = 0;
+        uint64_t changed = 0;
+        uint64_t mismatches = 0;
+        double incrementalCpu = 0;
+        double fullCpu = 0;
+        double incrementalWall = 0;
+        double fullWall = 0;
+        while (source.capture(frame, info, std::chrono::milliseconds(0)) == CaptureStatus::Captured) {
+            info.sequence = fullInfo.sequence = ++frames;
+
+            std::clock_t cpu = std::clock();
+            auto start = std::chrono::steady_clock::now();
+            converted += incremental.update(frame, info);
+            incrementalWall += secondsSince(start);
+            incrementalCpu += double(std::clock() - cpu) / CLOCKS_PER_SEC;
+            changed += incremental.damage().count();
+
+            cpu = std::clock();
+            start = std::chrono::steady_clock::now();
+            full.update(frame, fullInfo);
+            fullWall += secondsSince(start);
+            fullCpu += double(std::clock() - cpu) / CLOCKS_PER_SEC;
+
+            for (uint32_t row = 0; row < height; ++row) {
+                mismatches += std::memcmp(incremental.row(row), full.row(row), width) != 0 ? 1 : 0;
+            }
+        }
+        if (frames == 0) {
+            std::printf("  %-48s no frames\n", name);
+            return;
+        }
+        size_t tiles = size_t((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+        std::printf("  %-48s %6.1f %6.1f of %zu %9.0f %9.0f %9.0f %9.0f %7.1fx %s\n", name, double(converted) / frames,
+                    double(changed) / frames, tiles, incrementalCpu / frames * 1e6, fullCpu / frames * 1e6,
+                    incrementalWall / frames * 1e6, fullWall / frames * 1e6, fullCpu / incrementalCpu,
+                    mismatches ? "MISMATCH" : "same");
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    uint32_t width = quick ? 640 : 1920;
+    uint32_t height = quick ? 360 : 1080;
+    uint64_t frames = quick ? 20 : 120;
+    const Content contents[] = {
+        {"static slide, cursor moving", 100000, 0},
+        {"slide deck, new slide every 30 frames", 30, 0},
+        {"scrolling 3 px/frame", 100000, 3},
+    };
+
+    std::printf("%ux%u, %llu frames each, %u px tiles, %s kernels\n", width, height,
+                static_cast<unsigned long long>(frames), TILE_SIZE, kernelIsaName(activeKernelIsa()));
+    std::printf("  %-48s %6s %13s %9s %9s %9s %9s %8s\n", "", "tiles", "tiles", "CPU us", "CPU us", "wall us",
+                "wall us", "");
+    std::printf("  %-48s %6s %13s %9s %9s %9s %9s %8s %s\n", "content", "conv", "changed", "incr", "full", "incr",
+                "full", "speedup", "planes");
+    std::string path = (std::filesystem::temp_directory_path() / "luma_plane_bench.y4m").string();
+    for (const Content& content : contents) {
+        writeRecording(path, sourceConfig(content, width, height, frames));
+        Y4mFrameSource replay;
+        if (!replay.open(path)) {
+            std::printf("cannot open %s\n", path.c_str());
+            return 1;
+        }
+        run(replay, (std::string(content.name) + ", replayed").c_str(), width, height);
+    }
+    std::filesystem::remove(path);
+
+    SyntheticFrameSource scrolling(sourceConfig(contents[2], width, height, frames));
+    run(scrolling, "scrolling 3 px/frame, reported as moves", width, height);
+    return 0;
+}
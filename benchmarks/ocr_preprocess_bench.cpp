@@ -0,0 +1,171 @@
+// OcrPreprocessor frames per second on a replayed capture. Slides from
+// SyntheticFrameSource are written as Y4M, straight, skewed by 3 degrees
+// and in a dark theme, and played back through Y4mFrameSource. Each
+// frame is preprocessed on TaskPools of several sizes and its lines are
+// read by StubOcrEngine. Only the preprocessing and the stub are timed,
+// not the Y4M decode.
+//
+//   ocr_preprocess_bench [--quick]
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "frame_kernels.h"
+#include "ocr_preprocessor.h"
+#include "synthetic_frame_source.h"
+#include "y4m_frame_source.h"
+
+namespace {
+    struct Scenario {
+        const char* name;
+        float skewDegrees;
+        bool dark;
+    };
+
+    // Rotate clockwise about the centre, nearest neighbour, filling with
+    // the colour of the top left pixel
+    void skew(const FrameBuffer& source, FrameBuffer& target, float degrees) {
+        uint32_t width = source.width();
+        uint32_t height = source.height();
+        target.allocate(width, height);
+        double radians = degrees * 3.14159265358979 / 180.0;
+        double c = std::cos(radians);
+        double s = std::sin(radians);
+        double cx = width / 2.0;
+        double cy = height / 2.0;
+        for (uint32_t y = 0; y < height; ++y) {
+            uint8_t* out = target.row(y);
+            for (uint32_t x = 0; x < width; ++x) {
+                double dx = x + 0.5 - cx;
+                double dy = y + 0.5 - cy;
+                long sx = std::lround(c * dx + s * dy + cx - 0.5);
+                long sy = std::lround(-s * dx + c * dy + cy - 0.5);
+                bool inside = sx >= 0 && sy >= 0 && sx < long(width) && sy < long(height);
+                const uint8_t* in = inside ? source.row(static_cast<uint32_t>(sy)) + sx * 4 : source.row(0);
+                std::memcpy(out + x * 4, in, 4);
+            }
+        }
+    }
+
+    void invert(FrameBuffer& frame) {
+        for (uint32_t y = 0; y < frame.height(); ++y) {
+            uint8_t* row = frame.row(y);
+            for (uint32_t x = 0; x < frame.width(); ++x) {
+                row[x * 4] = static_cast<uint8_t>(255 - row[x * 4]);
+                row[x * 4 + 1] = static_cast<uint8_t>(255 - row[x * 4 + 1]);
+                row[x * 4 + 2] = static_cast<uint8_t>(255 - row[x * 4 + 2]);
+            }
+        }
+    }
+
+    void writeRecording(const std::string& path, const Scenario& scenario, uint32_t width, uint32_t height,
+                        uint32_t frames) {
+        SyntheticFrameSourceConfig config;
+        config.width = width;
+        config.height = height;
+        config.slideFrames = 1;     // Every frame a new slide, as the extractor sees them
+        config.paced = false;
+        SyntheticFrameSource slides(config);
+
+        std::ofstream out(path, std::ios::binary);
+        out << "YUV4MPEG2 W" << width << " H" << height << " F30:1 Ip A1:1 C420jpeg\n";
+        std::vector<uint8_t> planes(size_t(width) * height * 3 / 2);
+        uint8_t* y = planes.data();
+        uint8_t* u = y + size_t(width) * height;
+        uint8_t* v = u + size_t(width / 2) * (height / 2);
+        FrameBuffer frame;
+        FrameBuffer skewed;
+        for (uint32_t i = 0; i < frames; ++i) {
+            slides.render(i, frame);
+            FrameBuffer* shown = &frame;
+            if (scenario.skewDegrees != 0.0f) {
+                skew(frame, skewed, scenario.skewDegrees);
+                shown = &skewed;
+            }
+            if (scenario.dark) {
+                invert(*shown);
+            }
+            bgraToI420(shown->data(), shown->stride(), y, width, u, v, width / 2, width, height);
+            out << "FRAME\n";
+            out.write(reinterpret_cast<const char*>(planes.data()), static_cast<std::streamsize>(planes.size()));
+        }
+    }
+
+    void replay(const std::string& path, const Scenario& scenario, size_t threads) {
+        Y4mFrameSource source;
+        if (!source.open(path)) {
+            std::printf("cannot open %s\n", path.c_str());
+            return;
+        }
+        TaskPool pool(threads - 1);
+        OcrPreprocessor preprocessor(OcrPreprocessorConfig{}, pool);
+        StubOcrEngine engine;
+
+        FrameBuffer frame;
+        FrameInfo info;
+        uint32_t frames = 0;
+        size_t regions = 0;
+        size_t lines = 0;
+        double skew = 0;
+        double preprocessSeconds = 0;
+        double recognizeSeconds = 0;
+        while (source.capture(frame, info, std::chrono::milliseconds(0)) == CaptureStatus::Captured) {
+            auto start = std::chrono::steady_clock::now();
+            const OcrPage& page = preprocessor.process(frame);
+            preprocessSeconds += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            for (const TextRegion& region : page.regions) {
+                OcrLine line;
+                line.bounds = region.bounds;
+                lines += engine.recognize(page.image, region.bounds, line) ? 1 : 0;
+            }
+            recognizeSeconds += secondsSince(start);
+            regions += page.regions.size();
+            skew += page.skewDegrees;
+            ++frames;
+        }
+        std::printf("  %-14s %7zu %9.1f %8.2f %8.2f %8.1f %6.1f %6.2f\n", scenario.name, threads,
+                    frames / preprocessSeconds, 1000 * preprocessSeconds / frames, 1000 * recognizeSeconds / frames,
+                    double(regions) / frames, double(lines) / frames, skew / frames);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    uint32_t width = quick ? 640 : 1920;
+    uint32_t height = quick ? 360 : 1080;
+    uint32_t frames = quick ? 3 : 30;
+
+    std::vector<size_t> threadCounts = {1, 2, 4};
+    size_t cores = std::thread::hardware_concurrency();
+    if (cores > 4) {
+        threadCounts.push_back(cores);
+    }
+    if (quick) {
+        threadCounts = {1, 2};
+    }
+
+    static const Scenario SCENARIOS[] = {
+        {"straight", 0.0f, false},
+        {"skewed 3 deg", 3.0f, false},
+        {"dark theme", 0.0f, true},
+    };
+
+    std::printf("%u slides of %ux%u per recording; frames/s is preprocessing, stub ms the stub engine\n",
+                frames, width, height);
+    std::printf("  %-14s %7s %9s %8s %8s %8s %6s %6s\n", "recording", "threads", "frames/s", "ms/frame",
+                "stub ms", "regions", "lines", "skew");
+    std::string path = (std::filesystem::temp_directory_path() / "ocr_preprocess_bench.y4m").string();
+    for (const Scenario& scenario : SCENARIOS) {
+        writeRecording(path, scenario, width, height, frames);
+        for (size_t threads : threadCounts) {
+            replay(path, scenario, threads);
+        }
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,291 @@
+// SlideDetector on a replayed capture. A recording of a presentation is
+// written as Y4M and played back through Y4mFrameSource, the way a real
+// session is replayed: slides from SyntheticFrameSource with a moving
+// cursor, cross-fades between slides, sparse codec-like noise on every
+// frame, slides built up in two steps and some slides shown twice. Since
+// the recording is generated, every change is known, so false positives
+// (events without a change) and false negatives (changes without an
+// event) can be counted.
+//
+//   slide_detector_bench [--quick]
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "bench_util.h"
+#include "frame_kernels.h"
+#include "frame_pool.h"
+#include "slide_detector.h"
+#include "synthetic_frame_source.h"
+#include "y4m_frame_source.h"
+
+namespace {
+    // Frame indexes passed to SyntheticFrameSource::render are
+    // slide * SLIDE_FRAMES + frame, so any slide can be drawn at any time
+    const uint32_t SLIDE_FRAMES = 100000;
+    const uint32_t FADE_FRAMES = 4;
+    const uint32_t NOISE_BLOCK = 16;
+    const uint32_t CURSOR_COLOR = 0xffff2020;   // As SyntheticFrameSource draws it
+
+    // What is on screen: a slide, with its text shown down to row reveal
+    // while the slide is being built up line by line
+    struct Picture {
+        uint32_t slide;
+        uint32_t reveal;
+
+        bool operator==(const Picture& other) const { return slide == other.slide && reveal == other.reveal; }
+    };
+
+    struct Segment {
+        Picture picture;
+        uint64_t start;         // First frame showing only this picture
+        bool revisit;           // The picture was on screen before
+    };
+
+    struct Recording {
+        std::vector<Segment> segments;
+        std::vector<int64_t> segmentOf;     // Per frame; -1 during a fade
+    };
+
+    struct Found {
+        uint64_t frame;
+        uint64_t slideId;
+        bool revisit;
+    };
+
+    void draw(const SyntheticFrameSource& slides, const Picture& picture, uint64_t index, FrameBuffer& frame) {
+        slides.render(uint64_t(picture.slide) * SLIDE_FRAMES + index, frame);
+        if (picture.reveal >= frame.height()) {
+            return;
+        }
+
+        // Hide the text below reveal. The top row has no text, and the
+        // cursor can cover at most one of three samples of it.
+        uint32_t width = frame.width();
+        uint32_t samples[3];
+        std::memcpy(&samples[0], frame.row(0), 4);
+        std::memcpy(&samples[1], frame.row(0) + (width / 2) * 4, 4);
+        std::memcpy(&samples[2], frame.row(0) + (width - 1) * 4, 4);
+        uint32_t background = samples[0] == samples[1] || samples[0] == samples[2] ? samples[0] : samples[1];
+        for (uint32_t y = picture.reveal; y < frame.height(); ++y) {
+            uint8_t* row = frame.row(y);
+            for (uint32_t x = 0; x < width; ++x) {
+                uint32_t pixel;
+                std::memcpy(&pixel, row + x * 4, 4);
+                if (pixel != CURSOR_COLOR) {
+                    std::memcpy(row + x * 4, &background, 4);
+                }
+            }
+        }
+    }
+
+    void writeFrame(std::ofstream& out, const FrameBuffer& frame, std::vector<uint8_t>& planes, std::mt19937& random) {
+        uint32_t width = frame.width();
+        uint32_t height = frame.height();
+        uint8_t* y = planes.data();
+        uint8_t* u = y + size_t(width) * height;
+        uint8_t* v = u + size_t(width / 2) * (height / 2);
+        bgraToI420(frame.data(), frame.stride(), y, width, u, v, width / 2, width, height);
+
+        // Re-encoding leaves a little noise in a few blocks of every frame
+        for (uint32_t top = 0; top < height; top += NOISE_BLOCK) {
+            for (uint32_t left = 0; left < width; left += NOISE_BLOCK) {
+                if (random() % 20 != 0) {
+                    continue;
+                }
+                for (uint32_t row = top; row < std::min(top + NOISE_BLOCK, height); ++row) {
+                    for (uint32_t x = left; x < std::min(left + NOISE_BLOCK, width); ++x) {
+                        int value = y[size_t(row) * width + x] + static_cast<int>(random() % 5) - 2;
+                        y[size_t(row) * width + x] = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+                    }
+                }
+            }
+        }
+        out << "FRAME\n";
+        out.write(reinterpret_cast<const char*>(planes.data()), static_cast<std::streamsize>(planes.size()));
+    }
+
+    Recording writeRecording(const std::string& path, uint32_t width, uint32_t height, uint32_t segments,
+                             uint32_t minFrames, uint32_t maxFrames) {
+        std::mt19937 random(11);
+        SyntheticFrameSourceConfig config;
+        config.width = width;
+        config.height = height;
+        config.slideFrames = SLIDE_FRAMES;
+        SyntheticFrameSource slides(config);
+
+        std::ofstream out(path, std::ios::binary);
+        out << "YUV4MPEG2 W" << width << " H" << height << " F30:1 Ip A1:1 C420jpeg\n";
+        std::vector<uint8_t> planes(size_t(width) * height * 3 / 2);
+        FrameBuffer frame;
+        FrameBuffer from;
+        FrameBuffer to;
+
+        Recording recording;
+        std::vector<Picture> shown;
+        uint32_t nextSlide = 1;
+        bool building = false;
+        for (uint32_t s = 0; s < segments; ++s) {
+            // Mostly new slides. About one in five is built up over two
+            // steps and about one in five goes back to an earlier slide.
+            Picture picture{nextSlide, height};
+            if (building) {
+                picture.slide = recording.segments.back().picture.slide;
+                building = false;
+            } else if (shown.size() > 2 && random() % 5 == 0) {
+                Picture earlier = shown[random() % shown.size()];
+                if (!(earlier == recording.segments.back().picture) && earlier.reveal == height) {
+                    picture = earlier;
+                }
+            } else if (random() % 5 == 0) {
+                picture.reveal = height / 2;
+                building = true;
+            }
+            if (picture.slide == nextSlide) {
+                ++nextSlide;
+            }
+            bool revisit = std::find(shown.begin(), shown.end(), picture) != shown.end();
+
+            // New slides fade in; a build step just adds its lines
+            uint64_t index = recording.segmentOf.size();
+            if (s > 0 && picture.slide != recording.segments.back().picture.slide) {
+                const Picture& previous = recording.segments.back().picture;
+                for (uint32_t f = 1; f <= FADE_FRAMES; ++f, ++index) {
+                    draw(slides, previous, index, from);
+                    draw(slides, picture, index, to);
+                    frame.allocate(width, height);
+                    uint32_t weight = 256 * f / (FADE_FRAMES + 1);
+                    for (uint32_t row = 0; row < height; ++row) {
+                        const uint8_t* a = from.row(row);
+                        const uint8_t* b = to.row(row);
+                        uint8_t* mixed = frame.row(row);
+                        for (uint32_t x = 0; x < width * 4; ++x) {
+                            mixed[x] = static_cast<uint8_t>((a[x] * (256 - weight) + b[x] * weight) >> 8);
+                        }
+                    }
+                    writeFrame(out, frame, planes, random);
+                    recording.segmentOf.push_back(-1);
+                }
+            }
+
+            uint32_t length = minFrames + random() % (maxFrames - minFrames + 1);
+            recording.segments.push_back(Segment{picture, index, revisit});
+            for (uint32_t f = 0; f < length; ++f, ++index) {
+                draw(slides, picture, index, frame);
+                writeFrame(out, frame, planes, random);
+                recording.segmentOf.push_back(s);
+            }
+            if (!revisit) {
+                shown.push_back(picture);
+            }
+        }
+        return recording;
+    }
+
+    void replay(const std::string& path, const Recording& recording, SlideHashKind kind, const char* name) {
+        Y4mFrameSource source;
+        if (!source.open(path)) {
+            std::printf("cannot open %s\n", path.c_str());
+            return;
+        }
+
+        SlideDetectorConfig config;
+        config.kind = kind;
+        std::vector<Found> found;
+        uint64_t frameIndex = 0;
+        SlideDetector detector(config, [&](const SlideEvent& event) {
+            found.push_back(Found{frameIndex, event.slideId, event.revisit});
+        });
+
+        FramePool pool(2);
+        double detectSeconds = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (;; ++frameIndex) {
+            FrameHandle frame = pool.acquire();
+            if (source.capture(frame.writableBuffer(), frame.writableInfo(), std::chrono::milliseconds(0))
+                != CaptureStatus::Captured) {
+                break;
+            }
+            auto detectStart = std::chrono::steady_clock::now();
+            detector.process(frame);
+            detectSeconds += secondsSince(detectStart);
+        }
+        double totalSeconds = secondsSince(start);
+
+        // Every segment shows a new picture, so the first event inside it
+        // is a hit. Events during a fade and further events in the same
+        // segment are false positives.
+        std::vector<bool> matched(recording.segments.size(), false);
+        std::vector<uint64_t> segmentSlideId(recording.segments.size(), 0);
+        uint64_t falsePositives = 0;
+        uint64_t wrongRevisits = 0;
+        uint64_t latencyFrames = 0;
+        for (const Found& event : found) {
+            int64_t segment = recording.segmentOf[event.frame];
+            if (segment < 0 || matched[segment]) {
+                ++falsePositives;
+                continue;
+            }
+            const Segment& truth = recording.segments[segment];
+            matched[segment] = true;
+            segmentSlideId[segment] = event.slideId;
+            latencyFrames += event.frame - truth.start;
+            wrongRevisits += event.revisit != truth.revisit ? 1 : 0;
+        }
+
+        // A revisit must also come back under the id its slide first had
+        for (size_t s = 0; s < recording.segments.size(); ++s) {
+            if (!matched[s] || !recording.segments[s].revisit) {
+                continue;
+            }
+            for (size_t first = 0; first < s; ++first) {
+                if (recording.segments[first].picture == recording.segments[s].picture && matched[first]) {
+                    wrongRevisits += segmentSlideId[first] != segmentSlideId[s] ? 1 : 0;
+                    break;
+                }
+            }
+        }
+
+        uint64_t changes = recording.segments.size();
+        uint64_t hits = changes - static_cast<uint64_t>(std::count(matched.begin(), matched.end(), false));
+        uint64_t misses = changes - hits;
+        SlideDetectorStats stats = detector.stats();
+        std::printf("%s hash\n", name);
+        std::printf("  frames %llu, hashed %llu, events %zu (%.1f frames per event)\n",
+                    static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.hashed),
+                    found.size(), found.empty() ? 0.0 : double(stats.frames) / found.size());
+        std::printf("  false positives %llu (%.2f%% of events), false negatives %llu of %llu changes (%.2f%%)\n",
+                    static_cast<unsigned long long>(falsePositives),
+                    found.empty() ? 0.0 : 100.0 * falsePositives / found.size(),
+                    static_cast<unsigned long long>(misses), static_cast<unsigned long long>(changes),
+                    100.0 * misses / changes);
+        std::printf("  revisit errors %llu, mean latency %.1f frames\n",
+                    static_cast<unsigned long long>(wrongRevisits), hits ? double(latencyFrames) / hits : 0.0);
+        std::printf("  detector %.0f frames/s, replay with Y4M decode %.0f frames/s\n",
+                    stats.frames / detectSeconds, stats.frames / totalSeconds);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    uint32_t width = quick ? 640 : 1280;
+    uint32_t height = quick ? 360 : 720;
+    uint32_t segments = quick ? 8 : 40;
+
+    std::string path = (std::filesystem::temp_directory_path() / "slide_detector_bench.y4m").string();
+    Recording recording = quick ? writeRecording(path, width, height, segments, 6, 12)
+                                : writeRecording(path, width, height, segments, 30, 90);
+    size_t revisits = std::count_if(recording.segments.begin(), recording.segments.end(),
+                                    [](const Segment& segment) { return segment.revisit; });
+    size_t builds = std::count_if(recording.segments.begin(), recording.segments.end(),
+                                  [height](const Segment& segment) { return segment.picture.reveal < height; });
+    std::printf("%ux%u recording, %zu frames, %u changes: %zu slides built in two steps, %zu revisits\n",
+                width, height, recording.segmentOf.size(), segments, builds, revisits);
+
+    replay(path, recording, SlideHashKind::Difference, "Difference");
+    replay(path, recording, SlideHashKind::Dct, "DCT");
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,168 @@
+// Subscription checks from several threads against a populated store:
+// one isActive() per address, and activeMask() over blocks of addresses,
+// each with and without a writer renewing subscriptions concurrently.
+// Then activeMask() on one thread over batches of 1 to 100k addresses,
+// for the cost per call and per address at each size.
+#include <algorithm>
+#include <bitset>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "subscription_store.h"
+
+static const time_t NOW = 1800000000;
+
+struct Run {
+    double seconds;
+    uint64_t checks;
+    uint64_t active;
+};
+
+template <typename F>
+static Run runThreads(unsigned threads, bool writer, SubscriptionStore& store,
+                      const std::vector<std::string>& emails, F&& check) {
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> checks{0};
+    std::atomic<uint64_t> active{0};
+
+    // Renews the first half again and again; expiries stay in the future,
+    // so the active count the readers see doesn't change
+    std::thread renewing;
+    if (writer) {
+        renewing = std::thread([&]() {
+            for (size_t i = 0; !done.load(std::memory_order_relaxed); i = (i + 1) % (emails.size() / 2)) {
+                store.put(emails[i], "renewal", NOW + 86400 + time_t(i % 1000));
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < threads; ++t) {
+        readers.emplace_back([&, t]() {
+            uint64_t found = 0;
+            uint64_t count = check(t, found);
+            checks += count;
+            active += found;
+        });
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    double seconds = secondsSince(start);
+    done.store(true, std::memory_order_relaxed);
+    if (renewing.joinable()) {
+        renewing.join();
+    }
+    return Run{seconds, checks.load(), active.load()};
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    const size_t subscriptions = quick ? 20000 : 1000000;
+    const int passes = quick ? 1 : 3;
+
+    // Half the addresses are subscribed; the other half never were
+    std::vector<std::string> emails;
+    emails.reserve(subscriptions * 2);
+    for (size_t i = 0; i < subscriptions * 2; ++i) {
+        emails.push_back("customer" + std::to_string(i) + "@example.com");
+    }
+    SubscriptionStore store;
+    for (size_t i = 0; i < subscriptions; ++i) {
+        store.put(emails[i], "tx" + std::to_string(i), NOW + 86400);
+    }
+
+    // Each thread checks every address once per pass, in its own order
+    std::vector<std::vector<std::string_view>> orders;
+    unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned t = 0; t < maxThreads; ++t) {
+        std::vector<std::string_view> order(emails.begin(), emails.end());
+        std::shuffle(order.begin(), order.end(), std::mt19937(t));
+        orders.push_back(std::move(order));
+    }
+
+    std::printf("%zu subscriptions, %zu addresses checked per thread per pass\n", subscriptions, emails.size());
+    std::printf("  %-12s %-7s %-7s %10s %12s\n", "check", "threads", "writer", "M checks/s", "per thread");
+    bool correct = true;
+    for (int mode = 0; mode < 2; ++mode) {
+        for (int writer = 0; writer < 2; ++writer) {
+            for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+                Run run = runThreads(threads, writer != 0, store, emails, [&](unsigned t, uint64_t& found) {
+                    const std::vector<std::string_view>& order = orders[t];
+                    uint64_t count = 0;
+                    std::vector<uint64_t> mask((order.size() + 63) / 64);
+                    for (int pass = 0; pass < passes; ++pass) {
+                        if (mode == 0) {
+                            for (std::string_view email : order) {
+                                found += store.isActive(email, NOW);
+                            }
+                        } else {
+                            store.activeMask(order.data(), order.size(), NOW, mask.data());
+                            for (uint64_t word : mask) {
+                                found += std::bitset<64>(word).count();
+                            }
+                        }
+                        count += order.size();
+                    }
+                    return count;
+                });
+                correct = correct && run.active == uint64_t(threads) * passes * subscriptions;
+                double rate = run.checks / run.seconds / 1e6;
+                std::printf("  %-12s %-7u %-7s %10.1f %12.1f\n", mode == 0 ? "isActive" : "activeMask", threads,
+                            writer ? "yes" : "no", rate, rate / threads);
+            }
+        }
+    }
+
+    // The same addresses in batches of each size, against one isActive()
+    // per address. The addresses repeat when there are fewer than the
+    // largest batch.
+    static const size_t BATCH_SIZES[] = {1, 4, 16, 64, 256, 1024, 4096, 16384, 100000};
+    std::vector<std::string_view> items(orders[0]);
+    while (items.size() < 100000) {
+        items.insert(items.end(), orders[0].begin(), orders[0].end());
+    }
+    std::vector<uint64_t> mask((items.size() + 63) / 64);
+    std::printf("activeMask by batch size, 1 thread, no writer, %zu addresses per pass\n", items.size());
+    std::printf("  %-8s %12s %12s %10s\n", "batch", "ns per call", "ns per item", "vs isActive");
+    uint64_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (std::string_view email : items) {
+            found += store.isActive(email, NOW);
+        }
+    }
+    double isActiveItem = secondsSince(start) * 1e9 / (double(passes) * items.size());
+
+    for (size_t batch : BATCH_SIZES) {
+        uint64_t batchFound = 0;
+        size_t calls = 0;
+        start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (size_t base = 0; base + batch <= items.size(); base += batch) {
+                store.activeMask(items.data() + base, batch, NOW, mask.data());
+                for (size_t w = 0; w < (batch + 63) / 64; ++w) {
+                    batchFound += std::bitset<64>(mask[w]).count();
+                }
+                ++calls;
+            }
+        }
+        double seconds = secondsSince(start);
+        keep(batchFound);
+        double perItem = seconds * 1e9 / (double(calls) * batch);
+        std::printf("  %-8zu %12.1f %12.1f %9.2fx\n", batch, seconds * 1e9 / calls, perItem,
+                    isActiveItem / perItem);
+    }
+    std::printf("  isActive %12s %12.1f\n", "", isActiveItem);
+    keep(found);
+
+    if (!correct) {
+        std::printf("active counts were wrong\n");
+        return 1;
+    }
+    return 0;
+}
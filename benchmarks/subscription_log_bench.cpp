@@ -0,0 +1,178 @@
+// SubscriptionLog on the file system of the given directory, by default
+// the temporary one, so run it on the disk the application uses. Reports:
+// - commit throughput at several appender counts, with records per fsync
+//   and append() latency percentiles; with one appender each append is
+//   one write and one fsync, so its latency is the fsync latency;
+// - recovery time for logs of several sizes, behind a snapshot;
+// - recovery of logs damaged the ways a crash or a bad disk leaves them:
+//   a torn last record, and a byte changed halfway through.
+//
+//   subscription_log_bench [directory] [--quick]
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "subscription_log.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    SubscriptionEntry entry(size_t n) {
+        return SubscriptionEntry{"customer" + std::to_string(n) + "@example.com", "tx" + std::to_string(n),
+                                 std::time(nullptr) + 86400};
+    }
+
+    double percentile(std::vector<double>& values, double fraction) {
+        size_t index = std::min(values.size() - 1, size_t(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    // records appended by threads appenders; returns false if any failed
+    bool appendAll(SubscriptionLog& log, size_t threads, size_t records, std::vector<double>* latencies) {
+        std::vector<std::vector<double>> perThread(threads);
+        std::vector<char> failed(threads, 0);
+        std::vector<std::thread> appenders;
+        for (size_t t = 0; t < threads; ++t) {
+            appenders.emplace_back([&, t]() {
+                for (size_t n = t; n < records; n += threads) {
+                    auto start = std::chrono::steady_clock::now();
+                    failed[t] |= log.append(entry(n)) ? 0 : 1;
+                    perThread[t].push_back(secondsSince(start) * 1e6);
+                }
+            });
+        }
+        for (std::thread& appender : appenders) {
+            appender.join();
+        }
+        if (latencies) {
+            for (const std::vector<double>& values : perThread) {
+                latencies->insert(latencies->end(), values.begin(), values.end());
+            }
+        }
+        return std::count(failed.begin(), failed.end(), 1) == 0;
+    }
+
+    uint64_t recoverTimed(const std::string& directory, double& ms) {
+        SubscriptionLog log(directory);
+        size_t applied = 0;
+        log.recover([&](const SubscriptionEntry& e) { applied += e.email.size() > 0 ? 1 : 0; });
+        ms = log.stats().recoveryMs;
+        keep(applied);
+        return log.stats().recoveredRecords;
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    fs::path base = fs::temp_directory_path();
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) != "--quick") {
+            base = argv[i];
+        }
+    }
+    std::string directory = (base / "subscription_log_bench").string();
+    std::printf("log in %s\n", directory.c_str());
+
+    std::printf("\ncommit throughput\n");
+    std::printf("  %-9s %10s %12s %9s %9s %9s\n", "appenders", "records/s", "per fsync", "p50 us", "p99 us",
+                "max us");
+    size_t records = quick ? 200 : 4000;
+    for (size_t threads : {1, 4, 16, 64}) {
+        fs::remove_all(directory);
+        SubscriptionLog log(directory);
+        if (!log.start()) {
+            std::printf("cannot open %s\n", directory.c_str());
+            return 1;
+        }
+        std::vector<double> latencies;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = appendAll(log, threads, records, &latencies);
+        double seconds = secondsSince(start);
+        SubscriptionLogStats stats = log.stats();
+        log.stop();
+        if (!ok) {
+            std::printf("append failed\n");
+            return 1;
+        }
+        double maximum = *std::max_element(latencies.begin(), latencies.end());
+        std::printf("  %-9zu %10.0f %12.1f %9.1f %9.1f %9.1f\n", threads, records / seconds,
+                    double(stats.records) / stats.commits, percentile(latencies, 0.5), percentile(latencies, 0.99),
+                    maximum);
+    }
+
+    // Logs written by 64 appenders, so building them takes few fsyncs.
+    // The log compacts before it reaches SNAPSHOT_THRESHOLD records, so
+    // a longer plain log is that one repeated; its records stand alone.
+    // The snapshot case writes size records more than a compaction.
+    std::printf("\nrecovery\n");
+    std::printf("  %-34s %9s %9s %9s\n", "files", "records", "ms", "MB/s");
+    std::vector<size_t> sizes = quick ? std::vector<size_t>{1000} : std::vector<size_t>{1000, 100000};
+    std::string wal = (fs::path(directory) / "subscriptions.wal").string();
+    std::string snapshotFile = (fs::path(directory) / "subscriptions.snapshot").string();
+    std::string largest;
+    for (size_t size : sizes) {
+        for (bool snapshot : {false, true}) {
+            size_t limit = SubscriptionLog::SNAPSHOT_THRESHOLD - 1;
+            fs::remove_all(directory);
+            {
+                SubscriptionLog log(directory);
+                log.start();
+                if (!appendAll(log, 64, snapshot ? size + SubscriptionLog::SNAPSHOT_THRESHOLD : std::min(size, limit),
+                               nullptr)) {
+                    std::printf("append failed\n");
+                    return 1;
+                }
+                log.stop();
+            }
+            if (!snapshot && size > limit) {
+                std::ifstream in(wal, std::ios::binary);
+                std::string one((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                std::string repeated;
+                for (size_t written = 0; written < size; written += limit) {
+                    repeated += one;
+                }
+                std::ofstream(wal, std::ios::binary | std::ios::trunc).write(repeated.data(), repeated.size());
+            }
+            uintmax_t bytes = fs::file_size(wal) + (fs::exists(snapshotFile) ? fs::file_size(snapshotFile) : 0);
+            if (!snapshot) {
+                std::ifstream in(wal, std::ios::binary);
+                largest.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            double ms = 0;
+            uint64_t recovered = recoverTimed(directory, ms);
+            std::string name = std::string(snapshot ? "snapshot + log, " : "log, ") + std::to_string(size) + " records";
+            std::printf("  %-34s %9llu %9.2f %9.0f\n", name.c_str(), static_cast<unsigned long long>(recovered), ms,
+                        bytes / ms / 1e3);
+        }
+    }
+
+    // The largest plain log, damaged; recovery replays up to the damage
+    // and truncates the log there
+    std::printf("\nrecovery of the largest log, damaged\n");
+    std::printf("  %-34s %9s %9s\n", "damage", "records", "ms");
+    for (int kind = 0; kind < 2; ++kind) {
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+        std::string bytes = largest;
+        if (kind == 0) {
+            bytes.resize(bytes.size() - 7);
+        } else {
+            bytes[bytes.size() / 2] = static_cast<char>(bytes[bytes.size() / 2] ^ 0x20);
+        }
+        std::ofstream(wal, std::ios::binary).write(bytes.data(), bytes.size());
+        double ms = 0;
+        uint64_t recovered = recoverTimed(directory, ms);
+        std::printf("  %-34s %9llu %9.2f   log now %llu of %zu bytes\n",
+                    kind == 0 ? "torn last record" : "byte changed halfway",
+                    static_cast<unsigned long long>(recovered), ms,
+                    static_cast<unsigned long long>(fs::file_size(wal)), bytes.size());
+    }
+    fs::remove_all(directory);
+    return 0;
+}
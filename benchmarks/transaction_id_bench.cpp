@@ -0,0 +1,46 @@
+// IDs per second from TransactionIdGenerator::next() at several thread
+// counts, and how far the issued timestamps ran ahead of the clock.
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "transaction_id.h"
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    const size_t perThread = quick ? 20000 : 2000000;
+    unsigned maxThreads = std::max(8u, std::thread::hardware_concurrency());
+
+    std::printf("%zu IDs per thread\n", perThread);
+    std::printf("  %-7s %10s %12s %10s\n", "threads", "M IDs/s", "ns per ID", "ahead ms");
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        TransactionIdGenerator generator(TransactionIdGenerator::randomNode());
+        std::atomic<uint64_t> newest{0};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                uint64_t last = 0;
+                for (size_t i = 0; i < perThread; ++i) {
+                    last = generator.next();
+                }
+                uint64_t seen = newest.load();
+                while (last > seen && !newest.compare_exchange_weak(seen, last)) {
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        double seconds = secondsSince(start);
+
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        int64_t clockMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+        int64_t ahead = static_cast<int64_t>(TransactionIdGenerator::timestampMs(newest.load())) - clockMs;
+        double ids = double(threads) * perThread;
+        std::printf("  %-7u %10.2f %12.1f %10lld\n", threads, ids / seconds / 1e6, seconds * 1e9 / ids,
+                    static_cast<long long>(std::max<int64_t>(ahead, 0)));
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// utf8ToUtf16 and utf16ToUtf8 throughput on the kinds of text the UI
+// shows: plain ASCII, mostly-ASCII European text with accents and the odd
+// emoji, and CJK. MB/s counts the input bytes of each direction. Output
+// strings are reused between calls, as the UI code reuses them.
+//
+//   utf_transcode_bench [--quick]
+#include <random>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "utf_transcode.h"
+
+namespace {
+    const size_t TEXT_BYTES = 1 << 20;
+
+    void appendUtf8(uint32_t codePoint, std::string& out) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    // Words of 2-10 letters separated by spaces, with a line break now and
+    // then. percentAccented of the letters come from Latin-1 and
+    // percentEmoji of the words are followed by an emoji.
+    std::string latinText(std::mt19937& random, uint32_t percentAccented, uint32_t percentEmoji) {
+        static const uint32_t ACCENTED[] = {0xE9, 0xE8, 0xE0, 0xFC, 0xF6, 0xE4, 0xF1, 0xE7, 0xDF, 0xF8};
+        std::string text;
+        while (text.size() < TEXT_BYTES) {
+            uint32_t letters = 2 + random() % 9;
+            for (uint32_t k = 0; k < letters; ++k) {
+                if (random() % 100 < percentAccented) {
+                    appendUtf8(ACCENTED[random() % 10], text);
+                } else {
+                    text += static_cast<char>('a' + random() % 26);
+                }
+            }
+            if (random() % 100 < percentEmoji) {
+                appendUtf8(0x1F600 + random() % 80, text);
+            }
+            text += random() % 12 == 0 ? '\n' : ' ';
+        }
+        return text;
+    }
+
+    // CJK ideographs with an ASCII comma or digit now and then
+    std::string cjkText(std::mt19937& random) {
+        std::string text;
+        while (text.size() < TEXT_BYTES) {
+            if (random() % 20 == 0) {
+                text += random() % 2 ? ',' : static_cast<char>('0' + random() % 10);
+            } else {
+                appendUtf8(0x4E00 + random() % 0x5200, text);
+            }
+        }
+        return text;
+    }
+
+    void run(const char* name, const std::string& text, size_t rounds) {
+        std::u16string units;
+        std::string bytes;
+        utf8ToUtf16(text, units);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            keep(utf8ToUtf16(text, units));
+        }
+        double decodeSeconds = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            keep(utf16ToUtf8(units, bytes));
+        }
+        double encodeSeconds = secondsSince(start);
+
+        std::printf("  %-24s %9.2f %12.0f %12.0f\n", name, double(units.size()) / text.size(),
+                    double(text.size()) * rounds / decodeSeconds / 1e6,
+                    double(units.size()) * 2 * rounds / encodeSeconds / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = quickRun(argc, argv);
+    size_t rounds = quick ? 2 : 200;
+    std::mt19937 random(5);
+
+    std::printf("1 MB of UTF-8 per text; MB/s of input\n");
+    std::printf("  %-24s %9s %12s %12s\n", "text", "units/B", "8->16 MB/s", "16->8 MB/s");
+    run("ASCII", latinText(random, 0, 0), rounds);
+    run("mixed, 2% accented", latinText(random, 2, 1), rounds);
+    run("mixed, 15% accented", latinText(random, 15, 3), rounds);
+    run("CJK", cjkText(random), rounds);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "capture_pipeline.h"
+#include <algorithm>
+
+static int64_t steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CapturePipeline::CapturePipeline(std::unique_ptr<FrameSource> source, const CapturePipelineConfig& config)
+    : m_source(std::move(source))
+    , m_config(config)
+    , m_pool(std::max<size_t>(config.poolSize, 1))
+{
+}
+
+CapturePipeline::~CapturePipeline() {
+    stop();
+}
+
+std::shared_ptr<FrameRing> CapturePipeline::subscribe(size_t capacity) {
+    auto ring = std::make_shared<FrameRing>(capacity);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stats.ended) {
+        ring->close();
+    }
+    m_rings.push_back(ring);
+    return ring;
+}
+
+void CapturePipeline::unsubscribe(const std::shared_ptr<FrameRing>& ring) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rings.erase(std::remove(m_rings.begin(), m_rings.end(), ring), m_rings.end());
+    ring->close();
+}
+
+bool CapturePipeline::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable() || !m_source) {
+        return false;
+    }
+    m_stopping = false;
+    m_running = true;
+    m_thread = std::thread(&CapturePipeline::run, this);
+    return true;
+}
+
+void CapturePipeline::stop() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        stopped = std::move(m_thread);
+    }
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+    closeRings();
+}
+
+bool CapturePipeline::running() const {
+    return m_running;
+}
+
+CapturePipelineStats CapturePipeline::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CapturePipelineStats result = m_stats;
+    for (const auto& ring : m_rings) {
+        result.consumerDrops += ring->stats().dropped;
+    }
+    return result;
+}
+
+void CapturePipeline::run() {
+    while (!m_stopping) {
+        FrameHandle frame = m_pool.acquire(m_config.bufferWait);
+        if (!frame) {
+            // Consumers hold every frame. The source keeps its own backlog
+            // (DXGI accumulates, timed sources count skipped frames), so
+            // nothing is lost silently while we wait.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.bufferStalls;
+            continue;
+        }
+
+        FrameInfo& info = frame.writableInfo();
+        CaptureStatus status = m_source->capture(frame.writableBuffer(), info, m_config.captureTimeout);
+        if (status == CaptureStatus::Captured) {
+            info.sequence = ++m_sequence;
+            info.captureTimeUs = steadyMicros();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_stats.captured;
+                m_stats.sourceMissed += info.missedFrames;
+                m_stats.lastPresentTimeUs = info.presentTimeUs;
+            }
+            publish(frame);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (status == CaptureStatus::Ended) {
+            m_stats.ended = true;
+            break;
+        }
+        if (status == CaptureStatus::Timeout) {
+            ++m_stats.timeouts;
+        } else {
+            ++m_stats.errors;
+        }
+    }
+
+    m_running = false;
+    closeRings();
+}
+
+void CapturePipeline::publish(const FrameHandle& frame) {
+    // Pushing under the lock keeps a ring from being unsubscribed midway;
+    // pushes never block so the lock is only held briefly
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& ring : m_rings) {
+        ring->push(frame);
+    }
+}
+
+void CapturePipeline::closeRings() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& ring : m_rings) {
+        ring->close();
+    }
+}
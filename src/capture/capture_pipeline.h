@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "frame_pool.h"
+#include "frame_ring.h"
+#include "frame_source.h"
+
+struct CapturePipelineConfig {
+    size_t poolSize = 6;                                // Frames shared by the capture thread and all consumers
+    std::chrono::milliseconds captureTimeout{100};      // Longest single wait on the source
+    std::chrono::milliseconds bufferWait{50};           // Wait for a free frame before counting a stall
+};
+
+struct CapturePipelineStats {
+    uint64_t captured;          // Frames published to consumers
+    uint64_t sourceMissed;      // Frames the source produced but never delivered
+    uint64_t bufferStalls;      // Waits that found every pooled frame still held
+    uint64_t consumerDrops;     // Frames overwritten in consumer rings
+    uint64_t timeouts;
+    uint64_t errors;
+    int64_t lastPresentTimeUs;
+    bool ended;                 // The source ran out of frames
+};
+
+// Runs a FrameSource on its own thread and publishes each frame to every
+// subscriber's ring. Frames live in a fixed pool and are shared by handle,
+// so the only copy per frame is the source writing into a pooled buffer.
+// Consumers that fall behind lose their oldest queued frames; they never
+// slow the capture thread or other consumers.
+class CapturePipeline {
+public:
+    CapturePipeline(std::unique_ptr<FrameSource> source, const CapturePipelineConfig& config = {});
+    ~CapturePipeline();
+    CapturePipeline(const CapturePipeline&) = delete;
+    CapturePipeline& operator=(const CapturePipeline&) = delete;
+
+    // New consumer queue holding up to capacity frames. Rings are closed
+    // when the pipeline stops or the source ends.
+    std::shared_ptr<FrameRing> subscribe(size_t capacity = 2);
+    void unsubscribe(const std::shared_ptr<FrameRing>& ring);
+
+    bool start();
+    void stop();
+    bool running() const;
+
+    CapturePipelineStats stats() const;
+
+private:
+    void run();
+    void publish(const FrameHandle& frame);
+    void closeRings();
+
+    std::unique_ptr<FrameSource> m_source;
+    CapturePipelineConfig m_config;
+    FramePool m_pool;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<FrameRing>> m_rings;
+    std::thread m_thread;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<bool> m_running{false};
+
+    uint64_t m_sequence = 0;
+    CapturePipelineStats m_stats = {};
+};
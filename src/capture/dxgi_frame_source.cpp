@@ -0,0 +1,191 @@
+#ifdef _WIN32
+#include "dxgi_frame_source.h"
+#include <cstring>
+
+DxgiFrameSource::DxgiFrameSource(ID3D11Device* device, ID3D11DeviceContext* context,
+                                 IDXGIOutputDuplication* duplication, UINT output)
+    : m_device(device)
+    , m_context(context)
+    , m_duplication(duplication)
+    , m_output(output)
+{
+    m_device->AddRef();
+    m_context->AddRef();
+    QueryPerformanceFrequency(&m_qpcFrequency);
+}
+
+DxgiFrameSource::~DxgiFrameSource() {
+    releaseDuplication();
+    if (m_staging) {
+        m_staging->Release();
+    }
+    m_context->Release();
+    m_device->Release();
+}
+
+HRESULT DxgiFrameSource::createDuplication(ID3D11Device* device, UINT output, IDXGIOutputDuplication** duplication) {
+    *duplication = nullptr;
+    IDXGIDevice* dxgiDevice = nullptr;
+    IDXGIAdapter* adapter = nullptr;
+    IDXGIOutput* dxgiOutput = nullptr;
+    IDXGIOutput1* output1 = nullptr;
+
+    HRESULT hr = device->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(&dxgiDevice));
+    if (SUCCEEDED(hr)) {
+        hr = dxgiDevice->GetAdapter(&adapter);
+    }
+    if (SUCCEEDED(hr)) {
+        hr = adapter->EnumOutputs(output, &dxgiOutput);
+    }
+    if (SUCCEEDED(hr)) {
+        hr = dxgiOutput->QueryInterface(__uuidof(IDXGIOutput1), reinterpret_cast<void**>(&output1));
+    }
+    if (SUCCEEDED(hr)) {
+        hr = output1->DuplicateOutput(device, duplication);
+    }
+
+    if (output1) output1->Release();
+    if (dxgiOutput) dxgiOutput->Release();
+    if (adapter) adapter->Release();
+    if (dxgiDevice) dxgiDevice->Release();
+    return hr;
+}
+
+void DxgiFrameSource::releaseDuplication() {
+    if (m_duplication) {
+        m_duplication->Release();
+        m_duplication = nullptr;
+    }
+    m_needFull = true;
+}
+
+bool DxgiFrameSource::ensureStaging(const D3D11_TEXTURE2D_DESC& desc) {
+    if (m_staging && m_stagingDesc.Width == desc.Width && m_stagingDesc.Height == desc.Height
+        && m_stagingDesc.Format == desc.Format) {
+        return true;
+    }
+    if (m_staging) {
+        m_staging->Release();
+        m_staging = nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC staging = {};
+    staging.Width = desc.Width;
+    staging.Height = desc.Height;
+    staging.MipLevels = 1;
+    staging.ArraySize = 1;
+    staging.Format = desc.Format;
+    staging.SampleDesc.Count = 1;
+    staging.Usage = D3D11_USAGE_STAGING;
+    staging.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    if (FAILED(m_device->CreateTexture2D(&staging, nullptr, &m_staging))) {
+        m_staging = nullptr;
+        return false;
+    }
+    m_stagingDesc = staging;
+    m_needFull = true;
+    return true;
+}
+
+void DxgiFrameSource::readRegions(const DXGI_OUTDUPL_FRAME_INFO& frameInfo, FrameRegions& regions) {
+    regions.clear();
+    bool full = m_needFull;
+    m_needFull = false;
+    if (full || frameInfo.TotalMetadataBufferSize == 0) {
+        return;
+    }
+
+    // Moves first, then dirty rects after them in the same buffer
+    m_metadata.resize(frameInfo.TotalMetadataBufferSize);
+    UINT moveBytes = 0;
+    UINT dirtyBytes = 0;
+    if (FAILED(m_duplication->GetFrameMoveRects(static_cast<UINT>(m_metadata.size()),
+            reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(m_metadata.data()), &moveBytes))
+        || FAILED(m_duplication->GetFrameDirtyRects(static_cast<UINT>(m_metadata.size()) - moveBytes,
+            reinterpret_cast<RECT*>(m_metadata.data() + moveBytes), &dirtyBytes))) {
+        return;
+    }
+
+    const DXGI_OUTDUPL_MOVE_RECT* moves = reinterpret_cast<const DXGI_OUTDUPL_MOVE_RECT*>(m_metadata.data());
+    for (UINT i = 0; i < moveBytes / sizeof(DXGI_OUTDUPL_MOVE_RECT); ++i) {
+        const RECT& to = moves[i].DestinationRect;
+        regions.moves.push_back(FrameMove{moves[i].SourcePoint.x, moves[i].SourcePoint.y,
+                                          FrameRect{to.left, to.top, to.right, to.bottom}});
+    }
+    const RECT* dirty = reinterpret_cast<const RECT*>(m_metadata.data() + moveBytes);
+    for (UINT i = 0; i < dirtyBytes / sizeof(RECT); ++i) {
+        regions.dirty.push_back(FrameRect{dirty[i].left, dirty[i].top, dirty[i].right, dirty[i].bottom});
+    }
+    regions.full = false;
+}
+
+CaptureStatus DxgiFrameSource::capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) {
+    if (!m_duplication && FAILED(createDuplication(m_device, m_output, &m_duplication))) {
+        // Usually the secure desktop is up; try again on the next call
+        Sleep(static_cast<DWORD>(timeout.count()));
+        return CaptureStatus::Error;
+    }
+
+    DXGI_OUTDUPL_FRAME_INFO frameInfo;
+    IDXGIResource* resource = nullptr;
+    HRESULT hr = m_duplication->AcquireNextFrame(static_cast<UINT>(timeout.count()), &frameInfo, &resource);
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
+        return CaptureStatus::Timeout;
+    }
+    if (FAILED(hr)) {
+        if (hr == DXGI_ERROR_ACCESS_LOST) {
+            releaseDuplication();
+        }
+        return CaptureStatus::Error;
+    }
+
+    // Only the pointer moved
+    if (frameInfo.LastPresentTime.QuadPart == 0) {
+        resource->Release();
+        m_duplication->ReleaseFrame();
+        return CaptureStatus::Timeout;
+    }
+
+    ID3D11Texture2D* desktop = nullptr;
+    hr = resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&desktop));
+    resource->Release();
+    bool copied = false;
+    if (SUCCEEDED(hr)) {
+        D3D11_TEXTURE2D_DESC desc;
+        desktop->GetDesc(&desc);
+        // HDR desktops are duplicated as FP16; only 8-bit BGRA is handled
+        if (desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM && ensureStaging(desc)) {
+            m_context->CopyResource(m_staging, desktop);
+            readRegions(frameInfo, info.regions);
+            copied = true;
+        }
+        desktop->Release();
+    }
+    // Hand the desktop image back to DWM before the slow readback
+    m_duplication->ReleaseFrame();
+    if (!copied) {
+        m_needFull = true;
+        return CaptureStatus::Error;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(m_staging, 0, D3D11_MAP_READ, 0, &mapped))) {
+        m_needFull = true;
+        return CaptureStatus::Error;
+    }
+    target.allocate(m_stagingDesc.Width, m_stagingDesc.Height);
+    size_t rowBytes = size_t(m_stagingDesc.Width) * FrameBuffer::BYTES_PER_PIXEL;
+    const uint8_t* source = static_cast<const uint8_t*>(mapped.pData);
+    for (UINT y = 0; y < m_stagingDesc.Height; ++y) {
+        std::memcpy(target.row(y), source + size_t(y) * mapped.RowPitch, rowBytes);
+    }
+    m_context->Unmap(m_staging, 0);
+
+    // Split so the tick count times 10^6 cannot overflow
+    LONGLONG ticks = frameInfo.LastPresentTime.QuadPart;
+    LONGLONG frequency = m_qpcFrequency.QuadPart;
+    info.presentTimeUs = (ticks / frequency) * 1000000 + (ticks % frequency) * 1000000 / frequency;
+    info.missedFrames = frameInfo.AccumulatedFrames > 1 ? frameInfo.AccumulatedFrames - 1 : 0;
+    return CaptureStatus::Captured;
+}
+#endif
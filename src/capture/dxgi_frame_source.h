@@ -0,0 +1,52 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <vector>
+#include "frame_source.h"
+
+// Desktop frames through DXGI desktop duplication. Each new desktop image
+// is copied on the GPU into a staging texture that is kept between frames
+// and only recreated when the mode changes, then read back row by row
+// into the target buffer. Pointer-only updates are not frames and report
+// a timeout. When the duplication is lost (mode change, secure desktop,
+// full-screen app) it is recreated on a later capture() call.
+//
+// Each frame carries the move and dirty rects DXGI reports, accumulated
+// over any frames we missed. The first frame after (re)creating the
+// duplication or the staging texture, or after a failed frame, is full.
+//
+// Uses the immediate context from the capture thread, so nothing else may
+// use that context while capturing.
+class DxgiFrameSource : public FrameSource {
+public:
+    // Takes over the caller's reference to duplication, which may be null
+    // to have the source create it. device and context are AddRef'd.
+    DxgiFrameSource(ID3D11Device* device, ID3D11DeviceContext* context,
+                    IDXGIOutputDuplication* duplication = nullptr, UINT output = 0);
+    ~DxgiFrameSource() override;
+    DxgiFrameSource(const DxgiFrameSource&) = delete;
+    DxgiFrameSource& operator=(const DxgiFrameSource&) = delete;
+
+    CaptureStatus capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) override;
+
+    // Duplicate output (adapter-relative index) of device's adapter
+    static HRESULT createDuplication(ID3D11Device* device, UINT output, IDXGIOutputDuplication** duplication);
+
+private:
+    bool ensureStaging(const D3D11_TEXTURE2D_DESC& desc);
+    void releaseDuplication();
+    void readRegions(const DXGI_OUTDUPL_FRAME_INFO& frameInfo, FrameRegions& regions);
+
+    ID3D11Device* m_device;
+    ID3D11DeviceContext* m_context;
+    IDXGIOutputDuplication* m_duplication;
+    UINT m_output;
+    ID3D11Texture2D* m_staging = nullptr;
+    D3D11_TEXTURE2D_DESC m_stagingDesc = {};
+    LARGE_INTEGER m_qpcFrequency = {};
+    std::vector<uint8_t> m_metadata;
+    bool m_needFull = true;
+};
+#endif
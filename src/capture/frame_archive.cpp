@@ -0,0 +1,141 @@
+#include "frame_archive.h"
+#include <algorithm>
+#include <cstring>
+
+static const char MAGIC[4] = {'M', 'A', 'F', 'A'};
+static const uint32_t VERSION = 1;
+// Larger than any packet of a 16384 x 16384 frame; anything above is damage
+static const uint32_t MAX_PACKET = 1u << 31;
+
+static void putU32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+static uint32_t getU32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= uint32_t(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+FrameArchiveWriter::~FrameArchiveWriter() {
+    close();
+}
+
+bool FrameArchiveWriter::open(const std::string& path, const FrameCodecConfig& config) {
+    close();
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        return false;
+    }
+    char header[8];
+    memcpy(header, MAGIC, 4);
+    putU32(header + 4, VERSION);
+    m_file.write(header, sizeof(header));
+    m_encoder = std::make_unique<FrameEncoder>(config);
+    return static_cast<bool>(m_file);
+}
+
+bool FrameArchiveWriter::write(const FrameBuffer& frame, const FrameInfo& info) {
+    if (!m_file || !m_encoder || frame.empty()) {
+        return false;
+    }
+    m_encoder->encode(frame, info, m_packet);
+    char size[4];
+    putU32(size, static_cast<uint32_t>(m_packet.size()));
+    m_file.write(size, sizeof(size));
+    m_file.write(reinterpret_cast<const char*>(m_packet.data()), static_cast<std::streamsize>(m_packet.size()));
+    return static_cast<bool>(m_file);
+}
+
+void FrameArchiveWriter::close() {
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_encoder.reset();
+}
+
+bool FrameArchiveReader::open(const std::string& path) {
+    m_file.close();
+    m_file.clear();
+    m_records.clear();
+    m_keyframes.clear();
+    m_decoder.reset();
+    m_decoded = SIZE_MAX;
+
+    m_file.open(path, std::ios::binary);
+    char header[8];
+    if (!m_file.read(header, sizeof(header)) || memcmp(header, MAGIC, 4) != 0 || getU32(header + 4) != VERSION) {
+        m_file.close();
+        return false;
+    }
+
+    m_file.seekg(0, std::ios::end);
+    std::streamoff end = m_file.tellg();
+    std::streamoff offset = sizeof(header);
+
+    // Only the size and flags of each record are read here
+    while (offset + 5 <= end) {
+        char prefix[5];
+        m_file.seekg(offset);
+        if (!m_file.read(prefix, sizeof(prefix))) {
+            break;
+        }
+        uint32_t size = getU32(prefix);
+        if (size == 0 || size > MAX_PACKET || offset + 4 + size > end) {
+            break;
+        }
+        if (static_cast<uint8_t>(prefix[4]) & 1) {
+            m_keyframes.push_back(m_records.size());
+        }
+        m_records.push_back(Record{offset + 4, size});
+        offset += 4 + size;
+    }
+    m_file.clear();
+    return true;
+}
+
+bool FrameArchiveReader::decodeRecord(size_t index) {
+    const Record& record = m_records[index];
+    m_packet.resize(record.size);
+    m_file.clear();
+    if (!m_file.seekg(record.offset) || !m_file.read(reinterpret_cast<char*>(m_packet.data()), record.size)) {
+        return false;
+    }
+    return m_decoder.decode(m_packet.data(), m_packet.size());
+}
+
+bool FrameArchiveReader::read(size_t index, FrameBuffer& frame, FrameInfo& info) {
+    if (index >= m_records.size()) {
+        return false;
+    }
+    auto after = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), index);
+    if (after == m_keyframes.begin()) {
+        return false;
+    }
+    size_t keyframe = *(after - 1);
+    // Regions only hold when the caller's last frame was the one before
+    bool follows = m_decoded != SIZE_MAX && m_decoded + 1 == index;
+    size_t next = m_decoded != SIZE_MAX && m_decoded >= keyframe && m_decoded <= index ? m_decoded + 1 : keyframe;
+    for (; next <= index; ++next) {
+        if (!decodeRecord(next)) {
+            m_decoded = SIZE_MAX;
+            return false;
+        }
+        m_decoded = next;
+    }
+
+    const FrameBuffer& decoded = m_decoder.frame();
+    frame.allocate(decoded.width(), decoded.height());
+    for (uint32_t y = 0; y < decoded.height(); ++y) {
+        memcpy(frame.row(y), decoded.row(y), size_t(decoded.width()) * FrameBuffer::BYTES_PER_PIXEL);
+    }
+    info = m_decoder.info();
+    if (!follows) {
+        info.regions.clear();
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "frame_codec.h"
+
+// File of FrameEncoder packets: the magic "MAFA", a u32 version, then
+// records of a u32 packet size and the packet. Nothing is written at the
+// end, so a recording cut short by a crash still reads up to its last
+// whole record.
+class FrameArchiveWriter {
+public:
+    FrameArchiveWriter() = default;
+    ~FrameArchiveWriter();
+
+    bool open(const std::string& path, const FrameCodecConfig& config = {});
+    bool isOpen() const { return m_file.is_open(); }
+
+    // Encode and append a frame. False once writing has failed.
+    bool write(const FrameBuffer& frame, const FrameInfo& info);
+    void close();
+
+    FrameEncoderStats stats() const { return m_encoder ? m_encoder->stats() : FrameEncoderStats{}; }
+
+private:
+    std::ofstream m_file;
+    std::unique_ptr<FrameEncoder> m_encoder;
+    std::vector<uint8_t> m_packet;
+};
+
+// Random access into an archive. The records are indexed on open; reading
+// frame n decodes forward from the closest keyframe before it, or from
+// the last frame read when that is nearer, so playing in order decodes
+// each packet once.
+class FrameArchiveReader {
+public:
+    bool open(const std::string& path);
+    bool isOpen() const { return m_file.is_open(); }
+
+    size_t frameCount() const { return m_records.size(); }
+    size_t keyframeCount() const { return m_keyframes.size(); }
+
+    // Decode frame index into frame. Regions are full unless the previous
+    // read was of index - 1. False when the index is out of range or the
+    // archive is corrupt there.
+    bool read(size_t index, FrameBuffer& frame, FrameInfo& info);
+
+private:
+    struct Record {
+        std::streamoff offset;
+        uint32_t size;
+    };
+
+    bool decodeRecord(size_t index);
+
+    std::ifstream m_file;
+    std::vector<Record> m_records;
+    std::vector<size_t> m_keyframes;    // Record indices, ascending
+    std::vector<uint8_t> m_packet;
+    FrameDecoder m_decoder;
+    size_t m_decoded = SIZE_MAX;        // Record in m_decoder, if any
+};
@@ -0,0 +1,56 @@
+#include "frame_arena.h"
+#include <algorithm>
+
+// Overflow blocks are at least this big, so a frame's many small arrays
+// don't each add a block
+static const size_t MIN_BLOCK = 1 << 20;
+
+static size_t roundUp(size_t bytes) {
+    return (bytes + FrameArena::ALIGNMENT - 1) & ~(FrameArena::ALIGNMENT - 1);
+}
+
+FrameArena::FrameArena(size_t initialBytes) {
+    if (initialBytes) {
+        addBlock(initialBytes);
+    }
+}
+
+void FrameArena::addBlock(size_t bytes) {
+    Block block;
+    block.size = roundUp(bytes);
+    block.storage.reset(new uint8_t[block.size + ALIGNMENT - 1]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(block.storage.get());
+    block.data = block.storage.get() + (roundUp(address) - address);
+    m_blocks.push_back(std::move(block));
+    m_offset = 0;
+}
+
+void* FrameArena::allocate(size_t bytes) {
+    bytes = roundUp(std::max<size_t>(bytes, 1));
+    if (m_blocks.empty() || m_blocks.back().size - m_offset < bytes) {
+        addBlock(std::max(bytes, std::max(MIN_BLOCK, m_used)));
+    }
+    void* memory = m_blocks.back().data + m_offset;
+    m_offset += bytes;
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used);
+    return memory;
+}
+
+void FrameArena::reset() {
+    if (m_blocks.size() > 1) {
+        // Replace the pieces with one block that fits the busiest frame
+        m_blocks.clear();
+        addBlock(m_peak);
+    }
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : m_blocks) {
+        total += block.size;
+    }
+    return total;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for the scratch buffers of one frame's processing. Every
+// buffer comes from a few large blocks and reset() frees them all at once.
+// After a reset that followed an overflow the blocks are merged into one
+// big enough for the whole frame, so from the second frame of a given
+// size on the arena allocates nothing.
+//
+// Memory is not initialised and destructors are never run, so it is for
+// plain pixel, label and index arrays only.
+class FrameArena {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    explicit FrameArena(size_t initialBytes = 0);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // bytes of 64-byte aligned memory, valid until reset()
+    void* allocate(size_t bytes);
+
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    void reset();
+
+    // Bytes handed out since the last reset, and reserved in total
+    size_t used() const { return m_used; }
+    size_t capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> storage;
+        uint8_t* data;      // storage rounded up to ALIGNMENT
+        size_t size;
+    };
+
+    void addBlock(size_t bytes);
+
+    std::vector<Block> m_blocks;
+    size_t m_offset = 0;    // Into the last block
+    size_t m_used = 0;
+    size_t m_peak = 0;      // Largest used() so far
+};
@@ -0,0 +1,17 @@
+#include "frame_buffer.h"
+#include <cstdint>
+
+void FrameBuffer::allocate(uint32_t width, uint32_t height) {
+    size_t stride = (size_t(width) * BYTES_PER_PIXEL + ROW_ALIGNMENT - 1) & ~(ROW_ALIGNMENT - 1);
+    size_t bytes = stride * height;
+    if (bytes > m_capacity) {
+        // Over-allocate by one alignment unit and align the start by hand
+        m_storage.reset(new uint8_t[bytes + ROW_ALIGNMENT]);
+        m_capacity = bytes;
+        uintptr_t address = reinterpret_cast<uintptr_t>(m_storage.get());
+        m_data = m_storage.get() + ((ROW_ALIGNMENT - address % ROW_ALIGNMENT) % ROW_ALIGNMENT);
+    }
+    m_width = width;
+    m_height = height;
+    m_stride = stride;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// CPU image in 8-bit BGRA. Rows start on 64-byte boundaries so SIMD
+// kernels can use aligned loads and tiles never share a cache line across
+// rows. Storage is kept when the buffer is reallocated to the same or a
+// smaller size, so pooled buffers stop allocating after the first frame.
+class FrameBuffer {
+public:
+    static const size_t ROW_ALIGNMENT = 64;
+    static const size_t BYTES_PER_PIXEL = 4;
+
+    FrameBuffer() = default;
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    // Contents are unspecified afterwards
+    void allocate(uint32_t width, uint32_t height);
+
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    size_t stride() const { return m_stride; }
+    bool empty() const { return m_width == 0 || m_height == 0; }
+
+    uint8_t* data() { return m_data; }
+    const uint8_t* data() const { return m_data; }
+    uint8_t* row(uint32_t y) { return m_data + y * m_stride; }
+    const uint8_t* row(uint32_t y) const { return m_data + y * m_stride; }
+
+private:
+    std::unique_ptr<uint8_t[]> m_storage;
+    size_t m_capacity = 0;
+    uint8_t* m_data = nullptr;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    size_t m_stride = 0;
+};
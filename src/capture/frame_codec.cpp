@@ -0,0 +1,495 @@
+#include "frame_codec.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "lz_block.h"
+#include "task_pool.h"
+
+static const uint32_t MAX_TILE = 64;
+static const uint32_t MAX_DIMENSION = 16384;
+static const size_t HEADER_BYTES = 1 + 2 + 4 + 4 + 4 + 4 + 8 + 8 + 8;
+static const uint8_t FLAG_KEYFRAME = 1;
+// Fewer tiles than this are cheaper to do on the calling thread
+static const size_t PARALLEL_TILES = 16;
+
+static void put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static void put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+static void put64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+static uint64_t get(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= uint64_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+static void forEachTile(size_t count, const std::function<void(size_t)>& task) {
+    if (count < PARALLEL_TILES) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+    } else {
+        TaskPool::getInstance().parallelFor(count, task);
+    }
+}
+
+// Interleaved BGRA rows to four planes and back. Each plane of screen
+// content is mostly runs, which LZ finds far more easily than the same
+// runs interleaved with three other channels.
+static void splitPlanes(const uint8_t* pixels, size_t stride, uint32_t width, uint32_t height, uint8_t* planes) {
+    size_t area = size_t(width) * height;
+    uint8_t* b = planes;
+    uint8_t* g = planes + area;
+    uint8_t* r = planes + 2 * area;
+    uint8_t* a = planes + 3 * area;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* in = pixels + y * stride;
+        for (uint32_t x = 0; x < width; ++x, in += 4) {
+            *b++ = in[0];
+            *g++ = in[1];
+            *r++ = in[2];
+            *a++ = in[3];
+        }
+    }
+}
+
+static void mergePlanes(const uint8_t* planes, uint32_t width, uint32_t height, uint8_t* pixels, size_t stride) {
+    size_t area = size_t(width) * height;
+    const uint8_t* b = planes;
+    const uint8_t* g = planes + area;
+    const uint8_t* r = planes + 2 * area;
+    const uint8_t* a = planes + 3 * area;
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* out = pixels + y * stride;
+        for (uint32_t x = 0; x < width; ++x, out += 4) {
+            out[0] = *b++;
+            out[1] = *g++;
+            out[2] = *r++;
+            out[3] = *a++;
+        }
+    }
+}
+
+static bool sameTile(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB, uint32_t width, uint32_t height) {
+    for (uint32_t y = 0; y < height; ++y) {
+        if (memcmp(a + y * strideA, b + y * strideB, size_t(width) * 4) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t hashTile(const uint8_t* pixels, size_t stride, uint32_t width, uint32_t height) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    // Four independent lanes so the multiplies overlap
+    uint64_t lanes[4] = {prime, prime * 3, prime * 5, prime * 7};
+    size_t rowBytes = size_t(width) * 4;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + y * stride;
+        size_t x = 0;
+        for (; x + 32 <= rowBytes; x += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                uint64_t word;
+                memcpy(&word, row + x + lane * 8, 8);
+                lanes[lane] = (lanes[lane] ^ word) * 0xFF51AFD7ED558CCDull;
+                lanes[lane] ^= lanes[lane] >> 32;
+            }
+        }
+        for (; x < rowBytes; x += 4) {
+            uint32_t word;
+            memcpy(&word, row + x, 4);
+            lanes[0] = (lanes[0] ^ word) * 0xFF51AFD7ED558CCDull;
+            lanes[0] ^= lanes[0] >> 32;
+        }
+    }
+    uint64_t hash = (uint64_t(width) << 32) | height;
+    for (uint64_t lane : lanes) {
+        hash = (hash ^ lane) * prime;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+void TileDictionary::reset(uint32_t capacity, uint32_t tileSize) {
+    m_capacity = capacity;
+    m_slotBytes = size_t(tileSize) * tileSize * 4;
+    m_entries.clear();
+    m_slots.clear();
+    m_next = 0;
+}
+
+const uint8_t* TileDictionary::find(uint64_t hash, uint32_t width, uint32_t height) const {
+    auto found = m_slots.find(hash);
+    if (found == m_slots.end()) {
+        return nullptr;
+    }
+    const Entry& entry = m_entries[found->second];
+    if (entry.width != width || entry.height != height) {
+        return nullptr;
+    }
+    return &m_pixels[found->second * m_slotBytes];
+}
+
+void TileDictionary::insert(uint64_t hash, const uint8_t* pixels, size_t stride, uint32_t width, uint32_t height) {
+    if (m_capacity == 0) {
+        return;
+    }
+    uint32_t slot = m_next;
+    m_next = (m_next + 1) % m_capacity;
+    if (slot == m_entries.size()) {
+        m_entries.push_back(Entry{});
+        m_pixels.resize(m_entries.size() * m_slotBytes);
+    } else {
+        auto evicted = m_slots.find(m_entries[slot].hash);
+        if (evicted != m_slots.end() && evicted->second == slot) {
+            m_slots.erase(evicted);
+        }
+    }
+    m_entries[slot] = Entry{hash, width, height};
+    m_slots[hash] = slot;
+    uint8_t* out = &m_pixels[slot * m_slotBytes];
+    for (uint32_t y = 0; y < height; ++y) {
+        memcpy(out + size_t(y) * width * 4, pixels + y * stride, size_t(width) * 4);
+    }
+}
+
+FrameEncoder::FrameEncoder(const FrameCodecConfig& config)
+    : m_config(config)
+    , m_damage(std::min(std::max(config.tileSize, 8u), MAX_TILE))
+{
+    m_config.tileSize = m_damage.tileSize();
+    m_config.keyframeInterval = std::max(m_config.keyframeInterval, 1u);
+}
+
+void FrameEncoder::resize(uint32_t width, uint32_t height) {
+    m_width = width;
+    m_height = height;
+    m_damage.reset(width, height);
+    m_previous.allocate(width, height);
+    size_t count = size_t(m_damage.columns()) * m_damage.rows();
+    m_tiles.resize(count);
+    m_hashes.assign(count, 0);
+}
+
+void FrameEncoder::compressTile(const FrameBuffer& frame, uint32_t index) {
+    Tile& tile = m_tiles[index];
+    FrameRect rect = m_damage.tileRect(index % m_damage.columns(), index / m_damage.columns());
+    uint32_t width = static_cast<uint32_t>(rect.width());
+    uint32_t height = static_cast<uint32_t>(rect.height());
+    size_t bytes = size_t(width) * height * 4;
+
+    uint8_t planes[MAX_TILE * MAX_TILE * 4];
+    splitPlanes(frame.row(rect.top) + size_t(rect.left) * 4, frame.stride(), width, height, planes);
+    tile.data.resize(lzCompressBound(bytes));
+    size_t size = lzCompress(planes, bytes, tile.data.data(), std::min(tile.data.size(), bytes - 1));
+    if (size == 0) {
+        tile.coding = TileCoding::Stored;
+        tile.data.assign(planes, planes + bytes);
+    } else {
+        tile.data.resize(size);
+    }
+}
+
+bool FrameEncoder::encode(const FrameBuffer& frame, const FrameInfo& info, std::vector<uint8_t>& packet) {
+    bool keyframe = m_forceKeyframe || m_keyframeDistance + 1 >= m_config.keyframeInterval;
+    if (frame.width() != m_width || frame.height() != m_height) {
+        resize(frame.width(), frame.height());
+        keyframe = true;
+    }
+
+    bool follows = info.sequence == m_sequence + 1;
+    m_sequence = info.sequence;
+    const FrameRegions& regions = info.regions;
+    if (keyframe || !follows || regions.full || !regions.fits(m_width, m_height)) {
+        m_damage.markAll();
+    } else {
+        m_damage.clear();
+        for (const FrameMove& move : regions.moves) {
+            m_damage.mark(move.destination);
+        }
+        for (const FrameRect& rect : regions.dirty) {
+            m_damage.mark(rect);
+        }
+    }
+    if (keyframe) {
+        m_dictionary.reset(m_config.dictionaryTiles, m_config.tileSize);
+        m_keyframeDistance = 0;
+        m_forceKeyframe = false;
+    } else {
+        ++m_keyframeDistance;
+    }
+
+    uint32_t columns = m_damage.columns();
+    m_work.clear();
+    for (uint32_t i = 0; i < m_tiles.size(); ++i) {
+        m_tiles[i].coding = TileCoding::Same;
+        if (m_damage.isDamaged(i % columns, i / columns)) {
+            m_work.push_back(i);
+        }
+    }
+    forEachTile(m_work.size(), [&](size_t k) {
+        uint32_t i = m_work[k];
+        FrameRect rect = m_damage.tileRect(i % columns, i / columns);
+        m_tiles[i].hash = hashTile(frame.row(rect.top) + size_t(rect.left) * 4, frame.stride(),
+                                   static_cast<uint32_t>(rect.width()), static_cast<uint32_t>(rect.height()));
+    });
+
+    // Dictionary lookups and inserts must happen in tile order so the
+    // decoder can repeat them, so this pass is serial
+    size_t literals = 0;
+    for (uint32_t i : m_work) {
+        Tile& tile = m_tiles[i];
+        FrameRect rect = m_damage.tileRect(i % columns, i / columns);
+        uint32_t width = static_cast<uint32_t>(rect.width());
+        uint32_t height = static_cast<uint32_t>(rect.height());
+        const uint8_t* pixels = frame.row(rect.top) + size_t(rect.left) * 4;
+        const uint8_t* previous = m_previous.row(rect.top) + size_t(rect.left) * 4;
+        const uint8_t* known = m_dictionary.find(tile.hash, width, height);
+        if (!keyframe && tile.hash == m_hashes[i] && sameTile(pixels, frame.stride(), previous, m_previous.stride(), width, height)) {
+            tile.coding = TileCoding::Same;
+        } else if (known && sameTile(pixels, frame.stride(), known, size_t(width) * 4, width, height)) {
+            tile.coding = TileCoding::Reference;
+        } else {
+            tile.coding = TileCoding::Literal;
+            m_dictionary.insert(tile.hash, pixels, frame.stride(), width, height);
+            m_work[literals++] = i;
+        }
+        m_hashes[i] = tile.hash;
+        if (tile.coding != TileCoding::Same) {
+            for (uint32_t y = 0; y < height; ++y) {
+                memcpy(m_previous.row(rect.top + y) + size_t(rect.left) * 4, pixels + y * frame.stride(), size_t(width) * 4);
+            }
+        }
+    }
+    m_work.resize(literals);
+    forEachTile(m_work.size(), [&](size_t k) { compressTile(frame, m_work[k]); });
+
+    packet.clear();
+    packet.push_back(keyframe ? FLAG_KEYFRAME : 0);
+    put16(packet, static_cast<uint16_t>(m_config.tileSize));
+    put32(packet, m_config.dictionaryTiles);
+    put32(packet, m_keyframeDistance);
+    put32(packet, m_width);
+    put32(packet, m_height);
+    put64(packet, info.sequence);
+    put64(packet, static_cast<uint64_t>(info.presentTimeUs));
+    put64(packet, static_cast<uint64_t>(info.captureTimeUs));
+    for (const Tile& tile : m_tiles) {
+        packet.push_back(static_cast<uint8_t>(tile.coding));
+        switch (tile.coding) {
+            case TileCoding::Same:
+                ++m_stats.sameTiles;
+                break;
+            case TileCoding::Reference:
+                put64(packet, tile.hash);
+                ++m_stats.referenceTiles;
+                break;
+            case TileCoding::Literal:
+                put32(packet, static_cast<uint32_t>(tile.data.size()));
+                packet.insert(packet.end(), tile.data.begin(), tile.data.end());
+                ++m_stats.literalTiles;
+                break;
+            case TileCoding::Stored:
+                packet.insert(packet.end(), tile.data.begin(), tile.data.end());
+                ++m_stats.storedTiles;
+                break;
+        }
+    }
+
+    ++m_stats.frames;
+    m_stats.keyframes += keyframe ? 1 : 0;
+    m_stats.rawBytes += uint64_t(m_width) * m_height * 4;
+    m_stats.packetBytes += packet.size();
+    return keyframe;
+}
+
+FrameDecoder::FrameDecoder() : m_damage(MAX_TILE) {
+}
+
+bool FrameDecoder::isKeyframe(const uint8_t* packet, size_t size) {
+    return size >= HEADER_BYTES && (packet[0] & FLAG_KEYFRAME) != 0;
+}
+
+bool FrameDecoder::decodeTile(uint32_t index) {
+    Tile& tile = m_tiles[index];
+    FrameRect rect = m_damage.tileRect(index % m_damage.columns(), index / m_damage.columns());
+    uint32_t width = static_cast<uint32_t>(rect.width());
+    uint32_t height = static_cast<uint32_t>(rect.height());
+    size_t bytes = size_t(width) * height * 4;
+    uint8_t* pixels = m_frame.row(rect.top) + size_t(rect.left) * 4;
+
+    if (tile.coding == TileCoding::Stored) {
+        if (tile.size != bytes) {
+            return false;
+        }
+        mergePlanes(tile.data, width, height, pixels, m_frame.stride());
+    } else {
+        uint8_t planes[MAX_TILE * MAX_TILE * 4];
+        if (!lzDecompress(tile.data, tile.size, planes, bytes)) {
+            return false;
+        }
+        mergePlanes(planes, width, height, pixels, m_frame.stride());
+    }
+    tile.hash = hashTile(pixels, m_frame.stride(), width, height);
+    return true;
+}
+
+bool FrameDecoder::decode(const uint8_t* packet, size_t size) {
+    if (size < HEADER_BYTES) {
+        return false;
+    }
+    bool keyframe = (packet[0] & FLAG_KEYFRAME) != 0;
+    uint32_t tileSize = static_cast<uint32_t>(get(packet + 1, 2));
+    uint32_t dictionaryTiles = static_cast<uint32_t>(get(packet + 3, 4));
+    uint32_t keyframeDistance = static_cast<uint32_t>(get(packet + 7, 4));
+    uint32_t width = static_cast<uint32_t>(get(packet + 11, 4));
+    uint32_t height = static_cast<uint32_t>(get(packet + 15, 4));
+    if (tileSize < 8 || tileSize > MAX_TILE || width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+        m_valid = false;
+        return false;
+    }
+
+    if (keyframe) {
+        if (keyframeDistance != 0) {
+            m_valid = false;
+            return false;
+        }
+        if (tileSize != m_tileSize) {
+            m_tileSize = tileSize;
+            m_damage = TileDamage(tileSize);
+        }
+        m_frame.allocate(width, height);
+        m_damage.reset(width, height);
+        m_dictionary.reset(dictionaryTiles, tileSize);
+    } else if (!m_valid || keyframeDistance != m_keyframeDistance + 1 || tileSize != m_tileSize
+               || width != m_frame.width() || height != m_frame.height()) {
+        m_valid = false;
+        return false;
+    }
+    // Whatever happens next, the picture is no longer the previous frame
+    m_valid = false;
+
+    // Walk the tile entries once to find each payload
+    uint32_t columns = m_damage.columns();
+    m_tiles.resize(size_t(columns) * m_damage.rows());
+    m_work.clear();
+    const uint8_t* in = packet + HEADER_BYTES;
+    const uint8_t* end = packet + size;
+    for (uint32_t i = 0; i < m_tiles.size(); ++i) {
+        if (in == end) {
+            return false;
+        }
+        Tile& tile = m_tiles[i];
+        tile.coding = static_cast<TileCoding>(*in++);
+        tile.data = in;
+        FrameRect rect = m_damage.tileRect(i % columns, i / columns);
+        size_t bytes = size_t(rect.width()) * rect.height() * 4;
+        switch (tile.coding) {
+            case TileCoding::Same:
+                if (keyframe) {
+                    return false;
+                }
+                tile.size = 0;
+                break;
+            case TileCoding::Reference:
+                if (end - in < 8) {
+                    return false;
+                }
+                tile.hash = get(in, 8);
+                tile.size = 8;
+                break;
+            case TileCoding::Literal:
+                if (end - in < 4) {
+                    return false;
+                }
+                tile.size = static_cast<uint32_t>(get(in, 4));
+                tile.data = in + 4;
+                if (size_t(end - tile.data) < tile.size) {
+                    return false;
+                }
+                in += 4;
+                m_work.push_back(i);
+                break;
+            case TileCoding::Stored:
+                tile.size = static_cast<uint32_t>(bytes);
+                if (size_t(end - in) < bytes) {
+                    return false;
+                }
+                m_work.push_back(i);
+                break;
+            default:
+                return false;
+        }
+        in += tile.size;
+    }
+    if (in != end) {
+        return false;
+    }
+
+    // Literal tiles don't depend on each other and decode in parallel;
+    // references then replay the encoder's dictionary in tile order
+    std::atomic<bool> intact{true};
+    forEachTile(m_work.size(), [&](size_t k) {
+        if (!decodeTile(m_work[k])) {
+            intact = false;
+        }
+    });
+    if (!intact) {
+        return false;
+    }
+
+    if (keyframe) {
+        m_damage.markAll();
+    } else {
+        m_damage.clear();
+    }
+    for (uint32_t i = 0; i < m_tiles.size(); ++i) {
+        const Tile& tile = m_tiles[i];
+        if (tile.coding == TileCoding::Same) {
+            continue;
+        }
+        FrameRect rect = m_damage.tileRect(i % columns, i / columns);
+        uint32_t tileWidth = static_cast<uint32_t>(rect.width());
+        uint32_t tileHeight = static_cast<uint32_t>(rect.height());
+        uint8_t* pixels = m_frame.row(rect.top) + size_t(rect.left) * 4;
+        if (tile.coding == TileCoding::Reference) {
+            const uint8_t* known = m_dictionary.find(tile.hash, tileWidth, tileHeight);
+            if (!known) {
+                return false;
+            }
+            for (uint32_t y = 0; y < tileHeight; ++y) {
+                memcpy(pixels + y * m_frame.stride(), known + size_t(y) * tileWidth * 4, size_t(tileWidth) * 4);
+            }
+        } else {
+            m_dictionary.insert(tile.hash, pixels, m_frame.stride(), tileWidth, tileHeight);
+        }
+        m_damage.mark(rect);
+    }
+
+    m_info.sequence = get(packet + 19, 8);
+    m_info.presentTimeUs = static_cast<int64_t>(get(packet + 27, 8));
+    m_info.captureTimeUs = static_cast<int64_t>(get(packet + 35, 8));
+    m_info.missedFrames = 0;
+    m_info.regions.clear();
+    m_info.regions.full = keyframe;
+    if (!keyframe) {
+        m_damage.runs(m_info.regions.dirty);
+    }
+    m_keyframeDistance = keyframeDistance;
+    m_valid = true;
+    return true;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "frame_buffer.h"
+#include "frame_regions.h"
+#include "frame_source.h"
+
+// Delta codec for storing captured screen frames. A frame is cut into
+// tiles and each tile is coded as one of
+//   Same       unchanged since the previous frame
+//   Reference  identical to a tile in the dictionary, found by hash
+//   Literal    LZ-compressed (lz_block.h), as separate B, G, R, A planes
+//   Stored     raw planes, when LZ doesn't help
+// The dictionary holds recently coded tiles, so a slide that comes back
+// or a scrolled block that lands on the tile grid costs 9 bytes a tile.
+// Keyframes code no tile as Same and clear the dictionary first, so
+// decoding can start at any keyframe.
+//
+// Packet layout, little endian:
+//   u8  flags                  bit 0 keyframe
+//   u16 tileSize
+//   u32 dictionaryTiles
+//   u32 keyframeDistance       packets since the last keyframe
+//   u32 width, height
+//   u64 sequence, presentTimeUs, captureTimeUs
+//   per tile, row by row: u8 coding, then nothing (Same), u64 hash
+//   (Reference), u32 size and the block (Literal) or the planes (Stored)
+
+struct FrameCodecConfig {
+    uint32_t tileSize = 64;             // 8 to 64; one tile must fit an LZ block
+    uint32_t keyframeInterval = 300;    // Frames between keyframes, 10 s at 30 fps
+    uint32_t dictionaryTiles = 1024;    // Tiles kept for references, 16 MiB at 64 px
+};
+
+enum class TileCoding : uint8_t {
+    Same = 0,
+    Reference = 1,
+    Literal = 2,
+    Stored = 3
+};
+
+// Recently coded tiles by hash, evicted oldest first. Encoder and decoder
+// make the same inserts in the same order, so their dictionaries agree
+// without the packets describing them.
+class TileDictionary {
+public:
+    void reset(uint32_t capacity, uint32_t tileSize);
+
+    // Tightly packed BGRA pixels of the newest tile with this hash and
+    // shape, or nullptr
+    const uint8_t* find(uint64_t hash, uint32_t width, uint32_t height) const;
+    void insert(uint64_t hash, const uint8_t* pixels, size_t stride, uint32_t width, uint32_t height);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    uint32_t m_capacity = 0;
+    size_t m_slotBytes = 0;
+    std::vector<Entry> m_entries;
+    std::vector<uint8_t> m_pixels;
+    std::unordered_map<uint64_t, uint32_t> m_slots;
+    uint32_t m_next = 0;
+};
+
+struct FrameEncoderStats {
+    uint64_t frames;
+    uint64_t keyframes;
+    uint64_t sameTiles;
+    uint64_t referenceTiles;
+    uint64_t literalTiles;
+    uint64_t storedTiles;
+    uint64_t rawBytes;          // BGRA bytes of the frames encoded
+    uint64_t packetBytes;
+};
+
+// Not thread-safe; tiles are hashed and compressed across the TaskPool
+class FrameEncoder {
+public:
+    explicit FrameEncoder(const FrameCodecConfig& config = {});
+
+    // Replace packet with the coded frame. Dirty regions in info spare
+    // hashing tiles that can't have changed. Returns true for a keyframe.
+    bool encode(const FrameBuffer& frame, const FrameInfo& info, std::vector<uint8_t>& packet);
+
+    // Make the next frame a keyframe
+    void forceKeyframe() { m_forceKeyframe = true; }
+
+    const FrameEncoderStats& stats() const { return m_stats; }
+
+private:
+    struct Tile {
+        TileCoding coding;
+        uint64_t hash;
+        std::vector<uint8_t> data;  // Block or planes, reused between frames
+    };
+
+    void resize(uint32_t width, uint32_t height);
+    void compressTile(const FrameBuffer& frame, uint32_t index);
+
+    FrameCodecConfig m_config;
+    TileDictionary m_dictionary;
+    TileDamage m_damage;
+    FrameBuffer m_previous;         // Last frame's pixels, for verifying Same
+    std::vector<Tile> m_tiles;
+    std::vector<uint64_t> m_hashes; // Tile hashes of the last frame
+    std::vector<uint32_t> m_work;   // Tile indices for the current parallel pass
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint64_t m_sequence = 0;
+    uint32_t m_keyframeDistance = 0;
+    bool m_forceKeyframe = true;
+    FrameEncoderStats m_stats = {};
+};
+
+// Rebuilds frames from packets. Not thread-safe.
+class FrameDecoder {
+public:
+    FrameDecoder();
+
+    // Decode the next packet. The first must be a keyframe and every later
+    // packet up to the next keyframe must follow in order. Returns false
+    // for corrupt packets or packets out of order; decoding then resumes
+    // at a keyframe.
+    bool decode(const uint8_t* packet, size_t size);
+
+    // The decoded picture and its info; regions cover the tiles that were
+    // not Same
+    const FrameBuffer& frame() const { return m_frame; }
+    const FrameInfo& info() const { return m_info; }
+
+    void reset() { m_valid = false; }
+
+    static bool isKeyframe(const uint8_t* packet, size_t size);
+
+private:
+    struct Tile {
+        TileCoding coding;
+        const uint8_t* data;
+        uint32_t size;
+        uint64_t hash;
+    };
+
+    bool decodeTile(uint32_t index);
+
+    FrameBuffer m_frame;
+    FrameInfo m_info;
+    TileDictionary m_dictionary;
+    TileDamage m_damage;
+    std::vector<Tile> m_tiles;
+    std::vector<uint32_t> m_work;
+    uint32_t m_tileSize = 0;
+    uint32_t m_keyframeDistance = 0;
+    bool m_valid = false;
+};
+
+// 64-bit hash of a width x height BGRA tile, shape included
+uint64_t hashTile(const uint8_t* pixels, size_t stride, uint32_t width, uint32_t height);
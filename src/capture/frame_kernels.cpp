@@ -0,0 +1,247 @@
+#include "frame_kernels_impl.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#ifdef FRAME_KERNELS_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+    uint64_t sumAbsDiffScalar(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                              uint32_t rowBytes, uint32_t rows) {
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < rows; ++y, a += strideA, b += strideB) {
+            uint32_t row = 0;
+            for (uint32_t x = 0; x < rowBytes; ++x) {
+                row += static_cast<uint32_t>(std::abs(a[x] - b[x]));
+            }
+            sum += row;
+        }
+        return sum;
+    }
+
+    void bgraToGrayScalar(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                          uint32_t width, uint32_t height) {
+        for (uint32_t y = 0; y < height; ++y, src += srcStride, dst += dstStride) {
+            for (uint32_t x = 0; x < width; ++x) {
+                dst[x] = grayPixel(src + x * 4);
+            }
+        }
+    }
+
+    void bgraToI420Scalar(const uint8_t* src, size_t srcStride, uint8_t* y, size_t yStride,
+                          uint8_t* u, uint8_t* v, size_t uvStride, uint32_t width, uint32_t height) {
+        for (uint32_t row = 0; row < height; ++row) {
+            const uint8_t* in = src + row * srcStride;
+            uint8_t* out = y + row * yStride;
+            for (uint32_t x = 0; x < width; ++x) {
+                out[x] = lumaPixel(in + x * 4);
+            }
+        }
+        uint32_t blocks = (width + 1) / 2;
+        for (uint32_t row = 0; row < (height + 1) / 2; ++row) {
+            const uint8_t* row0 = src + size_t(2 * row) * srcStride;
+            const uint8_t* row1 = 2 * row + 1 < height ? row0 + srcStride : row0;
+            i420ChromaScalar(row0, row1, u + row * uvStride, v + row * uvStride, width, 0, blocks);
+        }
+    }
+
+    void boxDownscaleGrayScalar(const uint8_t* src, size_t srcStride, uint32_t width, uint32_t height,
+                                uint32_t factor, uint8_t* dst, size_t dstStride) {
+        uint32_t outWidth = width / factor;
+        size_t count = size_t(outWidth) * factor;
+        std::unique_ptr<uint16_t[]> sums(new uint16_t[count]);
+        for (uint32_t row = 0; row < height / factor; ++row) {
+            std::fill(sums.get(), sums.get() + count, 0);
+            for (uint32_t k = 0; k < factor; ++k) {
+                const uint8_t* in = src + size_t(row * factor + k) * srcStride;
+                for (size_t x = 0; x < count; ++x) {
+                    sums[x] = static_cast<uint16_t>(sums[x] + in[x]);
+                }
+            }
+            boxHorizontalScalar(sums.get(), dst + row * dstStride, factor, 0, outWidth);
+        }
+    }
+
+    void bilinearScaleGrayScalar(const uint8_t* src, size_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+                                 uint8_t* dst, size_t dstStride, uint32_t dstWidth, uint32_t dstHeight) {
+        std::unique_ptr<int32_t[]> xIndex(new int32_t[dstWidth]);
+        std::unique_ptr<int32_t[]> yIndex(new int32_t[dstHeight]);
+        std::unique_ptr<uint16_t[]> xWeight(new uint16_t[dstWidth]);
+        std::unique_ptr<uint16_t[]> yWeight(new uint16_t[dstHeight]);
+        bilinearAxis(srcWidth, dstWidth, xIndex.get(), xWeight.get());
+        bilinearAxis(srcHeight, dstHeight, yIndex.get(), yWeight.get());
+        std::unique_ptr<uint16_t[]> column(new uint16_t[srcWidth + 1]);
+        for (uint32_t row = 0; row < dstHeight; ++row) {
+            const uint8_t* top = src + size_t(yIndex[row]) * srcStride;
+            const uint8_t* bottom = yIndex[row] + 1 < static_cast<int32_t>(srcHeight) ? top + srcStride : top;
+            uint32_t wy = yWeight[row];
+            for (uint32_t x = 0; x < srcWidth; ++x) {
+                column[x] = static_cast<uint16_t>((top[x] * (256 - wy) + bottom[x] * wy + 128) >> 8);
+            }
+            column[srcWidth] = column[srcWidth - 1];
+            uint8_t* out = dst + row * dstStride;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                uint32_t wx = xWeight[x];
+                out[x] = static_cast<uint8_t>((column[xIndex[x]] * (256 - wx) + column[xIndex[x] + 1] * wx + 128) >> 8);
+            }
+        }
+    }
+
+    bool cpuSupportsAvx2(bool& sse41) {
+        sse41 = false;
+#ifdef FRAME_KERNELS_X86
+        unsigned int regs[4] = {};
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(info[i]);
+#else
+        __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        sse41 = (regs[2] & (1u << 19)) != 0;
+        bool osxsave = (regs[2] & (1u << 27)) != 0;
+        bool avx = (regs[2] & (1u << 28)) != 0;
+        if (!osxsave || !avx) {
+            return false;
+        }
+
+        // The OS must save the YMM registers on context switches
+#if defined(_MSC_VER)
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned int xcrLow, xcrHigh;
+        __asm__ volatile("xgetbv" : "=a"(xcrLow), "=d"(xcrHigh) : "c"(0));
+        unsigned long long xcr0 = (static_cast<unsigned long long>(xcrHigh) << 32) | xcrLow;
+#endif
+        if ((xcr0 & 0x6) != 0x6) {
+            return false;
+        }
+
+#if defined(_MSC_VER)
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+        return (regs[1] & (1u << 5)) != 0;
+#endif
+#else
+        return false;
+#endif
+    }
+
+    std::atomic<const KernelTable*> activeTable{nullptr};
+    std::atomic<KernelIsa> activeIsa{KernelIsa::Scalar};
+}
+
+const KernelTable SCALAR_KERNELS = {
+    sumAbsDiffScalar,
+    bgraToGrayScalar,
+    bgraToI420Scalar,
+    boxDownscaleGrayScalar,
+    bilinearScaleGrayScalar
+};
+
+void i420ChromaScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v,
+                      uint32_t width, uint32_t fromBlock, uint32_t toBlock) {
+    for (uint32_t block = fromBlock; block < toBlock; ++block) {
+        uint32_t left = 2 * block;
+        uint32_t right = left + 1 < width ? left + 1 : left;
+        const uint8_t* p[4] = {row0 + left * 4, row0 + right * 4, row1 + left * 4, row1 + right * 4};
+        int b = p[0][0] + p[1][0] + p[2][0] + p[3][0];
+        int g = p[0][1] + p[1][1] + p[2][1] + p[3][1];
+        int r = p[0][2] + p[1][2] + p[2][2] + p[3][2];
+        u[block] = chromaU(b, g, r);
+        v[block] = chromaV(b, g, r);
+    }
+}
+
+void boxHorizontalScalar(const uint16_t* sums, uint8_t* out, uint32_t factor, uint32_t from, uint32_t to) {
+    uint32_t shift = factor == 2 ? 2 : (factor == 4 ? 4 : 6);
+    uint32_t round = 1u << (shift - 1);
+    for (uint32_t x = from; x < to; ++x) {
+        uint32_t sum = 0;
+        for (uint32_t k = 0; k < factor; ++k) {
+            sum += sums[x * factor + k];
+        }
+        out[x] = static_cast<uint8_t>((sum + round) >> shift);
+    }
+}
+
+void bilinearAxis(uint32_t srcSize, uint32_t dstSize, int32_t* index, uint16_t* weight) {
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        // Centre of output pixel i in source coordinates, 16.16 fixed point
+        int64_t position = ((int64_t(2 * i + 1) * srcSize) << 15) / dstSize - 32768;
+        position = std::max<int64_t>(position, 0);
+        int64_t first = position >> 16;
+        if (first >= int64_t(srcSize) - 1) {
+            index[i] = static_cast<int32_t>(srcSize - 1);
+            weight[i] = 0;
+        } else {
+            index[i] = static_cast<int32_t>(first);
+            weight[i] = static_cast<uint16_t>((position >> 8) & 0xff);
+        }
+    }
+}
+
+KernelIsa detectKernelIsa() {
+    bool sse41;
+    bool avx2 = cpuSupportsAvx2(sse41);
+    return avx2 ? KernelIsa::Avx2 : (sse41 ? KernelIsa::Sse41 : KernelIsa::Scalar);
+}
+
+const KernelTable& kernelTable(KernelIsa isa) {
+#ifdef FRAME_KERNELS_X86
+    static const KernelIsa supported = detectKernelIsa();
+    if (isa > supported) {
+        isa = supported;
+    }
+    if (isa == KernelIsa::Avx2) {
+        return AVX2_KERNELS;
+    }
+    if (isa == KernelIsa::Sse41) {
+        return SSE41_KERNELS;
+    }
+#endif
+    (void)isa;
+    return SCALAR_KERNELS;
+}
+
+const KernelTable& kernels() {
+    const KernelTable* table = activeTable.load(std::memory_order_acquire);
+    if (!table) {
+        setActiveKernelIsa(detectKernelIsa());
+        table = activeTable.load(std::memory_order_acquire);
+    }
+    return *table;
+}
+
+KernelIsa activeKernelIsa() {
+    kernels();
+    return activeIsa.load(std::memory_order_relaxed);
+}
+
+void setActiveKernelIsa(KernelIsa isa) {
+    const KernelTable& table = kernelTable(isa);
+    KernelIsa chosen = &table == &SCALAR_KERNELS ? KernelIsa::Scalar : isa;
+#ifdef FRAME_KERNELS_X86
+    if (&table == &SSE41_KERNELS) {
+        chosen = KernelIsa::Sse41;
+    }
+#endif
+    activeIsa.store(chosen, std::memory_order_relaxed);
+    activeTable.store(&table, std::memory_order_release);
+}
+
+const char* kernelIsaName(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Avx2: return "AVX2";
+        case KernelIsa::Sse41: return "SSE4.1";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Pixel kernels for captured frames. Each has a scalar reference and, on
+// x86, SSE4.1 and AVX2 versions chosen at startup from CPUID. The SIMD
+// versions are bit-exact with the scalar ones, so results never depend on
+// the machine. Every kernel takes a pointer and stride per plane and works
+// on any sub-rectangle, so callers can split a frame into bands or tiles
+// and run them in parallel.
+
+enum class KernelIsa {
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+struct KernelTable {
+    // Sum of |a - b| over rowBytes x rows bytes
+    uint64_t (*sumAbsDiff)(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                           uint32_t rowBytes, uint32_t rows);
+
+    // Full-range BT.601 luma: (29 B + 150 G + 77 R + 128) >> 8
+    void (*bgraToGray)(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                       uint32_t width, uint32_t height);
+
+    // Limited-range BT.601 I420. Chroma is taken from the rounded mean of
+    // each 2x2 block; odd edges repeat the last row or column.
+    void (*bgraToI420)(const uint8_t* src, size_t srcStride, uint8_t* y, size_t yStride,
+                       uint8_t* u, uint8_t* v, size_t uvStride, uint32_t width, uint32_t height);
+
+    // Mean of factor x factor blocks, factor 2, 4 or 8. The output is
+    // width / factor by height / factor; leftover edge pixels are ignored.
+    void (*boxDownscaleGray)(const uint8_t* src, size_t srcStride, uint32_t width, uint32_t height,
+                             uint32_t factor, uint8_t* dst, size_t dstStride);
+
+    // Bilinear resample to any size with pixel centres aligned, 8-bit
+    // weights, vertical pass first
+    void (*bilinearScaleGray)(const uint8_t* src, size_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+                              uint8_t* dst, size_t dstStride, uint32_t dstWidth, uint32_t dstHeight);
+};
+
+// Best ISA this CPU and OS support
+KernelIsa detectKernelIsa();
+
+// Kernels for isa, falling back to the best supported one below it
+const KernelTable& kernelTable(KernelIsa isa);
+
+// The table used by the free functions below; starts at detectKernelIsa()
+const KernelTable& kernels();
+KernelIsa activeKernelIsa();
+void setActiveKernelIsa(KernelIsa isa);
+
+const char* kernelIsaName(KernelIsa isa);
+
+inline uint64_t sumAbsDiff(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                           uint32_t rowBytes, uint32_t rows) {
+    return kernels().sumAbsDiff(a, strideA, b, strideB, rowBytes, rows);
+}
+
+inline void bgraToGray(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                       uint32_t width, uint32_t height) {
+    kernels().bgraToGray(src, srcStride, dst, dstStride, width, height);
+}
+
+inline void bgraToI420(const uint8_t* src, size_t srcStride, uint8_t* y, size_t yStride,
+                       uint8_t* u, uint8_t* v, size_t uvStride, uint32_t width, uint32_t height) {
+    kernels().bgraToI420(src, srcStride, y, yStride, u, v, uvStride, width, height);
+}
+
+inline void boxDownscaleGray(const uint8_t* src, size_t srcStride, uint32_t width, uint32_t height,
+                             uint32_t factor, uint8_t* dst, size_t dstStride) {
+    kernels().boxDownscaleGray(src, srcStride, width, height, factor, dst, dstStride);
+}
+
+inline void bilinearScaleGray(const uint8_t* src, size_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+                              uint8_t* dst, size_t dstStride, uint32_t dstWidth, uint32_t dstHeight) {
+    kernels().bilinearScaleGray(src, srcStride, srcWidth, srcHeight, dst, dstStride, dstWidth, dstHeight);
+}
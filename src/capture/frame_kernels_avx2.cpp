@@ -0,0 +1,187 @@
+#include "frame_kernels_impl.h"
+
+#ifdef FRAME_KERNELS_X86
+#include <immintrin.h>
+
+namespace {
+    uint64_t sumAbsDiffAvx2(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                            uint32_t rowBytes, uint32_t rows) {
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < rows; ++y, a += strideA, b += strideB) {
+            __m256i acc = _mm256_setzero_si256();
+            uint32_t x = 0;
+            for (; x + 32 <= rowBytes; x += 32) {
+                __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x));
+                __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+            }
+            __m128i folded = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            sum += static_cast<uint64_t>(_mm_cvtsi128_si64(folded)) + static_cast<uint64_t>(_mm_extract_epi64(folded, 1));
+            for (; x < rowBytes; ++x) {
+                sum += static_cast<uint64_t>(a[x] > b[x] ? a[x] - b[x] : b[x] - a[x]);
+            }
+        }
+        return sum;
+    }
+
+    // ((w . bgra) + 128) >> 8 for eight pixels, in pixel order
+    inline __m256i weighEight(const uint8_t* in, __m256i weights) {
+        __m256i low = _mm256_madd_epi16(
+            _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))), weights);
+        __m256i high = _mm256_madd_epi16(
+            _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16))), weights);
+        // hadd works within 128-bit lanes and leaves pixels 0 1 4 5 | 2 3 6 7
+        __m256i sums = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(low, high), _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+        return _mm256_srli_epi32(_mm256_add_epi32(sums, _mm256_set1_epi32(128)), 8);
+    }
+
+    // 16 pixels of weighted luma, plus offset
+    inline __m128i weighSixteen(const uint8_t* in, __m256i weights, __m128i offset) {
+        __m256i words = _mm256_permute4x64_epi64(
+            _mm256_packus_epi32(weighEight(in, weights), weighEight(in + 32, weights)), 0xd8);
+        __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        return _mm_add_epi8(packed, offset);
+    }
+
+    void lumaRows(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                  uint32_t width, uint32_t height, __m256i weights, __m128i offset, uint8_t (*pixel)(const uint8_t*)) {
+        for (uint32_t y = 0; y < height; ++y, src += srcStride, dst += dstStride) {
+            uint32_t x = 0;
+            for (; x + 16 <= width; x += 16) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), weighSixteen(src + x * 4, weights, offset));
+            }
+            for (; x < width; ++x) {
+                dst[x] = pixel(src + x * 4);
+            }
+        }
+    }
+
+    void bgraToGrayAvx2(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                        uint32_t width, uint32_t height) {
+        const __m256i weights = _mm256_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0, 29, 150, 77, 0, 29, 150, 77, 0);
+        lumaRows(src, srcStride, dst, dstStride, width, height, weights, _mm_setzero_si128(), grayPixel);
+    }
+
+    void bgraToI420Avx2(const uint8_t* src, size_t srcStride, uint8_t* y, size_t yStride,
+                        uint8_t* u, uint8_t* v, size_t uvStride, uint32_t width, uint32_t height) {
+        const __m256i weights = _mm256_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0, 25, 129, 66, 0, 25, 129, 66, 0);
+        lumaRows(src, srcStride, y, yStride, width, height, weights, _mm_set1_epi8(16), lumaPixel);
+        // Chroma is a quarter of the output and its 2x2 gathering crosses
+        // lanes badly in 256 bits, so it stays on SSE4.1
+        i420ChromaSse41(src, srcStride, u, v, uvStride, width, height);
+    }
+
+    void verticalSums(const uint8_t* src, size_t srcStride, uint32_t factor, uint32_t count, uint16_t* sums) {
+        uint32_t x = 0;
+        for (; x + 16 <= count; x += 16) {
+            __m256i acc = _mm256_setzero_si256();
+            for (uint32_t k = 0; k < factor; ++k) {
+                acc = _mm256_add_epi16(acc, _mm256_cvtepu8_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k * srcStride + x))));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + x), acc);
+        }
+        for (; x < count; ++x) {
+            uint16_t sum = 0;
+            for (uint32_t k = 0; k < factor; ++k) {
+                sum = static_cast<uint16_t>(sum + src[k * srcStride + x]);
+            }
+            sums[x] = sum;
+        }
+    }
+
+    void boxDownscaleGrayAvx2(const uint8_t* src, size_t srcStride, uint32_t width, uint32_t height,
+                              uint32_t factor, uint8_t* dst, size_t dstStride) {
+        uint32_t outWidth = width / factor;
+        size_t count = size_t(outWidth) * factor;
+        std::unique_ptr<uint16_t[]> sums(new uint16_t[count]);
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i two = _mm256_set1_epi32(2);
+        for (uint32_t row = 0; row < height / factor; ++row) {
+            verticalSums(src + size_t(row) * factor * srcStride, srcStride, factor,
+                         static_cast<uint32_t>(count), sums.get());
+            uint8_t* out = dst + row * dstStride;
+            uint32_t x = 0;
+            if (factor == 2) {
+                for (; x + 16 <= outWidth; x += 16) {
+                    __m256i a = _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&sums[2 * x])), ones);
+                    __m256i b = _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&sums[2 * x + 16])), ones);
+                    a = _mm256_srli_epi32(_mm256_add_epi32(a, two), 2);
+                    b = _mm256_srli_epi32(_mm256_add_epi32(b, two), 2);
+                    __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+                    __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), packed);
+                }
+            }
+            boxHorizontalScalar(sums.get(), out, factor, x, outWidth);
+        }
+    }
+
+    void bilinearScaleGrayAvx2(const uint8_t* src, size_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+                               uint8_t* dst, size_t dstStride, uint32_t dstWidth, uint32_t dstHeight) {
+        std::unique_ptr<int32_t[]> xIndex(new int32_t[dstWidth]);
+        std::unique_ptr<int32_t[]> yIndex(new int32_t[dstHeight]);
+        std::unique_ptr<uint16_t[]> xWeight(new uint16_t[dstWidth]);
+        std::unique_ptr<uint16_t[]> yWeight(new uint16_t[dstHeight]);
+        bilinearAxis(srcWidth, dstWidth, xIndex.get(), xWeight.get());
+        bilinearAxis(srcHeight, dstHeight, yIndex.get(), yWeight.get());
+
+        // Both horizontal weights per output pixel, (256 - wx) | wx << 16,
+        // for one madd per gathered pair
+        std::unique_ptr<int32_t[]> xPair(new int32_t[dstWidth]);
+        for (uint32_t i = 0; i < dstWidth; ++i) {
+            xPair[i] = static_cast<int32_t>((256 - xWeight[i]) | (uint32_t(xWeight[i]) << 16));
+        }
+        // One spare lane past the padding so a 32-bit gather at the last
+        // index stays inside the buffer
+        std::unique_ptr<uint16_t[]> column(new uint16_t[srcWidth + 2]());
+        const __m256i round16 = _mm256_set1_epi16(128);
+        const __m256i round32 = _mm256_set1_epi32(128);
+
+        for (uint32_t row = 0; row < dstHeight; ++row) {
+            const uint8_t* top = src + size_t(yIndex[row]) * srcStride;
+            const uint8_t* bottom = yIndex[row] + 1 < static_cast<int32_t>(srcHeight) ? top + srcStride : top;
+            uint32_t wy = yWeight[row];
+            __m256i weightTop = _mm256_set1_epi16(static_cast<short>(256 - wy));
+            __m256i weightBottom = _mm256_set1_epi16(static_cast<short>(wy));
+            uint32_t x = 0;
+            for (; x + 16 <= srcWidth; x += 16) {
+                __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x)));
+                __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x)));
+                __m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, weightTop),
+                                                                _mm256_mullo_epi16(b, weightBottom)), round16);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&column[x]), _mm256_srli_epi16(sum, 8));
+            }
+            for (; x < srcWidth; ++x) {
+                column[x] = static_cast<uint16_t>((top[x] * (256 - wy) + bottom[x] * wy + 128) >> 8);
+            }
+            column[srcWidth] = column[srcWidth - 1];
+
+            // A 32-bit gather at column[i] fetches both taps at once
+            const int* base = reinterpret_cast<const int*>(column.get());
+            uint8_t* out = dst + row * dstStride;
+            uint32_t i = 0;
+            for (; i + 8 <= dstWidth; i += 8) {
+                __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&xIndex[i]));
+                __m256i taps = _mm256_i32gather_epi32(base, index, 2);
+                __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&xPair[i]));
+                __m256i value = _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(taps, weights), round32), 8);
+                __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+            }
+            for (; i < dstWidth; ++i) {
+                uint32_t wx = xWeight[i];
+                out[i] = static_cast<uint8_t>((column[xIndex[i]] * (256 - wx) + column[xIndex[i] + 1] * wx + 128) >> 8);
+            }
+        }
+    }
+}
+
+const KernelTable AVX2_KERNELS = {
+    sumAbsDiffAvx2,
+    bgraToGrayAvx2,
+    bgraToI420Avx2,
+    boxDownscaleGrayAvx2,
+    bilinearScaleGrayAvx2
+};
+#endif
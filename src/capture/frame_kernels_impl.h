@@ -0,0 +1,62 @@
+#pragma once
+// Shared between the scalar and SIMD kernel translation units. The SIMD
+// files are compiled with their own instruction set flags and must only
+// be called after detectKernelIsa() allows it. Helpers defined here are
+// static and the SIMD files avoid std::vector, so the linker can never
+// pick an AVX2-compiled copy of a shared inline function for scalar code.
+#include <cstdint>
+#include <memory>
+#include "frame_kernels.h"
+
+// The SIMD paths use 64-bit-only intrinsics
+#if defined(_M_X64) || defined(__x86_64__)
+#define FRAME_KERNELS_X86 1
+#endif
+
+extern const KernelTable SCALAR_KERNELS;
+#ifdef FRAME_KERNELS_X86
+extern const KernelTable SSE41_KERNELS;
+extern const KernelTable AVX2_KERNELS;
+#endif
+
+static inline uint8_t grayPixel(const uint8_t* bgra) {
+    return static_cast<uint8_t>((29 * bgra[0] + 150 * bgra[1] + 77 * bgra[2] + 128) >> 8);
+}
+
+static inline uint8_t lumaPixel(const uint8_t* bgra) {
+    return static_cast<uint8_t>(((25 * bgra[0] + 129 * bgra[1] + 66 * bgra[2] + 128) >> 8) + 16);
+}
+
+// From channel sums of a 2x2 block
+static inline uint8_t chromaU(int b, int g, int r) {
+    b = (b + 2) >> 2;
+    g = (g + 2) >> 2;
+    r = (r + 2) >> 2;
+    return static_cast<uint8_t>(((112 * b - 74 * g - 38 * r + 128) >> 8) + 128);
+}
+
+static inline uint8_t chromaV(int b, int g, int r) {
+    b = (b + 2) >> 2;
+    g = (g + 2) >> 2;
+    r = (r + 2) >> 2;
+    return static_cast<uint8_t>(((-18 * b - 94 * g + 112 * r + 128) >> 8) + 128);
+}
+
+// Chroma blocks [fromBlock, toBlock) of one output row from two BGRA
+// rows (the same row twice at an odd bottom edge)
+void i420ChromaScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v,
+                      uint32_t width, uint32_t fromBlock, uint32_t toBlock);
+
+#ifdef FRAME_KERNELS_X86
+// Chroma planes of bgraToI420 with SSE4.1, shared by the AVX2 version
+void i420ChromaSse41(const uint8_t* src, size_t srcStride, uint8_t* u, uint8_t* v, size_t uvStride,
+                     uint32_t width, uint32_t height);
+#endif
+
+// Horizontal step of the box filter over vertical u16 sums, for output
+// pixels [from, to)
+void boxHorizontalScalar(const uint16_t* sums, uint8_t* out, uint32_t factor, uint32_t from, uint32_t to);
+
+// Source index and 8-bit weight of the second tap for each output pixel
+// along one axis
+void bilinearAxis(uint32_t srcSize, uint32_t dstSize, int32_t* index, uint16_t* weight);
@@ -0,0 +1,225 @@
+#include "frame_kernels_impl.h"
+#include <cstring>
+
+#ifdef FRAME_KERNELS_X86
+#include <smmintrin.h>
+
+namespace {
+    uint64_t sumAbsDiffSse41(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                             uint32_t rowBytes, uint32_t rows) {
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < rows; ++y, a += strideA, b += strideB) {
+            __m128i acc = _mm_setzero_si128();
+            uint32_t x = 0;
+            for (; x + 16 <= rowBytes; x += 16) {
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+                __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+            }
+            sum += static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) + static_cast<uint64_t>(_mm_extract_epi64(acc, 1));
+            for (; x < rowBytes; ++x) {
+                sum += static_cast<uint64_t>(a[x] > b[x] ? a[x] - b[x] : b[x] - a[x]);
+            }
+        }
+        return sum;
+    }
+
+    // Weighted sum of B, G, R for four pixels: ((w . bgra) + 128) >> 8
+    inline __m128i weighFour(__m128i pixels, __m128i weights) {
+        __m128i low = _mm_madd_epi16(_mm_cvtepu8_epi16(pixels), weights);
+        __m128i high = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(pixels, 8)), weights);
+        return _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(low, high), _mm_set1_epi32(128)), 8);
+    }
+
+    // 16 pixels of weighted luma, plus offset
+    inline __m128i weighSixteen(const uint8_t* in, __m128i weights, __m128i offset) {
+        __m128i p0 = weighFour(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), weights);
+        __m128i p1 = weighFour(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16)), weights);
+        __m128i p2 = weighFour(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32)), weights);
+        __m128i p3 = weighFour(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 48)), weights);
+        __m128i packed = _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+        return _mm_add_epi8(packed, offset);
+    }
+
+    void bgraToGraySse41(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                         uint32_t width, uint32_t height) {
+        const __m128i weights = _mm_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0);
+        const __m128i zero = _mm_setzero_si128();
+        for (uint32_t y = 0; y < height; ++y, src += srcStride, dst += dstStride) {
+            uint32_t x = 0;
+            for (; x + 16 <= width; x += 16) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), weighSixteen(src + x * 4, weights, zero));
+            }
+            for (; x < width; ++x) {
+                dst[x] = grayPixel(src + x * 4);
+            }
+        }
+    }
+
+    // Sum of each horizontal pixel pair over two rows, as 16-bit BGRA
+    // channel sums for two chroma blocks
+    inline __m128i blockSums(const uint8_t* row0, const uint8_t* row1) {
+        __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+        __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+        __m128i low = _mm_add_epi16(_mm_cvtepu8_epi16(top), _mm_cvtepu8_epi16(bottom));
+        __m128i high = _mm_add_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(top, 8)),
+                                     _mm_cvtepu8_epi16(_mm_srli_si128(bottom, 8)));
+        low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+        high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+        return _mm_unpacklo_epi64(low, high);
+    }
+
+    // Chroma from two blocks' channel sums: ((w . mean) + 128) >> 8 + 128,
+    // arithmetic shift as in the scalar version
+    inline __m128i chromaFour(__m128i sums01, __m128i sums23, __m128i weights) {
+        const __m128i two = _mm_set1_epi16(2);
+        __m128i mean01 = _mm_srli_epi16(_mm_add_epi16(sums01, two), 2);
+        __m128i mean23 = _mm_srli_epi16(_mm_add_epi16(sums23, two), 2);
+        __m128i dot = _mm_hadd_epi32(_mm_madd_epi16(mean01, weights), _mm_madd_epi16(mean23, weights));
+        dot = _mm_srai_epi32(_mm_add_epi32(dot, _mm_set1_epi32(128)), 8);
+        return _mm_add_epi32(dot, _mm_set1_epi32(128));
+    }
+
+    void bgraToI420Sse41(const uint8_t* src, size_t srcStride, uint8_t* y, size_t yStride,
+                         uint8_t* u, uint8_t* v, size_t uvStride, uint32_t width, uint32_t height) {
+        const __m128i lumaWeights = _mm_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0);
+        const __m128i sixteen = _mm_set1_epi8(16);
+        for (uint32_t row = 0; row < height; ++row) {
+            const uint8_t* in = src + row * srcStride;
+            uint8_t* out = y + row * yStride;
+            uint32_t x = 0;
+            for (; x + 16 <= width; x += 16) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), weighSixteen(in + x * 4, lumaWeights, sixteen));
+            }
+            for (; x < width; ++x) {
+                out[x] = lumaPixel(in + x * 4);
+            }
+        }
+
+        i420ChromaSse41(src, srcStride, u, v, uvStride, width, height);
+    }
+
+    // Vertical sums of factor rows into 16-bit lanes
+    void verticalSums(const uint8_t* src, size_t srcStride, uint32_t factor, uint32_t count, uint16_t* sums) {
+        uint32_t x = 0;
+        for (; x + 16 <= count; x += 16) {
+            __m128i low = _mm_setzero_si128();
+            __m128i high = _mm_setzero_si128();
+            for (uint32_t k = 0; k < factor; ++k) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k * srcStride + x));
+                low = _mm_add_epi16(low, _mm_cvtepu8_epi16(in));
+                high = _mm_add_epi16(high, _mm_cvtepu8_epi16(_mm_srli_si128(in, 8)));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x + 8), high);
+        }
+        for (; x < count; ++x) {
+            uint16_t sum = 0;
+            for (uint32_t k = 0; k < factor; ++k) {
+                sum = static_cast<uint16_t>(sum + src[k * srcStride + x]);
+            }
+            sums[x] = sum;
+        }
+    }
+
+    void boxDownscaleGraySse41(const uint8_t* src, size_t srcStride, uint32_t width, uint32_t height,
+                               uint32_t factor, uint8_t* dst, size_t dstStride) {
+        uint32_t outWidth = width / factor;
+        size_t count = size_t(outWidth) * factor;
+        std::unique_ptr<uint16_t[]> sums(new uint16_t[count]);
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i two = _mm_set1_epi32(2);
+        for (uint32_t row = 0; row < height / factor; ++row) {
+            verticalSums(src + size_t(row) * factor * srcStride, srcStride, factor,
+                         static_cast<uint32_t>(count), sums.get());
+            uint8_t* out = dst + row * dstStride;
+            uint32_t x = 0;
+            if (factor == 2) {
+                for (; x + 8 <= outWidth; x += 8) {
+                    __m128i a = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&sums[2 * x])), ones);
+                    __m128i b = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&sums[2 * x + 8])), ones);
+                    a = _mm_srli_epi32(_mm_add_epi32(a, two), 2);
+                    b = _mm_srli_epi32(_mm_add_epi32(b, two), 2);
+                    __m128i packed = _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_setzero_si128());
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), packed);
+                }
+            }
+            boxHorizontalScalar(sums.get(), out, factor, x, outWidth);
+        }
+    }
+
+    void bilinearScaleGraySse41(const uint8_t* src, size_t srcStride, uint32_t srcWidth, uint32_t srcHeight,
+                                uint8_t* dst, size_t dstStride, uint32_t dstWidth, uint32_t dstHeight) {
+        std::unique_ptr<int32_t[]> xIndex(new int32_t[dstWidth]);
+        std::unique_ptr<int32_t[]> yIndex(new int32_t[dstHeight]);
+        std::unique_ptr<uint16_t[]> xWeight(new uint16_t[dstWidth]);
+        std::unique_ptr<uint16_t[]> yWeight(new uint16_t[dstHeight]);
+        bilinearAxis(srcWidth, dstWidth, xIndex.get(), xWeight.get());
+        bilinearAxis(srcHeight, dstHeight, yIndex.get(), yWeight.get());
+        std::unique_ptr<uint16_t[]> column(new uint16_t[srcWidth + 1]);
+        const __m128i round = _mm_set1_epi16(128);
+        for (uint32_t row = 0; row < dstHeight; ++row) {
+            const uint8_t* top = src + size_t(yIndex[row]) * srcStride;
+            const uint8_t* bottom = yIndex[row] + 1 < static_cast<int32_t>(srcHeight) ? top + srcStride : top;
+            uint32_t wy = yWeight[row];
+            // top * (256 - wy) + bottom * wy + 128 is at most 65408, so
+            // it stays within unsigned 16-bit lanes
+            __m128i weightTop = _mm_set1_epi16(static_cast<short>(256 - wy));
+            __m128i weightBottom = _mm_set1_epi16(static_cast<short>(wy));
+            uint32_t x = 0;
+            for (; x + 8 <= srcWidth; x += 8) {
+                __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(top + x)));
+                __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bottom + x)));
+                __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a, weightTop), _mm_mullo_epi16(b, weightBottom)), round);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&column[x]), _mm_srli_epi16(sum, 8));
+            }
+            for (; x < srcWidth; ++x) {
+                column[x] = static_cast<uint16_t>((top[x] * (256 - wy) + bottom[x] * wy + 128) >> 8);
+            }
+            column[srcWidth] = column[srcWidth - 1];
+
+            // Without a gather the horizontal taps stay scalar
+            uint8_t* out = dst + row * dstStride;
+            for (uint32_t i = 0; i < dstWidth; ++i) {
+                uint32_t wx = xWeight[i];
+                out[i] = static_cast<uint8_t>((column[xIndex[i]] * (256 - wx) + column[xIndex[i] + 1] * wx + 128) >> 8);
+            }
+        }
+    }
+}
+
+void i420ChromaSse41(const uint8_t* src, size_t srcStride, uint8_t* u, uint8_t* v, size_t uvStride,
+                     uint32_t width, uint32_t height) {
+    const __m128i uWeights = _mm_setr_epi16(112, -74, -38, 0, 112, -74, -38, 0);
+    const __m128i vWeights = _mm_setr_epi16(-18, -94, 112, 0, -18, -94, 112, 0);
+    uint32_t blocks = (width + 1) / 2;
+    for (uint32_t row = 0; row < (height + 1) / 2; ++row) {
+        const uint8_t* row0 = src + size_t(2 * row) * srcStride;
+        const uint8_t* row1 = 2 * row + 1 < height ? row0 + srcStride : row0;
+        uint8_t* outU = u + row * uvStride;
+        uint8_t* outV = v + row * uvStride;
+        // Four whole blocks (eight pixels) per step
+        uint32_t block = 0;
+        for (; 2 * block + 8 <= width; block += 4) {
+            __m128i sums01 = blockSums(row0 + block * 8, row1 + block * 8);
+            __m128i sums23 = blockSums(row0 + block * 8 + 16, row1 + block * 8 + 16);
+            __m128i cu = chromaFour(sums01, sums23, uWeights);
+            __m128i cv = chromaFour(sums01, sums23, vWeights);
+            __m128i packed = _mm_packus_epi16(_mm_packus_epi32(cu, cv), _mm_setzero_si128());
+            int32_t bytesU = _mm_cvtsi128_si32(packed);
+            int32_t bytesV = _mm_extract_epi32(packed, 1);
+            std::memcpy(outU + block, &bytesU, 4);
+            std::memcpy(outV + block, &bytesV, 4);
+        }
+        i420ChromaScalar(row0, row1, outU, outV, width, block, blocks);
+    }
+}
+
+const KernelTable SSE41_KERNELS = {
+    sumAbsDiffSse41,
+    bgraToGraySse41,
+    bgraToI420Sse41,
+    boxDownscaleGraySse41,
+    bilinearScaleGraySse41
+};
+#endif
@@ -0,0 +1,87 @@
+#include "frame_pool.h"
+
+FrameHandle::FrameHandle(const FrameHandle& other) : m_slot(other.m_slot) {
+    if (m_slot) {
+        m_slot->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept : m_slot(other.m_slot) {
+    other.m_slot = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle other) noexcept {
+    std::swap(m_slot, other.m_slot);
+    return *this;
+}
+
+FrameHandle::~FrameHandle() {
+    reset();
+}
+
+void FrameHandle::reset() {
+    Slot* slot = m_slot;
+    m_slot = nullptr;
+    // acq_rel so every consumer's reads of the pixels happen before the
+    // producer reuses the buffer
+    if (slot && slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        slot->pool->release(slot);
+    }
+}
+
+const FrameBuffer& FrameHandle::buffer() const {
+    return m_slot->buffer;
+}
+
+const FrameInfo& FrameHandle::info() const {
+    return m_slot->info;
+}
+
+FrameBuffer& FrameHandle::writableBuffer() {
+    return m_slot->buffer;
+}
+
+FrameInfo& FrameHandle::writableInfo() {
+    return m_slot->info;
+}
+
+FramePool::FramePool(size_t count) {
+    m_slots.reserve(count);
+    m_free.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        m_slots.push_back(std::make_unique<FrameHandle::Slot>());
+        m_slots.back()->pool = this;
+        m_free.push_back(m_slots.back().get());
+    }
+}
+
+FrameHandle FramePool::acquire(std::chrono::milliseconds wait) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_free.empty() && wait.count() > 0) {
+        m_released.wait_for(lock, wait, [this]() { return !m_free.empty(); });
+    }
+    if (m_free.empty()) {
+        return FrameHandle();
+    }
+    FrameHandle::Slot* slot = m_free.back();
+    m_free.pop_back();
+    slot->refs.store(1, std::memory_order_relaxed);
+    FrameRegions regions = std::move(slot->info.regions);
+    regions.clear();
+    slot->info = FrameInfo();
+    slot->info.regions = std::move(regions);
+    return FrameHandle(slot);
+}
+
+size_t FramePool::available() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_free.size();
+}
+
+void FramePool::release(FrameHandle::Slot* slot) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(slot);
+    }
+    m_released.notify_one();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "frame_source.h"
+
+class FramePool;
+
+// Reference to a pooled frame. Copies share the same pixels; the frame
+// goes back to its pool when the last handle is released, so passing a
+// frame to several consumers never copies the image.
+class FrameHandle {
+public:
+    FrameHandle() = default;
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(FrameHandle other) noexcept;
+    ~FrameHandle();
+
+    explicit operator bool() const { return m_slot != nullptr; }
+    void reset();
+
+    const FrameBuffer& buffer() const;
+    const FrameInfo& info() const;
+
+    // Writable access for the producer. Only valid while this is the sole
+    // handle, i.e. before the frame has been published.
+    FrameBuffer& writableBuffer();
+    FrameInfo& writableInfo();
+
+private:
+    friend class FramePool;
+    struct Slot;
+    explicit FrameHandle(Slot* slot) : m_slot(slot) {}
+
+    Slot* m_slot = nullptr;
+};
+
+// Fixed set of frame buffers recycled between captures. The pool size
+// bounds memory and how far consumers may lag; when every frame is held
+// the producer waits or drops instead of allocating. Handles must be
+// released before the pool is destroyed.
+class FramePool {
+public:
+    explicit FramePool(size_t count);
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // A free frame, or an empty handle if none frees up within wait
+    FrameHandle acquire(std::chrono::milliseconds wait = std::chrono::milliseconds(0));
+
+    size_t size() const { return m_slots.size(); }
+    size_t available() const;
+
+private:
+    friend class FrameHandle;
+    void release(FrameHandle::Slot* slot);
+
+    std::vector<std::unique_ptr<FrameHandle::Slot>> m_slots;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+    std::vector<FrameHandle::Slot*> m_free;
+};
+
+struct FrameHandle::Slot {
+    FrameBuffer buffer;
+    FrameInfo info;
+    std::atomic<uint32_t> refs{0};
+    FramePool* pool = nullptr;
+};
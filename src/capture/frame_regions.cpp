@@ -0,0 +1,132 @@
+#include "frame_regions.h"
+#include <algorithm>
+#include <cstring>
+
+static bool inside(const FrameRect& rect, uint32_t width, uint32_t height) {
+    return rect.left >= 0 && rect.top >= 0 && rect.left <= rect.right && rect.top <= rect.bottom
+        && rect.right <= static_cast<int64_t>(width) && rect.bottom <= static_cast<int64_t>(height);
+}
+
+bool FrameRegions::fits(uint32_t width, uint32_t height) const {
+    for (const FrameMove& move : moves) {
+        FrameRect source = {move.sourceX, move.sourceY,
+                            move.sourceX + move.destination.width(), move.sourceY + move.destination.height()};
+        if (!inside(move.destination, width, height) || !inside(source, width, height)) {
+            return false;
+        }
+    }
+    for (const FrameRect& rect : dirty) {
+        if (!inside(rect, width, height)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TileDamage::TileDamage(uint32_t tileSize) : m_tileSize(std::max<uint32_t>(tileSize, 1)) {
+}
+
+void TileDamage::reset(uint32_t width, uint32_t height) {
+    m_width = width;
+    m_height = height;
+    m_columns = (width + m_tileSize - 1) / m_tileSize;
+    m_rows = (height + m_tileSize - 1) / m_tileSize;
+    m_tiles.assign(size_t(m_columns) * m_rows, 0);
+    markAll();
+}
+
+void TileDamage::clear() {
+    std::fill(m_tiles.begin(), m_tiles.end(), 0);
+    m_count = 0;
+}
+
+void TileDamage::markAll() {
+    std::fill(m_tiles.begin(), m_tiles.end(), 1);
+    m_count = m_tiles.size();
+}
+
+void TileDamage::mark(const FrameRect& rect) {
+    int32_t left = std::max(rect.left, 0);
+    int32_t top = std::max(rect.top, 0);
+    int32_t right = std::min(rect.right, static_cast<int32_t>(m_width));
+    int32_t bottom = std::min(rect.bottom, static_cast<int32_t>(m_height));
+    if (right <= left || bottom <= top) {
+        return;
+    }
+    for (uint32_t row = top / m_tileSize; row <= (bottom - 1) / m_tileSize; ++row) {
+        uint8_t* tile = &m_tiles[size_t(row) * m_columns];
+        for (uint32_t column = left / m_tileSize; column <= (right - 1) / m_tileSize; ++column) {
+            m_count += tile[column] == 0;
+            tile[column] = 1;
+        }
+    }
+}
+
+FrameRect TileDamage::tileRect(uint32_t column, uint32_t row) const {
+    int32_t left = static_cast<int32_t>(column * m_tileSize);
+    int32_t top = static_cast<int32_t>(row * m_tileSize);
+    return FrameRect{left, top,
+                     static_cast<int32_t>(std::min(left + m_tileSize, m_width)),
+                     static_cast<int32_t>(std::min(top + m_tileSize, m_height))};
+}
+
+void TileDamage::runs(std::vector<FrameRect>& out) const {
+    out.clear();
+    for (uint32_t row = 0; row < m_rows; ++row) {
+        uint32_t column = 0;
+        while (column < m_columns) {
+            if (!isDamaged(column, row)) {
+                ++column;
+                continue;
+            }
+            uint32_t first = column;
+            while (column < m_columns && isDamaged(column, row)) {
+                ++column;
+            }
+            FrameRect rect = tileRect(first, row);
+            rect.right = tileRect(column - 1, row).right;
+            out.push_back(rect);
+        }
+    }
+}
+
+void applyMoves(const FrameRegions& regions, uint8_t* plane, size_t stride, size_t bytesPerPixel,
+                std::vector<uint8_t>& scratch) {
+    if (regions.moves.size() == 1) {
+        // In place; walk rows away from the overlap, memmove handles the
+        // horizontal one
+        const FrameMove& move = regions.moves[0];
+        size_t rowBytes = size_t(move.destination.width()) * bytesPerPixel;
+        int32_t height = move.destination.height();
+        bool upwards = move.destination.top > move.sourceY;
+        for (int32_t i = 0; i < height; ++i) {
+            int32_t y = upwards ? height - 1 - i : i;
+            std::memmove(plane + size_t(move.destination.top + y) * stride + size_t(move.destination.left) * bytesPerPixel,
+                         plane + size_t(move.sourceY + y) * stride + size_t(move.sourceX) * bytesPerPixel,
+                         rowBytes);
+        }
+        return;
+    }
+
+    // Every move reads the previous frame, so gather all sources before
+    // writing any destination
+    size_t total = 0;
+    for (const FrameMove& move : regions.moves) {
+        total += size_t(move.destination.width()) * move.destination.height() * bytesPerPixel;
+    }
+    scratch.resize(total);
+    uint8_t* out = scratch.data();
+    for (const FrameMove& move : regions.moves) {
+        size_t rowBytes = size_t(move.destination.width()) * bytesPerPixel;
+        for (int32_t y = 0; y < move.destination.height(); ++y, out += rowBytes) {
+            std::memcpy(out, plane + size_t(move.sourceY + y) * stride + size_t(move.sourceX) * bytesPerPixel, rowBytes);
+        }
+    }
+    const uint8_t* in = scratch.data();
+    for (const FrameMove& move : regions.moves) {
+        size_t rowBytes = size_t(move.destination.width()) * bytesPerPixel;
+        for (int32_t y = move.destination.top; y < move.destination.bottom; ++y, in += rowBytes) {
+            std::memcpy(plane + size_t(y) * stride + size_t(move.destination.left) * bytesPerPixel, in, rowBytes);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Half-open pixel rectangle, laid out like a Win32 RECT
+struct FrameRect {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+
+    int32_t width() const { return right - left; }
+    int32_t height() const { return bottom - top; }
+    bool empty() const { return right <= left || bottom <= top; }
+};
+
+// Pixels now at destination were at (sourceX, sourceY) in the previous frame
+struct FrameMove {
+    int32_t sourceX;
+    int32_t sourceY;
+    FrameRect destination;
+};
+
+// What changed since the source's previous frame, as desktop duplication
+// reports it: moves are applied first, each reading the previous frame,
+// then dirty rects are copied from the new frame. Consumers that missed a
+// frame (sequence gap) must treat the frame as full.
+struct FrameRegions {
+    bool full = true;               // Everything may have changed
+    std::vector<FrameMove> moves;
+    std::vector<FrameRect> dirty;
+
+    // Keeps vector capacity so pooled frames stop allocating
+    void clear() {
+        full = true;
+        moves.clear();
+        dirty.clear();
+    }
+
+    // False when any rect lies outside a width x height frame
+    bool fits(uint32_t width, uint32_t height) const;
+};
+
+// Which tiles of a frame need work. Rects are marked at tile granularity,
+// so a stage iterates just the damaged tiles instead of the whole frame.
+class TileDamage {
+public:
+    explicit TileDamage(uint32_t tileSize = 64);
+
+    // Size for a frame, with every tile damaged
+    void reset(uint32_t width, uint32_t height);
+    void clear();
+    void markAll();
+    void mark(const FrameRect& rect);
+
+    uint32_t tileSize() const { return m_tileSize; }
+    uint32_t columns() const { return m_columns; }
+    uint32_t rows() const { return m_rows; }
+    size_t count() const { return m_count; }
+    bool full() const { return m_count == m_tiles.size(); }
+    bool isDamaged(uint32_t column, uint32_t row) const { return m_tiles[size_t(row) * m_columns + column] != 0; }
+
+    // Tile rectangle clipped to the frame
+    FrameRect tileRect(uint32_t column, uint32_t row) const;
+
+    // Damaged tiles grouped into row-wise runs, so a stage can handle
+    // adjacent tiles with one call
+    void runs(std::vector<FrameRect>& out) const;
+
+private:
+    uint32_t m_tileSize;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_columns = 0;
+    uint32_t m_rows = 0;
+    size_t m_count = 0;
+    std::vector<uint8_t> m_tiles;
+};
+
+// Apply regions' moves to a plane holding the previous frame, with
+// bytesPerPixel bytes per pixel. Derived planes (luma, a frame copy) stay
+// in step with the screen this way for the cost of a memmove instead of
+// recomputing the moved pixels. scratch is reused between calls.
+void applyMoves(const FrameRegions& regions, uint8_t* plane, size_t stride, size_t bytesPerPixel,
+                std::vector<uint8_t>& scratch);
@@ -0,0 +1,56 @@
+#include "frame_ring.h"
+
+FrameRing::FrameRing(size_t capacity) : m_frames(capacity > 0 ? capacity : 1) {
+}
+
+bool FrameRing::push(FrameHandle frame) {
+    FrameHandle dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            return false;
+        }
+        if (m_count == m_frames.size()) {
+            // Released after the lock so a pool waiter isn't woken into it
+            dropped = std::move(m_frames[m_head]);
+            m_head = (m_head + 1) % m_frames.size();
+            --m_count;
+            ++m_stats.dropped;
+        }
+        m_frames[(m_head + m_count) % m_frames.size()] = std::move(frame);
+        ++m_count;
+        ++m_stats.pushed;
+    }
+    m_ready.notify_one();
+    return true;
+}
+
+bool FrameRing::pop(FrameHandle& frame, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_ready.wait_for(lock, timeout, [this]() { return m_count > 0 || m_closed; }) || m_count == 0) {
+        return false;
+    }
+    frame = std::move(m_frames[m_head]);
+    m_head = (m_head + 1) % m_frames.size();
+    --m_count;
+    ++m_stats.popped;
+    return true;
+}
+
+void FrameRing::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_ready.notify_all();
+}
+
+bool FrameRing::closed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_closed;
+}
+
+FrameRingStats FrameRing::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
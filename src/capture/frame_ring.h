@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "frame_pool.h"
+
+struct FrameRingStats {
+    uint64_t pushed;
+    uint64_t popped;
+    uint64_t dropped;       // Frames overwritten before the consumer took them
+};
+
+// Bounded queue of frames for one consumer. When the consumer falls
+// behind, push() drops the oldest queued frame rather than blocking the
+// capture thread, so a slow consumer always sees the most recent screen
+// and holds at most capacity frames of the pool.
+class FrameRing {
+public:
+    explicit FrameRing(size_t capacity);
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Returns false once the ring is closed
+    bool push(FrameHandle frame);
+
+    // Wait up to timeout for a frame. Returns false on timeout, or when
+    // the ring is closed and drained.
+    bool pop(FrameHandle& frame, std::chrono::milliseconds timeout);
+
+    // Wakes waiting consumers; queued frames can still be popped
+    void close();
+    bool closed() const;
+
+    FrameRingStats stats() const;
+
+private:
+    std::vector<FrameHandle> m_frames;
+    size_t m_head = 0;      // Next frame to pop
+    size_t m_count = 0;
+    bool m_closed = false;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    FrameRingStats m_stats = {};
+};
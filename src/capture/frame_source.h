@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "frame_buffer.h"
+#include "frame_regions.h"
+
+struct FrameInfo {
+    uint64_t sequence = 0;          // Assigned by the pipeline, starting at 1
+    int64_t presentTimeUs = 0;      // When the source produced the frame, on the source's clock
+    int64_t captureTimeUs = 0;      // steady_clock time the frame reached the pipeline
+    uint32_t missedFrames = 0;      // Source frames skipped since the previous one
+    FrameRegions regions;           // Changes since the source's previous frame
+};
+
+enum class CaptureStatus {
+    Captured,
+    Timeout,    // Nothing new before the timeout
+    Ended,      // A finite source has no more frames
+    Error       // Capture failed; the source may recover on a later call
+};
+
+// Producer of BGRA frames. capture() is only ever called from one thread.
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Wait up to timeout for the next frame and write it into target,
+    // resizing target to the frame size. Fills every FrameInfo field but
+    // sequence and captureTimeUs. target holds some older frame, so the
+    // whole frame must be written even when regions lists only changes.
+    virtual CaptureStatus capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) = 0;
+};
@@ -0,0 +1,65 @@
+#include "luma_plane.h"
+#include "frame_kernels.h"
+#include "task_pool.h"
+
+// Below this many pixels waking the pool costs more than it saves
+static const size_t PARALLEL_PIXELS = 256 * 1024;
+
+LumaPlane::LumaPlane(uint32_t tileSize) : m_damage(tileSize), m_dirty(tileSize) {
+}
+
+void LumaPlane::resize(uint32_t width, uint32_t height) {
+    m_width = width;
+    m_height = height;
+    m_stride = (size_t(width) + FrameBuffer::ROW_ALIGNMENT - 1) & ~(FrameBuffer::ROW_ALIGNMENT - 1);
+    m_data.reset(new uint8_t[m_stride * height]);
+    m_damage.reset(width, height);
+    m_dirty.reset(width, height);
+}
+
+size_t LumaPlane::update(const FrameBuffer& frame, const FrameInfo& info) {
+    bool follows = m_sequence != 0 && info.sequence == m_sequence + 1;
+    m_sequence = info.sequence;
+    if (frame.width() != m_width || frame.height() != m_height) {
+        resize(frame.width(), frame.height());
+        follows = false;
+    }
+
+    const FrameRegions& regions = info.regions;
+    if (!follows || regions.full || !regions.fits(m_width, m_height)) {
+        m_damage.markAll();
+        m_dirty.markAll();
+    } else {
+        m_damage.clear();
+        m_dirty.clear();
+        if (!regions.moves.empty()) {
+            applyMoves(regions, m_data.get(), m_stride, 1, m_scratch);
+            for (const FrameMove& move : regions.moves) {
+                m_damage.mark(move.destination);
+            }
+        }
+        for (const FrameRect& rect : regions.dirty) {
+            m_dirty.mark(rect);
+            m_damage.mark(rect);
+        }
+    }
+
+    // Runs are one tile row high, so they never overlap and can be
+    // converted in parallel
+    m_dirty.runs(m_runs);
+    size_t tilePixels = size_t(m_dirty.tileSize()) * m_dirty.tileSize();
+    if (m_dirty.count() * tilePixels < PARALLEL_PIXELS) {
+        for (const FrameRect& run : m_runs) {
+            convert(frame, run);
+        }
+    } else {
+        TaskPool::getInstance().parallelFor(m_runs.size(), [&](size_t i) { convert(frame, m_runs[i]); });
+    }
+    return m_dirty.count();
+}
+
+void LumaPlane::convert(const FrameBuffer& frame, const FrameRect& rect) {
+    bgraToGray(frame.row(rect.top) + size_t(rect.left) * FrameBuffer::BYTES_PER_PIXEL, frame.stride(),
+               m_data.get() + size_t(rect.top) * m_stride + rect.left, m_stride,
+               static_cast<uint32_t>(rect.width()), static_cast<uint32_t>(rect.height()));
+}
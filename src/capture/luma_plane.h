@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "frame_regions.h"
+#include "frame_source.h"
+
+// 8-bit luma of the latest frame for analysis stages, kept up to date
+// from each frame's regions: dirty tiles are converted from BGRA, moved
+// areas are copied within the plane, and everything else is left as is.
+// On a slide deck most frames only touch the cursor's few tiles.
+//
+// Falls back to converting the whole frame on the first frame, a size
+// change, a full or invalid region list, or a sequence gap (a consumer
+// ring dropped frames, so the regions don't describe our last frame).
+class LumaPlane {
+public:
+    explicit LumaPlane(uint32_t tileSize = 64);
+    LumaPlane(const LumaPlane&) = delete;
+    LumaPlane& operator=(const LumaPlane&) = delete;
+
+    // Bring the plane up to date with frame. Returns the number of tiles
+    // converted from BGRA.
+    size_t update(const FrameBuffer& frame, const FrameInfo& info);
+
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    size_t stride() const { return m_stride; }
+    const uint8_t* data() const { return m_data.get(); }
+    const uint8_t* row(uint32_t y) const { return m_data.get() + y * m_stride; }
+
+    // Tiles whose luma changed in the last update, converted or moved
+    const TileDamage& damage() const { return m_damage; }
+
+private:
+    void resize(uint32_t width, uint32_t height);
+    void convert(const FrameBuffer& frame, const FrameRect& rect);
+
+    std::unique_ptr<uint8_t[]> m_data;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    size_t m_stride = 0;
+    uint64_t m_sequence = 0;
+
+    TileDamage m_damage;
+    TileDamage m_dirty;
+    std::vector<FrameRect> m_runs;
+    std::vector<uint8_t> m_scratch;
+};
@@ -0,0 +1,167 @@
+#include "lz_block.h"
+#include <algorithm>
+#include <cstring>
+
+static const size_t MIN_MATCH = 4;
+static const uint32_t HASH_BITS = 12;
+// Misses in a row before the scan starts skipping ahead, so data that
+// doesn't compress goes through quickly
+static const uint32_t SKIP_TRIGGER = 6;
+
+static inline uint32_t load32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hash4(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Length field continuation: 255s then the remainder
+static inline bool putLength(size_t length, uint8_t*& out, const uint8_t* end) {
+    for (; length >= 255; length -= 255) {
+        if (out == end) {
+            return false;
+        }
+        *out++ = 255;
+    }
+    if (out == end) {
+        return false;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return true;
+}
+
+static inline bool getLength(size_t& length, const uint8_t*& in, const uint8_t* end) {
+    uint8_t byte;
+    do {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+static bool putSequence(const uint8_t* literals, size_t literalCount, size_t matchLength, uint32_t offset,
+                        uint8_t*& out, const uint8_t* end) {
+    if (out == end) {
+        return false;
+    }
+    uint8_t* token = out++;
+    size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    *token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+    if (literalCount >= 15 && !putLength(literalCount - 15, out, end)) {
+        return false;
+    }
+    if (size_t(end - out) < literalCount) {
+        return false;
+    }
+    memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0) {
+        return true;
+    }
+    if (end - out < 2) {
+        return false;
+    }
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    return matchCode < 15 || putLength(matchCode - 15, out, end);
+}
+
+size_t lzCompress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    if (size > LZ_MAX_BLOCK) {
+        return 0;
+    }
+    uint8_t* out = dst;
+    const uint8_t* end = dst + capacity;
+    size_t anchor = 0;
+
+    if (size >= MIN_MATCH + 1) {
+        // Positions + 1, so 0 means empty
+        uint32_t table[1 << HASH_BITS] = {};
+        size_t limit = size - MIN_MATCH;
+        size_t pos = 0;
+        uint32_t misses = 0;
+        while (pos <= limit) {
+            uint32_t value = load32(src + pos);
+            uint32_t& slot = table[hash4(value)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos + 1);
+            if (candidate == 0 || load32(src + candidate - 1) != value) {
+                pos += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+            size_t match = candidate - 1;
+            size_t length = MIN_MATCH;
+            while (pos + length < size && src[match + length] == src[pos + length]) {
+                ++length;
+            }
+            if (!putSequence(src + anchor, pos - anchor, length, static_cast<uint32_t>(pos - match), out, end)) {
+                return 0;
+            }
+            pos += length;
+            anchor = pos;
+            // Index one position inside the match so runs chain on
+            if (pos - 2 <= limit) {
+                table[hash4(load32(src + pos - 2))] = static_cast<uint32_t>(pos - 2 + 1);
+            }
+        }
+    }
+    if (!putSequence(src + anchor, size - anchor, 0, 0, out, end)) {
+        return 0;
+    }
+    return static_cast<size_t>(out - dst);
+}
+
+bool lzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+    const uint8_t* in = src;
+    const uint8_t* inEnd = src + size;
+    uint8_t* out = dst;
+    uint8_t* outEnd = dst + dstSize;
+    while (in < inEnd) {
+        uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(literals, in, inEnd)) {
+            return false;
+        }
+        if (size_t(inEnd - in) < literals || size_t(outEnd - out) < literals) {
+            return false;
+        }
+        memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == inEnd) {
+            break;      // Final sequence
+        }
+
+        if (inEnd - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (size_t(in[1]) << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !getLength(length, in, inEnd)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (offset == 0 || offset > size_t(out - dst) || size_t(outEnd - out) < length) {
+            return false;
+        }
+        // An offset shorter than the length repeats a pattern. Copying
+        // what is already there doubles it each step, so a run of one
+        // colour takes a few memcpys rather than a byte loop.
+        const uint8_t* from = out - offset;
+        while (length > 0) {
+            size_t chunk = std::min(length, size_t(out - from));
+            memcpy(out, from, chunk);
+            out += chunk;
+            length -= chunk;
+        }
+    }
+    return out == outEnd;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Small, fast LZ77 coder for independent blocks of up to 64 KiB, in the
+// style of LZ4: each sequence is a token byte (literal count in the high
+// nibble, match length - 4 in the low), 255-continued length bytes, the
+// literals, and a 16-bit little-endian match offset. The last sequence
+// has literals only. Blocks carry no header; the caller stores the sizes.
+//
+// Screen content is long runs of flat colour and repeated glyphs, which
+// this compresses well at memory speed. Nothing is shared between
+// blocks, so tiles can be coded on any thread in any order.
+
+static const size_t LZ_MAX_BLOCK = 65536;
+
+// Largest output for size bytes of input that doesn't compress
+inline size_t lzCompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Compress size bytes (at most LZ_MAX_BLOCK) into dst. Returns the
+// compressed size, or 0 if it would exceed capacity.
+size_t lzCompress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+
+// Decompress a whole block that must expand to exactly dstSize bytes.
+// Returns false for corrupt input instead of reading or writing out of
+// bounds.
+bool lzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize);
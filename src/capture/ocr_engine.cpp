@@ -0,0 +1,33 @@
+#include "ocr_engine.h"
+
+bool StubOcrEngine::recognize(const OcrImage& image, const FrameRect& region, OcrLine& line) {
+    line.text.clear();
+    line.confidence = 0.0f;
+    if (region.empty() || !image.binary) {
+        return false;
+    }
+
+    int32_t wordGap = region.height() / 2;
+    int32_t gap = 0;
+    bool inGlyph = false;
+    for (int32_t x = region.left; x < region.right; ++x) {
+        bool ink = false;
+        for (int32_t y = region.top; y < region.bottom && !ink; ++y) {
+            ink = image.binary[size_t(y) * image.stride + x] != 0;
+        }
+        if (ink) {
+            if (!inGlyph) {
+                if (!line.text.empty() && gap > wordGap) {
+                    line.text += ' ';
+                }
+                line.text += 'x';
+            }
+            gap = 0;
+        } else {
+            ++gap;
+        }
+        inGlyph = ink;
+    }
+    line.confidence = line.text.empty() ? 0.0f : 1.0f;
+    return !line.text.empty();
+}
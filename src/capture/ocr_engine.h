@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "frame_regions.h"
+
+// A preprocessed page: deskewed 8-bit gray and its binarisation (255 ink,
+// 0 background) with a shared stride
+struct OcrImage {
+    const uint8_t* gray = nullptr;
+    const uint8_t* binary = nullptr;
+    size_t stride = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+struct OcrLine {
+    FrameRect bounds;           // In OcrImage coordinates
+    std::string text;           // UTF-8
+    float confidence = 0.0f;    // 0 to 1
+};
+
+// Text recognition behind the preprocessing, so an engine (Tesseract, the
+// Windows.Media.Ocr API, a service) can be dropped in without touching
+// capture. recognize() is called for one text line at a time, always from
+// the same thread.
+class OcrEngine {
+public:
+    virtual ~OcrEngine() = default;
+
+    // Read the line of text inside region. Returns false when the engine
+    // could not read it; line.bounds is already set.
+    virtual bool recognize(const OcrImage& image, const FrameRect& region, OcrLine& line) = 0;
+};
+
+// Deterministic engine for tests and benchmarks. It "reads" each run of
+// ink columns as the character 'x' and each gap wider than half the line
+// height as a space, so its output depends only on the layout it is given
+// and word counts can be checked against a known page.
+class StubOcrEngine : public OcrEngine {
+public:
+    bool recognize(const OcrImage& image, const FrameRect& region, OcrLine& line) override;
+};
@@ -0,0 +1,506 @@
+#include "ocr_preprocessor.h"
+#include <algorithm>
+#include <cmath>
+#include "frame_kernels.h"
+
+// Gray levels per bin when looking for the background level
+static const uint32_t LEVEL_BIN = 8;
+// Ink samples kept for the skew search; plenty to find the lines
+static const size_t MAX_SKEW_POINTS = 20000;
+static const size_t MIN_SKEW_POINTS = 64;
+static const uint32_t SKEW_BIN = 2;
+static const float COARSE_STEP = 0.5f;
+static const float FINE_STEP = 0.1f;
+static const double PI = 3.14159265358979;
+// The integral image is 32-bit
+static const uint64_t MAX_PIXELS = UINT32_MAX / 255;
+
+static uint32_t findRoot(uint32_t* parent, uint32_t label) {
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+// Roots are always the smaller label, so a tile's roots stay in its range
+// until the border pass joins tiles
+static void unite(uint32_t* parent, uint32_t a, uint32_t b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
+
+OcrPreprocessor::OcrPreprocessor(const OcrPreprocessorConfig& config, TaskPool& pool)
+    : m_config(config)
+    , m_pool(pool)
+{
+    m_config.tileSize = std::max(m_config.tileSize, 16u);
+    m_config.windowSize = std::max(m_config.windowSize | 1, 3u);
+}
+
+const OcrPage& OcrPreprocessor::process(const FrameBuffer& frame) {
+    m_arena.reset();
+    m_page.regions.clear();
+    m_page.components = 0;
+    m_page.skewDegrees = 0.0f;
+    m_width = frame.width();
+    m_height = frame.height();
+    m_stride = (size_t(m_width) + FrameArena::ALIGNMENT - 1) & ~(FrameArena::ALIGNMENT - 1);
+    m_page.image = OcrImage{nullptr, nullptr, m_stride, m_width, m_height};
+    if (frame.empty() || uint64_t(m_width) * m_height > MAX_PIXELS) {
+        return m_page;
+    }
+
+    uint8_t* gray = m_arena.allocate<uint8_t>(m_stride * m_height);
+    uint8_t* binary = m_arena.allocate<uint8_t>(m_stride * m_height);
+    m_integral = m_arena.allocate<uint32_t>((size_t(m_width) + 1) * (m_height + 1));
+    forEachBand(m_pool, m_height, m_config.tileSize, [&](uint32_t first, uint32_t count) {
+        bgraToGray(frame.row(first), frame.stride(), gray + first * m_stride, m_stride, m_width, count);
+    });
+    buildIntegral(gray);
+    uint8_t background = findBackground(gray);
+    binarize(gray, binary);
+
+    float skew = estimateSkew(binary);
+    if (std::fabs(skew) >= m_config.minSkewDegrees) {
+        uint8_t* straight = m_arena.allocate<uint8_t>(m_stride * m_height);
+        rotate(gray, straight, skew, background);
+        gray = straight;
+        buildIntegral(gray);
+        binarize(gray, binary);
+        m_page.skewDegrees = skew;
+    }
+
+    labelComponents(binary);
+    findLines();
+    m_page.image.gray = gray;
+    m_page.image.binary = binary;
+    m_page.components = m_components.size();
+    return m_page;
+}
+
+void OcrPreprocessor::buildIntegral(const uint8_t* gray) {
+    size_t stride = size_t(m_width) + 1;
+    std::fill(m_integral, m_integral + stride, 0u);
+    // Row prefix sums in bands, then column sums in strips; both passes
+    // are independent per band or strip
+    forEachBand(m_pool, m_height, m_config.tileSize, [&](uint32_t first, uint32_t count) {
+        for (uint32_t y = first; y < first + count; ++y) {
+            const uint8_t* in = gray + y * m_stride;
+            uint32_t* out = m_integral + (y + 1) * stride;
+            uint32_t run = 0;
+            out[0] = 0;
+            for (uint32_t x = 0; x < m_width; ++x) {
+                run += in[x];
+                out[x + 1] = run;
+            }
+        }
+    });
+    uint32_t strip = m_config.tileSize;
+    m_pool.parallelFor((m_width + strip - 1) / strip, [&](size_t i) {
+        size_t left = 1 + i * strip;
+        size_t right = std::min<size_t>(left + strip, stride);
+        for (uint32_t y = 2; y <= m_height; ++y) {
+            uint32_t* row = m_integral + y * stride;
+            const uint32_t* above = row - stride;
+            for (size_t x = left; x < right; ++x) {
+                row[x] += above[x];
+            }
+        }
+    });
+}
+
+uint8_t OcrPreprocessor::findBackground(const uint8_t* gray) {
+    // Screen backgrounds are flat, so the most common level is the
+    // background even where text is dense; a quarter of the pixels is
+    // plenty to find it
+    uint32_t histogram[256 / LEVEL_BIN] = {};
+    for (uint32_t y = 0; y < m_height; y += 2) {
+        const uint8_t* row = gray + y * m_stride;
+        for (uint32_t x = 0; x < m_width; x += 2) {
+            ++histogram[row[x] / LEVEL_BIN];
+        }
+    }
+    size_t mode = std::max_element(std::begin(histogram), std::end(histogram)) - std::begin(histogram);
+    uint8_t background = static_cast<uint8_t>(mode * LEVEL_BIN + LEVEL_BIN / 2);
+    uint64_t total = m_integral[size_t(m_height) * (m_width + 1) + m_width];
+    m_darkBackground = background * (uint64_t(m_width) * m_height) < total;
+    return background;
+}
+
+void OcrPreprocessor::binarize(const uint8_t* gray, uint8_t* binary) {
+    size_t stride = size_t(m_width) + 1;
+    uint32_t radius = m_config.windowSize / 2;
+    uint64_t darker = 100 - std::min(m_config.contrast, 100u);
+    uint64_t lighter = 100 + m_config.contrast;
+    uint64_t minContrast = m_config.minContrast;
+    bool dark = m_darkBackground;
+    forEachBand(m_pool, m_height, m_config.tileSize, [&](uint32_t first, uint32_t count) {
+        for (uint32_t y = first; y < first + count; ++y) {
+            size_t top = y > radius ? y - radius : 0;
+            size_t bottom = std::min<size_t>(y + radius + 1, m_height);
+            const uint32_t* above = m_integral + top * stride;
+            const uint32_t* below = m_integral + bottom * stride;
+            const uint8_t* in = gray + y * m_stride;
+            uint8_t* out = binary + y * m_stride;
+            auto classify = [&](uint32_t x, size_t left, size_t right) {
+                uint64_t area = (bottom - top) * (right - left);
+                uint64_t sum = below[right] - below[left] - above[right] + above[left];
+                uint64_t pixel = in[x] * area;
+                bool ink = dark
+                    ? pixel * 100 > sum * lighter && pixel - sum >= minContrast * area
+                    : pixel * 100 < sum * darker && sum - pixel >= minContrast * area;
+                out[x] = ink ? 255 : 0;
+            };
+            // The window is only clipped near the left and right edges
+            uint32_t inner = std::min(radius, m_width);
+            uint32_t outer = m_width > radius ? std::max(m_width - radius - 1, inner) : inner;
+            for (uint32_t x = 0; x < inner; ++x) {
+                classify(x, 0, std::min<size_t>(x + radius + 1, m_width));
+            }
+            for (uint32_t x = inner; x < outer; ++x) {
+                classify(x, x - radius, x + radius + 1);
+            }
+            for (uint32_t x = outer; x < m_width; ++x) {
+                classify(x, x >= radius ? x - radius : 0, m_width);
+            }
+        }
+    });
+}
+
+uint64_t OcrPreprocessor::skewScore(float degrees, uint32_t* histogram, size_t bins) const {
+    // Rows of text line up into few, tall bins only at the right angle
+    double slope = std::tan(degrees * PI / 180.0);
+    double offset = m_width * std::tan(m_config.maxSkewDegrees * PI / 180.0);
+    std::fill(histogram, histogram + bins, 0u);
+    for (const Point& point : m_points) {
+        double y = point.y - point.x * slope + offset;
+        size_t bin = static_cast<size_t>(std::max(y, 0.0)) / SKEW_BIN;
+        ++histogram[std::min(bin, bins - 1)];
+    }
+    uint64_t score = 0;
+    for (size_t i = 0; i < bins; ++i) {
+        score += uint64_t(histogram[i]) * histogram[i];
+    }
+    return score;
+}
+
+float OcrPreprocessor::estimateSkew(const uint8_t* binary) {
+    if (m_config.maxSkewDegrees <= 0.0f) {
+        return 0.0f;
+    }
+    // Every 4th column of every other row; thinned further on busy pages
+    m_points.clear();
+    for (uint32_t y = 0; y < m_height; y += 2) {
+        const uint8_t* row = binary + y * m_stride;
+        for (uint32_t x = 0; x < m_width; x += 4) {
+            if (row[x]) {
+                m_points.push_back(Point{static_cast<int32_t>(x), static_cast<int32_t>(y)});
+            }
+        }
+    }
+    if (m_points.size() < MIN_SKEW_POINTS) {
+        return 0.0f;
+    }
+    if (m_points.size() > MAX_SKEW_POINTS) {
+        size_t step = (m_points.size() + MAX_SKEW_POINTS - 1) / MAX_SKEW_POINTS;
+        size_t kept = 0;
+        for (size_t i = 0; i < m_points.size(); i += step) {
+            m_points[kept++] = m_points[i];
+        }
+        m_points.resize(kept);
+    }
+
+    double reach = 2.0 * m_width * std::tan(m_config.maxSkewDegrees * PI / 180.0);
+    size_t bins = static_cast<size_t>((m_height + reach) / SKEW_BIN) + 2;
+    int32_t steps = static_cast<int32_t>(m_config.maxSkewDegrees / COARSE_STEP);
+    size_t coarse = size_t(2 * steps + 1);
+    size_t fine = size_t(2 * COARSE_STEP / FINE_STEP + 1);
+    uint32_t* histograms = m_arena.allocate<uint32_t>(std::max(coarse, fine) * bins);
+    uint64_t* scores = m_arena.allocate<uint64_t>(std::max(coarse, fine));
+
+    m_pool.parallelFor(coarse, [&](size_t i) {
+        scores[i] = skewScore((static_cast<int32_t>(i) - steps) * COARSE_STEP, histograms + i * bins, bins);
+    });
+    uint64_t level = scores[size_t(steps)];
+    size_t best = std::max_element(scores, scores + coarse) - scores;
+    float center = (static_cast<int32_t>(best) - steps) * COARSE_STEP;
+
+    m_pool.parallelFor(fine, [&](size_t i) {
+        float degrees = center - COARSE_STEP + i * FINE_STEP;
+        scores[i] = std::fabs(degrees) <= m_config.maxSkewDegrees
+            ? skewScore(degrees, histograms + i * bins, bins) : 0;
+    });
+    best = std::max_element(scores, scores + fine) - scores;
+
+    // Pages without clear lines peak anywhere; only trust a clear winner
+    if (scores[best] * 10 < level * 11) {
+        return 0.0f;
+    }
+    return center - COARSE_STEP + best * FINE_STEP;
+}
+
+void OcrPreprocessor::rotate(const uint8_t* source, uint8_t* target, float degrees, uint8_t fill) {
+    // Each target pixel samples the source rotated by degrees around the
+    // centre, so lines sloping by that angle come out level
+    float radians = static_cast<float>(degrees * PI / 180.0);
+    float cosine = std::cos(radians);
+    float sine = std::sin(radians);
+    float cx = m_width * 0.5f;
+    float cy = m_height * 0.5f;
+    forEachBand(m_pool, m_height, m_config.tileSize, [&](uint32_t first, uint32_t count) {
+        for (uint32_t y = first; y < first + count; ++y) {
+            float dy = y + 0.5f - cy;
+            uint8_t* out = target + y * m_stride;
+            for (uint32_t x = 0; x < m_width; ++x) {
+                float dx = x + 0.5f - cx;
+                float sx = cx + dx * cosine - dy * sine;
+                float sy = cy + dx * sine + dy * cosine;
+                if (sx >= 0.0f && sy >= 0.0f && sx < m_width && sy < m_height) {
+                    out[x] = source[static_cast<size_t>(sy) * m_stride + static_cast<uint32_t>(sx)];
+                } else {
+                    out[x] = fill;
+                }
+            }
+        }
+    });
+}
+
+void OcrPreprocessor::labelComponents(const uint8_t* binary) {
+    uint32_t tile = m_config.tileSize;
+    uint32_t columns = (m_width + tile - 1) / tile;
+    uint32_t rows = (m_height + tile - 1) / tile;
+    size_t tiles = size_t(columns) * rows;
+    // A new label only starts at a pixel with no ink among its four
+    // earlier neighbours, so no two are adjacent: at most a quarter of
+    // the tile
+    uint32_t perTile = ((tile + 1) / 2) * ((tile + 1) / 2);
+
+    uint32_t* labels = m_arena.allocate<uint32_t>(m_stride * m_height);
+    uint32_t* parent = m_arena.allocate<uint32_t>(1 + tiles * perTile);
+    uint32_t* used = m_arena.allocate<uint32_t>(tiles);
+    parent[0] = 0;
+
+    // Pass 1: label each tile on its own, labels from the tile's range
+    m_pool.parallelFor(tiles, [&](size_t t) {
+        uint32_t left = static_cast<uint32_t>(t % columns) * tile;
+        uint32_t top = static_cast<uint32_t>(t / columns) * tile;
+        uint32_t right = std::min(left + tile, m_width);
+        uint32_t bottom = std::min(top + tile, m_height);
+        uint32_t base = 1 + static_cast<uint32_t>(t) * perTile;
+        uint32_t next = base;
+        for (uint32_t y = top; y < bottom; ++y) {
+            const uint8_t* in = binary + y * m_stride;
+            uint32_t* out = labels + y * m_stride;
+            const uint32_t* above = y > top ? out - m_stride : nullptr;
+            for (uint32_t x = left; x < right; ++x) {
+                if (!in[x]) {
+                    out[x] = 0;
+                    continue;
+                }
+                // Of the earlier neighbours only above-right is apart from
+                // the others, so at most one union per pixel
+                uint32_t upLeft = above && x > left ? above[x - 1] : 0;
+                uint32_t up = above ? above[x] : 0;
+                uint32_t upRight = above && x + 1 < right ? above[x + 1] : 0;
+                uint32_t back = x > left ? out[x - 1] : 0;
+                uint32_t label;
+                if (up) {
+                    label = up;
+                } else if (upRight) {
+                    label = upRight;
+                    if (upLeft || back) {
+                        unite(parent, label, upLeft ? upLeft : back);
+                    }
+                } else if (upLeft || back) {
+                    label = upLeft ? upLeft : back;
+                } else {
+                    label = next++;
+                    parent[label] = label;
+                }
+                out[x] = label;
+            }
+        }
+        used[t] = next - base;
+    });
+
+    // Pass 2: join components that touch across tile borders
+    for (uint32_t x = tile; x < m_width; x += tile) {
+        for (uint32_t y = 0; y < m_height; ++y) {
+            uint32_t label = labels[y * m_stride + x];
+            if (label == 0) {
+                continue;
+            }
+            for (int32_t dy = -1; dy <= 1; ++dy) {
+                int32_t ny = static_cast<int32_t>(y) + dy;
+                if (ny >= 0 && ny < static_cast<int32_t>(m_height) && labels[ny * m_stride + x - 1]) {
+                    unite(parent, label, labels[ny * m_stride + x - 1]);
+                }
+            }
+        }
+    }
+    for (uint32_t y = tile; y < m_height; y += tile) {
+        const uint32_t* row = labels + y * m_stride;
+        const uint32_t* above = row - m_stride;
+        for (uint32_t x = 0; x < m_width; ++x) {
+            if (row[x] == 0) {
+                continue;
+            }
+            for (int32_t dx = -1; dx <= 1; ++dx) {
+                int32_t nx = static_cast<int32_t>(x) + dx;
+                if (nx >= 0 && nx < static_cast<int32_t>(m_width) && above[nx]) {
+                    unite(parent, row[x], above[nx]);
+                }
+            }
+        }
+    }
+
+    // Pass 3: point every label straight at its root, and give each a
+    // slot in a compact stats array
+    uint32_t* offsets = m_arena.allocate<uint32_t>(tiles);
+    uint32_t total = 0;
+    for (size_t t = 0; t < tiles; ++t) {
+        offsets[t] = total;
+        total += used[t];
+        uint32_t base = 1 + static_cast<uint32_t>(t) * perTile;
+        for (uint32_t label = base; label < base + used[t]; ++label) {
+            parent[label] = findRoot(parent, label);
+        }
+    }
+    auto slot = [&](uint32_t label) {
+        size_t t = (label - 1) / perTile;
+        return offsets[t] + (label - 1 - static_cast<uint32_t>(t) * perTile);
+    };
+
+    // Pass 4: bounds and pixel counts per label, tile by tile
+    Component* stats = m_arena.allocate<Component>(std::max(total, 1u));
+    m_pool.parallelFor(tiles, [&](size_t t) {
+        uint32_t left = static_cast<uint32_t>(t % columns) * tile;
+        uint32_t top = static_cast<uint32_t>(t / columns) * tile;
+        uint32_t right = std::min(left + tile, m_width);
+        uint32_t bottom = std::min(top + tile, m_height);
+        Component* own = stats + offsets[t];
+        for (uint32_t i = 0; i < used[t]; ++i) {
+            own[i] = Component{INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN, 0};
+        }
+        uint32_t base = 1 + static_cast<uint32_t>(t) * perTile;
+        for (uint32_t y = top; y < bottom; ++y) {
+            const uint32_t* row = labels + y * m_stride;
+            uint32_t x = left;
+            while (x < right) {
+                uint32_t label = row[x];
+                uint32_t start = x;
+                while (x < right && row[x] == label) {
+                    ++x;
+                }
+                if (label == 0) {
+                    continue;
+                }
+                Component& c = own[label - base];
+                c.left = std::min(c.left, static_cast<int32_t>(start));
+                c.top = std::min(c.top, static_cast<int32_t>(y));
+                c.right = std::max(c.right, static_cast<int32_t>(x));
+                c.bottom = std::max(c.bottom, static_cast<int32_t>(y) + 1);
+                c.pixels += x - start;
+            }
+        }
+    });
+
+    // Pass 5: fold each label's stats into its root's
+    m_components.clear();
+    for (size_t t = 0; t < tiles; ++t) {
+        uint32_t base = 1 + static_cast<uint32_t>(t) * perTile;
+        for (uint32_t label = base; label < base + used[t]; ++label) {
+            uint32_t root = parent[label];
+            if (root == label) {
+                continue;
+            }
+            Component& from = stats[slot(label)];
+            Component& to = stats[slot(root)];
+            to.left = std::min(to.left, from.left);
+            to.top = std::min(to.top, from.top);
+            to.right = std::max(to.right, from.right);
+            to.bottom = std::max(to.bottom, from.bottom);
+            to.pixels += from.pixels;
+        }
+    }
+    for (size_t t = 0; t < tiles; ++t) {
+        uint32_t base = 1 + static_cast<uint32_t>(t) * perTile;
+        for (uint32_t label = base; label < base + used[t]; ++label) {
+            if (parent[label] == label) {
+                m_components.push_back(stats[slot(label)]);
+            }
+        }
+    }
+}
+
+void OcrPreprocessor::findLines() {
+    m_candidates.clear();
+    for (uint32_t i = 0; i < m_components.size(); ++i) {
+        int32_t height = m_components[i].bottom - m_components[i].top;
+        if (height >= static_cast<int32_t>(m_config.minGlyphHeight) && height <= static_cast<int32_t>(m_config.maxGlyphHeight)) {
+            m_candidates.push_back(i);
+        }
+    }
+    std::sort(m_candidates.begin(), m_candidates.end(), [&](uint32_t a, uint32_t b) {
+        return m_components[a].left < m_components[b].left;
+    });
+
+    // Join glyphs that sit side by side on the same rows. Sorted by left
+    // edge, only the glyphs starting within reach need checking.
+    m_lineParent.resize(m_candidates.size());
+    for (uint32_t i = 0; i < m_lineParent.size(); ++i) {
+        m_lineParent[i] = i;
+    }
+    for (size_t i = 0; i < m_candidates.size(); ++i) {
+        const Component& a = m_components[m_candidates[i]];
+        int32_t heightA = a.bottom - a.top;
+        int32_t reach = a.right + static_cast<int32_t>(m_config.wordGap * heightA);
+        for (size_t j = i + 1; j < m_candidates.size(); ++j) {
+            const Component& b = m_components[m_candidates[j]];
+            if (b.left > reach) {
+                break;
+            }
+            int32_t heightB = b.bottom - b.top;
+            int32_t overlap = std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
+            int32_t shorter = std::min(heightA, heightB);
+            int32_t taller = std::max(heightA, heightB);
+            if (overlap * 2 >= shorter && taller <= 3 * shorter) {
+                unite(m_lineParent.data(), static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+            }
+        }
+    }
+
+    // Roots are the smallest index of each line, so a line's region is
+    // created before any of its other glyphs are reached
+    std::vector<TextRegion>& regions = m_page.regions;
+    std::vector<uint32_t>& regionOf = m_candidates;    // Reused once the candidates are read
+    for (uint32_t i = 0; i < m_lineParent.size(); ++i) {
+        const Component& glyph = m_components[m_candidates[i]];
+        uint32_t root = findRoot(m_lineParent.data(), i);
+        if (root == i) {
+            regionOf[i] = static_cast<uint32_t>(regions.size());
+            regions.push_back(TextRegion{FrameRect{glyph.left, glyph.top, glyph.right, glyph.bottom}, 1});
+            continue;
+        }
+        TextRegion& region = regions[regionOf[root]];
+        region.bounds.left = std::min(region.bounds.left, glyph.left);
+        region.bounds.top = std::min(region.bounds.top, glyph.top);
+        region.bounds.right = std::max(region.bounds.right, glyph.right);
+        region.bounds.bottom = std::max(region.bounds.bottom, glyph.bottom);
+        ++region.glyphs;
+    }
+
+    // A lone glyph is noise or a bullet unless it is word-shaped
+    regions.erase(std::remove_if(regions.begin(), regions.end(), [](const TextRegion& region) {
+        return region.glyphs < 2 && region.bounds.width() < 2 * region.bounds.height();
+    }), regions.end());
+    std::sort(regions.begin(), regions.end(), [](const TextRegion& a, const TextRegion& b) {
+        return a.bounds.top != b.bounds.top ? a.bounds.top < b.bounds.top : a.bounds.left < b.bounds.left;
+    });
+}
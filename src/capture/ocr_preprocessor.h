@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "frame_arena.h"
+#include "frame_buffer.h"
+#include "ocr_engine.h"
+#include "task_pool.h"
+
+struct OcrPreprocessorConfig {
+    uint32_t tileSize = 128;            // Unit of parallel work and of component labelling
+    uint32_t windowSize = 31;           // Neighbourhood the local mean is taken over, in pixels
+    uint32_t contrast = 15;             // Percent off the local mean that makes a pixel ink
+    uint32_t minContrast = 20;          // Gray levels off the mean it must also be, so flat areas stay clean
+    float maxSkewDegrees = 8.0f;        // Deskew search range either way
+    float minSkewDegrees = 0.3f;        // Smaller skew is left alone
+    uint32_t minGlyphHeight = 4;        // Components outside these heights aren't text
+    uint32_t maxGlyphHeight = 120;
+    float wordGap = 1.0f;               // Largest gap within a line, in glyph heights
+};
+
+// A line of text: glyphs side by side with overlapping rows
+struct TextRegion {
+    FrameRect bounds;
+    uint32_t glyphs;
+};
+
+struct OcrPage {
+    OcrImage image;                     // Deskewed; regions are in its coordinates
+    float skewDegrees = 0.0f;           // Clockwise rotation that was removed
+    size_t components = 0;
+    std::vector<TextRegion> regions;    // Top to bottom, then left to right
+};
+
+// Turns a captured frame into text regions ready for an OcrEngine:
+//   1. grayscale (frame kernels)
+//   2. adaptive binarisation against the mean of a windowSize square,
+//      from an integral image. The most common gray level is taken as
+//      the background; when it is darker than the mean the frame is dark
+//      themed and the lighter side is ink. Flat areas of any size stay
+//      clean.
+//   3. deskew: the angle whose horizontal projection of sampled ink is
+//      most peaked, searched coarse then fine. If above minSkewDegrees
+//      the gray is rotated back and binarised again.
+//   4. 8-connected components, labelled per tile in parallel and joined
+//      across tile borders with union-find
+//   5. glyph-sized components grouped into lines
+// Every per-pixel stage runs in tiles or bands on the TaskPool, whose
+// threads steal work from each other. Planes and labels come from a
+// FrameArena, so after the first frame of a size they are not allocated
+// again.
+class OcrPreprocessor {
+public:
+    explicit OcrPreprocessor(const OcrPreprocessorConfig& config = {}, TaskPool& pool = TaskPool::getInstance());
+    OcrPreprocessor(const OcrPreprocessor&) = delete;
+    OcrPreprocessor& operator=(const OcrPreprocessor&) = delete;
+
+    // Run every stage on frame. The page's image points into buffers of
+    // the preprocessor and stays valid until the next call.
+    const OcrPage& process(const FrameBuffer& frame);
+    const OcrPage& page() const { return m_page; }
+
+private:
+    struct Component {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+        uint32_t pixels;
+    };
+
+    struct Point {
+        int32_t x;
+        int32_t y;
+    };
+
+    void buildIntegral(const uint8_t* gray);
+    uint8_t findBackground(const uint8_t* gray);
+    void binarize(const uint8_t* gray, uint8_t* binary);
+    float estimateSkew(const uint8_t* binary);
+    uint64_t skewScore(float degrees, uint32_t* histogram, size_t bins) const;
+    void rotate(const uint8_t* source, uint8_t* target, float degrees, uint8_t fill);
+    void labelComponents(const uint8_t* binary);
+    void findLines();
+
+    OcrPreprocessorConfig m_config;
+    TaskPool& m_pool;
+    FrameArena m_arena;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    size_t m_stride = 0;
+    uint32_t* m_integral = nullptr;     // (width + 1) x (height + 1)
+    bool m_darkBackground = false;      // Ink is lighter than its surroundings
+
+    std::vector<Point> m_points;        // Ink samples for the skew search
+    std::vector<Component> m_components;
+    std::vector<uint32_t> m_candidates; // Glyph-sized components, by left edge
+    std::vector<uint32_t> m_lineParent;
+    OcrPage m_page;
+};
@@ -0,0 +1,261 @@
+#include "slide_detector.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "frame_kernels.h"
+
+// The box pre-filter stops once the thumbnail would drop below this size
+static const uint32_t MIN_THUMBNAIL = 64;
+static const uint32_t DCT_SIZE = 32;
+static const uint32_t DCT_KEEP = 8;
+
+// Mean of each cell when src is cut into dstWidth x dstHeight cells
+static void areaResize(const uint8_t* src, size_t stride, uint32_t width, uint32_t height,
+                       uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight) {
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+        uint32_t top = y * height / dstHeight;
+        uint32_t bottom = std::max((y + 1) * height / dstHeight, top + 1);
+        for (uint32_t x = 0; x < dstWidth; ++x) {
+            uint32_t left = x * width / dstWidth;
+            uint32_t right = std::max((x + 1) * width / dstWidth, left + 1);
+            uint32_t sum = 0;
+            for (uint32_t row = top; row < bottom; ++row) {
+                const uint8_t* in = src + row * stride;
+                for (uint32_t column = left; column < right; ++column) {
+                    sum += in[column];
+                }
+            }
+            uint32_t count = (bottom - top) * (right - left);
+            dst[y * dstWidth + x] = static_cast<uint8_t>((sum + count / 2) / count);
+        }
+    }
+}
+
+SlideDetector::SlideDetector(const SlideDetectorConfig& config, Callback onSlide)
+    : m_config(config)
+    , m_onSlide(std::move(onSlide))
+{
+    m_config.stableFrames = std::max<uint32_t>(m_config.stableFrames, 1);
+    m_recent.reserve(m_config.recentSlides);
+}
+
+SlideDetector::~SlideDetector() {
+    stop();
+}
+
+uint32_t SlideDetector::hammingDistance(uint64_t a, uint64_t b) {
+    uint64_t bits = a ^ b;
+    uint32_t count = 0;
+    while (bits) {
+        bits &= bits - 1;
+        ++count;
+    }
+    return count;
+}
+
+uint64_t SlideDetector::differenceHash(const uint8_t* luma, size_t stride, uint32_t width, uint32_t height) {
+    uint8_t cells[8][9];
+    areaResize(luma, stride, width, height, &cells[0][0], 9, 8);
+    uint64_t hash = 0;
+    for (uint32_t y = 0; y < 8; ++y) {
+        for (uint32_t x = 0; x < 8; ++x) {
+            hash = (hash << 1) | (cells[y][x] < cells[y][x + 1] ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+uint64_t SlideDetector::dctHash(const uint8_t* luma, size_t stride, uint32_t width, uint32_t height) {
+    static const std::vector<float> cosines = []() {
+        std::vector<float> table(DCT_KEEP * DCT_SIZE);
+        for (uint32_t u = 0; u < DCT_KEEP; ++u) {
+            for (uint32_t x = 0; x < DCT_SIZE; ++x) {
+                table[u * DCT_SIZE + x] = static_cast<float>(std::cos((2 * x + 1) * u * 3.14159265358979 / (2 * DCT_SIZE)));
+            }
+        }
+        return table;
+    }();
+
+    uint8_t pixels[DCT_SIZE * DCT_SIZE];
+    areaResize(luma, stride, width, height, pixels, DCT_SIZE, DCT_SIZE);
+
+    // Only the low 8x8 terms are needed, so transform rows into 8
+    // frequencies each, then the columns of that
+    float rows[DCT_SIZE][DCT_KEEP];
+    for (uint32_t y = 0; y < DCT_SIZE; ++y) {
+        for (uint32_t u = 0; u < DCT_KEEP; ++u) {
+            float sum = 0;
+            for (uint32_t x = 0; x < DCT_SIZE; ++x) {
+                sum += cosines[u * DCT_SIZE + x] * pixels[y * DCT_SIZE + x];
+            }
+            rows[y][u] = sum;
+        }
+    }
+    float terms[DCT_KEEP * DCT_KEEP];
+    for (uint32_t v = 0; v < DCT_KEEP; ++v) {
+        for (uint32_t u = 0; u < DCT_KEEP; ++u) {
+            float sum = 0;
+            for (uint32_t y = 0; y < DCT_SIZE; ++y) {
+                sum += cosines[v * DCT_SIZE + y] * rows[y][u];
+            }
+            terms[v * DCT_KEEP + u] = sum;
+        }
+    }
+
+    // Compare against the median of the AC terms; the DC term is only
+    // overall brightness
+    float sorted[DCT_KEEP * DCT_KEEP - 1];
+    std::copy(terms + 1, terms + DCT_KEEP * DCT_KEEP, sorted);
+    std::nth_element(sorted, sorted + 31, sorted + 63);
+    float median = sorted[31];
+    uint64_t hash = 0;
+    for (uint32_t i = 0; i < DCT_KEEP * DCT_KEEP; ++i) {
+        hash = (hash << 1) | (terms[i] > median ? 1 : 0);
+    }
+    return hash;
+}
+
+void SlideDetector::fingerprintFrame(Fingerprint& out) {
+    const uint8_t* luma = m_luma.data();
+    size_t stride = m_luma.stride();
+    uint32_t width = m_luma.width();
+    uint32_t height = m_luma.height();
+
+    uint32_t factor = 8;
+    while (factor > 1 && (width / factor < MIN_THUMBNAIL || height / factor < MIN_THUMBNAIL)) {
+        factor /= 2;
+    }
+    if (factor > 1) {
+        m_thumbnail.resize(size_t(width / factor) * (height / factor));
+        boxDownscaleGray(luma, stride, width, height, factor, m_thumbnail.data(), width / factor);
+        width /= factor;
+        height /= factor;
+        luma = m_thumbnail.data();
+        stride = width;
+    }
+
+    out.hash = m_config.kind == SlideHashKind::Dct
+        ? dctHash(luma, stride, width, height)
+        : differenceHash(luma, stride, width, height);
+    areaResize(luma, stride, width, height, out.cells, GRID, GRID);
+}
+
+bool SlideDetector::samePicture(const Fingerprint& a, const Fingerprint& b) const {
+    if (hammingDistance(a.hash, b.hash) > m_config.threshold) {
+        return false;
+    }
+    uint32_t changed = 0;
+    for (uint32_t i = 0; i < GRID * GRID; ++i) {
+        uint32_t change = a.cells[i] > b.cells[i] ? a.cells[i] - b.cells[i] : b.cells[i] - a.cells[i];
+        changed += change > m_config.cellThreshold ? 1 : 0;
+    }
+    return changed < m_config.changedCells;
+}
+
+bool SlideDetector::process(const FrameHandle& frame) {
+    const FrameBuffer& buffer = frame.buffer();
+    if (buffer.empty()) {
+        return false;
+    }
+    m_luma.update(buffer, frame.info());
+
+    bool changed = m_luma.damage().count() != 0 || !m_hasLast;
+    if (changed) {
+        fingerprintFrame(m_last);
+        m_hasLast = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.frames;
+        ++(changed ? m_stats.hashed : m_stats.unchanged);
+    }
+
+    if (m_hasSlide && samePicture(m_last, m_slide)) {
+        m_candidateFrames = 0;
+        return false;
+    }
+    if (m_candidateFrames > 0 && samePicture(m_last, m_candidate)) {
+        ++m_candidateFrames;
+    } else {
+        m_candidate = m_last;
+        m_candidateFrames = 1;
+    }
+    if (m_candidateFrames < m_config.stableFrames) {
+        return false;
+    }
+
+    SlideEvent event;
+    event.hash = m_last.hash;
+    event.revisit = false;
+    event.frame = frame;
+    for (const Recent& recent : m_recent) {
+        if (samePicture(m_last, recent.fingerprint)) {
+            event.slideId = recent.slideId;
+            event.revisit = true;
+            break;
+        }
+    }
+    if (!event.revisit) {
+        event.slideId = m_nextSlideId++;
+        if (m_config.recentSlides > 0) {
+            if (m_recent.size() < m_config.recentSlides) {
+                m_recent.push_back(Recent{m_last, event.slideId});
+            } else {
+                m_recent[m_recentNext] = Recent{m_last, event.slideId};
+                m_recentNext = (m_recentNext + 1) % m_recent.size();
+            }
+        }
+    }
+
+    m_slide = m_last;
+    m_hasSlide = true;
+    m_candidateFrames = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.slides;
+        m_stats.revisits += event.revisit ? 1 : 0;
+    }
+    if (m_onSlide) {
+        m_onSlide(event);
+    }
+    return true;
+}
+
+bool SlideDetector::start(std::shared_ptr<FrameRing> ring) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable() || !ring) {
+        return false;
+    }
+    m_stopping = false;
+    m_thread = std::thread(&SlideDetector::run, this, std::move(ring));
+    return true;
+}
+
+void SlideDetector::stop() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        stopped = std::move(m_thread);
+    }
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+}
+
+SlideDetectorStats SlideDetector::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SlideDetector::run(std::shared_ptr<FrameRing> ring) {
+    FrameHandle frame;
+    while (!m_stopping) {
+        if (ring->pop(frame, std::chrono::milliseconds(100))) {
+            process(frame);
+            frame.reset();
+        } else if (ring->closed()) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "frame_pool.h"
+#include "frame_ring.h"
+#include "luma_plane.h"
+
+enum class SlideHashKind {
+    Difference,     // dHash: brightness gradients of a 9x8 thumbnail
+    Dct             // pHash: signs of the low 8x8 DCT terms of a 32x32 thumbnail
+};
+
+struct SlideDetectorConfig {
+    SlideHashKind kind = SlideHashKind::Difference;
+    uint32_t threshold = 8;         // Hamming distance still counted as the same slide
+    uint32_t cellThreshold = 4;     // Change in a grid cell's mean luma that counts the cell as changed
+    uint32_t changedCells = 4;      // Changed cells that make a new picture; a pointer touches up to three
+    uint32_t stableFrames = 2;      // Frames a new picture must hold before it counts
+    size_t recentSlides = 32;       // Earlier slides remembered to spot going back
+};
+
+struct SlideEvent {
+    uint64_t slideId;       // Same id again when an earlier slide returns
+    bool revisit;
+    uint64_t hash;
+    FrameHandle frame;      // First stable frame of the slide; hold briefly, it pins a pool frame
+};
+
+struct SlideDetectorStats {
+    uint64_t frames;
+    uint64_t unchanged;     // No damaged tiles, so not even hashed
+    uint64_t hashed;
+    uint64_t slides;        // Events emitted, revisits included
+    uint64_t revisits;
+};
+
+// Turns the stream of captured frames into "new slide" events. During a
+// shared presentation nearly every frame shows the slide already seen, so
+// stages that care about content (OCR, storage) should work from these
+// events rather than from raw frames.
+//
+// Each frame updates a LumaPlane from its dirty regions; a frame with no
+// damage is the previous picture and is not hashed. Otherwise the luma is
+// reduced to a thumbnail and hashed, and a hash within threshold bits of
+// the current slide is suppressed. A 64-bit hash can't see a bullet point
+// being revealed, so the thumbnail is also averaged into a 16x16 grid and
+// changedCells cells moving by more than cellThreshold count as a new
+// picture too. Encoder noise averages out within a cell and the pointer
+// only reaches a few of them.
+//
+// A different picture must stay put for stableFrames frames, which skips
+// transitions and animations, before it is emitted. Slides matching one
+// of the recent ones keep their old id.
+class SlideDetector {
+public:
+    using Callback = std::function<void(const SlideEvent&)>;
+
+    explicit SlideDetector(const SlideDetectorConfig& config = {}, Callback onSlide = nullptr);
+    ~SlideDetector();
+    SlideDetector(const SlideDetector&) = delete;
+    SlideDetector& operator=(const SlideDetector&) = delete;
+
+    // Process one frame on the caller's thread. Returns true when it
+    // produced a slide event.
+    bool process(const FrameHandle& frame);
+
+    // Process frames from ring on a thread of our own until stop() or the
+    // ring closes
+    bool start(std::shared_ptr<FrameRing> ring);
+    void stop();
+
+    SlideDetectorStats stats() const;
+
+    static uint64_t differenceHash(const uint8_t* luma, size_t stride, uint32_t width, uint32_t height);
+    static uint64_t dctHash(const uint8_t* luma, size_t stride, uint32_t width, uint32_t height);
+    static uint32_t hammingDistance(uint64_t a, uint64_t b);
+
+private:
+    static const uint32_t GRID = 16;
+
+    struct Fingerprint {
+        uint64_t hash;
+        uint8_t cells[GRID * GRID];     // Mean luma of each grid cell
+    };
+
+    struct Recent {
+        Fingerprint fingerprint;
+        uint64_t slideId;
+    };
+
+    void fingerprintFrame(Fingerprint& out);
+    bool samePicture(const Fingerprint& a, const Fingerprint& b) const;
+    void run(std::shared_ptr<FrameRing> ring);
+
+    SlideDetectorConfig m_config;
+    Callback m_onSlide;
+    LumaPlane m_luma;
+    std::vector<uint8_t> m_thumbnail;   // Box-filtered luma the hashes are taken from
+
+    Fingerprint m_last = {};
+    bool m_hasLast = false;
+    Fingerprint m_slide = {};
+    bool m_hasSlide = false;
+    Fingerprint m_candidate = {};
+    uint32_t m_candidateFrames = 0;
+    uint64_t m_nextSlideId = 1;
+    std::vector<Recent> m_recent;   // Ring of recentSlides entries
+    size_t m_recentNext = 0;
+
+    mutable std::mutex m_mutex;
+    SlideDetectorStats m_stats = {};
+    std::thread m_thread;
+    std::atomic<bool> m_stopping{false};
+};
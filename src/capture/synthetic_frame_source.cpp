@@ -0,0 +1,159 @@
+#include "synthetic_frame_source.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+static const uint32_t CURSOR_SIZE = 16;
+static const uint32_t LINE_HEIGHT = 24;
+static const uint32_t MARGIN = 64;
+
+static uint32_t mix(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x7feb352d;
+    value ^= value >> 15;
+    value *= 0x846ca68b;
+    value ^= value >> 16;
+    return value;
+}
+
+static void fillSpan(uint8_t* row, uint32_t from, uint32_t to, uint32_t bgra) {
+    for (uint32_t x = from; x < to; ++x) {
+        std::memcpy(row + x * FrameBuffer::BYTES_PER_PIXEL, &bgra, FrameBuffer::BYTES_PER_PIXEL);
+    }
+}
+
+SyntheticFrameSource::SyntheticFrameSource(const SyntheticFrameSourceConfig& config)
+    : m_config(config)
+    , m_period(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / (config.fps > 0 ? config.fps : 30.0))))
+{
+    m_config.slideFrames = std::max<uint32_t>(m_config.slideFrames, 1);
+}
+
+CaptureStatus SyntheticFrameSource::capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) {
+    if (m_config.frameCount != 0 && m_next >= m_config.frameCount) {
+        return CaptureStatus::Ended;
+    }
+
+    uint64_t missed = 0;
+    if (m_config.paced) {
+        auto now = std::chrono::steady_clock::now();
+        if (!m_started) {
+            m_start = now;
+            m_started = true;
+        }
+        auto due = m_start + m_period * m_next;
+        if (now < due) {
+            if (due - now > timeout) {
+                std::this_thread::sleep_for(timeout);
+                return CaptureStatus::Timeout;
+            }
+            std::this_thread::sleep_until(due);
+        } else {
+            // Jump to the latest frame that has come due
+            missed = static_cast<uint64_t>((now - due) / m_period);
+            if (m_config.frameCount != 0) {
+                missed = std::min(missed, m_config.frameCount - 1 - m_next);
+            }
+            m_next += missed;
+        }
+    }
+
+    render(m_next, target);
+    if (m_hasPrevious) {
+        describe(m_previous, m_next, info.regions);
+    } else {
+        info.regions.clear();
+    }
+    m_previous = m_next;
+    m_hasPrevious = true;
+    info.presentTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(m_period * m_next).count();
+    info.missedFrames = static_cast<uint32_t>(missed);
+    ++m_next;
+    return CaptureStatus::Captured;
+}
+
+SyntheticFrameSource::Cursor SyntheticFrameSource::cursorAt(uint64_t index) const {
+    // Bounces around the frame at a few pixels per frame
+    uint32_t spanX = m_config.width > CURSOR_SIZE ? m_config.width - CURSOR_SIZE : 1;
+    uint32_t spanY = m_config.height > CURSOR_SIZE ? m_config.height - CURSOR_SIZE : 1;
+    uint64_t x = (index * 7) % (2 * spanX);
+    uint64_t y = (index * 5) % (2 * spanY);
+    return Cursor{static_cast<uint32_t>(x < spanX ? x : 2 * spanX - x),
+                  static_cast<uint32_t>(y < spanY ? y : 2 * spanY - y)};
+}
+
+FrameRect SyntheticFrameSource::cursorRect(uint64_t index, int32_t shift) const {
+    Cursor cursor = cursorAt(index);
+    int32_t top = static_cast<int32_t>(cursor.y) - shift;
+    return FrameRect{static_cast<int32_t>(cursor.x), std::max(top, 0),
+                     static_cast<int32_t>(std::min(cursor.x + CURSOR_SIZE, m_config.width)),
+                     std::max(std::min(top + static_cast<int32_t>(CURSOR_SIZE), static_cast<int32_t>(m_config.height)), 0)};
+}
+
+void SyntheticFrameSource::describe(uint64_t previous, uint64_t index, FrameRegions& regions) const {
+    regions.clear();
+    if (previous / m_config.slideFrames != index / m_config.slideFrames) {
+        return;
+    }
+
+    int32_t width = static_cast<int32_t>(m_config.width);
+    int32_t top = static_cast<int32_t>(MARGIN);
+    int32_t bottom = static_cast<int32_t>(m_config.height) - top;
+    uint64_t scroll = uint64_t(m_config.scrollPixels) * (index - previous);
+    int32_t shift = 0;
+    if (scroll > 0 && bottom > top) {
+        if (scroll >= uint64_t(bottom - top)) {
+            return;
+        }
+        shift = static_cast<int32_t>(scroll);
+        regions.moves.push_back(FrameMove{0, top + shift, FrameRect{0, top, width, bottom - shift}});
+        regions.dirty.push_back(FrameRect{0, bottom - shift, width, bottom});
+    }
+
+    regions.full = false;
+    regions.dirty.push_back(cursorRect(previous, 0));
+    if (shift != 0) {
+        // The old cursor travelled with the scrolled text
+        FrameRect moved = cursorRect(previous, shift);
+        if (!moved.empty()) {
+            regions.dirty.push_back(moved);
+        }
+    }
+    regions.dirty.push_back(cursorRect(index, 0));
+}
+
+void SyntheticFrameSource::render(uint64_t index, FrameBuffer& target) const {
+    target.allocate(m_config.width, m_config.height);
+    uint32_t slide = mix(static_cast<uint32_t>(index / m_config.slideFrames) ^ m_config.seed);
+    uint32_t background = 0xff000000 | (0xc0c0c0 + (slide & 0x3f3f3f));
+    uint32_t ink = 0xff000000 | ((slide >> 8) & 0x3f3f3f);
+    uint64_t scroll = uint64_t(m_config.scrollPixels) * (index % m_config.slideFrames);
+
+    for (uint32_t y = 0; y < m_config.height; ++y) {
+        uint8_t* row = target.row(y);
+        fillSpan(row, 0, m_config.width, background);
+
+        // Text lines: each line is a run of word-sized blocks whose
+        // lengths come from the slide number and line index
+        uint64_t scrolled = y + scroll;
+        uint32_t line = static_cast<uint32_t>(scrolled / LINE_HEIGHT);
+        uint32_t inLine = static_cast<uint32_t>(scrolled % LINE_HEIGHT);
+        if (y < MARGIN || y + MARGIN >= m_config.height || inLine < 4 || inLine >= LINE_HEIGHT - 4) {
+            continue;
+        }
+        uint32_t words = mix(slide + line * 0x9e3779b9);
+        uint32_t x = MARGIN;
+        for (uint32_t word = 0; word < 16 && x + MARGIN < m_config.width; ++word) {
+            uint32_t length = 24 + (mix(words + word) % 96);
+            uint32_t end = std::min(x + length, m_config.width - MARGIN);
+            fillSpan(row, x, end, ink);
+            x = end + 12;
+        }
+    }
+
+    Cursor cursor = cursorAt(index);
+    for (uint32_t y = cursor.y; y < std::min(cursor.y + CURSOR_SIZE, m_config.height); ++y) {
+        fillSpan(target.row(y), cursor.x, std::min(cursor.x + CURSOR_SIZE, m_config.width), 0xffff2020);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "frame_source.h"
+
+struct SyntheticFrameSourceConfig {
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    double fps = 30.0;
+    uint64_t frameCount = 0;        // 0 runs forever
+    uint32_t slideFrames = 150;     // Frames between slide changes
+    uint32_t scrollPixels = 0;      // Text scrolls up this far each frame
+    bool paced = true;              // Deliver in real time; otherwise as fast as asked
+    uint32_t seed = 1;
+};
+
+// Deterministic stand-in for a presentation on screen: a slide of text
+// lines that changes every slideFrames frames, optionally scrolling, with
+// a cursor moving over it. Lets the capture pipeline and its consumers run
+// anywhere, not just on a Windows desktop. When paced and the caller falls
+// behind, frames that came due meanwhile are skipped and reported as
+// missed.
+//
+// Regions are reported the way desktop duplication would: a slide change
+// is full, scrolling is a move of the text area plus the newly exposed
+// strip, and the cursor dirties where it was and where it is.
+class SyntheticFrameSource : public FrameSource {
+public:
+    explicit SyntheticFrameSource(const SyntheticFrameSourceConfig& config = {});
+
+    CaptureStatus capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) override;
+
+    // Render frame index; also used to produce reference frames
+    void render(uint64_t index, FrameBuffer& target) const;
+
+private:
+    struct Cursor {
+        uint32_t x;
+        uint32_t y;
+    };
+
+    Cursor cursorAt(uint64_t index) const;
+    FrameRect cursorRect(uint64_t index, int32_t shift) const;
+    void describe(uint64_t previous, uint64_t index, FrameRegions& regions) const;
+
+    SyntheticFrameSourceConfig m_config;
+    std::chrono::steady_clock::duration m_period;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_next = 0;
+    uint64_t m_previous = 0;
+    bool m_hasPrevious = false;
+    bool m_started = false;
+};
@@ -0,0 +1,150 @@
+#include "task_pool.h"
+
+static inline uint64_t packShare(uint64_t begin, uint64_t end) {
+    return end << 32 | begin;
+}
+
+TaskPool::TaskPool(size_t workers) : m_shares(new Share[workers + 1]) {
+    m_workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&TaskPool::work, this, i + 1);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+TaskPool& TaskPool::getInstance() {
+    static TaskPool instance(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+    return instance;
+}
+
+void TaskPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || m_workers.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submit);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t threads = concurrency();
+        for (size_t i = 0; i < threads; ++i) {
+            m_shares[i].bounds.store(packShare(count * i / threads, count * (i + 1) / threads), std::memory_order_relaxed);
+        }
+        m_task = &task;
+        m_cancelled.store(false, std::memory_order_relaxed);
+        m_error = nullptr;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    drain(0);
+
+    std::exception_ptr error;
+    {
+        // Workers that woke late may still hold the job; wait them out so
+        // task can't be used after we return
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+        m_task = nullptr;
+        error = m_error;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool TaskPool::take(size_t self, size_t& index) {
+    std::atomic<uint64_t>& bounds = m_shares[self].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    for (;;) {
+        uint64_t begin = current & 0xffffffff;
+        uint64_t end = current >> 32;
+        if (begin >= end) {
+            return false;
+        }
+        if (bounds.compare_exchange_weak(current, packShare(begin + 1, end), std::memory_order_acq_rel)) {
+            index = static_cast<size_t>(begin);
+            return true;
+        }
+    }
+}
+
+bool TaskPool::steal(size_t self, size_t& index) {
+    size_t threads = concurrency();
+    for (size_t k = 1; k < threads; ++k) {
+        std::atomic<uint64_t>& bounds = m_shares[(self + k) % threads].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        for (;;) {
+            uint64_t begin = current & 0xffffffff;
+            uint64_t end = current >> 32;
+            if (begin >= end) {
+                break;
+            }
+            // Take the back half, leaving the owner the indices next to
+            // the ones it is working on
+            uint64_t split = end - (end - begin) / 2;
+            if (split == end) {
+                split = begin;
+            }
+            if (bounds.compare_exchange_weak(current, packShare(begin, split), std::memory_order_acq_rel)) {
+                // Our own share is empty, so no thief is touching it
+                m_shares[self].bounds.store(packShare(split + 1, end), std::memory_order_release);
+                index = static_cast<size_t>(split);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskPool::drain(size_t self) {
+    const std::function<void(size_t)>& task = *m_task;
+    size_t i;
+    while (!m_cancelled.load(std::memory_order_relaxed) && (take(self, i) || steal(self, i))) {
+        try {
+            task(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+            // Skip what's left
+            m_cancelled.store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+void TaskPool::work(size_t self) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [&]() { return m_stopping || (m_generation != seen && m_task); });
+        if (m_stopping) {
+            return;
+        }
+        seen = m_generation;
+        ++m_busy;
+        lock.unlock();
+        drain(self);
+        lock.lock();
+        if (--m_busy == 0) {
+            m_done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for splitting per-frame work into tiles or
+// bands. parallelFor() gives each thread, the caller included, an equal
+// contiguous share of the indices, so neighbouring tiles stay on one core.
+// A thread that runs out steals the back half of the fullest-looking
+// share it finds, so uneven tiles and workers that wake late balance out
+// without every index going through one shared counter. One parallelFor
+// runs at a time; concurrent callers queue.
+class TaskPool {
+public:
+    explicit TaskPool(size_t workers);
+    ~TaskPool();
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Shared pool with one worker per core besides the caller's
+    static TaskPool& getInstance();
+
+    // Threads that take part in a parallelFor, the caller included
+    size_t concurrency() const { return m_workers.size() + 1; }
+
+    // Call task(i) for every i in [0, count) and wait for all of them. The
+    // first exception thrown by a task is rethrown here. count must be
+    // below 2^32.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    // Indices [begin, end) a thread still has to run, packed as
+    // end << 32 | begin so the owner and thieves can update it with one
+    // compare-exchange. Padded to a cache line each.
+    struct alignas(64) Share {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    void work(size_t self);
+    void drain(size_t self);
+    bool take(size_t self, size_t& index);
+    bool steal(size_t self, size_t& index);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_submit;        // Serialises parallelFor callers
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    bool m_stopping = false;
+    size_t m_busy = 0;          // Workers inside the current job
+
+    const std::function<void(size_t)>* m_task = nullptr;
+    std::unique_ptr<Share[]> m_shares;  // One per thread; the caller's is 0
+    std::atomic<bool> m_cancelled{false};
+    std::exception_ptr m_error;
+};
+
+// Split rows into bands of bandRows and call band(first, count) for each
+// across the pool
+inline void forEachBand(TaskPool& pool, uint32_t rows, uint32_t bandRows,
+                        const std::function<void(uint32_t, uint32_t)>& band) {
+    bandRows = bandRows ? bandRows : 1;
+    size_t bands = (rows + bandRows - 1) / bandRows;
+    pool.parallelFor(bands, [&](size_t i) {
+        uint32_t first = static_cast<uint32_t>(i) * bandRows;
+        band(first, first + bandRows <= rows ? bandRows : rows - first);
+    });
+}
@@ -0,0 +1,116 @@
+#include "text_extractor.h"
+#include <chrono>
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+TextExtractor::TextExtractor(std::unique_ptr<OcrEngine> engine, const OcrPreprocessorConfig& config, Callback onResult)
+    : m_engine(std::move(engine))
+    , m_preprocessor(config)
+    , m_onResult(std::move(onResult))
+{
+}
+
+TextExtractor::~TextExtractor() {
+    stop();
+}
+
+void TextExtractor::submit(const FrameHandle& frame, uint64_t slideId) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.submitted;
+        if (m_pending) {
+            ++m_stats.skipped;
+        }
+        m_pending = frame;
+        m_pendingSlide = slideId;
+    }
+    m_wake.notify_one();
+}
+
+TextExtractorResult TextExtractor::extract(const FrameBuffer& frame) {
+    TextExtractorResult result;
+    auto start = std::chrono::steady_clock::now();
+    const OcrPage& page = m_preprocessor.process(frame);
+    result.preprocessMs = millisecondsSince(start);
+    result.skewDegrees = page.skewDegrees;
+    result.regions = page.regions.size();
+
+    if (m_engine) {
+        start = std::chrono::steady_clock::now();
+        for (const TextRegion& region : page.regions) {
+            OcrLine line;
+            line.bounds = region.bounds;
+            if (m_engine->recognize(page.image, region.bounds, line)) {
+                result.lines.push_back(std::move(line));
+            }
+        }
+        result.recognizeMs = millisecondsSince(start);
+    }
+    return result;
+}
+
+bool TextExtractor::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable()) {
+        return false;
+    }
+    m_stopping = false;
+    m_thread = std::thread(&TextExtractor::run, this);
+    return true;
+}
+
+void TextExtractor::stop() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        stopped = std::move(m_thread);
+    }
+    m_wake.notify_all();
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.reset();
+}
+
+TextExtractorResult TextExtractor::latest() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latest;
+}
+
+TextExtractorStats TextExtractor::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void TextExtractor::run() {
+    for (;;) {
+        FrameHandle frame;
+        uint64_t slideId;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || m_pending; });
+            if (m_stopping) {
+                return;
+            }
+            frame = std::move(m_pending);
+            slideId = m_pendingSlide;
+        }
+
+        TextExtractorResult result = extract(frame.buffer());
+        result.slideId = slideId;
+        result.sequence = frame.info().sequence;
+        frame.reset();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_latest = result;
+            ++m_stats.extracted;
+        }
+        if (m_onResult) {
+            m_onResult(result);
+        }
+    }
+}
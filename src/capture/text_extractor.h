@@ -0,0 +1,74 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "frame_pool.h"
+#include "ocr_engine.h"
+#include "ocr_preprocessor.h"
+
+struct TextExtractorResult {
+    uint64_t slideId = 0;           // 0 until the first frame is done
+    uint64_t sequence = 0;          // Frame the text was taken from
+    float skewDegrees = 0.0f;
+    size_t regions = 0;             // Text lines found, read or not
+    std::vector<OcrLine> lines;     // Lines the engine read
+    double preprocessMs = 0.0;
+    double recognizeMs = 0.0;
+};
+
+struct TextExtractorStats {
+    uint64_t submitted;
+    uint64_t skipped;       // Replaced by a newer frame before being reached
+    uint64_t extracted;
+};
+
+// Reads the text of frames handed to it, normally the SlideDetector's new
+// slides, on a thread of its own: OcrPreprocessor, then the engine for
+// each text line. Only the newest frame waits; a slide that was replaced
+// before its turn is skipped. A waiting frame pins a pool frame, so at
+// most two are held at any time.
+//
+// Without an engine the regions are still found and counted, which is
+// what the Assistance tab shows until one is installed.
+class TextExtractor {
+public:
+    using Callback = std::function<void(const TextExtractorResult&)>;
+
+    explicit TextExtractor(std::unique_ptr<OcrEngine> engine, const OcrPreprocessorConfig& config = {},
+                           Callback onResult = nullptr);
+    ~TextExtractor();
+    TextExtractor(const TextExtractor&) = delete;
+    TextExtractor& operator=(const TextExtractor&) = delete;
+
+    // Queue frame for the extraction thread
+    void submit(const FrameHandle& frame, uint64_t slideId);
+
+    // Extract on the caller's thread; not to be mixed with start()
+    TextExtractorResult extract(const FrameBuffer& frame);
+
+    bool start();
+    void stop();
+
+    TextExtractorResult latest() const;
+    TextExtractorStats stats() const;
+
+private:
+    void run();
+
+    std::unique_ptr<OcrEngine> m_engine;
+    OcrPreprocessor m_preprocessor;
+    Callback m_onResult;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    FrameHandle m_pending;
+    uint64_t m_pendingSlide = 0;
+    TextExtractorResult m_latest;
+    TextExtractorStats m_stats = {};
+    bool m_stopping = false;
+    std::thread m_thread;
+};
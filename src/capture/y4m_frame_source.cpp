@@ -0,0 +1,272 @@
+#include "y4m_frame_source.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+static const char Y4M_MAGIC[] = "YUV4MPEG2";
+static const uint32_t DIFF_BLOCK = 16;
+
+static inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// BT.601 limited range in 8.8 fixed point
+static inline void yuvToBgra(int y, int u, int v, uint8_t* out) {
+    int c = 298 * (y - 16) + 128;
+    int d = u - 128;
+    int e = v - 128;
+    out[0] = clampByte((c + 516 * d) >> 8);
+    out[1] = clampByte((c - 100 * d - 208 * e) >> 8);
+    out[2] = clampByte((c + 409 * e) >> 8);
+    out[3] = 255;
+}
+
+bool Y4mFrameSource::open(const std::string& path, bool paced, bool loop) {
+    m_file.close();
+    m_file.clear();
+    m_frameBytes = 0;
+    m_file.open(path, std::ios::binary);
+    if (!m_file) {
+        return false;
+    }
+
+    std::string header;
+    if (!std::getline(m_file, header) || !parseHeader(header)) {
+        m_file.close();
+        m_frameBytes = 0;
+        return false;
+    }
+
+    m_firstFrame = m_file.tellg();
+    m_planes.resize(m_frameBytes);
+    m_paced = paced;
+    m_loop = loop;
+    m_index = 0;
+    m_hasPrevious = false;
+    return true;
+}
+
+bool Y4mFrameSource::parseHeader(const std::string& header) {
+    std::istringstream tokens(header);
+    std::string token;
+    if (!(tokens >> token) || token != Y4M_MAGIC) {
+        return false;
+    }
+
+    m_width = 0;
+    m_height = 0;
+    m_chroma = Chroma::Yuv420;
+    while (tokens >> token) {
+        const char* value = token.c_str() + 1;
+        switch (token[0]) {
+            case 'W':
+                m_width = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+                break;
+            case 'H':
+                m_height = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+                break;
+            case 'F': {
+                char* colon = nullptr;
+                unsigned long num = std::strtoul(value, &colon, 10);
+                unsigned long den = (colon && *colon == ':') ? std::strtoul(colon + 1, nullptr, 10) : 0;
+                if (num != 0 && den != 0) {
+                    m_fpsNum = static_cast<uint32_t>(num);
+                    m_fpsDen = static_cast<uint32_t>(den);
+                }
+                break;
+            }
+            case 'C':
+                // 420, 420jpeg, 420mpeg2 and 420paldv differ only in chroma
+                // siting, which nearest-sample upscaling ignores
+                if (std::strncmp(value, "420", 3) == 0) {
+                    m_chroma = Chroma::Yuv420;
+                } else if (std::strcmp(value, "444") == 0) {
+                    m_chroma = Chroma::Yuv444;
+                } else if (std::strcmp(value, "mono") == 0) {
+                    m_chroma = Chroma::Mono;
+                } else {
+                    return false;   // 4:2:2, alpha and high bit depths
+                }
+                break;
+            case 'I':
+                if (token != "Ip" && token != "I?") {
+                    return false;
+                }
+                break;
+            default:
+                break;              // Aspect ratio, comments (X...)
+        }
+    }
+    if (m_width == 0 || m_height == 0 || m_width > 16384 || m_height > 16384) {
+        return false;
+    }
+
+    size_t luma = size_t(m_width) * m_height;
+    size_t chroma = 0;
+    if (m_chroma == Chroma::Yuv420) {
+        chroma = size_t((m_width + 1) / 2) * ((m_height + 1) / 2);
+    } else if (m_chroma == Chroma::Yuv444) {
+        chroma = luma;
+    }
+    m_frameBytes = luma + 2 * chroma;
+    return true;
+}
+
+bool Y4mFrameSource::readFrame() {
+    std::string marker;
+    if (!std::getline(m_file, marker) || marker.compare(0, 5, "FRAME") != 0) {
+        return false;
+    }
+    return static_cast<bool>(m_file.read(reinterpret_cast<char*>(m_planes.data()), m_frameBytes));
+}
+
+CaptureStatus Y4mFrameSource::capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) {
+    if (!isOpen()) {
+        return CaptureStatus::Error;
+    }
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(double(m_fpsDen) / m_fpsNum));
+    uint32_t missed = 0;
+    if (m_paced) {
+        auto now = std::chrono::steady_clock::now();
+        if (m_index == 0) {
+            m_start = now;
+        }
+        auto due = m_start + period * m_index;
+        if (now < due) {
+            if (due - now > timeout) {
+                std::this_thread::sleep_for(timeout);
+                return CaptureStatus::Timeout;
+            }
+            std::this_thread::sleep_until(due);
+        } else {
+            // Skip frames that came due while the caller was busy. Seeking
+            // is cheaper than reading, but frame headers may carry
+            // parameters, so each skipped frame is still read.
+            uint64_t behind = static_cast<uint64_t>((now - due) / period);
+            for (; missed < behind; ++missed) {
+                if (!readFrame()) {
+                    break;
+                }
+                ++m_index;
+            }
+        }
+    }
+
+    if (!readFrame()) {
+        if (!m_loop || m_index == 0) {
+            return CaptureStatus::Ended;
+        }
+        m_file.clear();
+        m_file.seekg(m_firstFrame);
+        if (!readFrame()) {
+            return CaptureStatus::Ended;
+        }
+    }
+
+    convert(target);
+    describe(info.regions);
+    info.presentTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(period * m_index).count();
+    info.missedFrames = missed;
+    ++m_index;
+    return CaptureStatus::Captured;
+}
+
+bool Y4mFrameSource::blockChanged(uint32_t column, uint32_t row) const {
+    uint32_t left = column * DIFF_BLOCK;
+    uint32_t top = row * DIFF_BLOCK;
+    uint32_t right = std::min(left + DIFF_BLOCK, m_width);
+    uint32_t bottom = std::min(top + DIFF_BLOCK, m_height);
+    for (uint32_t y = top; y < bottom; ++y) {
+        size_t offset = size_t(y) * m_width + left;
+        if (std::memcmp(&m_planes[offset], &m_previous[offset], right - left) != 0) {
+            return true;
+        }
+    }
+    if (m_chroma == Chroma::Mono) {
+        return false;
+    }
+
+    uint32_t shift = m_chroma == Chroma::Yuv420 ? 1 : 0;
+    size_t chromaWidth = m_chroma == Chroma::Yuv420 ? (m_width + 1) / 2 : m_width;
+    size_t chromaHeight = m_chroma == Chroma::Yuv420 ? (m_height + 1) / 2 : m_height;
+    size_t chromaLeft = left >> shift;
+    size_t chromaRight = (right + shift) >> shift;
+    for (size_t plane = 0; plane < 2; ++plane) {
+        size_t base = size_t(m_width) * m_height + plane * chromaWidth * chromaHeight;
+        for (size_t y = top >> shift; y < (bottom + shift) >> shift; ++y) {
+            size_t offset = base + y * chromaWidth + chromaLeft;
+            if (std::memcmp(&m_planes[offset], &m_previous[offset], chromaRight - chromaLeft) != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Y4mFrameSource::describe(FrameRegions& regions) {
+    regions.clear();
+    if (m_hasPrevious) {
+        regions.full = false;
+        uint32_t columns = (m_width + DIFF_BLOCK - 1) / DIFF_BLOCK;
+        uint32_t rows = (m_height + DIFF_BLOCK - 1) / DIFF_BLOCK;
+        for (uint32_t row = 0; row < rows; ++row) {
+            // One rect per run of changed blocks
+            uint32_t column = 0;
+            while (column < columns) {
+                if (!blockChanged(column, row)) {
+                    ++column;
+                    continue;
+                }
+                uint32_t first = column;
+                while (column < columns && blockChanged(column, row)) {
+                    ++column;
+                }
+                regions.dirty.push_back(FrameRect{
+                    static_cast<int32_t>(first * DIFF_BLOCK), static_cast<int32_t>(row * DIFF_BLOCK),
+                    static_cast<int32_t>(std::min(column * DIFF_BLOCK, m_width)),
+                    static_cast<int32_t>(std::min((row + 1) * DIFF_BLOCK, m_height))});
+            }
+        }
+    }
+    m_previous.swap(m_planes);
+    m_previous.resize(m_frameBytes);
+    m_planes.resize(m_frameBytes);
+    m_hasPrevious = true;
+}
+
+void Y4mFrameSource::convert(FrameBuffer& target) const {
+    target.allocate(m_width, m_height);
+    const uint8_t* lumaPlane = m_planes.data();
+    size_t chromaWidth = m_chroma == Chroma::Yuv420 ? (m_width + 1) / 2 : m_width;
+    size_t chromaHeight = m_chroma == Chroma::Yuv420 ? (m_height + 1) / 2 : m_height;
+    const uint8_t* uPlane = lumaPlane + size_t(m_width) * m_height;
+    const uint8_t* vPlane = uPlane + chromaWidth * chromaHeight;
+
+    for (uint32_t y = 0; y < m_height; ++y) {
+        const uint8_t* luma = lumaPlane + size_t(y) * m_width;
+        uint8_t* out = target.row(y);
+        if (m_chroma == Chroma::Mono) {
+            for (uint32_t x = 0; x < m_width; ++x) {
+                yuvToBgra(luma[x], 128, 128, out + x * 4);
+            }
+            continue;
+        }
+
+        size_t chromaRow = (m_chroma == Chroma::Yuv420 ? y / 2 : y) * chromaWidth;
+        const uint8_t* u = uPlane + chromaRow;
+        const uint8_t* v = vPlane + chromaRow;
+        if (m_chroma == Chroma::Yuv420) {
+            for (uint32_t x = 0; x < m_width; ++x) {
+                yuvToBgra(luma[x], u[x / 2], v[x / 2], out + x * 4);
+            }
+        } else {
+            for (uint32_t x = 0; x < m_width; ++x) {
+                yuvToBgra(luma[x], u[x], v[x], out + x * 4);
+            }
+        }
+    }
+}
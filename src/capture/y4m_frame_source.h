@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "frame_source.h"
+
+// Replays a YUV4MPEG2 (.y4m) recording, e.g. from
+//   ffmpeg -i talk.mp4 -pix_fmt yuv420p talk.y4m
+// so capture consumers can be run and profiled against a real session
+// without a desktop. Supports 4:2:0, 4:4:4 and mono streams in 8 bits,
+// converted to BGRA with BT.601 limited-range coefficients.
+//
+// A recording has no region metadata, so dirty rects are found by
+// comparing each frame with the previous one in 16x16 blocks. Moves are
+// never reported.
+class Y4mFrameSource : public FrameSource {
+public:
+    Y4mFrameSource() = default;
+
+    // Reads the stream header. paced plays at the stream's frame rate,
+    // otherwise frames come as fast as they are asked for; loop restarts
+    // at the first frame instead of ending.
+    bool open(const std::string& path, bool paced = false, bool loop = false);
+    bool isOpen() const { return m_frameBytes != 0; }
+
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    double fps() const { return m_fpsDen ? double(m_fpsNum) / m_fpsDen : 0.0; }
+
+    CaptureStatus capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) override;
+
+private:
+    enum class Chroma {
+        Yuv420,
+        Yuv444,
+        Mono
+    };
+
+    bool parseHeader(const std::string& header);
+    bool readFrame();
+    void convert(FrameBuffer& target) const;
+    bool blockChanged(uint32_t column, uint32_t row) const;
+    void describe(FrameRegions& regions);
+
+    std::ifstream m_file;
+    std::streampos m_firstFrame;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_fpsNum = 30;
+    uint32_t m_fpsDen = 1;
+    Chroma m_chroma = Chroma::Yuv420;
+    size_t m_frameBytes = 0;
+    std::vector<uint8_t> m_planes;
+    std::vector<uint8_t> m_previous;    // Planes of the last delivered frame
+    bool m_hasPrevious = false;
+
+    bool m_paced = false;
+    bool m_loop = false;
+    uint64_t m_index = 0;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -17,6 +17,12 @@
 #include "auth/auth.h"
 #include "ui/signup_panel.h"
 #include "ui/login_panel.h"
+#include "services/utf_transcode.h"
+#include "services/exchange_rate_service.h"
+#include "capture/capture_pipeline.h"
+#include "capture/dxgi_frame_source.h"
+#include "capture/slide_detector.h"
+#include "capture/text_extractor.h"
 
 #pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "user32.lib")
@@ -32,6 +38,10 @@ HWND g_hwnd = nullptr;
 ID3D11Device* g_device = nullptr;
 ID3D11DeviceContext* g_context = nullptr;
 IDXGIOutputDuplication* g_deskDupl = nullptr;
+std::unique_ptr<CapturePipeline> g_capture;
+std::unique_ptr<SlideDetector> g_slideDetector;
+std::unique_ptr<TextExtractor> g_textExtractor;
+std::wstring g_slideText;
 NOTIFYICONDATA g_nid = {};
 bool g_isMinimized = false;
 
@@ -39,6 +49,8 @@ bool g_isMinimized = false;
 std::unique_ptr<SignupPanel> g_signupPanel;
 std::unique_ptr<LoginPanel> g_loginPanel;
 bool g_isAuthenticated = false;
+std::string g_authStatusEmail;
+std::wstring g_authStatusText;
 
 // Navigation IDs
 const int ID_NAV_ACTIVATION = 4001;
@@ -49,6 +61,7 @@ const int ID_NAV_FEEDBACK = 4005;
 
 // Constants for window messages
 const UINT WM_TRAYICON = WM_USER + 1;
+const UINT WM_TEXT_EXTRACTED = WM_USER + 2;
 const UINT IDM_RESTORE = 3000;
 const UINT IDM_EXIT = 3001;
 
@@ -74,11 +87,21 @@ void ShowTabContent(HWND hwnd, int tabId);
 void DrawTabContent(HDC hdc, const RECT& contentRect, int tabId);
 void InitializeAuthUI(HWND hwnd);
 void ShowAuthenticationStatus(HDC hdc, const RECT& rect);
+void ShowSlideText(HDC hdc, const RECT& rect);
+void UpdateSlideText();
+void UpdateCaptureState();
 
 void InitializeLocation() {
+    // Rates for showing prices in the detected currency; edits to the
+    // file are picked up without a restart
+    ExchangeRateService::getInstance().startWatching(ExchangeRateService::ratesPath());
+
     // Initialize location service in a separate thread
     CreateThread(nullptr, 0, [](LPVOID) -> DWORD {
-        LocationService::getInstance().getLocationInfo();
+        LocationService& service = LocationService::getInstance();
+        service.getLocationInfo();
+        // Follow VPN and Wi-Fi switches for the rest of the session
+        service.startNetworkMonitoring();
         return 0;
     }, nullptr, 0, nullptr);
 }
@@ -96,9 +119,64 @@ bool InitializeDirectX() {
 
     if (FAILED(hr)) return false;
 
+    // Not fatal: duplication is unavailable in some remote sessions and
+    // the capture source keeps retrying
+    DxgiFrameSource::createDuplication(g_device, 0, &g_deskDupl);
     return true;
 }
 
+// Desktop frames for the assistance features. The source takes over
+// g_deskDupl since it must recreate the duplication when access is lost;
+// later starts let it create its own. Each new slide goes to the text
+// extractor, whose results are handed to the window thread for the
+// Assistance tab.
+void StartCapture() {
+    g_capture = std::make_unique<CapturePipeline>(
+        std::make_unique<DxgiFrameSource>(g_device, g_context, g_deskDupl, 0));
+    g_deskDupl = nullptr;
+
+    // No recognition engine ships yet; text regions are still found
+    g_textExtractor = std::make_unique<TextExtractor>(nullptr, OcrPreprocessorConfig(),
+        [](const TextExtractorResult&) {
+            PostMessageW(g_hwnd, WM_TEXT_EXTRACTED, 0, 0);
+        });
+    g_slideDetector = std::make_unique<SlideDetector>(SlideDetectorConfig(),
+        [](const SlideEvent& event) {
+            g_textExtractor->submit(event.frame, event.slideId);
+        });
+    g_textExtractor->start();
+    g_slideDetector->start(g_capture->subscribe());
+    g_capture->start();
+}
+
+void StopCapture() {
+    // Upstream first, so nothing is handed to a stopped stage
+    if (g_capture) {
+        g_capture->stop();
+    }
+    if (g_slideDetector) {
+        g_slideDetector->stop();
+    }
+    if (g_textExtractor) {
+        g_textExtractor->stop();
+    }
+    g_slideDetector.reset();
+    g_textExtractor.reset();
+    g_capture.reset();
+    g_slideText.clear();
+}
+
+// The screen is only captured and read while a signed-in user has the
+// Assistance tab open
+void UpdateCaptureState() {
+    bool wanted = g_isAuthenticated && g_activeTab == ID_NAV_ASSISTANCE && g_device != nullptr;
+    if (wanted && !g_capture) {
+        StartCapture();
+    } else if (!wanted && g_capture) {
+        StopCapture();
+    }
+}
+
 void CreateTrayIcon(HWND hwnd) {
     g_nid = {};
     g_nid.cbSize = sizeof(NOTIFYICONDATA);
@@ -200,9 +278,14 @@ void CreateHeaderControls(HWND hwnd) {
 
 void ShowAuthenticationStatus(HDC hdc, const RECT& rect) {
     if (g_isAuthenticated) {
-        std::wstring email = std::wstring(AuthenticationManager::getInstance().getCurrentUserEmail().begin(),
-                                        AuthenticationManager::getInstance().getCurrentUserEmail().end());
-        std::wstring status = L"Activated\nEmail: " + email;
+        // Converted only when the signed-in email changes, not on every paint
+        std::string email = AuthenticationManager::getInstance().getCurrentUserEmail();
+        if (g_authStatusText.empty() || email != g_authStatusEmail) {
+            g_authStatusEmail = email;
+            g_authStatusText = L"Activated\nEmail: ";
+            appendUtf8AsWide(email, g_authStatusText);
+        }
+        const std::wstring& status = g_authStatusText;
         
         SelectObject(hdc, g_headerFont);
         SetTextColor(hdc, RGB(0, 128, 0));
@@ -215,6 +298,52 @@ void ShowAuthenticationStatus(HDC hdc, const RECT& rect) {
     }
 }
 
+// Rebuilt when a result arrives rather than on every paint
+void UpdateSlideText() {
+    TextExtractorResult result = g_textExtractor->latest();
+    if (result.slideId == 0) {
+        g_slideText.clear();
+        return;
+    }
+    g_slideText = L"Slide " + std::to_wstring(result.slideId) + L": "
+        + std::to_wstring(result.regions) + L" lines of text\n";
+    if (result.lines.empty() && result.regions > 0) {
+        g_slideText += L"No text recognition engine installed\n";
+    }
+    for (const OcrLine& line : result.lines) {
+        g_slideText += L"\n";
+        appendUtf8AsWide(line.text, g_slideText);
+    }
+}
+
+void ShowSlideText(HDC hdc, const RECT& rect) {
+    const wchar_t* text = !g_isAuthenticated ? L"Activate MeetAssist to read slides"
+        : g_slideText.empty() ? L"Waiting for the first slide" : g_slideText.c_str();
+
+    SelectObject(hdc, g_headerFont);
+    SetTextColor(hdc, RGB(0, 0, 0));
+    SetBkMode(hdc, TRANSPARENT);
+
+    RECT textRect = rect;
+    textRect.left += 20;
+    textRect.top += 20;
+    textRect.right -= 20;
+    DrawTextW(hdc, text, -1, &textRect, DT_LEFT | DT_WORDBREAK | DT_NOPREFIX);
+}
+
+void DrawTabContent(HDC hdc, const RECT& contentRect, int tabId) {
+    switch (tabId) {
+        case ID_NAV_ACTIVATION:
+            if (g_isAuthenticated) {
+                ShowAuthenticationStatus(hdc, contentRect);
+            }
+            break;
+        case ID_NAV_ASSISTANCE:
+            ShowSlideText(hdc, contentRect);
+            break;
+    }
+}
+
 void ShowTabContent(HWND hwnd, int tabId) {
     RECT clientRect;
     GetClientRect(hwnd, &clientRect);
@@ -245,6 +374,7 @@ void ShowTabContent(HWND hwnd, int tabId) {
         if (g_loginPanel) g_loginPanel->Hide();
     }
 
+    UpdateCaptureState();
     RedrawWindow(hwnd, NULL, NULL, RDW_INVALIDATE | RDW_UPDATENOW);
 }
 
@@ -306,9 +436,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             FillRect(hdc, &contentRect, (HBRUSH)(COLOR_WINDOW + 1));
 
             // Draw specific tab content
-            if (g_activeTab == ID_NAV_ACTIVATION && g_isAuthenticated) {
-                ShowAuthenticationStatus(hdc, contentRect);
-            }
+            DrawTabContent(hdc, contentRect, g_activeTab);
             
             EndPaint(hwnd, &ps);
             return 0;
@@ -364,7 +492,22 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             }
             break;
 
+        case WM_TEXT_EXTRACTED:
+            if (g_textExtractor) {
+                UpdateSlideText();
+            }
+            if (g_activeTab == ID_NAV_ASSISTANCE) {
+                RECT contentRect;
+                GetClientRect(hwnd, &contentRect);
+                contentRect.top = HEADER_HEIGHT;
+                InvalidateRect(hwnd, &contentRect, TRUE);
+            }
+            return 0;
+
         case WM_DESTROY:
+            StopCapture();
+            LocationService::getInstance().stopNetworkMonitoring();
+            ExchangeRateService::getInstance().stopWatching();
             DeleteObject(g_headerBrush);
             DeleteObject(g_activeTabBrush);
             DeleteObject(g_headerFont);
@@ -413,9 +556,10 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         bool currentAuthStatus = AuthenticationManager::getInstance().isUserLoggedIn();
         if (g_isAuthenticated != currentAuthStatus) {
             g_isAuthenticated = currentAuthStatus;
-            if (g_activeTab == ID_NAV_ACTIVATION) {
-                ShowTabContent(g_hwnd, ID_NAV_ACTIVATION);
+            if (g_activeTab == ID_NAV_ACTIVATION || g_activeTab == ID_NAV_ASSISTANCE) {
+                ShowTabContent(g_hwnd, g_activeTab);
             }
+            UpdateCaptureState();
         }
     }
 
@@ -0,0 +1,15 @@
+#pragma once
+#include "currency_table.h"
+#include "location_info.h"
+
+// Set info's currency from the compiled-in ISO 4217 table. Returns false
+// for a country the table doesn't know, which is left to a network lookup.
+inline bool applyTableCurrency(const CountryCode& countryCode, LocationInfo& info) {
+    const CurrencyInfo* currency = findCurrencyByCountry(countryCode.view());
+    if (!currency) {
+        return false;
+    }
+    info.currency.assign(currency->code);
+    info.currency_symbol = InternedString::intern(currency->symbol);
+    return true;
+}
@@ -0,0 +1,558 @@
+// Generated by tools/currency_table/gen_currency_table.py from iso4217.csv.
+// Do not edit by hand.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+struct CurrencyInfo {
+    std::string_view countryCode;   // ISO 3166-1 alpha-2
+    std::string_view code;          // ISO 4217
+    std::string_view symbol;        // UTF-8
+    uint8_t minorUnits;
+};
+
+inline constexpr CurrencyInfo CURRENCY_TABLE[] = {
+    {"AD", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"AE", "AED", "\xD8\xAF.\xD8\xA5", 2},  // د.إ
+    {"AF", "AFN", "\xD8\x8B", 2},  // ؋
+    {"AG", "XCD", "$", 2},
+    {"AI", "XCD", "$", 2},
+    {"AL", "ALL", "L", 2},
+    {"AM", "AMD", "\xD6\x8F", 2},  // ֏
+    {"AO", "AOA", "Kz", 2},
+    {"AQ", "USD", "$", 2},
+    {"AR", "ARS", "$", 2},
+    {"AS", "USD", "$", 2},
+    {"AT", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"AU", "AUD", "$", 2},
+    {"AW", "AWG", "\xC6\x92", 2},  // ƒ
+    {"AX", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"AZ", "AZN", "\xE2\x82\xBC", 2},  // ₼
+    {"BA", "BAM", "KM", 2},
+    {"BB", "BBD", "$", 2},
+    {"BD", "BDT", "\xE0\xA7\xB3", 2},  // ৳
+    {"BE", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"BF", "XOF", "CFA", 0},
+    {"BG", "BGN", "\xD0\xBB\xD0\xB2", 2},  // лв
+    {"BH", "BHD", ".\xD8\xAF.\xD8\xA8", 3},  // .د.ب
+    {"BI", "BIF", "FBu", 0},
+    {"BJ", "XOF", "CFA", 0},
+    {"BL", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"BM", "BMD", "$", 2},
+    {"BN", "BND", "$", 2},
+    {"BO", "BOB", "Bs", 2},
+    {"BQ", "USD", "$", 2},
+    {"BR", "BRL", "R$", 2},
+    {"BS", "BSD", "$", 2},
+    {"BT", "BTN", "Nu.", 2},
+    {"BV", "NOK", "kr", 2},
+    {"BW", "BWP", "P", 2},
+    {"BY", "BYN", "Br", 2},
+    {"BZ", "BZD", "$", 2},
+    {"CA", "CAD", "$", 2},
+    {"CC", "AUD", "$", 2},
+    {"CD", "CDF", "FC", 2},
+    {"CF", "XAF", "FCFA", 0},
+    {"CG", "XAF", "FCFA", 0},
+    {"CH", "CHF", "CHF", 2},
+    {"CI", "XOF", "CFA", 0},
+    {"CK", "NZD", "$", 2},
+    {"CL", "CLP", "$", 0},
+    {"CM", "XAF", "FCFA", 0},
+    {"CN", "CNY", "\xC2\xA5", 2},  // ¥
+    {"CO", "COP", "$", 2},
+    {"CR", "CRC", "\xE2\x82\xA1", 2},  // ₡
+    {"CU", "CUP", "$", 2},
+    {"CV", "CVE", "$", 2},
+    {"CW", "XCG", "Cg", 2},
+    {"CX", "AUD", "$", 2},
+    {"CY", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"CZ", "CZK", "K\xC4\x8D", 2},  // Kč
+    {"DE", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"DJ", "DJF", "Fdj", 0},
+    {"DK", "DKK", "kr", 2},
+    {"DM", "XCD", "$", 2},
+    {"DO", "DOP", "$", 2},
+    {"DZ", "DZD", "\xD8\xAF.\xD8\xAC", 2},  // د.ج
+    {"EC", "USD", "$", 2},
+    {"EE", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"EG", "EGP", "E\xC2\xA3", 2},  // E£
+    {"EH", "MAD", "\xD8\xAF.\xD9\x85.", 2},  // د.م.
+    {"ER", "ERN", "Nfk", 2},
+    {"ES", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"ET", "ETB", "Br", 2},
+    {"EU", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"FI", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"FJ", "FJD", "$", 2},
+    {"FK", "FKP", "\xC2\xA3", 2},  // £
+    {"FM", "USD", "$", 2},
+    {"FO", "DKK", "kr", 2},
+    {"FR", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"GA", "XAF", "FCFA", 0},
+    {"GB", "GBP", "\xC2\xA3", 2},  // £
+    {"GD", "XCD", "$", 2},
+    {"GE", "GEL", "\xE2\x82\xBE", 2},  // ₾
+    {"GF", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"GG", "GBP", "\xC2\xA3", 2},  // £
+    {"GH", "GHS", "\xE2\x82\xB5", 2},  // ₵
+    {"GI", "GIP", "\xC2\xA3", 2},  // £
+    {"GL", "DKK", "kr", 2},
+    {"GM", "GMD", "D", 2},
+    {"GN", "GNF", "FG", 0},
+    {"GP", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"GQ", "XAF", "FCFA", 0},
+    {"GR", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"GS", "GBP", "\xC2\xA3", 2},  // £
+    {"GT", "GTQ", "Q", 2},
+    {"GU", "USD", "$", 2},
+    {"GW", "XOF", "CFA", 0},
+    {"GY", "GYD", "$", 2},
+    {"HK", "HKD", "$", 2},
+    {"HM", "AUD", "$", 2},
+    {"HN", "HNL", "L", 2},
+    {"HR", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"HT", "HTG", "G", 2},
+    {"HU", "HUF", "Ft", 2},
+    {"ID", "IDR", "Rp", 2},
+    {"IE", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"IL", "ILS", "\xE2\x82\xAA", 2},  // ₪
+    {"IM", "GBP", "\xC2\xA3", 2},  // £
+    {"IN", "INR", "\xE2\x82\xB9", 2},  // ₹
+    {"IO", "USD", "$", 2},
+    {"IQ", "IQD", "\xD8\xB9.\xD8\xAF", 3},  // ع.د
+    {"IR", "IRR", "\xEF\xB7\xBC", 2},  // ﷼
+    {"IS", "ISK", "kr", 0},
+    {"IT", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"JE", "GBP", "\xC2\xA3", 2},  // £
+    {"JM", "JMD", "$", 2},
+    {"JO", "JOD", "\xD8\xAF.\xD8\xA7", 3},  // د.ا
+    {"JP", "JPY", "\xC2\xA5", 0},  // ¥
+    {"KE", "KES", "KSh", 2},
+    {"KG", "KGS", "\xD1\x81", 2},  // с
+    {"KH", "KHR", "\xE1\x9F\x9B", 2},  // ៛
+    {"KI", "AUD", "$", 2},
+    {"KM", "KMF", "CF", 0},
+    {"KN", "XCD", "$", 2},
+    {"KP", "KPW", "\xE2\x82\xA9", 2},  // ₩
+    {"KR", "KRW", "\xE2\x82\xA9", 0},  // ₩
+    {"KW", "KWD", "\xD8\xAF.\xD9\x83", 3},  // د.ك
+    {"KY", "KYD", "$", 2},
+    {"KZ", "KZT", "\xE2\x82\xB8", 2},  // ₸
+    {"LA", "LAK", "\xE2\x82\xAD", 2},  // ₭
+    {"LB", "LBP", "\xD9\x84.\xD9\x84", 2},  // ل.ل
+    {"LC", "XCD", "$", 2},
+    {"LI", "CHF", "CHF", 2},
+    {"LK", "LKR", "Rs", 2},
+    {"LR", "LRD", "$", 2},
+    {"LS", "LSL", "L", 2},
+    {"LT", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"LU", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"LV", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"LY", "LYD", "\xD9\x84.\xD8\xAF", 3},  // ل.د
+    {"MA", "MAD", "\xD8\xAF.\xD9\x85.", 2},  // د.م.
+    {"MC", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"MD", "MDL", "L", 2},
+    {"ME", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"MF", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"MG", "MGA", "Ar", 2},
+    {"MH", "USD", "$", 2},
+    {"MK", "MKD", "\xD0\xB4\xD0\xB5\xD0\xBD", 2},  // ден
+    {"ML", "XOF", "CFA", 0},
+    {"MM", "MMK", "K", 2},
+    {"MN", "MNT", "\xE2\x82\xAE", 2},  // ₮
+    {"MO", "MOP", "MOP$", 2},
+    {"MP", "USD", "$", 2},
+    {"MQ", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"MR", "MRU", "UM", 2},
+    {"MS", "XCD", "$", 2},
+    {"MT", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"MU", "MUR", "\xE2\x82\xA8", 2},  // ₨
+    {"MV", "MVR", "Rf", 2},
+    {"MW", "MWK", "MK", 2},
+    {"MX", "MXN", "$", 2},
+    {"MY", "MYR", "RM", 2},
+    {"MZ", "MZN", "MT", 2},
+    {"NA", "NAD", "$", 2},
+    {"NC", "XPF", "\xE2\x82\xA3", 0},  // ₣
+    {"NE", "XOF", "CFA", 0},
+    {"NF", "AUD", "$", 2},
+    {"NG", "NGN", "\xE2\x82\xA6", 2},  // ₦
+    {"NI", "NIO", "C$", 2},
+    {"NL", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"NO", "NOK", "kr", 2},
+    {"NP", "NPR", "\xE0\xA4\xB0\xE0\xA5\x82", 2},  // रू
+    {"NR", "AUD", "$", 2},
+    {"NU", "NZD", "$", 2},
+    {"NZ", "NZD", "$", 2},
+    {"OM", "OMR", "\xD8\xB1.\xD8\xB9.", 3},  // ر.ع.
+    {"PA", "PAB", "B/.", 2},
+    {"PE", "PEN", "S/", 2},
+    {"PF", "XPF", "\xE2\x82\xA3", 0},  // ₣
+    {"PG", "PGK", "K", 2},
+    {"PH", "PHP", "\xE2\x82\xB1", 2},  // ₱
+    {"PK", "PKR", "\xE2\x82\xA8", 2},  // ₨
+    {"PL", "PLN", "z\xC5\x82", 2},  // zł
+    {"PM", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"PN", "NZD", "$", 2},
+    {"PR", "USD", "$", 2},
+    {"PS", "ILS", "\xE2\x82\xAA", 2},  // ₪
+    {"PT", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"PW", "USD", "$", 2},
+    {"PY", "PYG", "\xE2\x82\xB2", 0},  // ₲
+    {"QA", "QAR", "\xD8\xB1.\xD9\x82", 2},  // ر.ق
+    {"RE", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"RO", "RON", "lei", 2},
+    {"RS", "RSD", "\xD0\xB4\xD0\xB8\xD0\xBD.", 2},  // дин.
+    {"RU", "RUB", "\xE2\x82\xBD", 2},  // ₽
+    {"RW", "RWF", "FRw", 0},
+    {"SA", "SAR", "\xD8\xB1.\xD8\xB3", 2},  // ر.س
+    {"SB", "SBD", "$", 2},
+    {"SC", "SCR", "\xE2\x82\xA8", 2},  // ₨
+    {"SD", "SDG", "\xD8\xAC.\xD8\xB3.", 2},  // ج.س.
+    {"SE", "SEK", "kr", 2},
+    {"SG", "SGD", "$", 2},
+    {"SH", "SHP", "\xC2\xA3", 2},  // £
+    {"SI", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"SJ", "NOK", "kr", 2},
+    {"SK", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"SL", "SLE", "Le", 2},
+    {"SM", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"SN", "XOF", "CFA", 0},
+    {"SO", "SOS", "Sh", 2},
+    {"SR", "SRD", "$", 2},
+    {"SS", "SSP", "\xC2\xA3", 2},  // £
+    {"ST", "STN", "Db", 2},
+    {"SV", "USD", "$", 2},
+    {"SX", "XCG", "Cg", 2},
+    {"SY", "SYP", "\xC2\xA3", 2},  // £
+    {"SZ", "SZL", "E", 2},
+    {"TC", "USD", "$", 2},
+    {"TD", "XAF", "FCFA", 0},
+    {"TF", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"TG", "XOF", "CFA", 0},
+    {"TH", "THB", "\xE0\xB8\xBF", 2},  // ฿
+    {"TJ", "TJS", "\xD0\x85\xD0\x9C", 2},  // ЅМ
+    {"TK", "NZD", "$", 2},
+    {"TL", "USD", "$", 2},
+    {"TM", "TMT", "m", 2},
+    {"TN", "TND", "\xD8\xAF.\xD8\xAA", 3},  // د.ت
+    {"TO", "TOP", "T$", 2},
+    {"TR", "TRY", "\xE2\x82\xBA", 2},  // ₺
+    {"TT", "TTD", "$", 2},
+    {"TV", "AUD", "$", 2},
+    {"TW", "TWD", "NT$", 2},
+    {"TZ", "TZS", "TSh", 2},
+    {"UA", "UAH", "\xE2\x82\xB4", 2},  // ₴
+    {"UG", "UGX", "USh", 0},
+    {"UM", "USD", "$", 2},
+    {"US", "USD", "$", 2},
+    {"UY", "UYU", "$", 2},
+    {"UZ", "UZS", "so'm", 2},
+    {"VA", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"VC", "XCD", "$", 2},
+    {"VE", "VES", "Bs.", 2},
+    {"VG", "USD", "$", 2},
+    {"VI", "USD", "$", 2},
+    {"VN", "VND", "\xE2\x82\xAB", 0},  // ₫
+    {"VU", "VUV", "VT", 0},
+    {"WF", "XPF", "\xE2\x82\xA3", 0},  // ₣
+    {"WS", "WST", "T", 2},
+    {"XK", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"YE", "YER", "\xEF\xB7\xBC", 2},  // ﷼
+    {"YT", "EUR", "\xE2\x82\xAC", 2},  // €
+    {"ZA", "ZAR", "R", 2},
+    {"ZM", "ZMW", "ZK", 2},
+    {"ZW", "ZWG", "ZiG", 2},
+};
+
+inline constexpr size_t CURRENCY_TABLE_SIZE = 251;
+
+// Each currency once, sorted by code
+struct CurrencyUnit {
+    std::string_view code;          // ISO 4217
+    std::string_view symbol;        // UTF-8
+    uint8_t minorUnits;
+};
+
+inline constexpr CurrencyUnit CURRENCY_UNITS[] = {
+    {"AED", "\xD8\xAF.\xD8\xA5", 2},  // د.إ
+    {"AFN", "\xD8\x8B", 2},  // ؋
+    {"ALL", "L", 2},
+    {"AMD", "\xD6\x8F", 2},  // ֏
+    {"AOA", "Kz", 2},
+    {"ARS", "$", 2},
+    {"AUD", "$", 2},
+    {"AWG", "\xC6\x92", 2},  // ƒ
+    {"AZN", "\xE2\x82\xBC", 2},  // ₼
+    {"BAM", "KM", 2},
+    {"BBD", "$", 2},
+    {"BDT", "\xE0\xA7\xB3", 2},  // ৳
+    {"BGN", "\xD0\xBB\xD0\xB2", 2},  // лв
+    {"BHD", ".\xD8\xAF.\xD8\xA8", 3},  // .د.ب
+    {"BIF", "FBu", 0},
+    {"BMD", "$", 2},
+    {"BND", "$", 2},
+    {"BOB", "Bs", 2},
+    {"BRL", "R$", 2},
+    {"BSD", "$", 2},
+    {"BTN", "Nu.", 2},
+    {"BWP", "P", 2},
+    {"BYN", "Br", 2},
+    {"BZD", "$", 2},
+    {"CAD", "$", 2},
+    {"CDF", "FC", 2},
+    {"CHF", "CHF", 2},
+    {"CLP", "$", 0},
+    {"CNY", "\xC2\xA5", 2},  // ¥
+    {"COP", "$", 2},
+    {"CRC", "\xE2\x82\xA1", 2},  // ₡
+    {"CUP", "$", 2},
+    {"CVE", "$", 2},
+    {"CZK", "K\xC4\x8D", 2},  // Kč
+    {"DJF", "Fdj", 0},
+    {"DKK", "kr", 2},
+    {"DOP", "$", 2},
+    {"DZD", "\xD8\xAF.\xD8\xAC", 2},  // د.ج
+    {"EGP", "E\xC2\xA3", 2},  // E£
+    {"ERN", "Nfk", 2},
+    {"ETB", "Br", 2},
+    {"EUR", "\xE2\x82\xAC", 2},  // €
+    {"FJD", "$", 2},
+    {"FKP", "\xC2\xA3", 2},  // £
+    {"GBP", "\xC2\xA3", 2},  // £
+    {"GEL", "\xE2\x82\xBE", 2},  // ₾
+    {"GHS", "\xE2\x82\xB5", 2},  // ₵
+    {"GIP", "\xC2\xA3", 2},  // £
+    {"GMD", "D", 2},
+    {"GNF", "FG", 0},
+    {"GTQ", "Q", 2},
+    {"GYD", "$", 2},
+    {"HKD", "$", 2},
+    {"HNL", "L", 2},
+    {"HTG", "G", 2},
+    {"HUF", "Ft", 2},
+    {"IDR", "Rp", 2},
+    {"ILS", "\xE2\x82\xAA", 2},  // ₪
+    {"INR", "\xE2\x82\xB9", 2},  // ₹
+    {"IQD", "\xD8\xB9.\xD8\xAF", 3},  // ع.د
+    {"IRR", "\xEF\xB7\xBC", 2},  // ﷼
+    {"ISK", "kr", 0},
+    {"JMD", "$", 2},
+    {"JOD", "\xD8\xAF.\xD8\xA7", 3},  // د.ا
+    {"JPY", "\xC2\xA5", 0},  // ¥
+    {"KES", "KSh", 2},
+    {"KGS", "\xD1\x81", 2},  // с
+    {"KHR", "\xE1\x9F\x9B", 2},  // ៛
+    {"KMF", "CF", 0},
+    {"KPW", "\xE2\x82\xA9", 2},  // ₩
+    {"KRW", "\xE2\x82\xA9", 0},  // ₩
+    {"KWD", "\xD8\xAF.\xD9\x83", 3},  // د.ك
+    {"KYD", "$", 2},
+    {"KZT", "\xE2\x82\xB8", 2},  // ₸
+    {"LAK", "\xE2\x82\xAD", 2},  // ₭
+    {"LBP", "\xD9\x84.\xD9\x84", 2},  // ل.ل
+    {"LKR", "Rs", 2},
+    {"LRD", "$", 2},
+    {"LSL", "L", 2},
+    {"LYD", "\xD9\x84.\xD8\xAF", 3},  // ل.د
+    {"MAD", "\xD8\xAF.\xD9\x85.", 2},  // د.م.
+    {"MDL", "L", 2},
+    {"MGA", "Ar", 2},
+    {"MKD", "\xD0\xB4\xD0\xB5\xD0\xBD", 2},  // ден
+    {"MMK", "K", 2},
+    {"MNT", "\xE2\x82\xAE", 2},  // ₮
+    {"MOP", "MOP$", 2},
+    {"MRU", "UM", 2},
+    {"MUR", "\xE2\x82\xA8", 2},  // ₨
+    {"MVR", "Rf", 2},
+    {"MWK", "MK", 2},
+    {"MXN", "$", 2},
+    {"MYR", "RM", 2},
+    {"MZN", "MT", 2},
+    {"NAD", "$", 2},
+    {"NGN", "\xE2\x82\xA6", 2},  // ₦
+    {"NIO", "C$", 2},
+    {"NOK", "kr", 2},
+    {"NPR", "\xE0\xA4\xB0\xE0\xA5\x82", 2},  // रू
+    {"NZD", "$", 2},
+    {"OMR", "\xD8\xB1.\xD8\xB9.", 3},  // ر.ع.
+    {"PAB", "B/.", 2},
+    {"PEN", "S/", 2},
+    {"PGK", "K", 2},
+    {"PHP", "\xE2\x82\xB1", 2},  // ₱
+    {"PKR", "\xE2\x82\xA8", 2},  // ₨
+    {"PLN", "z\xC5\x82", 2},  // zł
+    {"PYG", "\xE2\x82\xB2", 0},  // ₲
+    {"QAR", "\xD8\xB1.\xD9\x82", 2},  // ر.ق
+    {"RON", "lei", 2},
+    {"RSD", "\xD0\xB4\xD0\xB8\xD0\xBD.", 2},  // дин.
+    {"RUB", "\xE2\x82\xBD", 2},  // ₽
+    {"RWF", "FRw", 0},
+    {"SAR", "\xD8\xB1.\xD8\xB3", 2},  // ر.س
+    {"SBD", "$", 2},
+    {"SCR", "\xE2\x82\xA8", 2},  // ₨
+    {"SDG", "\xD8\xAC.\xD8\xB3.", 2},  // ج.س.
+    {"SEK", "kr", 2},
+    {"SGD", "$", 2},
+    {"SHP", "\xC2\xA3", 2},  // £
+    {"SLE", "Le", 2},
+    {"SOS", "Sh", 2},
+    {"SRD", "$", 2},
+    {"SSP", "\xC2\xA3", 2},  // £
+    {"STN", "Db", 2},
+    {"SYP", "\xC2\xA3", 2},  // £
+    {"SZL", "E", 2},
+    {"THB", "\xE0\xB8\xBF", 2},  // ฿
+    {"TJS", "\xD0\x85\xD0\x9C", 2},  // ЅМ
+    {"TMT", "m", 2},
+    {"TND", "\xD8\xAF.\xD8\xAA", 3},  // د.ت
+    {"TOP", "T$", 2},
+    {"TRY", "\xE2\x82\xBA", 2},  // ₺
+    {"TTD", "$", 2},
+    {"TWD", "NT$", 2},
+    {"TZS", "TSh", 2},
+    {"UAH", "\xE2\x82\xB4", 2},  // ₴
+    {"UGX", "USh", 0},
+    {"USD", "$", 2},
+    {"UYU", "$", 2},
+    {"UZS", "so'm", 2},
+    {"VES", "Bs.", 2},
+    {"VND", "\xE2\x82\xAB", 0},  // ₫
+    {"VUV", "VT", 0},
+    {"WST", "T", 2},
+    {"XAF", "FCFA", 0},
+    {"XCD", "$", 2},
+    {"XCG", "Cg", 2},
+    {"XOF", "CFA", 0},
+    {"XPF", "\xE2\x82\xA3", 0},  // ₣
+    {"YER", "\xEF\xB7\xBC", 2},  // ﷼
+    {"ZAR", "R", 2},
+    {"ZMW", "ZK", 2},
+    {"ZWG", "ZiG", 2},
+};
+
+inline constexpr size_t CURRENCY_UNIT_COUNT = 154;
+
+namespace currency_detail {
+    // Two upper-case letters map one-to-one onto 26 * 26 slots, which makes
+    // the slot number a collision-free hash of the country code; three
+    // letters do the same for currency codes
+    constexpr size_t SLOT_COUNT = 26 * 26;
+    constexpr size_t CODE_SLOT_COUNT = 26 * 26 * 26;
+
+    constexpr int slotOf(std::string_view code, size_t length = 2) {
+        if (code.size() != length) {
+            return -1;
+        }
+        int slot = 0;
+        for (char c : code) {
+            if (c >= 'a' && c <= 'z') {
+                c = static_cast<char>(c - 'a' + 'A');
+            }
+            if (c < 'A' || c > 'Z') {
+                return -1;
+            }
+            slot = slot * 26 + (c - 'A');
+        }
+        return slot;
+    }
+
+    static_assert(CURRENCY_TABLE_SIZE < 255, "slot index entries are 8-bit");
+
+    struct SlotIndex {
+        uint8_t entries[SLOT_COUNT];  // Table index + 1, zero when unassigned
+    };
+
+    constexpr SlotIndex buildIndex() {
+        SlotIndex index{};
+        for (size_t i = 0; i < CURRENCY_TABLE_SIZE; ++i) {
+            index.entries[slotOf(CURRENCY_TABLE[i].countryCode)] = static_cast<uint8_t>(i + 1);
+        }
+        return index;
+    }
+
+    inline constexpr SlotIndex INDEX = buildIndex();
+
+    static_assert(CURRENCY_UNIT_COUNT < 255, "code index entries are 8-bit");
+
+    struct CodeIndex {
+        uint8_t entries[CODE_SLOT_COUNT];  // Unit index + 1, zero when unassigned
+    };
+
+    constexpr CodeIndex buildCodeIndex() {
+        CodeIndex index{};
+        for (size_t i = 0; i < CURRENCY_UNIT_COUNT; ++i) {
+            index.entries[slotOf(CURRENCY_UNITS[i].code, 3)] = static_cast<uint8_t>(i + 1);
+        }
+        return index;
+    }
+
+    inline constexpr CodeIndex CODE_INDEX = buildCodeIndex();
+}
+
+// Currency for a two-letter country code, or nullptr when unknown
+constexpr const CurrencyInfo* findCurrencyByCountry(std::string_view countryCode) {
+    int slot = currency_detail::slotOf(countryCode);
+    if (slot < 0) {
+        return nullptr;
+    }
+    uint8_t entry = currency_detail::INDEX.entries[slot];
+    return entry == 0 ? nullptr : &CURRENCY_TABLE[entry - 1];
+}
+
+// Currency for a three-letter ISO 4217 code, or nullptr when unknown
+constexpr const CurrencyUnit* findCurrencyUnit(std::string_view code) {
+    int slot = currency_detail::slotOf(code, 3);
+    if (slot < 0) {
+        return nullptr;
+    }
+    uint8_t entry = currency_detail::CODE_INDEX.entries[slot];
+    return entry == 0 ? nullptr : &CURRENCY_UNITS[entry - 1];
+}
+
+// Position of unit in CURRENCY_UNITS, for tables indexed by currency
+constexpr size_t currencyUnitIndex(const CurrencyUnit* unit) {
+    return static_cast<size_t>(unit - CURRENCY_UNITS);
+}
+
+namespace currency_detail {
+    constexpr bool isUpperAlpha(std::string_view text, size_t length) {
+        if (text.size() != length) {
+            return false;
+        }
+        for (char c : text) {
+            if (c < 'A' || c > 'Z') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Every entry must be well-formed and reachable through its own code
+    constexpr bool validateTable() {
+        static_assert(sizeof(CURRENCY_TABLE) / sizeof(CURRENCY_TABLE[0]) == CURRENCY_TABLE_SIZE,
+                      "table size mismatch");
+        for (size_t i = 0; i < CURRENCY_TABLE_SIZE; ++i) {
+            const CurrencyInfo& entry = CURRENCY_TABLE[i];
+            if (!isUpperAlpha(entry.countryCode, 2) || !isUpperAlpha(entry.code, 3) ||
+                entry.symbol.empty() || entry.minorUnits > 3 ||
+                findCurrencyByCountry(entry.countryCode) != &entry) {
+                return false;
+            }
+            const CurrencyUnit* unit = findCurrencyUnit(entry.code);
+            if (unit == nullptr || unit->minorUnits != entry.minorUnits) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < CURRENCY_UNIT_COUNT; ++i) {
+            if (findCurrencyUnit(CURRENCY_UNITS[i].code) != &CURRENCY_UNITS[i]) {
+                return false;
+            }
+        }
+        return findCurrencyByCountry("") == nullptr && findCurrencyByCountry("A1") == nullptr &&
+               findCurrencyUnit("US") == nullptr;
+    }
+}
+
+static_assert(currency_detail::validateTable(), "currency table is inconsistent");
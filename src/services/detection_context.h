@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum class DetectionStage {
+    IpDiscovery,
+    GeoLookup,
+    Currency,
+    Count
+};
+
+// Overall time budget and cancellation flag for one detection run. Every
+// network call made on its behalf is clamped to the time that is left.
+class DetectionContext {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit DetectionContext(std::chrono::milliseconds budget)
+        : start(Clock::now())
+        , deadline(start + budget)
+        , cancelled(false)
+    {
+        for (auto& micros : stageMicros) {
+            micros = 0;
+        }
+    }
+
+    void cancel() { cancelled = true; }
+    bool isCancelled() const { return cancelled; }
+    bool expired() const { return cancelled || Clock::now() >= deadline; }
+
+    std::chrono::milliseconds remaining() const {
+        if (cancelled) {
+            return std::chrono::milliseconds(0);
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+        return left.count() > 0 ? left : std::chrono::milliseconds(0);
+    }
+
+    void recordStage(DetectionStage stage, Clock::duration elapsed) {
+        stageMicros[static_cast<size_t>(stage)] +=
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+
+    double stageMs(DetectionStage stage) const {
+        return stageMicros[static_cast<size_t>(stage)] / 1000.0;
+    }
+
+    double elapsedMs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count() / 1000.0;
+    }
+
+private:
+    Clock::time_point start;
+    Clock::time_point deadline;
+    std::atomic<bool> cancelled;
+    std::array<std::atomic<int64_t>, static_cast<size_t>(DetectionStage::Count)> stageMicros;
+};
+
+// Adds the lifetime of the timer to a stage of the context
+class StageTimer {
+public:
+    StageTimer(DetectionContext& context, DetectionStage stage)
+        : context(context)
+        , stage(stage)
+        , begin(DetectionContext::Clock::now())
+    {
+    }
+
+    ~StageTimer() {
+        context.recordStage(stage, DetectionContext::Clock::now() - begin);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    DetectionContext& context;
+    DetectionStage stage;
+    DetectionContext::Clock::time_point begin;
+};
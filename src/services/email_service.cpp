@@ -3,6 +3,25 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <ctime>
+
+namespace {
+    std::string_view orUnknown(std::string_view text) {
+        return text.empty() ? std::string_view("Unknown") : text;
+    }
+
+    std::string formatDate(time_t time) {
+        std::tm parts = {};
+#ifdef _WIN32
+        gmtime_s(&parts, &time);
+#else
+        gmtime_r(&time, &parts);
+#endif
+        char text[32];
+        size_t length = std::strftime(text, sizeof(text), "%Y-%m-%d", &parts);
+        return std::string(text, length);
+    }
+}
 
 EmailService& EmailService::getInstance() {
     static EmailService instance;
@@ -10,8 +29,9 @@ EmailService& EmailService::getInstance() {
 }
 
 bool EmailService::sendActivationToken(const std::string& email, const std::string& token) {
-    // Get location info
-    LocationInfo location = LocationService::getInstance().getLocationInfo();
+    // Don't hold the email back for slow detection, whatever is known
+    // after a few seconds is good enough
+    LocationInfo location = LocationService::getInstance().getLocationInfo(std::chrono::seconds(3));
     
     std::stringstream body;
     body << "Welcome to MeetAssist!\n\n"
@@ -19,17 +39,33 @@ bool EmailService::sendActivationToken(const std::string& email, const std::stri
          << "Please use this token to activate your account.\n"
          << "This token will expire in 24 hours.\n\n"
          << "Location Information:\n"
-         << "IP: " << location.ip << "\n"
-         << "Country: " << location.country << "\n"
-         << "Region: " << location.region << "\n"
-         << "City: " << location.city << "\n"
-         << "Currency: " << location.currency << " (" << location.currency_symbol << ")\n\n"
+         << "IP: " << (location.ip.isValid() ? location.ip.toString() : "Unknown") << "\n"
+         << "Country: " << orUnknown(location.country.view()) << "\n"
+         << "Region: " << orUnknown(location.region.view()) << "\n"
+         << "City: " << orUnknown(location.city.view()) << "\n"
+         << "Currency: " << location.currency.view() << " (" << location.currency_symbol.view() << ")\n\n"
          << "Best regards,\n"
          << "MeetAssist Team";
 
     return simulateEmailSend(email, "MeetAssist Activation Token", body.str());
 }
 
+size_t EmailService::sendRenewalReminders(const std::vector<SubscriptionEntry>& subscriptions) {
+    std::vector<Message> messages;
+    messages.reserve(subscriptions.size());
+    for (const SubscriptionEntry& subscription : subscriptions) {
+        std::stringstream body;
+        body << "Your MeetAssist subscription expires on " << formatDate(subscription.expiry) << " (UTC).\n\n"
+             << "It will be renewed automatically the day before. If the renewal\n"
+             << "fails, premium features stop when the subscription expires.\n\n"
+             << "Transaction: " << subscription.transactionId << "\n\n"
+             << "Best regards,\n"
+             << "MeetAssist Team";
+        messages.push_back(Message{subscription.email, "Your MeetAssist subscription expires soon", body.str()});
+    }
+    return simulateEmailBatch(messages);
+}
+
 bool EmailService::simulateEmailSend(const std::string& to, const std::string& subject, const std::string& body) {
     try {
         // Log the email for debugging
@@ -50,4 +86,31 @@ bool EmailService::simulateEmailSend(const std::string& to, const std::string& s
         std::cerr << "Error sending email: " << e.what() << std::endl;
         return false;
     }
+}
+
+size_t EmailService::simulateEmailBatch(const std::vector<Message>& messages) {
+    try {
+        // One open and write for the whole batch
+        std::stringstream batch;
+        time_t now = std::time(nullptr);
+        for (const Message& message : messages) {
+            batch << "\n=== New Email ===\n"
+                  << "Timestamp: " << now << "\n"
+                  << "To: " << message.to << "\n"
+                  << "Subject: " << message.subject << "\n"
+                  << "Body:\n" << message.body << "\n"
+                  << "==================\n\n";
+        }
+
+        std::ofstream logFile("email_log.txt", std::ios::app);
+        if (!logFile.is_open()) {
+            return 0;
+        }
+        logFile << batch.rdbuf();
+        return logFile.good() ? messages.size() : 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error sending email: " << e.what() << std::endl;
+        return 0;
+    }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
+#include "subscription_store.h"
 
 class EmailService {
 public:
@@ -8,6 +10,9 @@ public:
     
     // Send activation token via email
     bool sendActivationToken(const std::string& email, const std::string& token);
+
+    // Send expiry reminders as one batch; returns how many were sent
+    size_t sendRenewalReminders(const std::vector<SubscriptionEntry>& subscriptions);
     
 private:
     EmailService() = default;
@@ -15,6 +20,13 @@ private:
     EmailService(const EmailService&) = delete;
     EmailService& operator=(const EmailService&) = delete;
 
+    struct Message {
+        std::string to;
+        std::string subject;
+        std::string body;
+    };
+
     // Helper function to simulate email sending
     bool simulateEmailSend(const std::string& to, const std::string& subject, const std::string& body);
+    size_t simulateEmailBatch(const std::vector<Message>& messages);
 };
\ No newline at end of file
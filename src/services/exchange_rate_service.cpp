@@ -0,0 +1,202 @@
+#include "exchange_rate_service.h"
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    const uint64_t POWERS_OF_TEN[] = {1, 10, 100, 1000};
+
+    // Keeps rate * RATE_SCALE * 10^3 within 64 bits for convert()
+    const double MAX_RATE = 9.0e6;
+
+    bool modificationTime(const std::string& path, std::filesystem::file_time_type& time) {
+        std::error_code error;
+        time = std::filesystem::last_write_time(path, error);
+        return !error;
+    }
+}
+
+constexpr std::chrono::milliseconds ExchangeRateService::RELOAD_INTERVAL;
+
+ExchangeRateService& ExchangeRateService::getInstance() {
+    static ExchangeRateService instance;
+    return instance;
+}
+
+ExchangeRateService::~ExchangeRateService() {
+    stopWatching();
+}
+
+std::string ExchangeRateService::ratesPath() {
+    if (const char* path = std::getenv("MEETASSIST_EXCHANGE_RATES")) {
+        return path;
+    }
+#ifdef _WIN32
+    char modulePath[MAX_PATH] = {};
+    DWORD length = GetModuleFileNameA(nullptr, modulePath, MAX_PATH);
+    std::string path(modulePath, length);
+    size_t slash = path.find_last_of("\\/");
+    return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "exchange_rates.json";
+#else
+    return "exchange_rates.json";
+#endif
+}
+
+bool ExchangeRateService::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadJson(text);
+}
+
+bool ExchangeRateService::loadJson(std::string_view text) {
+    try {
+        json document = json::parse(text.begin(), text.end());
+        ExchangeRates table;
+        table.base = findCurrencyUnit(document.at("base").get<std::string>());
+        if (!table.base) {
+            return false;
+        }
+        if (document.contains("timestamp")) {
+            table.asOf = document["timestamp"].get<time_t>();
+        }
+
+        for (const auto& [code, value] : document.at("rates").items()) {
+            const CurrencyUnit* unit = findCurrencyUnit(code);
+            if (!unit || !value.is_number()) {
+                continue;   // Currencies we never price in
+            }
+            double rate = value.get<double>();
+            if (!std::isfinite(rate) || rate <= 0 || rate > MAX_RATE) {
+                return false;
+            }
+            int64_t scaled = std::llround(rate * RATE_SCALE);
+            table.perBase[currencyUnitIndex(unit)] = scaled > 0 ? scaled : 1;
+        }
+        table.perBase[currencyUnitIndex(table.base)] = RATE_SCALE;
+
+        publish(table);
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+void ExchangeRateService::publish(const ExchangeRates& table) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    uint64_t start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed);
+    // Release stores, so a reader that sees a new rate also sees the odd
+    // sequence and retries
+    for (size_t i = 0; i < CURRENCY_UNIT_COUNT; ++i) {
+        perBase[i].store(table.perBase[i], std::memory_order_release);
+    }
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+void ExchangeRateService::readRates(size_t first, size_t second, int64_t& firstRate, int64_t& secondRate) const {
+    for (;;) {
+        uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        firstRate = perBase[first].load(std::memory_order_acquire);
+        secondRate = perBase[second].load(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            return;
+        }
+    }
+}
+
+bool ExchangeRateService::startWatching(const std::string& path, std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(watchMutex);
+    if (watcher.joinable()) {
+        return false;
+    }
+    stopping = false;
+    watcher = std::thread(&ExchangeRateService::watch, this, path, interval);
+    return true;
+}
+
+void ExchangeRateService::stopWatching() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(watchMutex);
+        stopping = true;
+        stopped = std::move(watcher);
+    }
+    watchWake.notify_all();
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+}
+
+void ExchangeRateService::watch(std::string path, std::chrono::milliseconds interval) {
+    std::filesystem::file_time_type loadedTime{};
+    bool loaded = false;
+
+    std::unique_lock<std::mutex> lock(watchMutex);
+    while (!stopping) {
+        lock.unlock();
+        std::filesystem::file_time_type time;
+        if (modificationTime(path, time) && (!loaded || time != loadedTime)) {
+            // A file caught mid-write fails to parse and is retried next round
+            if (load(path)) {
+                loadedTime = time;
+                loaded = true;
+            }
+        }
+        lock.lock();
+        watchWake.wait_for(lock, interval, [this]() { return stopping; });
+    }
+}
+
+bool ExchangeRateService::convert(const Money& amount, std::string_view currency, Money& out,
+                                  RoundingMode mode) const {
+    const CurrencyUnit* unit = findCurrencyUnit(currency);
+    return unit && convert(amount, *unit, out, mode);
+}
+
+bool ExchangeRateService::convert(const Money& amount, const CurrencyUnit& currency, Money& out,
+                                  RoundingMode mode) const {
+    int64_t from;
+    int64_t to;
+    readRates(currencyUnitIndex(&amount.currency()), currencyUnitIndex(&currency), from, to);
+    if (from == 0 || to == 0) {
+        return false;
+    }
+
+    // minor * to * 10^targetDecimals / (from * 10^sourceDecimals)
+    uint64_t numerator = static_cast<uint64_t>(to) * POWERS_OF_TEN[currency.minorUnits];
+    uint64_t denominator = static_cast<uint64_t>(from) * POWERS_OF_TEN[amount.decimals()];
+    int64_t minor = amount.minorUnits();
+    uint64_t magnitude = minor < 0 ? uint64_t(0) - static_cast<uint64_t>(minor) : static_cast<uint64_t>(minor);
+
+    uint64_t quotient;
+    uint64_t remainder;
+    int64_t result;
+    if (!multiplyDivide(magnitude, numerator, denominator, quotient, remainder) ||
+        !roundQuotient(minor < 0, quotient, remainder, denominator, mode, result)) {
+        return false;
+    }
+    out = Money(result, currency);
+    return true;
+}
+
+bool ExchangeRateService::hasRate(std::string_view currency) const {
+    const CurrencyUnit* unit = findCurrencyUnit(currency);
+    return unit && perBase[currencyUnitIndex(unit)].load(std::memory_order_relaxed) != 0;
+}
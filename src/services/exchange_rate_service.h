@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "currency_table.h"
+#include "money.h"
+
+// Rates against one base currency, indexed by currencyUnitIndex()
+struct ExchangeRates {
+    const CurrencyUnit* base = nullptr;
+    time_t asOf = 0;
+    // Units of each currency per unit of base, times RATE_SCALE; 0 when unknown
+    std::array<int64_t, CURRENCY_UNIT_COUNT> perBase{};
+};
+
+// Converts Money between currencies using a rates file such as
+//   {"base": "USD", "timestamp": 1700000000, "rates": {"EUR": 0.9213, ...}}
+//
+// A reload parses the whole file, then copies the rates over the one
+// table in place under a sequence lock, so the table never grows however
+// often the file changes. Readers see either the old or the new rates:
+// convert() reads its two rates and retries only if a reload was writing
+// meanwhile. It is one 128-bit multiply-divide, with no lock and no
+// allocation, cheap enough to run on every repaint.
+class ExchangeRateService {
+public:
+    static ExchangeRateService& getInstance();
+
+    static const int64_t RATE_SCALE = 1000000000;   // Rates keep 9 decimals
+    static constexpr std::chrono::milliseconds RELOAD_INTERVAL{30000};
+
+    // MEETASSIST_EXCHANGE_RATES, else exchange_rates.json next to the executable
+    static std::string ratesPath();
+
+    // Parse and publish; on failure the current rates stay in place
+    bool load(const std::string& path);
+    bool loadJson(std::string_view text);
+
+    // Reload path whenever its modification time changes
+    bool startWatching(const std::string& path, std::chrono::milliseconds interval = RELOAD_INTERVAL);
+    void stopWatching();
+
+    // amount in currency, rounded with mode. False when either rate is unknown.
+    bool convert(const Money& amount, std::string_view currency, Money& out,
+                 RoundingMode mode = RoundingMode::HalfEven) const;
+    bool convert(const Money& amount, const CurrencyUnit& currency, Money& out,
+                 RoundingMode mode = RoundingMode::HalfEven) const;
+
+    bool hasRate(std::string_view currency) const;
+
+    // Bumped by every successful load
+    uint64_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    ExchangeRateService() = default;
+    ~ExchangeRateService();
+    ExchangeRateService(const ExchangeRateService&) = delete;
+    ExchangeRateService& operator=(const ExchangeRateService&) = delete;
+
+    void watch(std::string path, std::chrono::milliseconds interval);
+
+    void publish(const ExchangeRates& table);
+    // Rates of the currencies at two indexes, read together
+    void readRates(size_t first, size_t second, int64_t& firstRate, int64_t& secondRate) const;
+
+    // Odd while a reload is writing perBase
+    std::atomic<uint64_t> sequence{0};
+    std::array<std::atomic<int64_t>, CURRENCY_UNIT_COUNT> perBase{};
+    std::mutex publishMutex;
+
+    std::mutex watchMutex;
+    std::condition_variable watchWake;
+    std::thread watcher;
+    bool stopping = false;
+};
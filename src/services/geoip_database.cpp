@@ -0,0 +1,220 @@
+#include "geoip_database.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#include <xmmintrin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    inline void prefetch(const void* address) {
+#if defined(_M_X64) || defined(_M_IX86)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    // Number of trailing one bits, used to climb back up the Eytzinger tree
+    unsigned trailingOnes(uint64_t value) {
+        uint64_t inverted = ~value;
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, inverted);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(inverted));
+#endif
+    }
+}
+
+GeoIpDatabase::~GeoIpDatabase() {
+    close();
+}
+
+bool GeoIpDatabase::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_base = static_cast<const unsigned char*>(view);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_base = static_cast<const unsigned char*>(view);
+    m_size = static_cast<size_t>(st.st_size);
+#endif
+
+    if (!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void GeoIpDatabase::close() {
+#ifdef _WIN32
+    if (m_base) UnmapViewOfFile(m_base);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_base) munmap(const_cast<unsigned char*>(m_base), m_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_base = nullptr;
+    m_size = 0;
+    m_keys = nullptr;
+    m_ranks = nullptr;
+    m_records = nullptr;
+    m_strings = nullptr;
+    m_stringsSize = 0;
+    m_rangeCount = 0;
+}
+
+bool GeoIpDatabase::validate() {
+    if (m_size < sizeof(GeoIpHeader)) {
+        return false;
+    }
+
+    GeoIpHeader header;
+    std::memcpy(&header, m_base, sizeof(header));
+    if (std::memcmp(header.magic, GEOIP_MAGIC, sizeof(GEOIP_MAGIC)) != 0 ||
+        header.version != GEOIP_FORMAT_VERSION) {
+        return false;
+    }
+
+    uint64_t slots = uint64_t(header.rangeCount) + 1;
+    auto fits = [this](uint64_t offset, uint64_t bytes) {
+        return offset <= m_size && bytes <= m_size - offset;
+    };
+    if (!fits(header.keysOffset, slots * sizeof(GeoIpKey)) ||
+        !fits(header.ranksOffset, slots * sizeof(uint32_t)) ||
+        !fits(header.recordsOffset, uint64_t(header.rangeCount) * sizeof(GeoIpRecord)) ||
+        !fits(header.stringsOffset, header.stringsSize)) {
+        return false;
+    }
+
+    m_rangeCount = header.rangeCount;
+    m_keys = reinterpret_cast<const GeoIpKey*>(m_base + header.keysOffset);
+    m_ranks = reinterpret_cast<const uint32_t*>(m_base + header.ranksOffset);
+    m_records = reinterpret_cast<const GeoIpRecord*>(m_base + header.recordsOffset);
+    m_strings = m_base + header.stringsOffset;
+    m_stringsSize = header.stringsSize;
+
+    for (uint32_t i = 1; i <= m_rangeCount; ++i) {
+        if (m_ranks[i] >= m_rangeCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GeoIpDatabase::lookup(const IpAddress& address, GeoIpLocation& out) const {
+    return address.isValid() && lookup(geoIpKeyFor(address), out);
+}
+
+bool GeoIpDatabase::lookup(const GeoIpKey& key, GeoIpLocation& out) const {
+    if (!m_base || m_rangeCount == 0) {
+        return false;
+    }
+
+    // Branchless descent to the first range starting after the key. The
+    // four grandchildren of a slot share one cache line, fetched two
+    // levels ahead so the misses of consecutive levels overlap.
+    uint64_t k = 1;
+    while (k <= m_rangeCount) {
+        prefetch(m_keys + 4 * k);
+        k = 2 * k + (m_keys[k] <= key ? 1 : 0);
+    }
+    k >>= trailingOnes(k) + 1;
+
+    // The candidate is the range just before it in sorted order
+    uint32_t next = k == 0 ? m_rangeCount : m_ranks[k];
+    if (next == 0) {
+        return false;
+    }
+
+    const GeoIpRecord& record = m_records[next - 1];
+    if (record.last < key) {
+        return false;
+    }
+
+    out.country = stringAt(record.country);
+    out.countryCode = stringAt(record.countryCode);
+    out.region = stringAt(record.region);
+    out.regionCode = stringAt(record.regionCode);
+    out.city = stringAt(record.city);
+    out.zip = stringAt(record.zip);
+    out.timezone = stringAt(record.timezone);
+    out.latitude = record.latitude;
+    out.longitude = record.longitude;
+    return true;
+}
+
+std::string_view GeoIpDatabase::stringAt(uint32_t offset) const {
+    if (uint64_t(offset) + sizeof(uint16_t) > m_stringsSize) {
+        return std::string_view();
+    }
+
+    uint16_t length;
+    std::memcpy(&length, m_strings + offset, sizeof(length));
+    if (uint64_t(offset) + sizeof(uint16_t) + length > m_stringsSize) {
+        return std::string_view();
+    }
+    return std::string_view(reinterpret_cast<const char*>(m_strings + offset + sizeof(uint16_t)), length);
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "ip_address.h"
+
+// Binary IP-range database for offline IP-to-location resolution.
+//
+// File layout (little-endian, offsets from the start of the file):
+//   GeoIpHeader
+//   GeoIpKey[rangeCount + 1]      range start addresses in Eytzinger order,
+//                                 slot 0 unused so the root is slot 1
+//   uint32_t[rangeCount + 1]      sorted rank of each Eytzinger slot
+//   GeoIpRecord[rangeCount]       ranges in ascending address order
+//   string pool                   uint16_t length followed by the bytes
+//
+// IPv4 addresses are stored as IPv4-mapped IPv6 (::ffff:a.b.c.d) so both
+// families share one key space.
+
+const char GEOIP_MAGIC[8] = {'M', 'A', 'G', 'E', 'O', 'I', 'P', '\0'};
+const uint32_t GEOIP_FORMAT_VERSION = 1;
+
+#pragma pack(push, 1)
+struct GeoIpHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rangeCount;
+    uint64_t keysOffset;
+    uint64_t ranksOffset;
+    uint64_t recordsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+// 128-bit address, compared as an unsigned big-endian number
+struct GeoIpKey {
+    uint64_t hi;
+    uint64_t lo;
+};
+
+struct GeoIpRecord {
+    GeoIpKey last;              // Inclusive end of the range
+    uint32_t country;           // String pool offsets
+    uint32_t countryCode;
+    uint32_t region;
+    uint32_t regionCode;
+    uint32_t city;
+    uint32_t zip;
+    uint32_t timezone;
+    float latitude;
+    float longitude;
+    uint32_t reserved;          // Keeps records 8-byte aligned
+};
+#pragma pack(pop)
+
+inline bool operator<(const GeoIpKey& a, const GeoIpKey& b) {
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+
+inline bool operator<=(const GeoIpKey& a, const GeoIpKey& b) {
+    return !(b < a);
+}
+
+inline GeoIpKey geoIpKeyFor(const IpAddress& address) {
+    return GeoIpKey{address.high(), address.low()};
+}
+
+// Result of a lookup; views point into the mapped file
+struct GeoIpLocation {
+    std::string_view country;
+    std::string_view countryCode;
+    std::string_view region;
+    std::string_view regionCode;
+    std::string_view city;
+    std::string_view zip;
+    std::string_view timezone;
+    double latitude;
+    double longitude;
+};
+
+// Read-only, memory-mapped view of a GeoIP database file
+class GeoIpDatabase {
+public:
+    GeoIpDatabase() = default;
+    ~GeoIpDatabase();
+    GeoIpDatabase(const GeoIpDatabase&) = delete;
+    GeoIpDatabase& operator=(const GeoIpDatabase&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    size_t rangeCount() const { return m_rangeCount; }
+
+    bool lookup(const IpAddress& address, GeoIpLocation& out) const;
+    bool lookup(const GeoIpKey& key, GeoIpLocation& out) const;
+
+private:
+    bool validate();
+    std::string_view stringAt(uint32_t offset) const;
+
+    const unsigned char* m_base = nullptr;
+    size_t m_size = 0;
+    const GeoIpKey* m_keys = nullptr;
+    const uint32_t* m_ranks = nullptr;
+    const GeoIpRecord* m_records = nullptr;
+    const unsigned char* m_strings = nullptr;
+    uint64_t m_stringsSize = 0;
+    uint32_t m_rangeCount = 0;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
@@ -0,0 +1,39 @@
+#include "http_body.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Typical ip/geo responses are a few hundred bytes
+    const size_t MIN_BODY_CAPACITY = 1024;
+}
+
+bool HttpBody::reserve(size_t bytes) {
+    if (bytes > m_limit) {
+        return false;
+    }
+    if (bytes > m_capacity) {
+        grow(bytes);
+    }
+    return true;
+}
+
+char* HttpBody::prepare(size_t minBytes) {
+    if (minBytes > m_limit - m_size) {
+        return nullptr;
+    }
+    if (m_capacity - m_size < minBytes) {
+        size_t required = m_size + minBytes;
+        grow(std::max(required, std::min(std::max(m_capacity * 2, MIN_BODY_CAPACITY), m_limit)));
+    }
+    return m_data.get() + m_size;
+}
+
+void HttpBody::grow(size_t required) {
+    std::unique_ptr<char[]> data(new char[required]);
+    if (m_size > 0) {
+        std::memcpy(data.get(), m_data.get(), m_size);
+    }
+    m_data = std::move(data);
+    m_capacity = required;
+    ++m_allocations;
+}
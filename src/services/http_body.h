@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Largest response body accepted from a server, with or without a
+// Content-Length. Every service we call answers with a few hundred bytes.
+const size_t MAX_HTTP_BODY = 1 << 20;
+
+// Contiguous receive buffer for HTTP response bodies.
+// Data is read straight into the tail of the buffer, so a body is never
+// copied, scanned for a terminator or truncated at an embedded zero byte.
+// The body never grows past its limit.
+class HttpBody {
+public:
+    explicit HttpBody(size_t limit = MAX_HTTP_BODY) : m_limit(limit) {}
+    HttpBody(HttpBody&&) noexcept = default;
+    HttpBody& operator=(HttpBody&&) noexcept = default;
+    HttpBody(const HttpBody&) = delete;
+    HttpBody& operator=(const HttpBody&) = delete;
+
+    // Preallocate for a known body length (e.g. from Content-Length).
+    // Returns false, allocating nothing, when bytes is over the limit.
+    bool reserve(size_t bytes);
+
+    // Returns a writable region of at least minBytes at the end of the body,
+    // or nullptr when the body would pass its limit. Capacity grows
+    // geometrically, up to the limit, when the region does not fit.
+    char* prepare(size_t minBytes);
+
+    // Marks bytes written into the region returned by prepare() as body data
+    void commit(size_t bytes) { m_size += bytes; }
+
+    void clear() { m_size = 0; }
+
+    std::string_view view() const { return std::string_view(m_data.get(), m_size); }
+    const char* data() const { return m_data.get(); }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    size_t limit() const { return m_limit; }
+    bool empty() const { return m_size == 0; }
+
+    // Number of heap allocations made for this body
+    size_t allocationCount() const { return m_allocations; }
+
+    std::string str() const { return std::string(view()); }
+
+private:
+    void grow(size_t required);
+
+    std::unique_ptr<char[]> m_data;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+    size_t m_limit;
+    size_t m_allocations = 0;
+};
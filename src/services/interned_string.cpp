@@ -0,0 +1,58 @@
+#include "interned_string.h"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+    struct StringTable {
+        std::shared_mutex mutex;
+        std::deque<std::string> entries;    // Stable addresses as the table grows
+        std::unordered_map<std::string_view, const std::string*> index;
+        size_t bytes = 0;
+    };
+
+    StringTable& table() {
+        static StringTable instance;
+        return instance;
+    }
+}
+
+InternedString InternedString::intern(std::string_view text) {
+    if (text.empty()) {
+        return InternedString();
+    }
+
+    StringTable& strings = table();
+    {
+        // Almost every lookup finds an existing entry
+        std::shared_lock<std::shared_mutex> lock(strings.mutex);
+        auto it = strings.index.find(text);
+        if (it != strings.index.end()) {
+            return InternedString(it->second);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(strings.mutex);
+    auto it = strings.index.find(text);
+    if (it != strings.index.end()) {
+        return InternedString(it->second);
+    }
+
+    const std::string& entry = strings.entries.emplace_back(text);
+    strings.index.emplace(std::string_view(entry), &entry);
+    strings.bytes += entry.size();
+    return InternedString(&entry);
+}
+
+size_t InternedString::tableSize() {
+    StringTable& strings = table();
+    std::shared_lock<std::shared_mutex> lock(strings.mutex);
+    return strings.entries.size();
+}
+
+size_t InternedString::tableBytes() {
+    StringTable& strings = table();
+    std::shared_lock<std::shared_mutex> lock(strings.mutex);
+    return strings.bytes;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Handle to an entry in the process-wide string table.
+//
+// Equal text is stored once, so handles are a single pointer that copies
+// trivially and compares by address. Entries are never freed: intern only
+// small vocabularies such as place names, time zones and currency symbols.
+class InternedString {
+public:
+    InternedString() = default;
+
+    // Returns the handle for text, adding it to the table on first use.
+    // The empty string is the default (null) handle.
+    static InternedString intern(std::string_view text);
+
+    // Number of distinct strings and bytes of text held by the table
+    static size_t tableSize();
+    static size_t tableBytes();
+
+    std::string_view view() const { return m_entry ? std::string_view(*m_entry) : std::string_view(); }
+    const char* c_str() const { return m_entry ? m_entry->c_str() : ""; }
+    std::string str() const { return std::string(view()); }
+    size_t size() const { return m_entry ? m_entry->size() : 0; }
+    bool empty() const { return m_entry == nullptr; }
+
+    bool operator==(InternedString other) const { return m_entry == other.m_entry; }
+    bool operator!=(InternedString other) const { return m_entry != other.m_entry; }
+
+private:
+    explicit InternedString(const std::string* entry) : m_entry(entry) {}
+
+    const std::string* m_entry = nullptr;
+};
+
+static_assert(std::is_trivially_copyable<InternedString>::value && sizeof(InternedString) == sizeof(void*),
+              "InternedString must stay a bare pointer");
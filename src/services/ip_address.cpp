@@ -0,0 +1,285 @@
+#include "ip_address.h"
+#include <cstring>
+
+namespace {
+    const uint8_t V4_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    const uint8_t NOT_HEX = 0xFF;
+
+    struct HexTable {
+        uint8_t values[256];
+
+        constexpr HexTable() : values() {
+            for (int i = 0; i < 256; ++i) values[i] = NOT_HEX;
+            for (int i = 0; i < 10; ++i) values['0' + i] = static_cast<uint8_t>(i);
+            for (int i = 0; i < 6; ++i) {
+                values['a' + i] = static_cast<uint8_t>(10 + i);
+                values['A' + i] = static_cast<uint8_t>(10 + i);
+            }
+        }
+    };
+
+    constexpr HexTable HEX;
+    const char HEX_DIGITS[] = "0123456789abcdef";
+
+    // Parses exactly a dotted quad spanning [pos, end) into out
+    bool parseV4(const char* text, size_t length, uint8_t out[4]) {
+        size_t pos = 0;
+        for (int octet = 0; octet < 4; ++octet) {
+            if (octet > 0) {
+                if (pos >= length || text[pos] != '.') return false;
+                ++pos;
+            }
+
+            unsigned value = 0;
+            size_t digits = 0;
+            while (pos < length && digits < 4) {
+                unsigned digit = static_cast<unsigned char>(text[pos]) - '0';
+                if (digit > 9) break;
+                value = value * 10 + digit;
+                ++digits;
+                ++pos;
+            }
+
+            // One to three digits, at most 255, no leading zero
+            if (digits == 0 || digits > 3 || value > 255 ||
+                (digits > 1 && text[pos - digits] == '0')) {
+                return false;
+            }
+            out[octet] = static_cast<uint8_t>(value);
+        }
+        return pos == length;
+    }
+
+    bool parseV6(const char* text, size_t length, uint8_t out[16]) {
+        uint16_t groups[8] = {};
+        int count = 0;
+        int gap = -1;   // Group index where "::" was seen
+        size_t pos = 0;
+
+        if (length >= 2 && text[0] == ':' && text[1] == ':') {
+            gap = 0;
+            pos = 2;
+            if (pos == length) {
+                std::memset(out, 0, 16);
+                return true;
+            }
+        } else if (length > 0 && text[0] == ':') {
+            return false;
+        }
+
+        while (pos < length) {
+            if (count == 8) return false;
+
+            // A group of up to four hex digits, or a trailing dotted IPv4 part
+            size_t start = pos;
+            unsigned value = 0;
+            while (pos < length && pos - start < 5) {
+                uint8_t digit = HEX.values[static_cast<unsigned char>(text[pos])];
+                if (digit == NOT_HEX) break;
+                value = (value << 4) | digit;
+                ++pos;
+            }
+
+            if (pos < length && text[pos] == '.') {
+                if (count > 6) return false;
+                uint8_t v4[4];
+                if (!parseV4(text + start, length - start, v4)) return false;
+                groups[count++] = static_cast<uint16_t>((v4[0] << 8) | v4[1]);
+                groups[count++] = static_cast<uint16_t>((v4[2] << 8) | v4[3]);
+                pos = length;
+                break;
+            }
+
+            size_t digits = pos - start;
+            if (digits == 0 || digits > 4) return false;
+            groups[count++] = static_cast<uint16_t>(value);
+
+            if (pos == length) break;
+            if (text[pos] != ':') return false;
+            ++pos;
+
+            if (pos < length && text[pos] == ':') {
+                if (gap >= 0) return false;
+                gap = count;
+                ++pos;
+            } else if (pos == length) {
+                return false;   // Trailing single colon
+            }
+        }
+
+        if (gap < 0 ? count != 8 : count > 7) {
+            return false;
+        }
+
+        // Expand "::" by shifting the groups after the gap to the end
+        uint16_t expanded[8] = {};
+        int tail = gap < 0 ? 0 : count - gap;
+        int head = count - tail;
+        for (int i = 0; i < head; ++i) expanded[i] = groups[i];
+        for (int i = 0; i < tail; ++i) expanded[8 - tail + i] = groups[head + i];
+
+        for (int i = 0; i < 8; ++i) {
+            out[2 * i] = static_cast<uint8_t>(expanded[i] >> 8);
+            out[2 * i + 1] = static_cast<uint8_t>(expanded[i] & 0xFF);
+        }
+        return true;
+    }
+
+    size_t formatV4(const uint8_t octets[4], char* out) {
+        size_t length = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (i > 0) out[length++] = '.';
+            unsigned value = octets[i];
+            if (value >= 100) out[length++] = static_cast<char>('0' + value / 100);
+            if (value >= 10) out[length++] = static_cast<char>('0' + (value / 10) % 10);
+            out[length++] = static_cast<char>('0' + value % 10);
+        }
+        return length;
+    }
+
+    uint64_t loadBigEndian(const uint8_t* bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+}
+
+bool IpAddress::parse(std::string_view text, IpAddress& out) {
+    if (text.empty() || text.size() > MAX_TEXT_LENGTH) {
+        return false;
+    }
+
+    IpAddress result;
+    if (text.find(':') == std::string_view::npos) {
+        uint8_t v4[4];
+        if (!parseV4(text.data(), text.size(), v4)) return false;
+        result = fromV4(v4);
+    } else {
+        if (!parseV6(text.data(), text.size(), result.bytes.data())) return false;
+        result.family = Family::V6;
+    }
+
+    out = result;
+    return true;
+}
+
+IpAddress IpAddress::fromV4(const uint8_t octets[4]) {
+    IpAddress address;
+    std::memcpy(address.bytes.data(), V4_MAPPED_PREFIX, sizeof(V4_MAPPED_PREFIX));
+    std::memcpy(address.bytes.data() + 12, octets, 4);
+    address.family = Family::V4;
+    return address;
+}
+
+IpAddress IpAddress::fromV6(const uint8_t octets[16]) {
+    IpAddress address;
+    std::memcpy(address.bytes.data(), octets, 16);
+    address.family = Family::V6;
+    return address;
+}
+
+size_t IpAddress::format(char* out) const {
+    if (family == Family::None) {
+        return 0;
+    }
+    if (family == Family::V4) {
+        return formatV4(bytes.data() + 12, out);
+    }
+
+    uint16_t groups[8];
+    for (int i = 0; i < 8; ++i) {
+        groups[i] = static_cast<uint16_t>((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+    }
+
+    // Longest run of two or more zero groups is compressed, first one wins ties
+    int bestStart = -1;
+    int bestLength = 1;
+    for (int i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            ++i;
+            continue;
+        }
+        int start = i;
+        while (i < 8 && groups[i] == 0) ++i;
+        if (i - start > bestLength) {
+            bestStart = start;
+            bestLength = i - start;
+        }
+    }
+
+    size_t length = 0;
+    int groupCount = isV4Mapped() ? 6 : 8;
+    for (int i = 0; i < groupCount; ++i) {
+        if (i == bestStart) {
+            out[length++] = ':';
+            out[length++] = ':';
+            i += bestLength - 1;
+            continue;
+        }
+        if (i > 0 && i != bestStart + bestLength) {
+            out[length++] = ':';
+        }
+
+        unsigned value = groups[i];
+        bool started = false;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            unsigned digit = (value >> shift) & 0xF;
+            if (digit != 0 || started || shift == 0) {
+                out[length++] = HEX_DIGITS[digit];
+                started = true;
+            }
+        }
+    }
+
+    if (groupCount == 6) {
+        if (bestStart + bestLength != 6) {
+            out[length++] = ':';
+        }
+        length += formatV4(bytes.data() + 12, out + length);
+    }
+    return length;
+}
+
+std::string IpAddress::toString() const {
+    char buffer[MAX_TEXT_LENGTH];
+    return std::string(buffer, format(buffer));
+}
+
+bool IpAddress::isV4Mapped() const {
+    return std::memcmp(bytes.data(), V4_MAPPED_PREFIX, sizeof(V4_MAPPED_PREFIX)) == 0;
+}
+
+bool IpAddress::isLoopback() const {
+    if (isV4Mapped()) {
+        return bytes[12] == 127;
+    }
+    static const uint8_t V6_LOOPBACK[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    return std::memcmp(bytes.data(), V6_LOOPBACK, 16) == 0;
+}
+
+bool IpAddress::isLinkLocal() const {
+    if (isV4Mapped()) {
+        return bytes[12] == 169 && bytes[13] == 254;
+    }
+    return bytes[0] == 0xFE && (bytes[1] & 0xC0) == 0x80;
+}
+
+bool IpAddress::isUnspecified() const {
+    if (isV4Mapped()) {
+        return bytes[12] == 0 && bytes[13] == 0 && bytes[14] == 0 && bytes[15] == 0;
+    }
+    for (uint8_t byte : bytes) {
+        if (byte != 0) return false;
+    }
+    return true;
+}
+
+uint64_t IpAddress::high() const {
+    return loadBigEndian(bytes.data());
+}
+
+uint64_t IpAddress::low() const {
+    return loadBigEndian(bytes.data() + 8);
+}
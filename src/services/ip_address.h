@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Binary IPv4/IPv6 address.
+//
+// Both families are held as 16 bytes in network order; IPv4 addresses use
+// the IPv4-mapped form (::ffff:a.b.c.d) so they share one key space with
+// IPv6. The family records how the address should be printed.
+struct IpAddress {
+    enum class Family : uint8_t {
+        None,
+        V4,
+        V6
+    };
+
+    // Longest text produced by format(), without the terminator
+    static const size_t MAX_TEXT_LENGTH = 45;
+
+    std::array<uint8_t, 16> bytes{};
+    Family family = Family::None;
+
+    // Strict parser for dotted-quad IPv4 and RFC 4291 IPv6 text, including
+    // "::" compression and a trailing dotted IPv4 part. Rejects leading
+    // zeros in IPv4 octets, zone IDs, brackets and surrounding whitespace.
+    static bool parse(std::string_view text, IpAddress& out);
+
+    static IpAddress fromV4(const uint8_t octets[4]);
+    static IpAddress fromV6(const uint8_t octets[16]);
+
+    // Writes the canonical (RFC 5952) text into out, which must hold at
+    // least MAX_TEXT_LENGTH bytes. Returns the number of bytes written.
+    size_t format(char* out) const;
+    std::string toString() const;
+
+    bool isValid() const { return family != Family::None; }
+    bool isV4() const { return family == Family::V4; }
+    bool isV4Mapped() const;
+    bool isLoopback() const;
+    bool isLinkLocal() const;
+    bool isUnspecified() const;
+
+    // Upper and lower 64 bits as big-endian numbers
+    uint64_t high() const;
+    uint64_t low() const;
+
+    bool operator==(const IpAddress& other) const {
+        return family == other.family && bytes == other.bytes;
+    }
+    bool operator!=(const IpAddress& other) const { return !(*this == other); }
+};
@@ -0,0 +1,202 @@
+#include "location_cache.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    const int CACHE_FORMAT_VERSION = 1;
+
+    json toJson(const LocationInfo& info) {
+        return json{
+            {"ip", info.ip.toString()},
+            {"country", info.country.view()},
+            {"country_code", info.country_code.view()},
+            {"region", info.region.view()},
+            {"region_code", info.region_code.view()},
+            {"city", info.city.view()},
+            {"zip", info.zip.view()},
+            {"timezone", info.timezone.view()},
+            {"currency", info.currency.view()},
+            {"currency_symbol", info.currency_symbol.view()},
+            {"latitude", info.latitude},
+            {"longitude", info.longitude}
+        };
+    }
+
+    std::string textField(const json& data, const char* key) {
+        std::string text = data.value(key, std::string());
+        // Files written before fields could be empty use placeholder text
+        if (text == "Unknown" || text == "Detecting...") {
+            text.clear();
+        }
+        return text;
+    }
+
+    bool fromJson(const json& data, LocationInfo& info) {
+        if (!IpAddress::parse(data.value("ip", std::string()), info.ip)) {
+            return false;
+        }
+        info.state = LocationState::Resolved;
+        info.country = InternedString::intern(textField(data, "country"));
+        info.country_code.assign(textField(data, "country_code"));
+        info.region = InternedString::intern(textField(data, "region"));
+        info.region_code.assign(textField(data, "region_code"));
+        info.city = InternedString::intern(textField(data, "city"));
+        info.zip = InternedString::intern(textField(data, "zip"));
+        info.timezone = InternedString::intern(textField(data, "timezone"));
+        info.currency.assign(textField(data, "currency"));
+        info.currency_symbol = InternedString::intern(textField(data, "currency_symbol"));
+        info.latitude = data.value("latitude", 0.0);
+        info.longitude = data.value("longitude", 0.0);
+        return true;
+    }
+}
+
+LocationCache::LocationCache(std::string path,
+                             std::chrono::seconds ttl,
+                             std::chrono::seconds staleWindow)
+    : m_path(std::move(path))
+    , m_ttl(ttl)
+    , m_staleWindow(staleWindow)
+{
+}
+
+std::string LocationCache::defaultPath() {
+    namespace fs = std::filesystem;
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (!base) base = std::getenv("XDG_CACHE_HOME");
+    fs::path dir = base ? fs::path(base) / "MeetAssist" : fs::path(".");
+    return (dir / "location_cache.json").string();
+}
+
+bool LocationCache::load() {
+    try {
+        std::ifstream file(m_path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        json data = json::parse(file);
+        if (data.value("version", 0) != CACHE_FORMAT_VERSION) {
+            return false;
+        }
+
+        m_entries.clear();
+        for (const auto& item : data["entries"]) {
+            Entry entry{LocationInfo(), item.value("fetched_at", int64_t(0))};
+            if (fromJson(item["info"], entry.info)) {
+                m_entries[entry.info.ip.toString()] = entry;
+            }
+        }
+        return true;
+    }
+    catch (const std::exception&) {
+        // A corrupt cache is treated as empty
+        m_entries.clear();
+        return false;
+    }
+}
+
+bool LocationCache::save() const {
+    namespace fs = std::filesystem;
+    try {
+        json entries = json::array();
+        for (const auto& [ip, entry] : m_entries) {
+            entries.push_back({{"info", toJson(entry.info)}, {"fetched_at", entry.fetchedAt}});
+        }
+        json data = {{"version", CACHE_FORMAT_VERSION}, {"entries", entries}};
+
+        fs::path target(m_path);
+        if (target.has_parent_path()) {
+            fs::create_directories(target.parent_path());
+        }
+
+        // Write to a temporary file and rename so readers never see a partial file
+        fs::path temp = target;
+        temp += ".tmp";
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            file << data.dump();
+            if (!file.good()) {
+                return false;
+            }
+        }
+        fs::rename(temp, target);
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+CacheFreshness LocationCache::lookup(const IpAddress& ip, LocationInfo& out) const {
+    auto it = m_entries.find(ip.toString());
+    if (it == m_entries.end()) {
+        return CacheFreshness::Missing;
+    }
+
+    CacheFreshness freshness = classify(it->second);
+    if (freshness != CacheFreshness::Expired) {
+        out = it->second.info;
+    }
+    return freshness;
+}
+
+CacheFreshness LocationCache::latest(LocationInfo& out) const {
+    const Entry* newest = nullptr;
+    for (const auto& [ip, entry] : m_entries) {
+        if (!newest || entry.fetchedAt > newest->fetchedAt) {
+            newest = &entry;
+        }
+    }
+    if (!newest) {
+        return CacheFreshness::Missing;
+    }
+
+    CacheFreshness freshness = classify(*newest);
+    if (freshness != CacheFreshness::Expired) {
+        out = newest->info;
+    }
+    return freshness;
+}
+
+void LocationCache::store(const LocationInfo& info) {
+    m_entries[info.ip.toString()] = Entry{info, now()};
+
+    // Evict the oldest entries once the cache is full
+    while (m_entries.size() > MAX_ENTRIES) {
+        auto oldest = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->second.fetchedAt < oldest->second.fetchedAt) {
+                oldest = it;
+            }
+        }
+        m_entries.erase(oldest);
+    }
+}
+
+CacheFreshness LocationCache::classify(const Entry& entry) const {
+    int64_t age = now() - entry.fetchedAt;
+    if (age < 0) {
+        // Clock moved backwards, trust the entry but revalidate it
+        return CacheFreshness::Stale;
+    }
+    if (age <= m_ttl.count()) {
+        return CacheFreshness::Fresh;
+    }
+    if (age <= m_ttl.count() + m_staleWindow.count()) {
+        return CacheFreshness::Stale;
+    }
+    return CacheFreshness::Expired;
+}
+
+int64_t LocationCache::now() {
+    using namespace std::chrono;
+    return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+}
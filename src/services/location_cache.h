@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include "location_info.h"
+
+// How usable a cached entry is at lookup time
+enum class CacheFreshness {
+    Missing,    // No entry for the key
+    Fresh,      // Within TTL, use as-is
+    Stale,      // Past TTL but within the stale window, use and revalidate
+    Expired     // Too old to show
+};
+
+// On-disk cache of resolved LocationInfo keyed by public IP.
+// Entries are served while fresh, served and revalidated while stale,
+// and ignored once past the stale window.
+class LocationCache {
+public:
+    LocationCache(std::string path,
+                  std::chrono::seconds ttl,
+                  std::chrono::seconds staleWindow);
+
+    // Default cache file under the per-user application data folder
+    static std::string defaultPath();
+
+    bool load();
+    bool save() const;
+
+    // Look up the entry for a public IP
+    CacheFreshness lookup(const IpAddress& ip, LocationInfo& out) const;
+
+    // Most recently stored entry, used before the public IP is known
+    CacheFreshness latest(LocationInfo& out) const;
+
+    // Insert or replace the entry for info.ip, stamped with the current time
+    void store(const LocationInfo& info);
+
+private:
+    struct Entry {
+        LocationInfo info;
+        int64_t fetchedAt;  // Seconds since epoch
+    };
+
+    CacheFreshness classify(const Entry& entry) const;
+    static int64_t now();
+
+    std::string m_path;
+    std::chrono::seconds m_ttl;
+    std::chrono::seconds m_staleWindow;
+    std::map<std::string, Entry> m_entries;
+
+    static const size_t MAX_ENTRIES = 16;
+};
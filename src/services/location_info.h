@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "interned_string.h"
+#include "ip_address.h"
+
+// Short ASCII code held inline, e.g. an ISO 3166 country or subdivision
+// code or an ISO 4217 currency code. Text longer than N is rejected.
+template <size_t N>
+class FixedCode {
+public:
+    FixedCode() = default;
+    explicit FixedCode(std::string_view text) { assign(text); }
+
+    bool assign(std::string_view text) {
+        if (text.size() > N) {
+            m_length = 0;
+            return false;
+        }
+        std::memcpy(m_chars, text.data(), text.size());
+        m_length = static_cast<uint8_t>(text.size());
+        return true;
+    }
+
+    std::string_view view() const { return std::string_view(m_chars, m_length); }
+    std::string str() const { return std::string(view()); }
+    bool empty() const { return m_length == 0; }
+
+    bool operator==(const FixedCode& other) const { return view() == other.view(); }
+    bool operator!=(const FixedCode& other) const { return !(*this == other); }
+
+private:
+    char m_chars[N] = {};
+    uint8_t m_length = 0;
+};
+
+using CountryCode = FixedCode<2>;
+using RegionCode = FixedCode<3>;
+using CurrencyCode = FixedCode<3>;
+
+static_assert(std::is_trivially_copyable<RegionCode>::value && sizeof(RegionCode) == 4,
+              "Codes must stay inline: their characters and a length byte");
+
+// How far detection got for a snapshot
+enum class LocationState : uint8_t {
+    Detecting,      // Nothing known yet
+    AddressKnown,   // Public IP known, location still being looked up
+    Resolved,       // Location found for the IP
+    Unresolved      // Lookup finished without a location
+};
+
+// Fields that are not known are empty. Every member is a value or a
+// handle, so snapshots copy as plain memory.
+struct LocationInfo {
+    IpAddress ip;
+    LocationState state = LocationState::Detecting;
+    CountryCode country_code;
+    RegionCode region_code;
+    CurrencyCode currency;
+    InternedString country;
+    InternedString region;
+    InternedString city;
+    InternedString zip;
+    InternedString timezone;
+    InternedString currency_symbol;
+    double latitude = 0.0;
+    double longitude = 0.0;
+
+    // Until a currency is detected prices are shown in US dollars
+    LocationInfo() : currency("USD") {
+        static const InternedString dollar = InternedString::intern("$");
+        currency_symbol = dollar;
+    }
+
+    bool isResolved() const { return state == LocationState::Resolved; }
+};
+
+static_assert(std::is_trivially_copyable<LocationInfo>::value, "LocationInfo must copy as plain memory");
+static_assert(sizeof(LocationInfo) <= 96, "LocationInfo grew past its size budget");
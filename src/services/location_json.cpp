@@ -0,0 +1,216 @@
+#include "location_json.h"
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    // Stores a decoded value; returns false when it does not fit the field
+    using StringSetter = bool (*)(LocationInfo& info, std::string_view value);
+
+    struct StringField {
+        const char* key;
+        StringSetter assign;
+        uint32_t bit;
+    };
+
+    struct NumberField {
+        const char* key;
+        double LocationInfo::* member;
+        uint32_t bit;
+    };
+
+    template <InternedString LocationInfo::* Member>
+    bool assignInterned(LocationInfo& info, std::string_view value) {
+        info.*Member = InternedString::intern(value);
+        return true;
+    }
+
+    template <typename Code, Code LocationInfo::* Member>
+    bool assignCode(LocationInfo& info, std::string_view value) {
+        return (info.*Member).assign(value);
+    }
+
+    const StringField IP_API_STRING_FIELDS[] = {
+        {"country", &assignInterned<&LocationInfo::country>, LOCATION_FIELD_COUNTRY},
+        {"countryCode", &assignCode<CountryCode, &LocationInfo::country_code>, LOCATION_FIELD_COUNTRY_CODE},
+        {"regionName", &assignInterned<&LocationInfo::region>, LOCATION_FIELD_REGION},
+        {"region", &assignCode<RegionCode, &LocationInfo::region_code>, LOCATION_FIELD_REGION_CODE},
+        {"city", &assignInterned<&LocationInfo::city>, LOCATION_FIELD_CITY},
+        {"zip", &assignInterned<&LocationInfo::zip>, LOCATION_FIELD_ZIP},
+        {"timezone", &assignInterned<&LocationInfo::timezone>, LOCATION_FIELD_TIMEZONE}
+    };
+
+    const NumberField IP_API_NUMBER_FIELDS[] = {
+        {"lat", &LocationInfo::latitude, LOCATION_FIELD_LATITUDE},
+        {"lon", &LocationInfo::longitude, LOCATION_FIELD_LONGITUDE}
+    };
+
+    // Top-level keys of the ip-api.com object, written straight into LocationInfo.
+    // Text fields are interned; codes that are too long are left unset.
+    class IpApiHandler {
+    public:
+        explicit IpApiHandler(LocationInfo& info) : m_info(info) {}
+
+        bool null() { return clearPending(); }
+        bool boolean(bool) { return clearPending(); }
+        bool number_integer(json::number_integer_t value) { return number(static_cast<double>(value)); }
+        bool number_unsigned(json::number_unsigned_t value) { return number(static_cast<double>(value)); }
+        bool number_float(json::number_float_t value, const json::string_t&) { return number(value); }
+        bool binary(json::binary_t&) { return clearPending(); }
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) { return false; }
+
+        bool string(json::string_t& value) {
+            if (m_statusPending) {
+                m_statusSuccess = value == "success";
+            } else if (m_string && m_string->assign(m_info, value)) {
+                m_fields |= m_string->bit;
+            }
+            return clearPending();
+        }
+
+        bool start_object(std::size_t) { ++m_depth; return clearPending(); }
+        bool end_object() { --m_depth; return clearPending(); }
+        bool start_array(std::size_t) { ++m_depth; return clearPending(); }
+        bool end_array() { --m_depth; return clearPending(); }
+
+        bool key(json::string_t& name) {
+            clearPending();
+            if (m_depth != 1) {
+                return true;
+            }
+            if (name == "status") {
+                m_statusPending = true;
+                return true;
+            }
+            for (const StringField& field : IP_API_STRING_FIELDS) {
+                if (name == field.key) {
+                    m_string = &field;
+                    return true;
+                }
+            }
+            for (const NumberField& field : IP_API_NUMBER_FIELDS) {
+                if (name == field.key) {
+                    m_number = &field;
+                    return true;
+                }
+            }
+            return true;
+        }
+
+        bool statusSuccess() const { return m_statusSuccess; }
+        uint32_t fields() const { return m_fields; }
+
+    private:
+        bool clearPending() {
+            m_string = nullptr;
+            m_number = nullptr;
+            m_statusPending = false;
+            return true;
+        }
+
+        bool number(double value) {
+            if (m_number) {
+                m_info.*(m_number->member) = value;
+                m_fields |= m_number->bit;
+            }
+            return clearPending();
+        }
+
+        LocationInfo& m_info;
+        const StringField* m_string = nullptr;
+        const NumberField* m_number = nullptr;
+        bool m_statusPending = false;
+        bool m_statusSuccess = false;
+        uint32_t m_fields = 0;
+        int m_depth = 0;
+    };
+
+    // Follows <country>.currencies.<CODE>.symbol for the first country and
+    // first currency, then stops the parse
+    class CurrencyHandler {
+    public:
+        CurrencyHandler(std::string& code, std::string& symbol) : m_code(code), m_symbol(symbol) {}
+
+        bool null() { return clearPending(); }
+        bool boolean(bool) { return clearPending(); }
+        bool number_integer(json::number_integer_t) { return clearPending(); }
+        bool number_unsigned(json::number_unsigned_t) { return clearPending(); }
+        bool number_float(json::number_float_t, const json::string_t&) { return clearPending(); }
+        bool binary(json::binary_t&) { return clearPending(); }
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) { return false; }
+
+        bool string(json::string_t& value) {
+            if (m_expect == Expect::Symbol) {
+                m_symbol = std::move(value);
+            }
+            return clearPending();
+        }
+
+        bool start_object(std::size_t) {
+            ++m_depth;
+            if (m_countryDepth < 0) {
+                m_countryDepth = m_depth;
+            } else if (m_expect == Expect::Currencies) {
+                m_currenciesDepth = m_depth;
+            } else if (m_expect == Expect::Currency) {
+                m_currencyDepth = m_depth;
+            }
+            return clearPending();
+        }
+
+        bool end_object() {
+            // Done once the first currency or the first country is closed
+            if (m_depth == m_currencyDepth || m_depth == m_countryDepth) {
+                return false;
+            }
+            --m_depth;
+            return clearPending();
+        }
+
+        bool start_array(std::size_t) { ++m_depth; return clearPending(); }
+        bool end_array() { --m_depth; return clearPending(); }
+
+        bool key(json::string_t& name) {
+            clearPending();
+            if (m_depth == m_countryDepth && name == "currencies") {
+                m_expect = Expect::Currencies;
+            } else if (m_depth == m_currenciesDepth && m_code.empty()) {
+                m_code = name;
+                m_expect = Expect::Currency;
+            } else if (m_depth == m_currencyDepth && name == "symbol") {
+                m_expect = Expect::Symbol;
+            }
+            return true;
+        }
+
+    private:
+        bool clearPending() {
+            m_expect = Expect::None;
+            return true;
+        }
+
+        enum class Expect { None, Currencies, Currency, Symbol };
+
+        std::string& m_code;
+        std::string& m_symbol;
+        Expect m_expect = Expect::None;
+        int m_depth = 0;
+        int m_countryDepth = -1;
+        int m_currenciesDepth = -1;
+        int m_currencyDepth = -1;
+    };
+}
+
+LocationDecodeResult decodeIpApiResponse(std::string_view body, LocationInfo& info) {
+    IpApiHandler handler(info);
+    bool complete = json::sax_parse(body.begin(), body.end(), &handler);
+    return LocationDecodeResult{complete, handler.statusSuccess(), handler.fields()};
+}
+
+bool decodeRestCountriesCurrency(std::string_view body, std::string& code, std::string& symbol) {
+    code.clear();
+    symbol.clear();
+    CurrencyHandler handler(code, symbol);
+    json::sax_parse(body.begin(), body.end(), &handler);
+    return !code.empty();
+}
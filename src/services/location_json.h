@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "location_info.h"
+
+// Streaming decoders for the geolocation service responses. They walk the
+// JSON once through nlohmann's SAX interface and write only the keys we use
+// straight into the target, without building a DOM. Missing and unknown
+// fields are tolerated; what was decoded is reported back.
+
+// Bits set in LocationDecodeResult::fields for each decoded value
+enum LocationField : uint32_t {
+    LOCATION_FIELD_COUNTRY      = 1u << 0,
+    LOCATION_FIELD_COUNTRY_CODE = 1u << 1,
+    LOCATION_FIELD_REGION       = 1u << 2,
+    LOCATION_FIELD_REGION_CODE  = 1u << 3,
+    LOCATION_FIELD_CITY         = 1u << 4,
+    LOCATION_FIELD_ZIP          = 1u << 5,
+    LOCATION_FIELD_TIMEZONE     = 1u << 6,
+    LOCATION_FIELD_LATITUDE     = 1u << 7,
+    LOCATION_FIELD_LONGITUDE    = 1u << 8
+};
+
+struct LocationDecodeResult {
+    bool complete;          // The whole document was well-formed
+    bool statusSuccess;     // "status" was "success"
+    uint32_t fields;        // LocationField bits that were written
+};
+
+// Decode an ip-api.com /json response into info
+LocationDecodeResult decodeIpApiResponse(std::string_view body, LocationInfo& info);
+
+// Decode the first currency of a restcountries.com /v3.1/alpha response.
+// Returns true when a currency code was found; symbol may stay empty.
+bool decodeRestCountriesCurrency(std::string_view body, std::string& code, std::string& symbol);
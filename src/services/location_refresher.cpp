@@ -0,0 +1,86 @@
+#include "location_refresher.h"
+
+LocationRefresher::LocationRefresher(std::unique_ptr<NetworkChangeSource> source,
+                                     std::chrono::milliseconds debounce,
+                                     std::function<void()> refresh)
+    : m_source(std::move(source))
+    , m_debounce(debounce)
+    , m_refresh(std::move(refresh))
+{
+}
+
+LocationRefresher::~LocationRefresher() {
+    stop();
+}
+
+bool LocationRefresher::start() {
+    if (m_thread.joinable() || !m_source) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+        m_pending = false;
+    }
+    m_thread = std::thread(&LocationRefresher::run, this);
+
+    if (!m_source->start([this]() { onChange(); })) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void LocationRefresher::stop() {
+    // Stop the source first so no callback arrives after the thread is gone
+    if (m_source) {
+        m_source->stop();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void LocationRefresher::onChange() {
+    ++m_changes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = true;
+        m_lastChange = std::chrono::steady_clock::now();
+    }
+    m_wake.notify_all();
+}
+
+void LocationRefresher::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this]() { return m_stopping || m_pending; });
+        if (m_stopping) {
+            return;
+        }
+
+        // Wait until the burst has been quiet for the whole debounce interval
+        auto quietUntil = m_lastChange + m_debounce;
+        while (!m_stopping && std::chrono::steady_clock::now() < quietUntil) {
+            m_wake.wait_until(lock, quietUntil);
+            quietUntil = m_lastChange + m_debounce;
+        }
+        if (m_stopping) {
+            return;
+        }
+
+        m_pending = false;
+        lock.unlock();
+        ++m_refreshes;
+        m_refresh();
+        lock.lock();
+    }
+}
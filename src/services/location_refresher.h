@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "network_change_source.h"
+
+// Turns bursts of network change notifications into single refreshes.
+// A refresh runs on the refresher's own thread once no further change has
+// been reported for the debounce interval.
+class LocationRefresher {
+public:
+    LocationRefresher(std::unique_ptr<NetworkChangeSource> source,
+                      std::chrono::milliseconds debounce,
+                      std::function<void()> refresh);
+    ~LocationRefresher();
+
+    LocationRefresher(const LocationRefresher&) = delete;
+    LocationRefresher& operator=(const LocationRefresher&) = delete;
+
+    bool start();
+    void stop();
+
+    uint64_t changeCount() const { return m_changes; }
+    uint64_t refreshCount() const { return m_refreshes; }
+
+private:
+    void onChange();
+    void run();
+
+    std::unique_ptr<NetworkChangeSource> m_source;
+    std::chrono::milliseconds m_debounce;
+    std::function<void()> m_refresh;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+    bool m_pending = false;
+    bool m_stopping = false;
+    std::chrono::steady_clock::time_point m_lastChange;
+
+    std::atomic<uint64_t> m_changes{0};
+    std::atomic<uint64_t> m_refreshes{0};
+};
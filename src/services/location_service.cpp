@@ -1,86 +1,472 @@
 #include "location_service.h"
-#include <regex>
-#include <sstream>
 #include <iostream>
-#include <nlohmann/json.hpp>
+#include <cstdlib>
+#include <algorithm>
 #include <iphlpapi.h>
-
-using json = nlohmann::json;
-
-// Static currency data initialization
-const std::map<std::string, std::pair<std::string, std::string>> LocationService::currencyData = {
-    {"US", {"USD", "$"}},
-    {"GB", {"GBP", "£"}},
-    {"EU", {"EUR", "€"}},
-    {"JP", {"JPY", "¥"}},
-    {"IN", {"INR", "₹"}},
-    // Add more currency mappings as needed
-};
+#include "currency_lookup.h"
 
 void WriteDebugLog(const std::string& message) {
     std::string fullMessage = "[Location] " + message + "\n";
     OutputDebugStringA(fullMessage.c_str());
 }
 
-LocationInfo LocationService::getLocationInfo() {
-    std::lock_guard<std::mutex> lock(locationMutex);
-    
-    if (locationInitialized) {
-        return cachedInfo;
+namespace {
+    // Cached locations are served without a lookup for a day and
+    // served while being revalidated for a further month
+    const std::chrono::hours LOCATION_CACHE_TTL(24);
+    const std::chrono::hours LOCATION_CACHE_STALE_WINDOW(24 * 30);
+
+    // Adapters report a burst of changes while connecting; refresh once
+    // things have settled
+    const std::chrono::milliseconds NETWORK_CHANGE_DEBOUNCE(2000);
+
+    // One unresponsive service must not eat the whole detection budget
+    const std::chrono::milliseconds HTTP_REQUEST_TIMEOUT(5000);
+}
+
+LocationService::LocationService()
+    : locationInitialized(false)
+    , cache(LocationCache::defaultPath(), LOCATION_CACHE_TTL, LOCATION_CACHE_STALE_WINDOW)
+    , startTime(std::chrono::steady_clock::now())
+    , cacheHits(0)
+    , cacheStaleHits(0)
+    , cacheMisses(0)
+    , firstLocationMicros(-1)
+    , networkLookupEnabled(true)
+    , refreshesSkipped(0)
+{
+    if (geoDatabase.open(geoDatabasePath())) {
+        WriteDebugLog("Offline GeoIP database loaded with " +
+                      std::to_string(geoDatabase.rangeCount()) + " ranges");
+    }
+
+    // Show the last known location immediately, detection refreshes it later
+    LocationInfo last;
+    if (cache.load()) {
+        CacheFreshness freshness = cache.latest(last);
+        if (freshness == CacheFreshness::Fresh || freshness == CacheFreshness::Stale) {
+            WriteDebugLog("Using cached location for " + last.ip.toString());
+            snapshot.publish(last);
+            recordFirstLocation();
+        }
+    }
+}
+
+LocationService::~LocationService() {
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        if (activeDetection) {
+            activeDetection->cancel();
+        }
+    }
+    stopNetworkMonitoring();
+    if (detectionThread.joinable()) {
+        detectionThread.join();
+    }
+}
+
+LocationInfo LocationService::getLocationInfo(std::chrono::milliseconds budget) {
+    if (!locationInitialized) {
+        startDetection();
+
+        std::unique_lock<std::mutex> lock(progressMutex);
+        if (!progressChanged.wait_for(lock, budget, [this]() { return locationInitialized.load(); })) {
+            WriteDebugLog("Location budget of " + std::to_string(budget.count()) +
+                          " ms expired, returning partial result");
+        }
+    }
+    return snapshot.read();
+}
+
+void LocationService::startDetection() {
+    // Detection runs once, on its own thread, however many callers wait on it
+    std::lock_guard<std::mutex> lock(progressMutex);
+    if (detectionThread.joinable() || locationInitialized) {
+        return;
     }
 
+    auto context = std::make_shared<DetectionContext>(DETECTION_BUDGET);
+    activeDetection = context;
+    detectionThread = std::thread([this, context]() {
+        runDetection(*context);
+
+        std::lock_guard<std::mutex> lock(progressMutex);
+        activeDetection.reset();
+        locationInitialized = true;
+        progressChanged.notify_all();
+    });
+}
+
+void LocationService::runDetection(DetectionContext& context) {
+    std::lock_guard<std::mutex> lock(detectionMutex);
     WriteDebugLog("Starting location detection...");
+    const LocationInfo& previous = snapshot.read();
 
     // Get IP first
-    cachedInfo.ip = getCurrentIP();
-    WriteDebugLog("IP Address detected: " + cachedInfo.ip);
+    IpAddress ip;
+    {
+        StageTimer timer(context, DetectionStage::IpDiscovery);
+        ip = getCurrentIP(context);
+    }
+    WriteDebugLog("IP Address detected: " + ip.toString());
+
+    // Only go to the network when the cached entry is missing or stale
+    LocationInfo info;
+    CacheFreshness freshness = cache.lookup(ip, info);
+    switch (freshness) {
+        case CacheFreshness::Fresh:
+            ++cacheHits;
+            WriteDebugLog("Location cache hit");
+            break;
+        case CacheFreshness::Stale:
+            ++cacheStaleHits;
+            publishLocation(info);
+            WriteDebugLog("Location cache stale, revalidating");
+            break;
+        default:
+            ++cacheMisses;
+            info = LocationInfo();
+            info.ip = ip;
+            info.state = LocationState::AddressKnown;
+            // Show the address right away, with the last known currency
+            info.currency = previous.currency;
+            info.currency_symbol = previous.currency_symbol;
+            publishLocation(info);
+            break;
+    }
+
+    if (freshness != CacheFreshness::Fresh) {
+        bool resolved;
+        {
+            StageTimer timer(context, DetectionStage::GeoLookup);
+            resolved = getLocationDetails(info, context);
+        }
 
-    // Get location details
-    if (getLocationDetails()) {
-        WriteDebugLog("Location details retrieved successfully");
+        if (resolved) {
+            WriteDebugLog("Location details retrieved successfully");
+            publishLocation(info);
+
+            bool currencyResolved;
+            {
+                StageTimer timer(context, DetectionStage::Currency);
+                currencyResolved = parseCurrencyInfo(info.country_code, info, context);
+            }
+
+            // A result cut short by the deadline is shown but not cached
+            if (currencyResolved) {
+                cache.store(info);
+                if (!cache.save()) {
+                    WriteDebugLog("Failed to write location cache");
+                }
+            }
+        } else {
+            WriteDebugLog("Failed to get location details");
+            if (info.state == LocationState::AddressKnown) {
+                info.state = LocationState::Unresolved;
+            }
+        }
+    }
+
+    publishLocation(info);
+    recordTimings(context);
+
+    LocationMetrics metrics = getMetrics();
+    WriteDebugLog("Cache hits/stale/misses: " + std::to_string(metrics.cacheHits) + "/" +
+                  std::to_string(metrics.cacheStaleHits) + "/" + std::to_string(metrics.cacheMisses) +
+                  ", time to first location: " + std::to_string(metrics.timeToFirstLocationMs) + " ms");
+}
+
+void LocationService::refreshLocation() {
+    if (!locationInitialized) {
+        return;
+    }
+
+    auto context = std::make_shared<DetectionContext>(REFRESH_BUDGET);
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        activeRefresh = context;
+    }
+
+    runRefresh(*context);
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    if (activeRefresh == context) {
+        activeRefresh.reset();
+    }
+}
+
+void LocationService::runRefresh(DetectionContext& context) {
+    // Wait for a detection or refresh already in progress, then start from
+    // whatever it published
+    std::lock_guard<std::mutex> lock(detectionMutex);
+    const LocationInfo& previous = snapshot.read();
+
+    IpAddress ip;
+    {
+        StageTimer timer(context, DetectionStage::IpDiscovery);
+        ip = getCurrentIP(context);
+    }
+    if (!ip.isValid() || ip == previous.ip) {
+        ++refreshesSkipped;
+        recordTimings(context);
+        WriteDebugLog("Network changed but public IP is still " + previous.ip.toString() + ", skipping lookup");
+        return;
+    }
+    WriteDebugLog("Public IP changed from " + previous.ip.toString() + " to " + ip.toString());
+
+    LocationInfo info;
+    CacheFreshness freshness = cache.lookup(ip, info);
+    switch (freshness) {
+        case CacheFreshness::Fresh:
+            ++cacheHits;
+            recordTimings(context);
+            publishLocation(std::move(info));
+            WriteDebugLog("Location cache hit for new IP");
+            return;
+        case CacheFreshness::Stale:
+            ++cacheStaleHits;
+            publishLocation(info);
+            break;
+        default:
+            ++cacheMisses;
+            info = LocationInfo();
+            info.ip = ip;
+            info.state = LocationState::AddressKnown;
+            break;
+    }
+
+    bool resolved;
+    {
+        StageTimer timer(context, DetectionStage::GeoLookup);
+        resolved = getLocationDetails(info, context);
+    }
+    if (!resolved) {
+        // Keep showing the previous (or stale cached) location
+        recordTimings(context);
+        WriteDebugLog("Failed to refresh location details");
+        return;
+    }
+
+    // Only the currency lookup can go to the network, skip it within a country
+    bool currencyResolved = true;
+    if (info.country_code == previous.country_code) {
+        info.currency = previous.currency;
+        info.currency_symbol = previous.currency_symbol;
     } else {
-        WriteDebugLog("Failed to get location details");
+        StageTimer timer(context, DetectionStage::Currency);
+        currencyResolved = parseCurrencyInfo(info.country_code, info, context);
+    }
+
+    if (currencyResolved) {
+        cache.store(info);
+        if (!cache.save()) {
+            WriteDebugLog("Failed to write location cache");
+        }
+    }
+    recordTimings(context);
+    publishLocation(std::move(info));
+}
+
+bool LocationService::startNetworkMonitoring(std::unique_ptr<NetworkChangeSource> source) {
+    std::lock_guard<std::mutex> lock(refresherMutex);
+    if (refresher) {
+        return true;
+    }
+
+    if (!source) {
+        source = createSystemNetworkChangeSource();
+    }
+    auto monitor = std::make_unique<LocationRefresher>(std::move(source), NETWORK_CHANGE_DEBOUNCE,
+                                                       [this]() { refreshLocation(); });
+    if (!monitor->start()) {
+        WriteDebugLog("Failed to start network change monitoring");
+        return false;
+    }
+
+    refresher = std::move(monitor);
+    WriteDebugLog("Network change monitoring started");
+    return true;
+}
+
+void LocationService::stopNetworkMonitoring() {
+    std::unique_ptr<LocationRefresher> stopped;
+    {
+        std::lock_guard<std::mutex> lock(refresherMutex);
+        stopped = std::move(refresher);
+    }
+    {
+        // Don't hold up shutdown for a refresh that is still on the network
+        std::lock_guard<std::mutex> lock(progressMutex);
+        if (activeRefresh) {
+            activeRefresh->cancel();
+        }
+    }
+    if (stopped) {
+        stopped->stop();
+    }
+}
+
+uint64_t LocationService::subscribe(LocationListener listener, TaskDispatcher dispatcher) {
+    // Register before reading, so a publish in between reaches the new
+    // listener itself; the versions keep this older value from landing last
+    uint64_t id = subscribers.add(std::move(listener), std::move(dispatcher));
+    uint64_t version = 0;
+    const LocationInfo& current = snapshot.read(version);
+    subscribers.notifyOne(id, current, version);
+    return id;
+}
+
+void LocationService::unsubscribe(uint64_t subscriptionId) {
+    subscribers.remove(subscriptionId);
+}
+
+void LocationService::publishLocation(LocationInfo info) {
+    snapshot.publish(std::move(info));
+    recordFirstLocation();
+    uint64_t version = 0;
+    const LocationInfo& current = snapshot.read(version);
+    subscribers.notify(current, version);
+}
+
+LocationMetrics LocationService::getMetrics() const {
+    LocationMetrics metrics;
+    metrics.cacheHits = cacheHits;
+    metrics.cacheStaleHits = cacheStaleHits;
+    metrics.cacheMisses = cacheMisses;
+    int64_t micros = firstLocationMicros;
+    metrics.timeToFirstLocationMs = micros < 0 ? -1.0 : micros / 1000.0;
+
+    metrics.networkChanges = 0;
+    metrics.refreshes = 0;
+    metrics.refreshesSkipped = refreshesSkipped;
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        metrics.lastDetection = lastTimings;
     }
+    {
+        std::lock_guard<std::mutex> lock(refresherMutex);
+        if (refresher) {
+            metrics.networkChanges = refresher->changeCount();
+            metrics.refreshes = refresher->refreshCount();
+        }
+    }
+    return metrics;
+}
 
-    locationInitialized = true;
-    return cachedInfo;
+void LocationService::recordFirstLocation() {
+    using namespace std::chrono;
+    int64_t elapsed = duration_cast<microseconds>(steady_clock::now() - startTime).count();
+    int64_t unset = -1;
+    firstLocationMicros.compare_exchange_strong(unset, elapsed);
 }
 
-bool LocationService::getLocationDetails() {
+void LocationService::recordTimings(const DetectionContext& context) {
+    DetectionTimings timings;
+    timings.ipDiscoveryMs = context.stageMs(DetectionStage::IpDiscovery);
+    timings.geoLookupMs = context.stageMs(DetectionStage::GeoLookup);
+    timings.currencyMs = context.stageMs(DetectionStage::Currency);
+    timings.totalMs = context.elapsedMs();
+    timings.timedOut = context.expired();
+
+    WriteDebugLog("Detection stages (ms): ip " + std::to_string(timings.ipDiscoveryMs) +
+                  ", geo " + std::to_string(timings.geoLookupMs) +
+                  ", currency " + std::to_string(timings.currencyMs) +
+                  ", total " + std::to_string(timings.totalMs) +
+                  (timings.timedOut ? " (deadline reached)" : ""));
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    lastTimings = timings;
+}
+
+std::string LocationService::geoDatabasePath() {
+    if (const char* path = std::getenv("MEETASSIST_GEOIP_DB")) {
+        return path;
+    }
+
+    // Default to geoip.madb next to the executable
+    char modulePath[MAX_PATH] = {};
+    DWORD length = GetModuleFileNameA(nullptr, modulePath, MAX_PATH);
+    std::string path(modulePath, length);
+    size_t slash = path.find_last_of("\\/");
+    return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "geoip.madb";
+}
+
+bool LocationService::getLocalLocationDetails(LocationInfo& info) {
+    GeoIpLocation location;
+    if (!geoDatabase.lookup(info.ip, location) || !info.country_code.assign(location.countryCode)) {
+        return false;
+    }
+
+    info.state = LocationState::Resolved;
+    info.country = InternedString::intern(location.country);
+    info.region = InternedString::intern(location.region);
+    info.region_code.assign(location.regionCode);
+    info.city = InternedString::intern(location.city);
+    info.zip = InternedString::intern(location.zip);
+    info.timezone = InternedString::intern(location.timezone);
+    info.latitude = location.latitude;
+    info.longitude = location.longitude;
+    return true;
+}
+
+bool LocationService::getLocationDetails(LocationInfo& info, DetectionContext& context) {
+    if (getLocalLocationDetails(info)) {
+        WriteDebugLog("Location resolved from offline database");
+        return true;
+    }
+
+    if (!networkLookupEnabled) {
+        WriteDebugLog("IP not in offline database and network lookup is disabled");
+        return false;
+    }
+    if (context.expired()) {
+        WriteDebugLog("IP not in offline database and the detection deadline has passed");
+        return false;
+    }
+
     try {
         // Use ip-api.com for location data
         std::wstring host = L"ip-api.com";
-        std::wstring path = L"/json/" + std::wstring(cachedInfo.ip.begin(), cachedInfo.ip.end());
+        std::string ip = info.ip.toString();
+        std::wstring path = L"/json/" + std::wstring(ip.begin(), ip.end());
         
-        std::string response = makeHttpRequest(host.c_str(), path.c_str());
+        HttpBody response = makeHttpRequest(host.c_str(), path.c_str(), context);
         if (response.empty()) {
             WriteDebugLog("Failed to get response from ip-api.com");
             return false;
         }
 
-        // Parse JSON response
-        json data = json::parse(response);
-        
-        if (data["status"] == "success") {
-            cachedInfo.country = data["country"].get<std::string>();
-            cachedInfo.country_code = data["countryCode"].get<std::string>();
-            cachedInfo.region = data["regionName"].get<std::string>();
-            cachedInfo.region_code = data["region"].get<std::string>();
-            cachedInfo.city = data["city"].get<std::string>();
-            cachedInfo.zip = data.value("zip", "");
-            cachedInfo.timezone = data["timezone"].get<std::string>();
-            cachedInfo.latitude = data["lat"].get<double>();
-            cachedInfo.longitude = data["lon"].get<double>();
-
-            // Get currency information based on country code
-            parseCurrencyInfo(cachedInfo.country_code);
-
-            WriteDebugLog("Location data parsed successfully");
-            return true;
-        } else {
+        // Decode only the fields we need straight from the receive buffer
+        LocationDecodeResult result = decodeIpApiResponse(response.view(), info);
+        if (!result.statusSuccess) {
             WriteDebugLog("IP-API returned error status");
             return false;
         }
+        if (!result.complete) {
+            WriteDebugLog("IP-API response was malformed, keeping partial result");
+        }
+        if (!(result.fields & LOCATION_FIELD_COUNTRY_CODE)) {
+            WriteDebugLog("IP-API response has no country code");
+            return false;
+        }
+
+        // Fields the response left out are unknown, not whatever a stale
+        // cache entry had. Coordinates are only kept as a pair; 0,0 is
+        // the unknown position.
+        if (!(result.fields & LOCATION_FIELD_COUNTRY)) info.country = InternedString();
+        if (!(result.fields & LOCATION_FIELD_REGION)) info.region = InternedString();
+        if (!(result.fields & LOCATION_FIELD_REGION_CODE)) info.region_code = RegionCode();
+        if (!(result.fields & LOCATION_FIELD_CITY)) info.city = InternedString();
+        if (!(result.fields & LOCATION_FIELD_ZIP)) info.zip = InternedString();
+        if (!(result.fields & LOCATION_FIELD_TIMEZONE)) info.timezone = InternedString();
+        if (!(result.fields & LOCATION_FIELD_LATITUDE) || !(result.fields & LOCATION_FIELD_LONGITUDE)) {
+            info.latitude = 0.0;
+            info.longitude = 0.0;
+        }
+        info.state = LocationState::Resolved;
+
+        WriteDebugLog("Location data parsed successfully");
+        return true;
     }
     catch (const std::exception& e) {
         WriteDebugLog("Error parsing location data: " + std::string(e.what()));
@@ -88,40 +474,37 @@ bool LocationService::getLocationDetails() {
     }
 }
 
-void LocationService::parseCurrencyInfo(const std::string& countryCode) {
-    auto it = currencyData.find(countryCode);
-    if (it != currencyData.end()) {
-        cachedInfo.currency = it->second.first;
-        cachedInfo.currency_symbol = it->second.second;
-    } else {
-        // Use a fallback currency service
-        try {
-            std::wstring host = L"restcountries.com";
-            std::wstring path = L"/v3.1/alpha/" + std::wstring(countryCode.begin(), countryCode.end());
-            
-            std::string response = makeHttpRequest(host.c_str(), path.c_str());
-            if (!response.empty()) {
-                json data = json::parse(response);
-                if (!data.empty()) {
-                    // Parse currency information from the response
-                    auto currencies = data[0]["currencies"];
-                    for (auto& [code, info] : currencies.items()) {
-                        cachedInfo.currency = code;
-                        if (info.contains("symbol")) {
-                            cachedInfo.currency_symbol = info["symbol"].get<std::string>();
-                        }
-                        break; // Just take the first currency
-                    }
-                }
+bool LocationService::parseCurrencyInfo(const CountryCode& countryCode, LocationInfo& info,
+                                        DetectionContext& context) {
+    // Known country codes never leave the compiled-in ISO 4217 table
+    if (applyTableCurrency(countryCode, info)) {
+        return true;
+    }
+
+    // Use a fallback currency service
+    try {
+        std::wstring host = L"restcountries.com";
+        std::string_view country = countryCode.view();
+        std::wstring path = L"/v3.1/alpha/" + std::wstring(country.begin(), country.end());
+        
+        HttpBody response = makeHttpRequest(host.c_str(), path.c_str(), context);
+        std::string code;
+        std::string symbol;
+        if (!response.empty() && decodeRestCountriesCurrency(response.view(), code, symbol) &&
+            info.currency.assign(code)) {
+            if (!symbol.empty()) {
+                info.currency_symbol = InternedString::intern(symbol);
             }
+            return true;
         }
-        catch (const std::exception& e) {
-            WriteDebugLog("Error getting currency data: " + std::string(e.what()));
-        }
     }
+    catch (const std::exception& e) {
+        WriteDebugLog("Error getting currency data: " + std::string(e.what()));
+    }
+    return false;
 }
 
-std::string LocationService::getCurrentIP() {
+IpAddress LocationService::getCurrentIP(DetectionContext& context) {
     WriteDebugLog("Starting IP detection...");
     
     // First try online services
@@ -133,21 +516,33 @@ std::string LocationService::getCurrentIP() {
     };
 
     for (const auto& service : ipServices) {
+        if (context.expired()) {
+            WriteDebugLog("Detection deadline reached during IP discovery");
+            break;
+        }
+
         try {
-            WriteDebugLog("Trying IP service: " + wstring_to_string(service.first));
-            std::string response = makeHttpRequest(service.first.c_str(), service.second.c_str());
+            WriteDebugLog("Trying IP service: " + wideToUtf8(service.first));
+            HttpBody body = makeHttpRequest(service.first.c_str(), service.second.c_str(), context);
             
             // Clean up response
-            response.erase(std::remove_if(response.begin(), response.end(), 
-                [](char c) { return std::isspace(c); }), response.end());
+            std::string response;
+            response.reserve(body.size());
+            for (char c : body.view()) {
+                if (!std::isspace(static_cast<unsigned char>(c))) {
+                    response += c;
+                }
+            }
             
-            if (validateIPFormat(response)) {
-                WriteDebugLog("Successfully retrieved IP: " + response);
-                return response;
+            // Accept IPv4 or IPv6 answers and normalise them for cache keys
+            IpAddress address;
+            if (IpAddress::parse(response, address) && !address.isUnspecified()) {
+                WriteDebugLog("Successfully retrieved IP: " + address.toString());
+                return address;
             }
         }
         catch (const std::exception& e) {
-            WriteDebugLog("Error with service " + wstring_to_string(service.first) + ": " + e.what());
+            WriteDebugLog("Error with service " + wideToUtf8(service.first) + ": " + e.what());
         }
     }
 
@@ -155,8 +550,9 @@ std::string LocationService::getCurrentIP() {
     return getLocalIP();
 }
 
-std::string LocationService::getLocalIP() {
-    std::string result;
+IpAddress LocationService::getLocalIP() {
+    IpAddress v4Address;
+    IpAddress v6Address;
     DWORD dwRetVal = 0;
     ULONG outBufLen = 15000;
     PIP_ADAPTER_ADDRESSES pAddresses = nullptr;
@@ -165,10 +561,10 @@ std::string LocationService::getLocalIP() {
         pAddresses = (IP_ADAPTER_ADDRESSES*)malloc(outBufLen);
         if (pAddresses == nullptr) {
             WriteDebugLog("Memory allocation failed");
-            return "";
+            return IpAddress();
         }
 
-        dwRetVal = GetAdaptersAddresses(AF_INET, GAA_FLAG_INCLUDE_PREFIX, nullptr, pAddresses, &outBufLen);
+        dwRetVal = GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_INCLUDE_PREFIX, nullptr, pAddresses, &outBufLen);
         if (dwRetVal == ERROR_BUFFER_OVERFLOW) {
             free(pAddresses);
             pAddresses = nullptr;
@@ -177,26 +573,33 @@ std::string LocationService::getLocalIP() {
 
     if (dwRetVal == NO_ERROR) {
         PIP_ADAPTER_ADDRESSES pCurrAddresses = pAddresses;
-        while (pCurrAddresses) {
+        while (pCurrAddresses && !v4Address.isValid()) {
             if (pCurrAddresses->OperStatus == IfOperStatusUp &&
                 pCurrAddresses->IfType != IF_TYPE_SOFTWARE_LOOPBACK) {
                 
                 PIP_ADAPTER_UNICAST_ADDRESS pUnicast = pCurrAddresses->FirstUnicastAddress;
                 while (pUnicast != nullptr) {
-                    if (pUnicast->Address.lpSockaddr->sa_family == AF_INET) {
-                        sockaddr_in* sa_in = (sockaddr_in*)pUnicast->Address.lpSockaddr;
-                        char ip[INET_ADDRSTRLEN];
-                        inet_ntop(AF_INET, &(sa_in->sin_addr), ip, INET_ADDRSTRLEN);
-                        std::string ipStr(ip);
-                        if (ipStr != "127.0.0.1" && ipStr.substr(0, 3) != "169") {
-                            result = ipStr;
-                            break;
+                    // Read the binary address directly, no text round-trip
+                    IpAddress address;
+                    const sockaddr* sa = pUnicast->Address.lpSockaddr;
+                    if (sa->sa_family == AF_INET) {
+                        const sockaddr_in* sa_in = reinterpret_cast<const sockaddr_in*>(sa);
+                        address = IpAddress::fromV4(reinterpret_cast<const uint8_t*>(&sa_in->sin_addr));
+                    } else if (sa->sa_family == AF_INET6) {
+                        const sockaddr_in6* sa_in6 = reinterpret_cast<const sockaddr_in6*>(sa);
+                        address = IpAddress::fromV6(sa_in6->sin6_addr.s6_addr);
+                    }
+
+                    if (address.isValid() && !address.isLoopback() && !address.isLinkLocal()) {
+                        IpAddress& slot = address.isV4() ? v4Address : v6Address;
+                        if (!slot.isValid()) {
+                            slot = address;
                         }
+                        if (address.isV4()) break;
                     }
                     pUnicast = pUnicast->Next;
                 }
             }
-            if (!result.empty()) break;
             pCurrAddresses = pCurrAddresses->Next;
         }
     }
@@ -205,38 +608,24 @@ std::string LocationService::getLocalIP() {
         free(pAddresses);
     }
 
-    if (result.empty()) {
-        result = "127.0.0.1";
-    }
+    // Prefer IPv4, then a routable IPv6 address, then loopback
+    static const uint8_t LOOPBACK[4] = {127, 0, 0, 1};
+    IpAddress result = v4Address.isValid() ? v4Address
+                     : v6Address.isValid() ? v6Address
+                     : IpAddress::fromV4(LOOPBACK);
 
-    WriteDebugLog("Local IP detected: " + result);
+    WriteDebugLog("Local IP detected: " + result.toString());
     return result;
 }
 
-bool LocationService::validateIPFormat(const std::string& ip) {
-    std::regex ipPattern("^(?:[0-9]{1,3}\\.){3}[0-9]{1,3}$");
-    
-    if (std::regex_match(ip, ipPattern)) {
-        std::stringstream ss(ip);
-        std::string octet;
-        while (std::getline(ss, octet, '.')) {
-            try {
-                int value = std::stoi(octet);
-                if (value < 0 || value > 255) {
-                    return false;
-                }
-            }
-            catch (...) {
-                return false;
-            }
-        }
-        return true;
+HttpBody LocationService::makeHttpRequest(const wchar_t* host, const wchar_t* path,
+                                          DetectionContext& context) {
+    HttpBody response;
+    if (context.expired()) {
+        WriteDebugLog("Skipping request, detection deadline reached");
+        return response;
     }
-    return false;
-}
 
-std::string LocationService::makeHttpRequest(const wchar_t* host, const wchar_t* path) {
-    std::string response;
     HINTERNET hInternet = nullptr;
     HINTERNET hConnect = nullptr;
     HINTERNET hRequest = nullptr;
@@ -251,6 +640,12 @@ std::string LocationService::makeHttpRequest(const wchar_t* host, const wchar_t*
             return response;
         }
 
+        // No phase of the request may outlive the detection budget. A zero
+        // timeout means infinite to WinHTTP, so wait at least a millisecond.
+        int64_t remainingMs = std::min(context.remaining(), HTTP_REQUEST_TIMEOUT).count();
+        int timeoutMs = static_cast<int>(std::max<int64_t>(remainingMs, 1));
+        WinHttpSetTimeouts(hInternet, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
+
         hConnect = WinHttpConnect(hInternet, host, INTERNET_DEFAULT_HTTP_PORT, 0);
         if (!hConnect) {
             WriteDebugLog("Failed to connect to host");
@@ -286,27 +681,60 @@ std::string LocationService::makeHttpRequest(const wchar_t* host, const wchar_t*
             return response;
         }
 
+        // Preallocate from Content-Length when the server sends one
+        DWORD contentLength = 0;
+        DWORD headerSize = sizeof(contentLength);
+        if (WinHttpQueryHeaders(hRequest,
+                               WINHTTP_QUERY_CONTENT_LENGTH | WINHTTP_QUERY_FLAG_NUMBER,
+                               WINHTTP_HEADER_NAME_BY_INDEX, &contentLength,
+                               &headerSize, WINHTTP_NO_HEADER_INDEX)) {
+            if (!response.reserve(contentLength)) {
+                WriteDebugLog("Response too large: " + std::to_string(contentLength) + " bytes");
+                WinHttpCloseHandle(hRequest);
+                WinHttpCloseHandle(hConnect);
+                WinHttpCloseHandle(hInternet);
+                return response;
+            }
+        }
+
         DWORD bytesAvailable = 0;
         DWORD bytesRead = 0;
-        std::vector<char> buffer;
 
         do {
+            if (context.expired()) {
+                WriteDebugLog("Detection deadline reached while reading response");
+                response.clear();
+                break;
+            }
+
             bytesAvailable = 0;
-            WinHttpQueryDataAvailable(hRequest, &bytesAvailable);
+            if (!WinHttpQueryDataAvailable(hRequest, &bytesAvailable)) {
+                WriteDebugLog("Error querying available data");
+                break;
+            }
             
             if (bytesAvailable == 0) break;
 
-            buffer.resize(bytesAvailable + 1);
-            
-            if (!WinHttpReadData(hRequest, buffer.data(),
+            // Read straight into the tail of the body buffer. Bodies without
+            // a Content-Length are held to the same limit.
+            char* dest = response.prepare(bytesAvailable);
+            if (!dest) {
+                WriteDebugLog("Response exceeded " + std::to_string(response.limit()) + " bytes");
+                response.clear();
+                break;
+            }
+
+            if (!WinHttpReadData(hRequest, dest,
                                 bytesAvailable, &bytesRead)) {
                 WriteDebugLog("Error reading data");
                 break;
             }
 
-            buffer[bytesRead] = '\0';
-            response += buffer.data();
+            response.commit(bytesRead);
         } while (bytesAvailable > 0);
+
+        WriteDebugLog("Received " + std::to_string(response.size()) + " bytes in " +
+                      std::to_string(response.allocationCount()) + " allocation(s)");
     }
     catch (const std::exception& e) {
         WriteDebugLog("Error in makeHttpRequest: " + std::string(e.what()));
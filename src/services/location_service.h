@@ -9,40 +9,46 @@
 #include <vector>
 #include <mutex>
 #include <memory>
-#include <nlohmann/json.hpp>  // Add this for JSON parsing
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include "http_body.h"
+#include "location_info.h"
+#include "location_cache.h"
+#include "geoip_database.h"
+#include "currency_table.h"
+#include "snapshot_cell.h"
+#include "location_json.h"
+#include "ip_address.h"
+#include "subscriber_list.h"
+#include "location_refresher.h"
+#include "detection_context.h"
+#include "utf_transcode.h"
 
 #pragma comment(lib, "ws2_32.lib")
 #pragma comment(lib, "winhttp.lib")
 
-struct LocationInfo {
-    std::string ip;
-    std::string country;
-    std::string country_code;
-    std::string region;
-    std::string region_code;
-    std::string city;
-    std::string zip;
-    std::string timezone;
-    std::string currency;
-    std::string currency_symbol;
-    double latitude;
-    double longitude;
-
-    // Constructor with default values
-    LocationInfo() : 
-        latitude(0.0), 
-        longitude(0.0) {
-        ip = "Detecting...";
-        country = "Detecting...";
-        country_code = "Detecting...";
-        region = "Detecting...";
-        region_code = "Detecting...";
-        city = "Detecting...";
-        zip = "Detecting...";
-        timezone = "Detecting...";
-        currency = "USD";
-        currency_symbol = "$";
-    }
+// Per-stage wall time of the most recent detection or refresh; all zero
+// until one has finished
+struct DetectionTimings {
+    double ipDiscoveryMs = 0.0;
+    double geoLookupMs = 0.0;
+    double currencyMs = 0.0;
+    double totalMs = 0.0;
+    bool timedOut = false;          // The budget ran out before every stage finished
+};
+
+// Cache effectiveness and startup latency counters
+struct LocationMetrics {
+    uint64_t cacheHits;
+    uint64_t cacheStaleHits;
+    uint64_t cacheMisses;
+    double timeToFirstLocationMs;   // Negative until a location is available
+    uint64_t networkChanges;        // Raw adapter/address notifications
+    uint64_t refreshes;             // Debounced refreshes that ran
+    uint64_t refreshesSkipped;      // Refreshes where the public IP was unchanged
+    DetectionTimings lastDetection;
 };
 
 class LocationService {
@@ -52,38 +58,95 @@ public:
         return instance;
     }
     
-    LocationInfo getLocationInfo();
-    const LocationInfo& getCachedLocationInfo() const { return cachedInfo; }
+    // Hard limits for a whole detection run and for a refresh
+    static constexpr std::chrono::milliseconds DETECTION_BUDGET{20000};
+    static constexpr std::chrono::milliseconds REFRESH_BUDGET{10000};
+
+    // Waits up to budget for detection and returns the best snapshot
+    // available by then, e.g. the IP with the last known currency. Detection
+    // keeps running in the background and publishes the rest when done.
+    LocationInfo getLocationInfo(std::chrono::milliseconds budget = DETECTION_BUDGET);
+
+    // Wait-free access to the latest published snapshot. The reference
+    // stays valid for the life of the service; snapshots are immutable.
+    const LocationInfo& getCachedLocationInfo() const { return snapshot.read(); }
+
+    // Bumped on every publish, so readers can poll for changes cheaply
+    uint64_t getLocationVersion() const { return snapshot.version(); }
+
     bool isLocationAvailable() const { return locationInitialized; }
+    LocationMetrics getMetrics() const;
+
+    // Register for new location snapshots. The listener is called through
+    // the dispatcher with the current snapshot right away and again on
+    // every change; it never runs while nothing changes.
+    using LocationListener = std::function<void(const LocationInfo&)>;
+    uint64_t subscribe(LocationListener listener, TaskDispatcher dispatcher = dispatchInline);
+    void unsubscribe(uint64_t subscriptionId);
+
+    // The offline GeoIP database is always tried first; the ip-api.com
+    // lookup is only used as a fallback while this is enabled
+    void setNetworkLookupEnabled(bool enabled) { networkLookupEnabled = enabled; }
+
+    // Re-resolve the location after a network change. The geo lookup is
+    // skipped while the public IP stays the same, and the currency is kept
+    // while the country does.
+    void refreshLocation();
+
+    // Refresh automatically whenever adapters or addresses change. Uses the
+    // OS notifications unless another source is supplied.
+    bool startNetworkMonitoring(std::unique_ptr<NetworkChangeSource> source = nullptr);
+    void stopNetworkMonitoring();
     
 private:
-    LocationService() : locationInitialized(false) {}
-    ~LocationService() = default;
+    LocationService();
+    ~LocationService();
     LocationService(const LocationService&) = delete;
     LocationService& operator=(const LocationService&) = delete;
 
     // Helper functions
-    std::string getCurrentIP();
-    std::string getLocalIP();
-    bool getLocationDetails();
-    std::string makeHttpRequest(const wchar_t* host, const wchar_t* path);
-    bool validateIPFormat(const std::string& ip);
-    void parseCurrencyInfo(const std::string& countryCode);
+    void startDetection();
+    void runDetection(DetectionContext& context);
+    void runRefresh(DetectionContext& context);
+    IpAddress getCurrentIP(DetectionContext& context);
+    IpAddress getLocalIP();
+    bool getLocationDetails(LocationInfo& info, DetectionContext& context);
+    bool getLocalLocationDetails(LocationInfo& info);
+    static std::string geoDatabasePath();
+    HttpBody makeHttpRequest(const wchar_t* host, const wchar_t* path, DetectionContext& context);
+    bool parseCurrencyInfo(const CountryCode& countryCode, LocationInfo& info, DetectionContext& context);
+    void recordFirstLocation();
+    void recordTimings(const DetectionContext& context);
+    void publishLocation(LocationInfo info);
     
-    // String conversion helper
-    static std::string wstring_to_string(const std::wstring& wstr) {
-        if (wstr.empty()) return std::string();
-        int size_needed = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), nullptr, 0, nullptr, nullptr);
-        std::string strTo(size_needed, 0);
-        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), &strTo[0], size_needed, nullptr, nullptr);
-        return strTo;
-    }
-
     // Member variables
-    LocationInfo cachedInfo;
-    bool locationInitialized;
-    std::mutex locationMutex;
+    SnapshotCell<LocationInfo> snapshot;
+    std::atomic<bool> locationInitialized;
+    std::mutex detectionMutex;
+
+    // Background detection and the callers waiting on it
+    mutable std::mutex progressMutex;
+    std::condition_variable progressChanged;
+    std::thread detectionThread;
+    std::shared_ptr<DetectionContext> activeDetection;
+    std::shared_ptr<DetectionContext> activeRefresh;
+    DetectionTimings lastTimings;
+    SubscriberList<LocationInfo> subscribers;
+
+    // Persistent cache keyed by public IP
+    LocationCache cache;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<uint64_t> cacheHits;
+    std::atomic<uint64_t> cacheStaleHits;
+    std::atomic<uint64_t> cacheMisses;
+    std::atomic<int64_t> firstLocationMicros;
+
+    // Offline IP-to-location database
+    GeoIpDatabase geoDatabase;
+    std::atomic<bool> networkLookupEnabled;
 
-    // Currency data
-    static const std::map<std::string, std::pair<std::string, std::string>> currencyData;
+    // Debounced network change monitoring
+    mutable std::mutex refresherMutex;
+    std::unique_ptr<LocationRefresher> refresher;
+    std::atomic<uint64_t> refreshesSkipped;
 };
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "money.h"
+#include <limits>
+#include <stdexcept>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+    const uint64_t INT64_MAGNITUDE = uint64_t(std::numeric_limits<int64_t>::max()) + 1;
+
+    const CurrencyUnit& requireCurrency(std::string_view code) {
+        const CurrencyUnit* unit = findCurrencyUnit(code);
+        if (!unit) {
+            throw std::invalid_argument("Unknown currency: " + std::string(code));
+        }
+        return *unit;
+    }
+
+    uint64_t magnitude(int64_t value) {
+        return value < 0 ? uint64_t(0) - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    }
+
+    const uint64_t POWERS_OF_TEN[] = {1, 10, 100, 1000, 10000};
+}
+
+bool multiplyDivide(uint64_t a, uint64_t b, uint64_t divisor, uint64_t& quotient, uint64_t& remainder) {
+    if (divisor == 0) {
+        return false;
+    }
+#if defined(_MSC_VER) && !defined(__clang__)
+    uint64_t high;
+    uint64_t low = _umul128(a, b, &high);
+    if (high >= divisor) {
+        return false;
+    }
+    quotient = _udiv128(high, low, divisor, &remainder);
+    return true;
+#else
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    unsigned __int128 result = product / divisor;
+    if (result > std::numeric_limits<uint64_t>::max()) {
+        return false;
+    }
+    quotient = static_cast<uint64_t>(result);
+    remainder = static_cast<uint64_t>(product % divisor);
+    return true;
+#endif
+}
+
+bool roundQuotient(bool negative, uint64_t quotient, uint64_t remainder, uint64_t divisor,
+                   RoundingMode mode, int64_t& result) {
+    bool roundAway = false;
+    if (remainder != 0) {
+        // Compare remainder with divisor / 2 without overflowing
+        uint64_t rest = divisor - remainder;
+        switch (mode) {
+            case RoundingMode::HalfEven:
+                roundAway = remainder > rest || (remainder == rest && (quotient & 1));
+                break;
+            case RoundingMode::HalfUp:
+                roundAway = remainder >= rest;
+                break;
+            case RoundingMode::Down:
+                break;
+            case RoundingMode::Up:
+                roundAway = true;
+                break;
+            case RoundingMode::Floor:
+                roundAway = negative;
+                break;
+            case RoundingMode::Ceiling:
+                roundAway = !negative;
+                break;
+        }
+    }
+
+    if (roundAway) {
+        if (quotient == std::numeric_limits<uint64_t>::max()) {
+            return false;
+        }
+        ++quotient;
+    }
+    if (quotient > (negative ? INT64_MAGNITUDE : INT64_MAGNITUDE - 1)) {
+        return false;
+    }
+    result = negative ? static_cast<int64_t>(uint64_t(0) - quotient) : static_cast<int64_t>(quotient);
+    return true;
+}
+
+Money::Money()
+    : m_minor(0)
+    , m_currency(findCurrencyUnit("USD"))
+{
+}
+
+Money::Money(int64_t minorUnits, std::string_view currency)
+    : m_minor(minorUnits)
+    , m_currency(&requireCurrency(currency))
+{
+}
+
+bool Money::parse(std::string_view text, std::string_view currency, Money& out, RoundingMode mode) {
+    const CurrencyUnit* unit = findCurrencyUnit(currency);
+    if (!unit || text.empty()) {
+        return false;
+    }
+
+    bool negative = false;
+    size_t i = 0;
+    if (text[0] == '-' || text[0] == '+') {
+        negative = text[0] == '-';
+        ++i;
+    }
+
+    // value keeps the digits down to the currency's minor unit. Rounding
+    // only needs the first digit past it and whether any later one is
+    // non-zero, so any number of further digits rounds exactly.
+    uint64_t value = 0;
+    uint64_t roundingDigit = 0;
+    bool sticky = false;
+    size_t digits = 0;
+    size_t decimals = 0;
+    bool point = false;
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        uint64_t digit = static_cast<uint64_t>(c - '0');
+        ++digits;
+        if (point && ++decimals > unit->minorUnits) {
+            if (decimals == unit->minorUnits + size_t(1)) {
+                roundingDigit = digit;
+            } else {
+                sticky = sticky || digit != 0;
+            }
+            continue;
+        }
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    if (digits == 0) {
+        return false;
+    }
+
+    // Pad to the currency's decimals
+    for (size_t pad = decimals; pad < unit->minorUnits; ++pad) {
+        if (value > std::numeric_limits<uint64_t>::max() / 10) {
+            return false;
+        }
+        value *= 10;
+    }
+
+    // The dropped digits as twentieths: 2 * digit, plus one when a later
+    // digit is non-zero, compares with a half exactly as they do
+    int64_t minor;
+    if (!roundQuotient(negative, value, 2 * roundingDigit + (sticky ? 1 : 0), 20, mode, minor)) {
+        return false;
+    }
+    out = Money(minor, *unit);
+    return true;
+}
+
+void Money::requireSameCurrency(const Money& other) const {
+    if (m_currency != other.m_currency) {
+        throw std::invalid_argument("Currency mismatch: " + std::string(currencyCode()) + " and " +
+                                    std::string(other.currencyCode()));
+    }
+}
+
+Money Money::operator+(const Money& other) const {
+    requireSameCurrency(other);
+    if ((other.m_minor > 0 && m_minor > std::numeric_limits<int64_t>::max() - other.m_minor) ||
+        (other.m_minor < 0 && m_minor < std::numeric_limits<int64_t>::min() - other.m_minor)) {
+        throw std::overflow_error("Money addition overflow");
+    }
+    return Money(m_minor + other.m_minor, *m_currency);
+}
+
+Money Money::operator-(const Money& other) const {
+    requireSameCurrency(other);
+    if ((other.m_minor < 0 && m_minor > std::numeric_limits<int64_t>::max() + other.m_minor) ||
+        (other.m_minor > 0 && m_minor < std::numeric_limits<int64_t>::min() + other.m_minor)) {
+        throw std::overflow_error("Money subtraction overflow");
+    }
+    return Money(m_minor - other.m_minor, *m_currency);
+}
+
+Money Money::operator-() const {
+    if (m_minor == std::numeric_limits<int64_t>::min()) {
+        throw std::overflow_error("Money negation overflow");
+    }
+    return Money(-m_minor, *m_currency);
+}
+
+Money Money::operator*(int64_t factor) const {
+    return scaled(factor, 1, RoundingMode::Down);
+}
+
+Money Money::scaled(int64_t numerator, int64_t denominator, RoundingMode mode) const {
+    if (denominator <= 0) {
+        throw std::invalid_argument("Money scale denominator must be positive");
+    }
+    uint64_t quotient;
+    uint64_t remainder;
+    int64_t result;
+    bool negative = (m_minor < 0) != (numerator < 0);
+    if (!multiplyDivide(magnitude(m_minor), magnitude(numerator), static_cast<uint64_t>(denominator),
+                        quotient, remainder) ||
+        !roundQuotient(negative, quotient, remainder, static_cast<uint64_t>(denominator), mode, result)) {
+        throw std::overflow_error("Money scaling overflow");
+    }
+    return Money(result, *m_currency);
+}
+
+bool Money::operator<(const Money& other) const {
+    requireSameCurrency(other);
+    return m_minor < other.m_minor;
+}
+
+std::string Money::toDecimal() const {
+    uint64_t units = magnitude(m_minor);
+    uint64_t divisor = POWERS_OF_TEN[m_currency->minorUnits];
+
+    std::string text = m_minor < 0 ? "-" : "";
+    text += std::to_string(units / divisor);
+    if (m_currency->minorUnits > 0) {
+        std::string fraction = std::to_string(units % divisor);
+        text += '.';
+        text.append(m_currency->minorUnits - fraction.size(), '0');
+        text += fraction;
+    }
+    return text;
+}
+
+std::string Money::toString() const {
+    return toDecimal() + " " + std::string(currencyCode());
+}
+
+std::string Money::format() const {
+    std::string decimal = toDecimal();
+    if (m_minor < 0) {
+        return "-" + std::string(m_currency->symbol) + decimal.substr(1);
+    }
+    return std::string(m_currency->symbol) + decimal;
+}
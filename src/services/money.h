@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "currency_table.h"
+
+enum class RoundingMode : uint8_t {
+    HalfEven,   // Banker's rounding
+    HalfUp,     // Halves away from zero
+    Down,       // Toward zero
+    Up,         // Away from zero
+    Floor,
+    Ceiling
+};
+
+// Amount of money as a whole number of minor units (cents, pence, ...) of
+// an ISO 4217 currency. Arithmetic is exact: it throws std::overflow_error
+// instead of wrapping and std::invalid_argument when currencies differ.
+// Only division and conversion round, with an explicit mode.
+class Money {
+public:
+    // Zero US dollars
+    Money();
+
+    // Throws std::invalid_argument for an unknown currency code
+    Money(int64_t minorUnits, std::string_view currency);
+    Money(int64_t minorUnits, const CurrencyUnit& currency)
+        : m_minor(minorUnits), m_currency(&currency) {}
+
+    // Parses a plain decimal such as "9.99", "-12" or "0.125". Fractional
+    // digits past the currency's minor units, however many, are rounded
+    // with mode. False for malformed text, an unknown currency, or an
+    // amount that does not fit in int64_t minor units after rounding.
+    static bool parse(std::string_view text, std::string_view currency, Money& out,
+                      RoundingMode mode = RoundingMode::HalfEven);
+
+    int64_t minorUnits() const { return m_minor; }
+    const CurrencyUnit& currency() const { return *m_currency; }
+    std::string_view currencyCode() const { return m_currency->code; }
+    int decimals() const { return m_currency->minorUnits; }
+
+    bool isZero() const { return m_minor == 0; }
+    bool isNegative() const { return m_minor < 0; }
+
+    Money operator+(const Money& other) const;
+    Money operator-(const Money& other) const;
+    Money operator-() const;
+    Money operator*(int64_t factor) const;
+    Money& operator+=(const Money& other) { return *this = *this + other; }
+    Money& operator-=(const Money& other) { return *this = *this - other; }
+
+    // this * numerator / denominator, e.g. a tax rate or a share. Exact
+    // in 128 bits before rounding; denominator must be positive.
+    Money scaled(int64_t numerator, int64_t denominator, RoundingMode mode = RoundingMode::HalfEven) const;
+
+    // Comparisons throw std::invalid_argument when currencies differ,
+    // except == and != which are simply false and true
+    bool operator==(const Money& other) const {
+        return m_currency == other.m_currency && m_minor == other.m_minor;
+    }
+    bool operator!=(const Money& other) const { return !(*this == other); }
+    bool operator<(const Money& other) const;
+    bool operator<=(const Money& other) const { return !(other < *this); }
+    bool operator>(const Money& other) const { return other < *this; }
+    bool operator>=(const Money& other) const { return !(*this < other); }
+
+    // "9.99" with the currency's number of decimals
+    std::string toDecimal() const;
+    // "9.99 EUR"
+    std::string toString() const;
+    // "€9.99" using the currency's UTF-8 symbol
+    std::string format() const;
+
+private:
+    void requireSameCurrency(const Money& other) const;
+
+    int64_t m_minor;
+    const CurrencyUnit* m_currency;
+};
+
+// Unsigned (a * b) / divisor in 128-bit precision with the remainder.
+// Returns false if the quotient does not fit in 64 bits or divisor is 0.
+bool multiplyDivide(uint64_t a, uint64_t b, uint64_t divisor, uint64_t& quotient, uint64_t& remainder);
+
+// Rounds the exact value +/-(quotient + remainder / divisor) to an integer.
+// Returns false if the result does not fit in int64_t.
+bool roundQuotient(bool negative, uint64_t quotient, uint64_t remainder, uint64_t divisor,
+                   RoundingMode mode, int64_t& result);
@@ -0,0 +1,221 @@
+#include "network_change_source.h"
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <windows.h>
+#include <ws2ipdef.h>
+#include <iphlpapi.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    class WindowsNetworkChangeSource : public NetworkChangeSource {
+    public:
+        ~WindowsNetworkChangeSource() override { stop(); }
+
+        bool start(std::function<void()> onChange) override {
+            stop();
+            m_onChange = std::move(onChange);
+
+            if (NotifyIpInterfaceChange(AF_UNSPEC, &WindowsNetworkChangeSource::onInterfaceChange,
+                                        this, FALSE, &m_interfaceHandle) != NO_ERROR) {
+                m_interfaceHandle = nullptr;
+                return false;
+            }
+            if (NotifyUnicastIpAddressChange(AF_UNSPEC, &WindowsNetworkChangeSource::onAddressChange,
+                                             this, FALSE, &m_addressHandle) != NO_ERROR) {
+                m_addressHandle = nullptr;
+                stop();
+                return false;
+            }
+            return true;
+        }
+
+        void stop() override {
+            // CancelMibChangeNotify2 waits for callbacks in flight to finish
+            if (m_interfaceHandle) {
+                CancelMibChangeNotify2(m_interfaceHandle);
+                m_interfaceHandle = nullptr;
+            }
+            if (m_addressHandle) {
+                CancelMibChangeNotify2(m_addressHandle);
+                m_addressHandle = nullptr;
+            }
+        }
+
+    private:
+        static VOID NETIOAPI_API_ onInterfaceChange(PVOID context, PMIB_IPINTERFACE_ROW,
+                                                   MIB_NOTIFICATION_TYPE) {
+            static_cast<WindowsNetworkChangeSource*>(context)->m_onChange();
+        }
+
+        static VOID NETIOAPI_API_ onAddressChange(PVOID context, PMIB_UNICASTIPADDRESS_ROW,
+                                                 MIB_NOTIFICATION_TYPE) {
+            static_cast<WindowsNetworkChangeSource*>(context)->m_onChange();
+        }
+
+        std::function<void()> m_onChange;
+        HANDLE m_interfaceHandle = nullptr;
+        HANDLE m_addressHandle = nullptr;
+    };
+#elif defined(__linux__)
+    class NetlinkNetworkChangeSource : public NetworkChangeSource {
+    public:
+        ~NetlinkNetworkChangeSource() override { stop(); }
+
+        bool start(std::function<void()> onChange) override {
+            stop();
+            m_onChange = std::move(onChange);
+
+            m_socket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+            if (m_socket < 0) {
+                return false;
+            }
+
+            sockaddr_nl address = {};
+            address.nl_family = AF_NETLINK;
+            address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+            if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+                pipe(m_wakePipe) != 0) {
+                stop();
+                return false;
+            }
+
+            m_thread = std::thread(&NetlinkNetworkChangeSource::run, this);
+            return true;
+        }
+
+        void stop() override {
+            if (m_thread.joinable()) {
+                char byte = 0;
+                ssize_t written = write(m_wakePipe[1], &byte, 1);
+                (void)written;
+                m_thread.join();
+            }
+            closeDescriptor(m_socket);
+            closeDescriptor(m_wakePipe[0]);
+            closeDescriptor(m_wakePipe[1]);
+        }
+
+    private:
+        static const int MAX_FAILURES = 8;
+        static const int FIRST_BACKOFF_MS = 10;
+
+        static void closeDescriptor(int& fd) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        // Sleeps for ms unless stop() is called first; true when it was
+        bool pauseUnlessStopped(int ms) {
+            pollfd wake = {m_wakePipe[0], POLLIN, 0};
+            int ready = poll(&wake, 1, ms);
+            if (ready < 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                return false;
+            }
+            return ready > 0;
+        }
+
+        void run() {
+            alignas(nlmsghdr) char buffer[8192];
+            int failures = 0;
+            for (;;) {
+                // poll or recv failing for any reason but a signal will
+                // likely keep failing: pause, doubling the pause each time,
+                // and give up after MAX_FAILURES in a row
+                if (failures > 0 && (failures > MAX_FAILURES ||
+                                     pauseUnlessStopped(FIRST_BACKOFF_MS << (failures - 1)))) {
+                    return;
+                }
+
+                pollfd fds[2] = {{m_socket, POLLIN, 0}, {m_wakePipe[0], POLLIN, 0}};
+                if (poll(fds, 2, -1) < 0) {
+                    failures += errno != EINTR ? 1 : 0;
+                    continue;
+                }
+                if (fds[1].revents) {
+                    return;
+                }
+
+                ssize_t length = recv(m_socket, buffer, sizeof(buffer), 0);
+                if (length < 0 && errno == ENOBUFS) {
+                    // The kernel dropped messages when the socket buffer
+                    // overflowed; whatever they said, something changed
+                    failures = 0;
+                    m_onChange();
+                    continue;
+                }
+                if (length < 0) {
+                    failures += errno != EINTR && errno != EAGAIN ? 1 : 0;
+                    continue;
+                }
+                failures = 0;
+
+                // One notification per batch of relevant messages
+                bool changed = false;
+                int remaining = static_cast<int>(length);
+                for (const nlmsghdr* header = reinterpret_cast<const nlmsghdr*>(buffer);
+                     NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+                    switch (header->nlmsg_type) {
+                        case RTM_NEWADDR:
+                        case RTM_DELADDR:
+                        case RTM_NEWLINK:
+                        case RTM_DELLINK:
+                            changed = true;
+                            break;
+                    }
+                }
+                if (changed) {
+                    m_onChange();
+                }
+            }
+        }
+
+        std::function<void()> m_onChange;
+        std::thread m_thread;
+        int m_socket = -1;
+        int m_wakePipe[2] = {-1, -1};
+    };
+#endif
+}
+
+std::unique_ptr<NetworkChangeSource> createSystemNetworkChangeSource() {
+#ifdef _WIN32
+    return std::make_unique<WindowsNetworkChangeSource>();
+#elif defined(__linux__)
+    return std::make_unique<NetlinkNetworkChangeSource>();
+#else
+    return std::make_unique<ManualNetworkChangeSource>();
+#endif
+}
+
+bool ManualNetworkChangeSource::start(std::function<void()> onChange) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onChange = std::move(onChange);
+    return true;
+}
+
+void ManualNetworkChangeSource::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onChange = nullptr;
+}
+
+void ManualNetworkChangeSource::trigger() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_onChange) {
+        m_onChange();
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Reports that network adapters or their addresses changed. The callback
+// may run on any thread and may fire several times for a single change.
+class NetworkChangeSource {
+public:
+    virtual ~NetworkChangeSource() = default;
+
+    virtual bool start(std::function<void()> onChange) = 0;
+    virtual void stop() = 0;
+};
+
+// Adapter/address notifications from the OS: the IP Helper change
+// notifications on Windows, an rtnetlink socket on Linux
+std::unique_ptr<NetworkChangeSource> createSystemNetworkChangeSource();
+
+// Source driven by hand, for tests and for callers with their own signal
+class ManualNetworkChangeSource : public NetworkChangeSource {
+public:
+    bool start(std::function<void()> onChange) override;
+    void stop() override;
+
+    // Report a change as if it came from the OS
+    void trigger();
+
+private:
+    std::mutex m_mutex;
+    std::function<void()> m_onChange;
+};
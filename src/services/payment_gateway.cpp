@@ -0,0 +1,53 @@
+#include "payment_gateway.h"
+#include <cmath>
+#include <thread>
+
+SimulatedPaymentGateway::SimulatedPaymentGateway(const SimulatedGatewayConfig& config)
+    : m_config(config)
+    , m_random(config.seed != 0 ? config.seed : std::random_device()())
+{
+}
+
+ChargeResponse SimulatedPaymentGateway::charge(const ChargeRequest& request,
+                                               std::chrono::steady_clock::time_point deadline) {
+    ++m_charges;
+
+    std::chrono::microseconds latency;
+    double outcome;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::normal_distribution<double> spread(0.0, m_config.latencySigma);
+        double scale = m_config.latencySigma > 0 ? std::exp(spread(m_random)) : 1.0;
+        latency = std::chrono::microseconds(static_cast<int64_t>(m_config.medianLatency.count() * scale));
+        outcome = std::uniform_real_distribution<double>(0.0, 1.0)(m_random);
+    }
+
+    auto answeredAt = std::chrono::steady_clock::now() + latency;
+    if (answeredAt > deadline) {
+        std::this_thread::sleep_until(deadline);
+        return {ChargeStatus::TimedOut, "", "Payment processor did not respond in time"};
+    }
+    std::this_thread::sleep_until(answeredAt);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!request.idempotencyKey.empty()) {
+        auto previous = m_approvedKeys.find(request.idempotencyKey);
+        if (previous != m_approvedKeys.end()) {
+            return previous->second;
+        }
+    }
+
+    if (outcome < m_config.failureRate) {
+        return {ChargeStatus::Failed, "", "Payment processor unavailable"};
+    }
+    if (outcome < m_config.failureRate + m_config.declineRate) {
+        return {ChargeStatus::Declined, "", "Card declined"};
+    }
+
+    ChargeResponse approved{ChargeStatus::Approved, request.transactionId, ""};
+    if (!request.idempotencyKey.empty()) {
+        m_approvedKeys.emplace(request.idempotencyKey, approved);
+    }
+    ++m_approved;
+    return approved;
+}
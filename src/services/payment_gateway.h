@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "money.h"
+
+struct ChargeRequest {
+    std::string idempotencyKey;     // Passed through so the processor can dedupe retries
+    std::string transactionId;
+    std::string email;
+    Money amount;
+};
+
+enum class ChargeStatus {
+    Approved,
+    Declined,   // Final; retrying will not help
+    Failed,     // Transient processor or network error
+    TimedOut    // No answer before the deadline; the charge may still happen
+};
+
+struct ChargeResponse {
+    ChargeStatus status;
+    std::string transactionId;      // Of the charge that was made, when Approved
+    std::string message;
+};
+
+// Payment processor. charge() blocks, must return by the deadline and may
+// be called from several threads at once.
+class PaymentGateway {
+public:
+    virtual ~PaymentGateway() = default;
+    virtual ChargeResponse charge(const ChargeRequest& request,
+                                  std::chrono::steady_clock::time_point deadline) = 0;
+};
+
+struct SimulatedGatewayConfig {
+    // Latency is log-normal around the median; sigma 0 makes it constant
+    std::chrono::microseconds medianLatency{50000};
+    double latencySigma = 0.5;
+    double declineRate = 0.0;
+    double failureRate = 0.0;
+    uint64_t seed = 0;              // 0 picks a random seed
+};
+
+// Local stand-in for a processor, for offline runs and load tests. Like a
+// real processor it remembers approved idempotency keys, so a retried
+// request is answered from the first approval instead of charging again.
+class SimulatedPaymentGateway : public PaymentGateway {
+public:
+    explicit SimulatedPaymentGateway(const SimulatedGatewayConfig& config = {});
+
+    ChargeResponse charge(const ChargeRequest& request,
+                          std::chrono::steady_clock::time_point deadline) override;
+
+    uint64_t chargeCount() const { return m_charges; }
+    uint64_t approvedCount() const { return m_approved; }
+
+private:
+    SimulatedGatewayConfig m_config;
+
+    std::mutex m_mutex;
+    std::mt19937_64 m_random;
+    std::unordered_map<std::string, ChargeResponse> m_approvedKeys;
+
+    std::atomic<uint64_t> m_charges{0};
+    std::atomic<uint64_t> m_approved{0};
+};
@@ -0,0 +1,233 @@
+#include "payment_pipeline.h"
+#include <algorithm>
+
+namespace {
+    const uint64_t PRUNE_INTERVAL = 1024;
+
+    PaymentResult failure(const std::string& message, bool retryable) {
+        return PaymentResult{false, "", message, retryable};
+    }
+
+    std::shared_future<PaymentResult> ready(const PaymentResult& result) {
+        std::promise<PaymentResult> promise;
+        promise.set_value(result);
+        return promise.get_future().share();
+    }
+}
+
+PaymentPipeline::PaymentPipeline(std::shared_ptr<PaymentGateway> gateway, uint32_t node,
+                                 const PaymentPipelineConfig& config, Fulfil fulfil)
+    : m_gateway(std::move(gateway))
+    , m_config(config)
+    , m_fulfil(std::move(fulfil))
+    , m_transactionIds(node)
+{
+    size_t workers = m_config.maxConcurrency > 0 ? m_config.maxConcurrency : 1;
+    for (size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&PaymentPipeline::run, this);
+    }
+    m_expirer = std::thread(&PaymentPipeline::expire, this);
+}
+
+PaymentPipeline::~PaymentPipeline() {
+    shutdown();
+}
+
+std::shared_future<PaymentResult> PaymentPipeline::submit(PaymentRequest request) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.submitted;
+
+    if (m_stopping) {
+        ++m_stats.rejected;
+        return ready(failure("Payment service is shutting down", false));
+    }
+
+    if (!request.idempotencyKey.empty()) {
+        auto existing = m_idempotency.find(request.idempotencyKey);
+        if (existing != m_idempotency.end()) {
+            if (existing->second.email != request.email || existing->second.amount != request.amount) {
+                ++m_stats.rejected;
+                return ready(failure("Idempotency key was already used for a different payment", false));
+            }
+            ++m_stats.deduplicated;
+            return existing->second.result;
+        }
+    }
+
+    if (m_queue.size() >= m_config.maxQueued) {
+        ++m_stats.rejected;
+        return ready(failure("Too many payments in progress", true));
+    }
+
+    auto job = std::make_unique<Job>();
+    job->id = ++m_nextJobId;
+    job->deadline = now + request.timeout;
+    job->request = std::move(request);
+    std::shared_future<PaymentResult> result = job->promise.get_future().share();
+
+    if (!job->request.idempotencyKey.empty()) {
+        if (++m_submitsSincePrune >= PRUNE_INTERVAL) {
+            pruneIdempotency(now);
+        }
+        m_idempotency.emplace(job->request.idempotencyKey,
+                              IdempotencyEntry{job->id, job->request.email, job->request.amount, result, now});
+    }
+
+    if (job->deadline < m_timerDeadline) {
+        m_deadlineChanged.notify_one();
+    }
+    m_queue.push_back(std::move(job));
+    m_wake.notify_one();
+    return result;
+}
+
+void PaymentPipeline::shutdown() {
+    std::deque<std::unique_ptr<Job>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        abandoned.swap(m_queue);
+    }
+    m_wake.notify_all();
+    m_deadlineChanged.notify_all();
+
+    for (auto& job : abandoned) {
+        finish(*job, failure("Payment service is shutting down", true));
+    }
+    for (std::thread& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    if (m_expirer.joinable()) {
+        m_expirer.join();
+    }
+}
+
+PaymentPipelineStats PaymentPipeline::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void PaymentPipeline::run() {
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        finish(*job, process(*job));
+    }
+}
+
+void PaymentPipeline::expire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        // The queue is bounded by maxQueued, so a scan is cheap
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<Job>> expired;
+        m_timerDeadline = std::chrono::steady_clock::time_point::max();
+        for (auto job = m_queue.begin(); job != m_queue.end();) {
+            if ((*job)->deadline <= now) {
+                expired.push_back(std::move(*job));
+                job = m_queue.erase(job);
+            } else {
+                m_timerDeadline = std::min(m_timerDeadline, (*job)->deadline);
+                ++job;
+            }
+        }
+
+        if (!expired.empty()) {
+            m_stats.expired += expired.size();
+            lock.unlock();
+            for (auto& job : expired) {
+                finish(*job, failure("Payment timed out before it was sent", true));
+            }
+            lock.lock();
+            continue;
+        }
+        if (m_timerDeadline == std::chrono::steady_clock::time_point::max()) {
+            m_deadlineChanged.wait(lock);
+        } else {
+            m_deadlineChanged.wait_until(lock, m_timerDeadline);
+        }
+    }
+}
+
+PaymentResult PaymentPipeline::process(Job& job) {
+    if (std::chrono::steady_clock::now() >= job.deadline) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.expired;
+        return failure("Payment timed out before it was sent", true);
+    }
+
+    ChargeRequest charge{job.request.idempotencyKey,
+                         TransactionIdGenerator::encode(m_transactionIds.next()),
+                         job.request.email,
+                         job.request.amount};
+    ChargeResponse response;
+    try {
+        response = m_gateway->charge(charge, job.deadline);
+    }
+    catch (const std::exception& e) {
+        response = ChargeResponse{ChargeStatus::Failed, "", e.what()};
+    }
+
+    PaymentResult result = failure(response.message, false);
+    switch (response.status) {
+    case ChargeStatus::Approved:
+        result = PaymentResult{true, response.transactionId, "", false};
+        if (m_fulfil && !m_fulfil(job.request, response.transactionId, result.errorMessage)) {
+            // The charge stands; a retry is answered by the gateway's dedupe
+            result.success = false;
+            result.retryable = true;
+        }
+        break;
+    case ChargeStatus::Declined:
+        break;
+    case ChargeStatus::Failed:
+    case ChargeStatus::TimedOut:
+        result.retryable = true;
+        break;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (result.success) {
+        ++m_stats.approved;
+    } else if (response.status == ChargeStatus::Declined) {
+        ++m_stats.declined;
+    } else {
+        ++m_stats.failed;
+    }
+    return result;
+}
+
+void PaymentPipeline::finish(Job& job, const PaymentResult& result) {
+    if (result.retryable && !job.request.idempotencyKey.empty()) {
+        // Forget the attempt so resubmitting the key tries again
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entry = m_idempotency.find(job.request.idempotencyKey);
+        if (entry != m_idempotency.end() && entry->second.jobId == job.id) {
+            m_idempotency.erase(entry);
+        }
+    }
+    job.promise.set_value(result);
+}
+
+void PaymentPipeline::pruneIdempotency(std::chrono::steady_clock::time_point now) {
+    m_submitsSincePrune = 0;
+    for (auto entry = m_idempotency.begin(); entry != m_idempotency.end();) {
+        bool done = entry->second.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (done && now - entry->second.created > m_config.idempotencyTtl) {
+            entry = m_idempotency.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+}
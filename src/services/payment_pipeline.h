@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "payment_gateway.h"
+#include "transaction_id.h"
+
+struct PaymentResult {
+    bool success;
+    std::string transactionId;
+    std::string errorMessage;
+    bool retryable;     // Resubmitting with the same idempotency key may succeed
+};
+
+struct PaymentRequest {
+    // Chosen by the client once per purchase and reused on every retry.
+    // Empty disables deduplication.
+    std::string idempotencyKey;
+    std::string email;
+    Money amount;
+    std::chrono::milliseconds timeout{30000};
+};
+
+struct PaymentPipelineConfig {
+    size_t maxConcurrency = 4;      // Charges in flight at the gateway
+    size_t maxQueued = 256;         // Further submissions fail fast
+    std::chrono::hours idempotencyTtl{24};
+};
+
+struct PaymentPipelineStats {
+    uint64_t submitted;
+    uint64_t deduplicated;  // Answered from an earlier submission with the same key
+    uint64_t rejected;      // Queue full, key reused for another request, or shutting down
+    uint64_t expired;       // Deadline passed while queued
+    uint64_t approved;
+    uint64_t declined;
+    uint64_t failed;        // Gateway failure, gateway timeout or fulfilment failure
+};
+
+// Runs payments asynchronously against a PaymentGateway.
+//
+// Submissions go to a bounded queue drained by maxConcurrency workers, so
+// the gateway never sees more than that many charges at once. Each request
+// carries a deadline; a timer thread fails one still queued when it
+// expires, without it reaching the gateway.
+//
+// Submissions are deduplicated by idempotency key: a repeat of a pending or
+// finished request gets the same future, so a double click or retry never
+// charges twice. Approved and declined results are kept for idempotencyTtl.
+// Retryable failures are forgotten so the same key can be tried again; the
+// key is passed to the gateway, which dedupes a charge that did go through.
+class PaymentPipeline {
+public:
+    // Called on a worker for each approved charge before its result is
+    // published. Returning false fails the payment with error.
+    using Fulfil = std::function<bool(const PaymentRequest& request, const std::string& transactionId,
+                                      std::string& error)>;
+
+    PaymentPipeline(std::shared_ptr<PaymentGateway> gateway, uint32_t node,
+                    const PaymentPipelineConfig& config = {}, Fulfil fulfil = nullptr);
+    ~PaymentPipeline();
+    PaymentPipeline(const PaymentPipeline&) = delete;
+    PaymentPipeline& operator=(const PaymentPipeline&) = delete;
+
+    // Never blocks. The result is ready by the request's deadline, unless
+    // the charge was already sent: then it is ready once the gateway has
+    // answered, which it must by the deadline, and fulfilment has run.
+    std::shared_future<PaymentResult> submit(PaymentRequest request);
+
+    // Fails everything still queued and waits for charges in flight
+    void shutdown();
+
+    PaymentPipelineStats stats() const;
+
+private:
+    struct Job {
+        uint64_t id;
+        PaymentRequest request;
+        std::chrono::steady_clock::time_point deadline;
+        std::promise<PaymentResult> promise;
+    };
+
+    struct IdempotencyEntry {
+        uint64_t jobId;
+        std::string email;
+        Money amount;
+        std::shared_future<PaymentResult> result;
+        std::chrono::steady_clock::time_point created;
+    };
+
+    void run();
+    void expire();
+    PaymentResult process(Job& job);
+    void finish(Job& job, const PaymentResult& result);
+    void pruneIdempotency(std::chrono::steady_clock::time_point now);
+
+    std::shared_ptr<PaymentGateway> m_gateway;
+    PaymentPipelineConfig m_config;
+    Fulfil m_fulfil;
+    TransactionIdGenerator m_transactionIds;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_deadlineChanged;  // Expirer: an earlier deadline was queued, or stopping
+    std::deque<std::unique_ptr<Job>> m_queue;
+    std::unordered_map<std::string, IdempotencyEntry> m_idempotency;
+    std::vector<std::thread> m_workers;
+    std::thread m_expirer;                  // Fails queued jobs at their deadline
+    std::chrono::steady_clock::time_point m_timerDeadline = std::chrono::steady_clock::time_point::max();
+    uint64_t m_nextJobId = 0;
+    uint64_t m_submitsSincePrune = 0;
+    bool m_stopping = false;
+
+    PaymentPipelineStats m_stats = {};
+};
@@ -1,64 +1,122 @@
 #include "payment_service.h"
 #include <ctime>
-#include <map>
+#include "email_service.h"
 
-namespace {
-    // In-memory storage for demo purposes
-    struct SubscriptionData {
-        std::string transactionId;
-        time_t expiryDate;
-        bool active;
-    };
-    
-    std::map<std::string, SubscriptionData> subscriptions;
+PaymentService::PaymentService(std::shared_ptr<PaymentGateway> gateway, const std::string& dataDirectory)
+    : log(dataDirectory)
+    , payments(std::move(gateway), TransactionIdGenerator::randomNode(),
+               PaymentPipelineConfig{},
+               [this](const PaymentRequest& request, const std::string& transactionId, std::string& error) {
+                   return fulfil(request, transactionId, error);
+               })
+    , renewals(subscriptions,
+               [](const std::vector<SubscriptionEntry>& expiring) {
+                   EmailService::getInstance().sendRenewalReminders(expiring);
+               },
+               [this](const std::vector<SubscriptionEntry>& due) { renewSubscriptions(due); })
+{
+    // A damaged snapshot still leaves whatever could be read plus the log
+    log.recover([this](const SubscriptionEntry& entry) {
+        subscriptions.put(entry.email, entry.transactionId, entry.expiry);
+    });
+    log.start();
+
+    for (const SubscriptionEntry& entry : subscriptions.entries()) {
+        renewals.track(entry.email, entry.expiry);
+    }
+    renewals.start();
+}
+
+PaymentService::~PaymentService() {
+    // Let charges in flight record their subscriptions before the log
+    // closes; renewals submitted after this fail straight away
+    payments.shutdown();
+    renewals.stop();
+    log.stop();
 }
 
 PaymentService& PaymentService::getInstance() {
-    static PaymentService instance;
+    static PaymentService instance(std::make_shared<SimulatedPaymentGateway>(), SubscriptionLog::defaultDirectory());
     return instance;
 }
 
-PaymentResult PaymentService::processPayment(const std::string& email, double amount) {
-    PaymentResult result;
-    
+std::shared_future<PaymentResult> PaymentService::submitPayment(PaymentRequest request) {
+    return payments.submit(std::move(request));
+}
+
+PaymentResult PaymentService::processPayment(const std::string& email, const Money& amount) {
+    PaymentRequest request;
+    request.email = email;
+    request.amount = amount;
+    return submitPayment(std::move(request)).get();
+}
+
+bool PaymentService::fulfil(const PaymentRequest& request, const std::string& transactionId, std::string& error) {
     try {
-        // TODO: Integrate with actual payment processor
-        // This is a placeholder implementation
-        
-        // Simulate payment processing
-        result.success = true;
-        result.transactionId = "TXN" + std::to_string(std::time(nullptr));
-        
-        // If payment successful, update subscription
-        if (result.success) {
-            SubscriptionData data;
-            data.transactionId = result.transactionId;
-            data.expiryDate = std::time(nullptr) + (30 * 24 * 60 * 60); // 30 days
-            data.active = true;
-            
-            subscriptions[email] = data;
+        std::lock_guard<std::mutex> serial(
+            fulfilLocks[SubscriptionStore::hashEmail(request.email) % FULFIL_LOCK_COUNT]);
+
+        // A renewal or early repurchase extends the current period. A retry
+        // of a charge already recorded is answered with the same
+        // transaction ID by the gateway and changes nothing.
+        SubscriptionEntry applied;
+        SubscriptionEntry previous;
+        switch (subscriptions.extend(request.email, transactionId, SUBSCRIPTION_PERIOD, std::time(nullptr),
+                                     applied, previous)) {
+        case SubscriptionStore::ExtendResult::Refused:
+            error = "Subscription key is held by another address";
+            return false;
+        case SubscriptionStore::ExtendResult::AlreadyApplied:
+            return true;
+        case SubscriptionStore::ExtendResult::Extended:
+            break;
         }
+
+        // Taken back if the append fails, as the payment is then retried.
+        // Compaction snapshots the log, not the store, so the change never
+        // outlives a failed append.
+        if (!log.append(applied)) {
+            subscriptions.revert(applied, previous);
+            error = "Failed to save subscription";
+            return false;
+        }
+        renewals.track(applied.email, applied.expiry);
+        return true;
     }
     catch (const std::exception& e) {
-        result.success = false;
-        result.errorMessage = e.what();
+        error = e.what();
+        return false;
     }
-    
-    return result;
 }
 
-bool PaymentService::hasActiveSubscription(const std::string& email) {
-    auto it = subscriptions.find(email);
-    if (it != subscriptions.end()) {
-        return it->second.active && (std::time(nullptr) < it->second.expiryDate);
+void PaymentService::renewSubscriptions(const std::vector<SubscriptionEntry>& due) {
+    // Submit the whole batch so the pipeline can charge it concurrently.
+    // The key names the period being renewed, so a retry never charges it
+    // twice.
+    std::vector<std::shared_future<PaymentResult>> results;
+    results.reserve(due.size());
+    for (const SubscriptionEntry& subscription : due) {
+        PaymentRequest request;
+        request.idempotencyKey = "renew:" + subscription.email + ":" + std::to_string(subscription.expiry);
+        request.email = subscription.email;
+        request.amount = subscriptionPrice();
+        results.push_back(submitPayment(std::move(request)));
+    }
+    // Successful renewals reschedule themselves through fulfil(); failed
+    // ones are left to expire
+    for (const auto& result : results) {
+        result.wait();
     }
-    return false;
+}
+
+bool PaymentService::hasActiveSubscription(const std::string& email) {
+    return subscriptions.isActive(email, std::time(nullptr));
+}
+
+void PaymentService::hasActiveSubscriptions(const std::string_view* emails, size_t count, uint64_t* active) {
+    subscriptions.activeMask(emails, count, std::time(nullptr), active);
 }
 
 time_t PaymentService::getSubscriptionExpiry(const std::string& email) {
-    auto it = subscriptions.find(email);
-    if (it != subscriptions.end()) {
-        return it->second.expiryDate;
-    }
-    return 0;
+    return subscriptions.expiry(email);
 }
\ No newline at end of file
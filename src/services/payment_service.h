@@ -1,28 +1,62 @@
 #pragma once
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
-
-struct PaymentResult {
-    bool success;
-    std::string transactionId;
-    std::string errorMessage;
-};
+#include <string_view>
+#include "payment_gateway.h"
+#include "payment_pipeline.h"
+#include "subscription_log.h"
+#include "subscription_scheduler.h"
+#include "subscription_store.h"
 
 class PaymentService {
 public:
+    // The application's instance, which charges through the simulated
+    // gateway and keeps its log in the per-user data folder
     static PaymentService& getInstance();
+
+    // Charges go to gateway; the subscription log lives in dataDirectory
+    PaymentService(std::shared_ptr<PaymentGateway> gateway, const std::string& dataDirectory);
+    ~PaymentService();
+    PaymentService(const PaymentService&) = delete;
+    PaymentService& operator=(const PaymentService&) = delete;
     
-    // Process payment and return result
-    PaymentResult processPayment(const std::string& email, double amount);
+    // Start a payment. Retries of one purchase must reuse its idempotency
+    // key; see PaymentPipeline.
+    std::shared_future<PaymentResult> submitPayment(PaymentRequest request);
+
+    // Process payment and wait for the result, without deduplication
+    PaymentResult processPayment(const std::string& email, const Money& amount);
+
+    // Monthly subscription price, charged in US dollars
+    static Money subscriptionPrice() { return Money(999, "USD"); }
+    static const time_t SUBSCRIPTION_PERIOD = 30 * 24 * 60 * 60;
     
-    // Check if user has active subscription
+    // Check if user has active subscription. Lock-free, safe to call from
+    // any thread on every gated feature access.
     bool hasActiveSubscription(const std::string& email);
+
+    // hasActiveSubscription for many users against one clock reading. Bit i
+    // of active, which must hold (count + 63) / 64 words, is set when
+    // emails[i] has an active subscription.
+    void hasActiveSubscriptions(const std::string_view* emails, size_t count, uint64_t* active);
     
     // Get subscription expiry date
     time_t getSubscriptionExpiry(const std::string& email);
 
 private:
-    PaymentService() = default;
-    ~PaymentService() = default;
-    PaymentService(const PaymentService&) = delete;
-    PaymentService& operator=(const PaymentService&) = delete;
+    bool fulfil(const PaymentRequest& request, const std::string& transactionId, std::string& error);
+    void renewSubscriptions(const std::vector<SubscriptionEntry>& due);
+
+    static const size_t FULFIL_LOCK_COUNT = 64;
+
+    SubscriptionStore subscriptions;
+    SubscriptionLog log;    // Every put is appended here before a payment is reported
+    PaymentPipeline payments;
+    SubscriptionScheduler renewals;
+
+    // Fulfilments of one address run one at a time, so undoing one whose
+    // log append failed never takes back a later extension built on it
+    std::mutex fulfilLocks[FULFIL_LOCK_COUNT];
 };
\ No newline at end of file
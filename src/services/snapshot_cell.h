@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// RCU-style holder for an immutable value.
+//
+// Readers take a single acquire load and never block or retry. Writers
+// build a new snapshot and swap it in under a writer-only mutex. Replaced
+// snapshots are retained until the cell is destroyed, so a reference
+// obtained from read() stays valid for the cell's lifetime. This suits
+// values that change rarely (location, configuration) and are read often.
+template <typename T>
+class SnapshotCell {
+public:
+    explicit SnapshotCell(T initial = T())
+        : m_current(nullptr)
+        , m_version(0)
+    {
+        publish(std::move(initial));
+    }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    // Wait-free read of the current snapshot
+    const T& read() const {
+        return m_current.load(std::memory_order_acquire)->value;
+    }
+
+    // Same, also giving the version the snapshot was published as
+    const T& read(uint64_t& version) const {
+        const Node* node = m_current.load(std::memory_order_acquire);
+        version = node->version;
+        return node->value;
+    }
+
+    // Monotonic counter bumped after every publish; cheap to poll
+    uint64_t version() const {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+    // Swap in a new snapshot and return its version
+    uint64_t publish(T value) {
+        std::unique_ptr<Node> snapshot(new Node{std::move(value), 0});
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        uint64_t version = m_version.load(std::memory_order_relaxed) + 1;
+        snapshot->version = version;
+        m_current.store(snapshot.get(), std::memory_order_release);
+        m_retained.push_back(std::move(snapshot));
+        m_version.store(version, std::memory_order_release);
+        return version;
+    }
+
+private:
+    struct Node {
+        T value;
+        uint64_t version;
+    };
+
+    std::atomic<const Node*> m_current;
+    std::atomic<uint64_t> m_version;
+    std::mutex m_writeMutex;
+    std::vector<std::unique_ptr<const Node>> m_retained;
+};
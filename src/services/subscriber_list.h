@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs a task on whichever thread the dispatcher chooses, e.g. by posting
+// it to a window's message queue
+using TaskDispatcher = std::function<void(std::function<void()>)>;
+
+// Dispatcher that runs the task immediately on the notifying thread
+inline void dispatchInline(std::function<void()> task) {
+    task();
+}
+
+// Registry of listeners that are told about new values of T.
+//
+// Each listener is paired with a dispatcher that marshals the call to the
+// listener's thread. Nothing runs while no value is published. A listener
+// removed before a queued delivery runs is not called; deliveries made
+// inline on another thread may still be in progress when remove() returns.
+// The value passed to notify() must outlive every queued delivery.
+//
+// Values carry the version they were published as. A listener only ever
+// moves forward: a delivery older than one it has already been given is
+// dropped, so a subscriber racing a publish can't end on a stale value.
+template <typename T>
+class SubscriberList {
+public:
+    using Listener = std::function<void(const T&)>;
+
+    uint64_t add(Listener listener, TaskDispatcher dispatcher) {
+        auto subscription = std::make_shared<Subscription>();
+        subscription->listener = std::move(listener);
+        subscription->dispatcher = dispatcher ? std::move(dispatcher) : TaskDispatcher(dispatchInline);
+        subscription->active = true;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t id = ++m_nextId;
+        m_subscriptions.emplace(id, std::move(subscription));
+        return id;
+    }
+
+    bool remove(uint64_t id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_subscriptions.find(id);
+        if (it == m_subscriptions.end()) {
+            return false;
+        }
+        it->second->active.store(false, std::memory_order_release);
+        m_subscriptions.erase(it);
+        return true;
+    }
+
+    // Deliver value to every listener
+    void notify(const T& value, uint64_t version) const {
+        std::vector<std::shared_ptr<Subscription>> targets;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            targets.reserve(m_subscriptions.size());
+            for (const auto& entry : m_subscriptions) {
+                targets.push_back(entry.second);
+            }
+        }
+        for (const auto& subscription : targets) {
+            deliver(subscription, value, version);
+        }
+    }
+
+    // Deliver value to a single listener, e.g. the current value on subscribe
+    void notifyOne(uint64_t id, const T& value, uint64_t version) const {
+        std::shared_ptr<Subscription> target;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_subscriptions.find(id);
+            if (it == m_subscriptions.end()) {
+                return;
+            }
+            target = it->second;
+        }
+        deliver(target, value, version);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_subscriptions.size();
+    }
+
+private:
+    struct Subscription {
+        Listener listener;
+        TaskDispatcher dispatcher;
+        std::atomic<bool> active;
+        std::mutex deliveryMutex;       // Serializes calls to the listener
+        uint64_t deliveredVersion = 0;  // Guarded by deliveryMutex
+    };
+
+    static void deliver(const std::shared_ptr<Subscription>& subscription, const T& value, uint64_t version) {
+        const T* current = &value;
+        subscription->dispatcher([subscription, current, version]() {
+            std::lock_guard<std::mutex> lock(subscription->deliveryMutex);
+            if (version <= subscription->deliveredVersion) {
+                return;
+            }
+            if (subscription->active.load(std::memory_order_acquire)) {
+                subscription->deliveredVersion = version;
+                subscription->listener(*current);
+            }
+        });
+    }
+
+    mutable std::mutex m_mutex;
+    std::map<uint64_t, std::shared_ptr<Subscription>> m_subscriptions;
+    uint64_t m_nextId = 0;
+};
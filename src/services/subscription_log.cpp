@@ -0,0 +1,423 @@
+#include "subscription_log.h"
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint8_t RECORD_PUT = 1;
+    const size_t FRAME_HEADER_SIZE = 8;
+    const uint32_t MAX_PAYLOAD_SIZE = 1 << 20;
+    const char SNAPSHOT_MAGIC[8] = {'M', 'A', 'S', 'N', 'A', 'P', '0', '1'};
+
+    // CRC-32C (Castagnoli), reflected, table driven
+    constexpr std::array<uint32_t, 256> makeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+    uint32_t crc32c(const char* data, size_t size) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i) {
+            crc = CRC_TABLE[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    void putInt(std::string& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    uint64_t getInt(const char* in, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value |= uint64_t(static_cast<unsigned char>(in[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    // Payload: u8 type | i64 expiry | u16 length + email | u16 length + transaction id
+    void appendRecord(std::string& out, const SubscriptionEntry& entry) {
+        size_t frame = out.size();
+        out.append(FRAME_HEADER_SIZE, '\0');
+
+        out.push_back(static_cast<char>(RECORD_PUT));
+        putInt(out, static_cast<uint64_t>(static_cast<int64_t>(entry.expiry)), 8);
+        putInt(out, entry.email.size(), 2);
+        out += entry.email;
+        putInt(out, entry.transactionId.size(), 2);
+        out += entry.transactionId;
+
+        size_t payloadSize = out.size() - frame - FRAME_HEADER_SIZE;
+        uint32_t crc = crc32c(out.data() + frame + FRAME_HEADER_SIZE, payloadSize);
+        for (int i = 0; i < 4; ++i) {
+            out[frame + i] = static_cast<char>((payloadSize >> (8 * i)) & 0xFF);
+            out[frame + 4 + i] = static_cast<char>((crc >> (8 * i)) & 0xFF);
+        }
+    }
+
+    bool decodePayload(const char* data, size_t size, SubscriptionEntry& entry) {
+        if (size < 13 || static_cast<uint8_t>(data[0]) != RECORD_PUT) {
+            return false;
+        }
+        entry.expiry = static_cast<time_t>(static_cast<int64_t>(getInt(data + 1, 8)));
+        size_t offset = 9;
+        size_t emailSize = getInt(data + offset, 2);
+        offset += 2;
+        if (offset + emailSize + 2 > size) {
+            return false;
+        }
+        entry.email.assign(data + offset, emailSize);
+        offset += emailSize;
+        size_t transactionSize = getInt(data + offset, 2);
+        offset += 2;
+        if (offset + transactionSize != size) {
+            return false;
+        }
+        entry.transactionId.assign(data + offset, transactionSize);
+        return true;
+    }
+
+    // Applies each intact record in order; returns the length of the
+    // intact prefix
+    size_t replayRecords(const std::string& data, size_t offset,
+                         const std::function<void(const SubscriptionEntry&)>& apply, uint64_t& count) {
+        SubscriptionEntry entry;
+        while (data.size() - offset >= FRAME_HEADER_SIZE) {
+            uint32_t payloadSize = static_cast<uint32_t>(getInt(data.data() + offset, 4));
+            uint32_t crc = static_cast<uint32_t>(getInt(data.data() + offset + 4, 4));
+            if (payloadSize > MAX_PAYLOAD_SIZE || data.size() - offset - FRAME_HEADER_SIZE < payloadSize) {
+                break;
+            }
+            const char* payload = data.data() + offset + FRAME_HEADER_SIZE;
+            if (crc32c(payload, payloadSize) != crc || !decodePayload(payload, payloadSize, entry)) {
+                break;
+            }
+            apply(entry);
+            ++count;
+            offset += FRAME_HEADER_SIZE + payloadSize;
+        }
+        return offset;
+    }
+
+    bool readFile(const std::string& path, std::string& out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+#ifdef _WIN32
+    int openFile(const std::string& path, bool append) {
+        int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC);
+        int fd = -1;
+        _sopen_s(&fd, path.c_str(), flags, _SH_DENYWR, _S_IREAD | _S_IWRITE);
+        return fd;
+    }
+
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            unsigned int chunk = static_cast<unsigned int>(size > (1u << 30) ? (1u << 30) : size);
+            int written = _write(fd, data, chunk);
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool syncFile(int fd) { return _commit(fd) == 0; }
+    bool truncateFile(int fd) { return _chsize_s(fd, 0) == 0; }
+    bool truncateFileAt(const std::string& path, int64_t size) {
+        int fd = -1;
+        if (_sopen_s(&fd, path.c_str(), _O_WRONLY | _O_BINARY, _SH_DENYWR, _S_IREAD | _S_IWRITE) != 0) {
+            return false;
+        }
+        bool ok = _chsize_s(fd, size) == 0 && _commit(fd) == 0;
+        _close(fd);
+        return ok;
+    }
+    void closeFile(int fd) { _close(fd); }
+
+    bool replaceFile(const std::string& from, const std::string& to) {
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+#else
+    int openFile(const std::string& path, bool append) {
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+        return open(path.c_str(), flags, 0600);
+    }
+
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = write(fd, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool syncFile(int fd) { return fsync(fd) == 0; }
+    bool truncateFile(int fd) { return ftruncate(fd, 0) == 0; }
+    bool truncateFileAt(const std::string& path, int64_t size) {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = ftruncate(fd, size) == 0 && fsync(fd) == 0;
+        close(fd);
+        return ok;
+    }
+    void closeFile(int fd) { close(fd); }
+
+    bool replaceFile(const std::string& from, const std::string& to) {
+        if (rename(from.c_str(), to.c_str()) != 0) {
+            return false;
+        }
+        // Make the rename itself durable
+        std::string directory = std::filesystem::path(to).parent_path().string();
+        int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+        return true;
+    }
+#endif
+}
+
+SubscriptionLog::SubscriptionLog(std::string directory)
+    : m_directory(std::move(directory))
+{
+}
+
+SubscriptionLog::~SubscriptionLog() {
+    stop();
+}
+
+std::string SubscriptionLog::defaultDirectory() {
+    namespace fs = std::filesystem;
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (!base) base = std::getenv("XDG_DATA_HOME");
+    return base ? (fs::path(base) / "MeetAssist").string() : std::string(".");
+}
+
+std::string SubscriptionLog::logPath() const {
+    return (std::filesystem::path(m_directory) / "subscriptions.wal").string();
+}
+
+std::string SubscriptionLog::snapshotPath() const {
+    return (std::filesystem::path(m_directory) / "subscriptions.snapshot").string();
+}
+
+bool SubscriptionLog::recover(const std::function<void(const SubscriptionEntry&)>& apply) {
+    auto started = std::chrono::steady_clock::now();
+    uint64_t count = 0;
+    bool ok = true;
+
+    std::string data;
+    if (readFile(snapshotPath(), data)) {
+        // Snapshots are renamed into place whole, so any damage is real corruption
+        if (data.size() < sizeof(SNAPSHOT_MAGIC) ||
+            std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+            replayRecords(data, sizeof(SNAPSHOT_MAGIC), apply, count) != data.size()) {
+            ok = false;
+        }
+    }
+
+    if (readFile(logPath(), data)) {
+        uint64_t logCount = 0;
+        size_t intact = replayRecords(data, 0, apply, logCount);
+        if (intact != data.size()) {
+            // A record torn by a crash was never acknowledged; drop it and
+            // anything after it so new records follow the intact prefix
+            truncateFileAt(logPath(), static_cast<int64_t>(intact));
+        }
+        count += logCount;
+        m_logRecords = logCount;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.recoveredRecords = count;
+    m_stats.recoveryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return ok;
+}
+
+bool SubscriptionLog::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return true;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    m_fd = openFile(logPath(), true);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    m_running = true;
+    m_stopping = false;
+    m_failed = false;
+    m_flusher = std::thread(&SubscriptionLog::run, this);
+    return true;
+}
+
+void SubscriptionLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_flusher.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closeFile(m_fd);
+    m_fd = -1;
+    m_running = false;
+}
+
+bool SubscriptionLog::append(const SubscriptionEntry& entry) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running || m_stopping || m_failed) {
+        return false;
+    }
+
+    appendRecord(m_pending, entry);
+    uint64_t sequence = ++m_enqueuedSeq;
+    ++m_pendingRecords;
+    m_wake.notify_one();
+
+    m_committed.wait(lock, [&]() { return m_durableSeq >= sequence || m_failed; });
+    return m_durableSeq >= sequence;
+}
+
+SubscriptionLogStats SubscriptionLog::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SubscriptionLog::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+        if (m_pending.empty()) {
+            return;
+        }
+
+        // Take everything queued so far; callers arriving during the write
+        // and sync form the next batch
+        m_writing.swap(m_pending);
+        m_pending.clear();
+        uint64_t batchEnd = m_enqueuedSeq;
+        uint64_t batchRecords = m_pendingRecords;
+        m_pendingRecords = 0;
+
+        lock.unlock();
+        bool ok = writeAll(m_fd, m_writing.data(), m_writing.size()) && syncFile(m_fd);
+        lock.lock();
+
+        if (!ok) {
+            m_failed = true;
+            m_committed.notify_all();
+            return;
+        }
+
+        m_durableSeq = batchEnd;
+        m_logRecords += batchRecords;
+        m_stats.records += batchRecords;
+        ++m_stats.commits;
+        m_committed.notify_all();
+
+        if (m_logRecords >= SNAPSHOT_THRESHOLD) {
+            // Only this thread writes the log, so it stays as compact()
+            // reads it; appenders queue the next batch meanwhile
+            lock.unlock();
+            bool compacted = compact();
+            lock.lock();
+            if (compacted) {
+                m_logRecords = 0;
+                ++m_stats.snapshots;
+            }
+        }
+    }
+}
+
+bool SubscriptionLog::compact() {
+    // Every record in the log is durable here. Replay the files the way
+    // recover() does, keeping what it would keep of a damaged snapshot.
+    SubscriptionStore state;
+    auto put = [&state](const SubscriptionEntry& entry) {
+        state.put(entry.email, entry.transactionId, entry.expiry);
+    };
+    uint64_t count = 0;
+    std::string data;
+    if (readFile(snapshotPath(), data) && data.size() >= sizeof(SNAPSHOT_MAGIC) &&
+        std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0) {
+        replayRecords(data, sizeof(SNAPSHOT_MAGIC), put, count);
+    }
+    if (!readFile(logPath(), data)) {
+        return false;
+    }
+    replayRecords(data, 0, put, count);
+
+    time_t now = std::time(nullptr);
+    data.assign(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    for (const SubscriptionEntry& entry : state.entries()) {
+        if (entry.expiry > now) {
+            appendRecord(data, entry);
+        }
+    }
+
+    std::string temp = snapshotPath() + ".tmp";
+    int fd = openFile(temp, false);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = writeAll(fd, data.data(), data.size()) && syncFile(fd);
+    closeFile(fd);
+
+    // The old log is only dropped once the snapshot covering it is durable
+    return written && replaceFile(temp, snapshotPath()) && truncateFile(m_fd) && syncFile(m_fd);
+}
\ No newline at end of file
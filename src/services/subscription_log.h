@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "subscription_store.h"
+
+struct SubscriptionLogStats {
+    uint64_t records;           // Records committed since start
+    uint64_t commits;           // fsyncs issued; records / commits is the batch size
+    uint64_t snapshots;
+    uint64_t recoveredRecords;  // Records replayed by recover()
+    double recoveryMs;
+};
+
+// Write-ahead log that makes subscription changes durable.
+//
+// Every change is appended as a checksummed record:
+//   u32 payload length | u32 CRC-32C of payload | payload
+// append() blocks until its record is on disk. A single flusher thread
+// writes everything queued since its last flush and syncs once, so
+// concurrent callers share one fsync (group commit).
+//
+// Once the log holds SNAPSHOT_THRESHOLD records the flusher folds the
+// snapshot and the log, as they are on disk, into a new snapshot file,
+// renames it over the old one and truncates the log. The snapshot is
+// thus exactly the state at the end of the log, never a change still
+// being appended that its caller may yet take back. Expired
+// subscriptions are left out. recover() loads the snapshot, replays the
+// log and cuts off a torn tail left by a crash.
+class SubscriptionLog {
+public:
+    explicit SubscriptionLog(std::string directory);
+    ~SubscriptionLog();
+    SubscriptionLog(const SubscriptionLog&) = delete;
+    SubscriptionLog& operator=(const SubscriptionLog&) = delete;
+
+    // Per-user data folder used by the application
+    static std::string defaultDirectory();
+
+    // Replay the snapshot and log through apply, oldest first. apply
+    // should store each entry as SubscriptionStore::put() does, which is
+    // how compaction folds them. Call before start(). Returns false if
+    // the snapshot is unreadable.
+    bool recover(const std::function<void(const SubscriptionEntry&)>& apply);
+
+    bool start();
+    void stop();
+
+    // Blocks until entry is durable. Returns false if the log is not
+    // running or a write failed; after a failed write the log stays failed.
+    bool append(const SubscriptionEntry& entry);
+
+    SubscriptionLogStats stats() const;
+
+    static const uint64_t SNAPSHOT_THRESHOLD = 4096;
+
+private:
+    void run();
+    bool compact();
+    std::string logPath() const;
+    std::string snapshotPath() const;
+
+    std::string m_directory;
+    int m_fd = -1;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;         // Flusher: work queued or stopping
+    std::condition_variable m_committed;    // Appenders: a flush finished
+    std::thread m_flusher;
+    std::string m_pending;
+    std::string m_writing;
+    uint64_t m_enqueuedSeq = 0;
+    uint64_t m_durableSeq = 0;
+    uint64_t m_pendingRecords = 0;
+    uint64_t m_logRecords = 0;              // Records in the log since the last snapshot
+    bool m_running = false;
+    bool m_stopping = false;
+    bool m_failed = false;
+
+    SubscriptionLogStats m_stats = {};
+};
@@ -0,0 +1,171 @@
+#include "subscription_scheduler.h"
+#include <algorithm>
+
+constexpr std::chrono::seconds SubscriptionScheduler::MAX_SLEEP;
+
+SubscriptionScheduler::SubscriptionScheduler(SubscriptionStore& store, Batch remind, Batch renew,
+                                             const SubscriptionSchedulerConfig& config, Clock clock)
+    : m_store(store)
+    , m_remind(std::move(remind))
+    , m_renew(std::move(renew))
+    , m_config(config)
+    , m_clock(clock ? std::move(clock) : Clock([]() { return std::time(nullptr); }))
+{
+}
+
+SubscriptionScheduler::~SubscriptionScheduler() {
+    stop();
+}
+
+void SubscriptionScheduler::track(std::string_view email, time_t expiry) {
+    if (expiry != 0) {
+        schedule(SubscriptionStore::hashEmail(email), expiry, Stage::Remind);
+    }
+}
+
+void SubscriptionScheduler::schedule(uint64_t key, time_t expiry, Stage stage) {
+    time_t due = expiry;
+    if (stage == Stage::Remind) {
+        due -= static_cast<time_t>(m_config.reminderLead.count());
+    } else if (stage == Stage::Renew) {
+        due -= static_cast<time_t>(m_config.renewalLead.count());
+    }
+
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        earliest = m_events.empty() || due < m_events.top().due;
+        m_events.push(Event{due, expiry, key, stage});
+    }
+    if (earliest) {
+        m_wake.notify_all();
+    }
+}
+
+bool SubscriptionScheduler::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable()) {
+        return false;
+    }
+    m_stopping = false;
+    m_thread = std::thread(&SubscriptionScheduler::run, this);
+    return true;
+}
+
+void SubscriptionScheduler::stop() {
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        stopped = std::move(m_thread);
+    }
+    m_wake.notify_all();
+    if (stopped.joinable()) {
+        stopped.join();
+    }
+}
+
+size_t SubscriptionScheduler::runDue() {
+    size_t handled = 0;
+    std::vector<Event> due;
+    std::vector<SubscriptionEntry> reminders;
+    std::vector<SubscriptionEntry> renewals;
+    SubscriptionEntry entry;
+
+    for (;;) {
+        time_t now = m_clock();
+        due.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (!m_events.empty() && m_events.top().due <= now && due.size() < m_config.batchSize) {
+                due.push_back(m_events.top());
+                m_events.pop();
+            }
+        }
+        if (due.empty()) {
+            return handled;
+        }
+
+        reminders.clear();
+        renewals.clear();
+        uint64_t stale = 0;
+        uint64_t expired = 0;
+        for (const Event& event : due) {
+            if (m_store.expiryForKey(event.key) != event.expiry || !m_store.entryForKey(event.key, entry)) {
+                ++stale;
+                continue;
+            }
+
+            // An event handled late, e.g. after the app was closed, skips
+            // any stage whose moment has passed
+            switch (event.stage) {
+                case Stage::Remind:
+                    if (now < event.expiry - static_cast<time_t>(m_config.renewalLead.count())) {
+                        reminders.push_back(entry);
+                    }
+                    schedule(event.key, event.expiry, Stage::Renew);
+                    break;
+                case Stage::Renew:
+                    if (now < event.expiry) {
+                        renewals.push_back(entry);
+                    }
+                    schedule(event.key, event.expiry, Stage::Expire);
+                    break;
+                case Stage::Expire:
+                    if (m_store.eraseIfExpired(event.key, now)) {
+                        ++expired;
+                    }
+                    break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.reminders += reminders.size();
+            m_stats.renewals += renewals.size();
+            m_stats.expired += expired;
+            m_stats.stale += stale;
+            ++m_stats.batches;
+        }
+
+        // A failing callback must not stop the schedule; its subscriptions
+        // still move on to the next stage
+        try {
+            if (!reminders.empty() && m_remind) {
+                m_remind(reminders);
+            }
+            if (!renewals.empty() && m_renew) {
+                m_renew(renewals);
+            }
+        }
+        catch (const std::exception&) {
+        }
+        handled += due.size();
+    }
+}
+
+SubscriptionSchedulerStats SubscriptionScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SubscriptionSchedulerStats result = m_stats;
+    result.pending = m_events.size();
+    return result;
+}
+
+void SubscriptionScheduler::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        time_t now = m_clock();
+        if (!m_events.empty() && m_events.top().due <= now) {
+            lock.unlock();
+            runDue();
+            lock.lock();
+            continue;
+        }
+
+        std::chrono::seconds sleep = MAX_SLEEP;
+        if (!m_events.empty()) {
+            sleep = std::min(sleep, std::chrono::seconds(m_events.top().due - now));
+        }
+        m_wake.wait_for(lock, sleep);
+    }
+}
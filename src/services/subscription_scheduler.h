@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "subscription_store.h"
+
+struct SubscriptionSchedulerConfig {
+    std::chrono::seconds reminderLead{3 * 24 * 60 * 60};    // Reminder this long before expiry
+    std::chrono::seconds renewalLead{24 * 60 * 60};         // Renewal attempt this long before expiry
+    size_t batchSize = 128;                                 // Events per batch; below the payment queue limit
+};
+
+struct SubscriptionSchedulerStats {
+    uint64_t reminders;     // Subscriptions handed to the reminder callback
+    uint64_t renewals;      // Subscriptions handed to the renewal callback
+    uint64_t expired;       // Records erased from the store
+    uint64_t stale;         // Events dropped because the subscription changed
+    uint64_t batches;
+    size_t pending;         // Events waiting in the queue
+};
+
+// Drives each subscription through reminder, renewal attempt and expiry.
+//
+// Every tracked subscription has one pending event in a min-heap ordered
+// by due time, so finding what is due costs O(log n) per event rather
+// than a scan of the store. Handling an event schedules the next stage.
+// Events carry the expiry they were scheduled for; when the store shows a
+// different expiry (renewed or replaced) the event is dropped, and the
+// new expiry is expected to arrive through track().
+//
+// Due events are handled in batches: the reminder and renewal callbacks
+// each get one vector per batch, and expired records are erased from the
+// store. Callbacks run without the scheduler's lock and may call track().
+class SubscriptionScheduler {
+public:
+    using Batch = std::function<void(const std::vector<SubscriptionEntry>&)>;
+    using Clock = std::function<time_t()>;
+
+    SubscriptionScheduler(SubscriptionStore& store, Batch remind, Batch renew,
+                          const SubscriptionSchedulerConfig& config = {}, Clock clock = nullptr);
+    ~SubscriptionScheduler();
+    SubscriptionScheduler(const SubscriptionScheduler&) = delete;
+    SubscriptionScheduler& operator=(const SubscriptionScheduler&) = delete;
+
+    // Schedule email's subscription, which now expires at expiry
+    void track(std::string_view email, time_t expiry);
+
+    // Background thread that calls runDue() as events come due
+    bool start();
+    void stop();
+
+    // Handle every event due at the clock's current time. Returns the
+    // number of events handled.
+    size_t runDue();
+
+    SubscriptionSchedulerStats stats() const;
+
+    // Longest the thread sleeps, so clock steps are noticed
+    static constexpr std::chrono::seconds MAX_SLEEP{60};
+
+private:
+    enum class Stage : uint8_t {
+        Remind,
+        Renew,
+        Expire
+    };
+
+    struct Event {
+        time_t due;
+        time_t expiry;
+        uint64_t key;
+        Stage stage;
+
+        bool operator>(const Event& other) const { return due > other.due; }
+    };
+
+    void schedule(uint64_t key, time_t expiry, Stage stage);
+    void run();
+
+    SubscriptionStore& m_store;
+    Batch m_remind;
+    Batch m_renew;
+    SubscriptionSchedulerConfig m_config;
+    Clock m_clock;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_events;
+    std::thread m_thread;
+    bool m_stopping = false;
+
+    SubscriptionSchedulerStats m_stats = {};
+};
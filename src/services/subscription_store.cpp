@@ -0,0 +1,438 @@
+#include "subscription_store.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+    inline void prefetch(const void* address) {
+#if defined(_M_X64) || defined(_M_IX86)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    const uint64_t IDLE = ~uint64_t(0);
+
+    // A thread's announcement of the epoch its lookup started in. Records
+    // are reused by later threads and never freed.
+    struct alignas(64) ReaderRecord {
+        std::atomic<uint64_t> epoch{IDLE};
+        std::atomic<bool> inUse{true};
+        ReaderRecord* next = nullptr;
+        int depth = 0;      // Nested guards; only touched by the owning thread
+    };
+
+    std::atomic<uint64_t> g_epoch{1};
+    std::atomic<ReaderRecord*> g_readers{nullptr};
+
+    ReaderRecord* acquireRecord() {
+        for (ReaderRecord* record = g_readers.load(std::memory_order_acquire); record; record = record->next) {
+            bool inUse = false;
+            if (!record->inUse.load(std::memory_order_relaxed) && record->inUse.compare_exchange_strong(inUse, true)) {
+                return record;
+            }
+        }
+        ReaderRecord* record = new ReaderRecord();
+        ReaderRecord* head = g_readers.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!g_readers.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        return record;
+    }
+
+    struct ThreadRecord {
+        ReaderRecord* record = acquireRecord();
+        ~ThreadRecord() { record->inUse.store(false, std::memory_order_release); }
+    };
+
+    // Announces the current epoch while in scope. The announcement and the
+    // table loads it covers are sequentially consistent with a writer's
+    // table swap, epoch bump and scan: a writer that misses the
+    // announcement is ordered before it, so the lookup loads the new table.
+    class ReadGuard {
+    public:
+        ReadGuard() : m_record(*threadRecord().record) {
+            if (m_record.depth++ == 0) {
+                m_record.epoch.store(g_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            }
+        }
+        ~ReadGuard() {
+            if (--m_record.depth == 0) {
+                m_record.epoch.store(IDLE, std::memory_order_release);
+            }
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        static ThreadRecord& threadRecord() {
+            thread_local ThreadRecord local;
+            return local;
+        }
+
+        ReaderRecord& m_record;
+    };
+
+    // Oldest epoch a lookup in progress may have started in
+    uint64_t oldestReaderEpoch() {
+        uint64_t oldest = IDLE;
+        for (ReaderRecord* record = g_readers.load(std::memory_order_acquire); record; record = record->next) {
+            uint64_t epoch = record->epoch.load(std::memory_order_seq_cst);
+            oldest = epoch < oldest ? epoch : oldest;
+        }
+        return oldest;
+    }
+}
+
+const size_t SubscriptionStore::INITIAL_CAPACITY;
+
+SubscriptionStore::Table::Table(size_t capacity)
+    : mask(capacity - 1)
+    , slots(new Slot[capacity])
+{
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].key.store(0, std::memory_order_relaxed);
+        slots[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+SubscriptionStore::SubscriptionStore() {
+    for (Shard& shard : m_shards) {
+        shard.current = std::make_unique<Table>(INITIAL_CAPACITY);
+        shard.table.store(shard.current.get(), std::memory_order_release);
+    }
+}
+
+uint64_t SubscriptionStore::hashEmail(std::string_view email) {
+    uint32_t check;
+    return hashEmail(email, check);
+}
+
+uint64_t SubscriptionStore::hashEmail(std::string_view email, uint32_t& check) {
+    // 64-bit FNV-1a over the bytes, then a murmur3 finalizer so the high
+    // bits (shard) and low bits (slot) are both well mixed. The check is
+    // 32-bit FNV-1a with its own finalizer, computed in the same pass.
+    uint64_t hash = 14695981039346656037ull;
+    uint32_t second = 2166136261u;
+    for (unsigned char c : email) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+        second ^= c;
+        second *= 16777619u;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+
+    second ^= second >> 16;
+    second *= 0x85ebca6bu;
+    second ^= second >> 13;
+    second *= 0xc2b2ae35u;
+    second ^= second >> 16;
+    check = second;
+    return hash != 0 ? hash : 1;
+}
+
+uint64_t SubscriptionStore::packValue(uint32_t check, time_t expiry) {
+    // Out-of-range expiries saturate; 0 stays "no subscription"
+    uint32_t seconds = 0;
+    if (expiry >= time_t(0xFFFFFFFFu)) {
+        seconds = 0xFFFFFFFFu;
+    } else if (expiry > 0) {
+        seconds = static_cast<uint32_t>(expiry);
+    }
+    return (uint64_t(check) << 32) | seconds;
+}
+
+bool SubscriptionStore::put(std::string_view email, const std::string& transactionId, time_t expiry) {
+    uint32_t check;
+    uint64_t key = hashEmail(email, check);
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    auto record = shard.records.find(key);
+    if (record != shard.records.end() && record->second.email != email) {
+        return false;
+    }
+    write(shard, key, check, email, transactionId, expiry);
+    return true;
+}
+
+SubscriptionStore::ExtendResult SubscriptionStore::extend(std::string_view email, const std::string& transactionId,
+                                                          time_t length, time_t now, SubscriptionEntry& applied,
+                                                          SubscriptionEntry& previous) {
+    uint32_t check;
+    uint64_t key = hashEmail(email, check);
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    previous = SubscriptionEntry{std::string(email), std::string(), 0};
+    auto record = shard.records.find(key);
+    if (record != shard.records.end()) {
+        if (record->second.email != email) {
+            return ExtendResult::Refused;
+        }
+        previous.transactionId = record->second.transactionId;
+        previous.expiry = unpackExpiry(probe(*shard.table.load(std::memory_order_relaxed), key));
+        if (record->second.transactionId == transactionId) {
+            applied = previous;
+            return ExtendResult::AlreadyApplied;
+        }
+    }
+
+    time_t start = previous.expiry > now ? previous.expiry : now;
+    applied = SubscriptionEntry{previous.email, transactionId, start + length};
+    write(shard, key, check, email, transactionId, applied.expiry);
+    return ExtendResult::Extended;
+}
+
+bool SubscriptionStore::revert(const SubscriptionEntry& applied, const SubscriptionEntry& previous) {
+    uint32_t check;
+    uint64_t key = hashEmail(applied.email, check);
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    auto record = shard.records.find(key);
+    const Table& table = *shard.table.load(std::memory_order_relaxed);
+    if (record == shard.records.end() || record->second.email != applied.email ||
+        record->second.transactionId != applied.transactionId || unpackExpiry(probe(table, key)) != applied.expiry) {
+        return false;
+    }
+
+    if (previous.expiry == 0) {
+        // There was no subscription; leave a dead slot like an erase does
+        find(table, key)->value.store(0, std::memory_order_relaxed);
+        shard.records.erase(record);
+    } else {
+        write(shard, key, check, previous.email, previous.transactionId, previous.expiry);
+    }
+    return true;
+}
+
+time_t SubscriptionStore::expiry(std::string_view email) const {
+    uint32_t check;
+    uint64_t key = hashEmail(email, check);
+    ReadGuard guard;
+    return probe(*shardFor(key).table.load(std::memory_order_seq_cst), key, check);
+}
+
+time_t SubscriptionStore::expiryForKey(uint64_t key) const {
+    // A key belongs to one address at a time, as put() refuses a second
+    ReadGuard guard;
+    return unpackExpiry(probe(*shardFor(key).table.load(std::memory_order_seq_cst), key));
+}
+
+bool SubscriptionStore::entryForKey(uint64_t key, SubscriptionEntry& out) const {
+    const Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+    auto record = shard.records.find(key);
+    if (record == shard.records.end()) {
+        return false;
+    }
+    out.email = record->second.email;
+    out.transactionId = record->second.transactionId;
+    out.expiry = unpackExpiry(probe(*shard.table.load(std::memory_order_relaxed), key));
+    return true;
+}
+
+bool SubscriptionStore::eraseIfExpired(uint64_t key, time_t now) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+    Slot* slot = find(*shard.table.load(std::memory_order_relaxed), key);
+    if (!slot || unpackExpiry(slot->value.load(std::memory_order_relaxed)) > now) {
+        return false;
+    }
+    // Readers see expiry 0, the same as no subscription
+    slot->value.store(0, std::memory_order_relaxed);
+    shard.records.erase(key);
+    reclaim(shard);
+    return true;
+}
+
+void SubscriptionStore::activeMask(const std::string_view* emails, size_t count, time_t now,
+                                   uint64_t* active) const {
+    // Struct-of-arrays scratch for one block
+    uint64_t keys[BATCH_BLOCK];
+    uint32_t checks[BATCH_BLOCK];
+    const Table* tables[BATCH_BLOCK];
+    int64_t expiries[BATCH_BLOCK];
+    const int64_t threshold = static_cast<int64_t>(now);
+    ReadGuard guard;
+
+    for (size_t base = 0; base < count; base += BATCH_BLOCK) {
+        size_t block = count - base < BATCH_BLOCK ? count - base : BATCH_BLOCK;
+
+        // Hash everything and start the slot loads, so the cache misses of
+        // the whole block overlap instead of being paid one at a time
+        for (size_t j = 0; j < block; ++j) {
+            uint64_t key = hashEmail(emails[base + j], checks[j]);
+            const Table* table = shardFor(key).table.load(std::memory_order_seq_cst);
+            keys[j] = key;
+            tables[j] = table;
+            prefetch(&table->slots[key & table->mask]);
+        }
+
+        for (size_t j = 0; j < block; ++j) {
+            expiries[j] = static_cast<int64_t>(probe(*tables[j], keys[j], checks[j]));
+        }
+
+        // Branch-free compare; vectorizes over the expiry array
+        for (size_t j = 0; j < block; j += 64) {
+            size_t lanes = block - j < 64 ? block - j : 64;
+            uint64_t word = 0;
+            for (size_t k = 0; k < lanes; ++k) {
+                word |= uint64_t(expiries[j + k] > threshold) << k;
+            }
+            active[(base + j) / 64] = word;
+        }
+    }
+}
+
+size_t SubscriptionStore::size() const {
+    size_t total = 0;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        total += shard.records.size();
+    }
+    return total;
+}
+
+size_t SubscriptionStore::retiredTables() const {
+    size_t total = 0;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        total += shard.retired.size();
+    }
+    return total;
+}
+
+std::vector<SubscriptionEntry> SubscriptionStore::entries() const {
+    std::vector<SubscriptionEntry> result;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        const Table* table = shard.table.load(std::memory_order_relaxed);
+        result.reserve(result.size() + shard.records.size());
+        for (const auto& [key, record] : shard.records) {
+            time_t expiry = unpackExpiry(probe(*table, key));
+            result.push_back(SubscriptionEntry{record.email, record.transactionId, expiry});
+        }
+    }
+    return result;
+}
+
+uint64_t SubscriptionStore::probe(const Table& table, uint64_t key) {
+    for (size_t i = key & table.mask;; i = (i + 1) & table.mask) {
+        uint64_t slotKey = table.slots[i].key.load(std::memory_order_acquire);
+        if (slotKey == key) {
+            return table.slots[i].value.load(std::memory_order_relaxed);
+        }
+        if (slotKey == 0) {
+            return 0;
+        }
+    }
+}
+
+time_t SubscriptionStore::probe(const Table& table, uint64_t key, uint32_t check) {
+    // Check and expiry are read together, so they always belong to the same put
+    uint64_t value = probe(table, key);
+    return unpackCheck(value) == check ? unpackExpiry(value) : 0;
+}
+
+SubscriptionStore::Slot* SubscriptionStore::find(const Table& table, uint64_t key) {
+    for (size_t i = key & table.mask;; i = (i + 1) & table.mask) {
+        uint64_t slotKey = table.slots[i].key.load(std::memory_order_relaxed);
+        if (slotKey == key) {
+            return &table.slots[i];
+        }
+        if (slotKey == 0) {
+            return nullptr;
+        }
+    }
+}
+
+bool SubscriptionStore::insert(const Table& table, uint64_t key, uint64_t value) {
+    for (size_t i = key & table.mask;; i = (i + 1) & table.mask) {
+        Slot& slot = table.slots[i];
+        uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+        if (slotKey == key) {
+            slot.value.store(value, std::memory_order_relaxed);
+            return false;
+        }
+        if (slotKey == 0) {
+            // The release on the key publishes the value written before it
+            slot.value.store(value, std::memory_order_relaxed);
+            slot.key.store(key, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+void SubscriptionStore::write(Shard& shard, uint64_t key, uint32_t check, std::string_view email,
+                              const std::string& transactionId, time_t expiry) {
+    auto [record, inserted] = shard.records.try_emplace(key);
+    record->second.email.assign(email.data(), email.size());
+    record->second.transactionId = transactionId;
+
+    if (inserted) {
+        // Keep the load factor at or below one half so probes stay short
+        const Table* table = shard.table.load(std::memory_order_relaxed);
+        if ((shard.count + 1) * 2 > table->mask + 1) {
+            rebuild(shard);
+        }
+    }
+    if (insert(*shard.table.load(std::memory_order_relaxed), key, packValue(check, expiry))) {
+        ++shard.count;
+    }
+    reclaim(shard);
+}
+
+void SubscriptionStore::rebuild(Shard& shard) {
+    // Size for the live slots alone, so erased ones are dropped and a shard
+    // that has mostly expired shrinks
+    const Table* current = shard.table.load(std::memory_order_relaxed);
+    size_t live = 0;
+    for (size_t i = 0; i <= current->mask; ++i) {
+        if (current->slots[i].key.load(std::memory_order_relaxed) != 0 &&
+            unpackExpiry(current->slots[i].value.load(std::memory_order_relaxed)) != 0) {
+            ++live;
+        }
+    }
+    size_t capacity = INITIAL_CAPACITY;
+    while ((live + 1) * 4 > capacity) {
+        capacity *= 2;
+    }
+
+    auto replacement = std::make_unique<Table>(capacity);
+    for (size_t i = 0; i <= current->mask; ++i) {
+        uint64_t key = current->slots[i].key.load(std::memory_order_relaxed);
+        uint64_t value = current->slots[i].value.load(std::memory_order_relaxed);
+        if (key != 0 && unpackExpiry(value) != 0) {
+            insert(*replacement, key, value);
+        }
+    }
+
+    shard.count = live;
+    std::unique_ptr<Table> previous = std::move(shard.current);
+    shard.current = std::move(replacement);
+    shard.table.store(shard.current.get(), std::memory_order_seq_cst);
+
+    // Lookups that start from here on announce a later epoch than this
+    shard.retired.push_back(Retired{std::move(previous), g_epoch.fetch_add(1, std::memory_order_seq_cst)});
+}
+
+void SubscriptionStore::reclaim(Shard& shard) {
+    if (shard.retired.empty()) {
+        return;
+    }
+    uint64_t oldest = oldestReaderEpoch();
+    shard.retired.erase(std::remove_if(shard.retired.begin(), shard.retired.end(),
+                                       [oldest](const Retired& retired) { return retired.epoch < oldest; }),
+                        shard.retired.end());
+}
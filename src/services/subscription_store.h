@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// One subscription as stored and persisted
+struct SubscriptionEntry {
+    std::string email;
+    std::string transactionId;
+    time_t expiry;
+};
+
+// Subscriptions keyed by a 64-bit hash of the email address.
+//
+// Entries are spread over 16 shards, each an open-addressing table with
+// linear probing over 16-byte {key, check, expiry} slots. The check is a
+// second, independent 32-bit hash of the email: a lookup only matches a
+// slot when both agree, so two addresses sharing a key can't read each
+// other's subscription. Writers compare the full email and refuse the
+// second address of a colliding pair. Expiries are stored as unsigned
+// 32-bit seconds, which lasts until 2106.
+//
+// Lookups take no lock: they load the shard's current table and probe it
+// with atomic loads. Writers take the shard's mutex, fill a slot's value
+// before its key, and on growth copy into a new table and publish it.
+//
+// Replaced tables are freed by epoch-based reclamation. For the length of
+// a lookup the thread announces the global epoch; replacing a table
+// advances the epoch, and the old table is freed by a later write to the
+// shard once no thread announces an epoch from before the replacement.
+//
+// Erasing frees the record at once but only zeroes the slot's value, as
+// moving keys would race with lock-free probes; the dead slot is dropped
+// when the shard's table is next rebuilt.
+class SubscriptionStore {
+public:
+    SubscriptionStore();
+    ~SubscriptionStore() = default;
+    SubscriptionStore(const SubscriptionStore&) = delete;
+    SubscriptionStore& operator=(const SubscriptionStore&) = delete;
+
+    enum class ExtendResult {
+        Extended,
+        AlreadyApplied,     // transactionId was the last payment applied; nothing changed
+        Refused             // A different address holds the key
+    };
+
+    // Insert or replace the subscription for email. Fails only when a
+    // different address already holds the same key.
+    bool put(std::string_view email, const std::string& transactionId, time_t expiry);
+
+    // Extend email's subscription by length from the later of now and its
+    // current expiry, reading and writing under the shard lock. applied
+    // receives the subscription as it now stands and previous the one it
+    // replaced, with expiry 0 when there was none.
+    ExtendResult extend(std::string_view email, const std::string& transactionId, time_t length, time_t now,
+                        SubscriptionEntry& applied, SubscriptionEntry& previous);
+
+    // Undo an extend() whose change could not be made durable. Does
+    // nothing if the subscription has changed since.
+    bool revert(const SubscriptionEntry& applied, const SubscriptionEntry& previous);
+
+    // Expiry of the subscription for email, or 0 when there is none
+    time_t expiry(std::string_view email) const;
+    time_t expiryForKey(uint64_t key) const;
+
+    // Copy of the subscription with the given hashEmail() key
+    bool entryForKey(uint64_t key, SubscriptionEntry& out) const;
+
+    // Remove the subscription if it has expired by now
+    bool eraseIfExpired(uint64_t key, time_t now);
+
+    bool isActive(std::string_view email, time_t now) const {
+        return now < expiry(email);
+    }
+
+    // isActive for a batch. Bit i of active, which must hold
+    // (count + 63) / 64 words, is set when emails[i] is active at now.
+    // All keys of a block are hashed and their slots prefetched before
+    // any is probed, and the expiries are compared in a separate pass.
+    void activeMask(const std::string_view* emails, size_t count, time_t now, uint64_t* active) const;
+
+    size_t size() const;
+
+    // Copy of every subscription, e.g. for a snapshot. Each shard is
+    // copied under its write lock.
+    std::vector<SubscriptionEntry> entries() const;
+
+    // Replaced tables a lookup may still be probing, not yet freed
+    size_t retiredTables() const;
+
+    // Never returns 0, which marks an empty slot
+    static uint64_t hashEmail(std::string_view email);
+
+private:
+    struct alignas(16) Slot {
+        std::atomic<uint64_t> key;
+        std::atomic<uint64_t> value;    // Check in the high half, expiry in the low
+    };
+
+    struct Table {
+        explicit Table(size_t capacity);
+
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    // Writer-side details that lookups never touch
+    struct Record {
+        std::string email;
+        std::string transactionId;
+    };
+
+    struct Retired {
+        std::unique_ptr<Table> table;
+        uint64_t epoch;                 // Global epoch when it was replaced
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<const Table*> table{nullptr};
+        mutable std::mutex writeMutex;
+        size_t count = 0;                   // Occupied slots, dead ones included
+        std::unique_ptr<Table> current;
+        std::vector<Retired> retired;
+        std::unordered_map<uint64_t, Record> records;
+    };
+
+    Shard& shardFor(uint64_t key) { return m_shards[key >> (64 - SHARD_BITS)]; }
+    const Shard& shardFor(uint64_t key) const { return m_shards[key >> (64 - SHARD_BITS)]; }
+    static uint64_t hashEmail(std::string_view email, uint32_t& check);
+    static uint64_t packValue(uint32_t check, time_t expiry);
+    static time_t unpackExpiry(uint64_t value) { return static_cast<time_t>(value & 0xFFFFFFFFu); }
+    static uint32_t unpackCheck(uint64_t value) { return static_cast<uint32_t>(value >> 32); }
+
+    static uint64_t probe(const Table& table, uint64_t key);
+    static time_t probe(const Table& table, uint64_t key, uint32_t check);
+    static Slot* find(const Table& table, uint64_t key);
+    static bool insert(const Table& table, uint64_t key, uint64_t value);
+    static void rebuild(Shard& shard);
+    static void reclaim(Shard& shard);
+    static void write(Shard& shard, uint64_t key, uint32_t check, std::string_view email,
+                      const std::string& transactionId, time_t expiry);
+
+    static const int SHARD_BITS = 4;
+    static const size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+    static const size_t INITIAL_CAPACITY = 64;
+    static const size_t BATCH_BLOCK = 256;     // Keys hashed and prefetched together; a multiple of 64
+
+    Shard m_shards[SHARD_COUNT];
+};
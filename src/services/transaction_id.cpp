@@ -0,0 +1,95 @@
+#include "transaction_id.h"
+#include <chrono>
+#include <random>
+
+namespace {
+    const char CROCKFORD_DIGITS[] = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+    const char PREFIX[] = "TXN";
+    const size_t PREFIX_LENGTH = 3;
+
+    int crockfordValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        // Crockford reads I and L as 1 and O as 0
+        if (c == 'I' || c == 'L') return 1;
+        if (c == 'O') return 0;
+        for (int value = 10; value < 32; ++value) {
+            if (CROCKFORD_DIGITS[value] == c) return value;
+        }
+        return -1;
+    }
+}
+
+TransactionIdGenerator::TransactionIdGenerator(uint32_t node)
+    : m_node(node & ((1u << NODE_BITS) - 1))
+{
+}
+
+uint32_t TransactionIdGenerator::randomNode() {
+    std::random_device device;
+    return device() & ((1u << NODE_BITS) - 1);
+}
+
+size_t TransactionIdGenerator::laneForThread() {
+    static std::atomic<size_t> nextLane{0};
+    thread_local size_t lane = nextLane.fetch_add(1, std::memory_order_relaxed) % LANE_COUNT;
+    return lane;
+}
+
+uint64_t TransactionIdGenerator::next() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return next(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count()));
+}
+
+uint64_t TransactionIdGenerator::next(uint64_t unixMs) {
+    const uint64_t timeMask = (uint64_t(1) << TIME_BITS) - 1;
+    uint64_t elapsed = unixMs > EPOCH_MS ? (unixMs - EPOCH_MS) & timeMask : 0;
+    uint64_t clock = elapsed << SEQUENCE_BITS;
+
+    size_t lane = laneForThread();
+    std::atomic<uint64_t>& state = m_lanes[lane].state;
+    uint64_t last = state.load(std::memory_order_relaxed);
+    uint64_t issued;
+    do {
+        // A full sequence carries into the milliseconds
+        issued = last + 1 > clock ? last + 1 : clock;
+    } while (!state.compare_exchange_weak(last, issued, std::memory_order_relaxed));
+
+    if (elapsed < m_lanes[lane].clock.exchange(elapsed, std::memory_order_relaxed)) {
+        m_regressions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t milliseconds = (issued >> SEQUENCE_BITS) & timeMask;
+    uint64_t sequence = issued & ((uint64_t(1) << SEQUENCE_BITS) - 1);
+    return (milliseconds << (NODE_BITS + LANE_BITS + SEQUENCE_BITS)) |
+           (m_node << (LANE_BITS + SEQUENCE_BITS)) |
+           (uint64_t(lane) << SEQUENCE_BITS) |
+           sequence;
+}
+
+std::string TransactionIdGenerator::encode(uint64_t id) {
+    std::string text(ENCODED_LENGTH, '0');
+    text.replace(0, PREFIX_LENGTH, PREFIX);
+    for (size_t i = ENCODED_LENGTH; i > PREFIX_LENGTH; --i) {
+        text[i - 1] = CROCKFORD_DIGITS[id & 31];
+        id >>= 5;
+    }
+    return text;
+}
+
+bool TransactionIdGenerator::decode(std::string_view text, uint64_t& id) {
+    if (text.size() != ENCODED_LENGTH || text.substr(0, PREFIX_LENGTH) != PREFIX) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = PREFIX_LENGTH; i < ENCODED_LENGTH; ++i) {
+        int digit = crockfordValue(text[i]);
+        // The leading digit only carries the top 4 bits
+        if (digit < 0 || (i == PREFIX_LENGTH && digit > 15)) {
+            return false;
+        }
+        value = (value << 5) | static_cast<uint64_t>(digit);
+    }
+    id = value;
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Snowflake-style 64-bit transaction IDs.
+//
+//   0 | 41-bit milliseconds since EPOCH_MS | 10-bit node | 2-bit lane | 10-bit sequence
+//
+// Each thread is bound to one of 4 lanes, one per payment pipeline
+// worker. A lane keeps its last (milliseconds, sequence) pair in a single
+// atomic word and advances it with one compare-and-swap to
+// max(last + 1, now), so IDs from a lane are strictly increasing. A lane
+// that issues more than 1024 IDs in a millisecond, or sees the wall clock
+// step backwards, keeps counting past the clock instead of waiting or
+// repeating an ID; the clock catches up later. Up to about a million IDs
+// a second per lane, four million per generator, stay on the clock.
+//
+// Processes with random nodes share one with probability 1/1024 per pair,
+// and even then only repeat an ID issued on the same lane in the same
+// millisecond with the same sequence. Servers should be given distinct
+// nodes instead.
+class TransactionIdGenerator {
+public:
+    static const int SEQUENCE_BITS = 10;
+    static const int LANE_BITS = 2;
+    static const int NODE_BITS = 10;
+    static const int TIME_BITS = 41;
+    static const size_t LANE_COUNT = size_t(1) << LANE_BITS;
+
+    // 2024-01-01T00:00:00Z; 41 bits of milliseconds last until 2093
+    static const uint64_t EPOCH_MS = 1704067200000ull;
+
+    // Crockford base32 text is 13 characters; with the prefix, 16
+    static const size_t ENCODED_LENGTH = 16;
+
+    // node must be below 1024 and distinct for every process issuing IDs
+    // at the same time
+    explicit TransactionIdGenerator(uint32_t node);
+    TransactionIdGenerator(const TransactionIdGenerator&) = delete;
+    TransactionIdGenerator& operator=(const TransactionIdGenerator&) = delete;
+
+    // Random node for a single client process
+    static uint32_t randomNode();
+
+    uint64_t next();
+
+    // next() with the clock supplied, in Unix milliseconds
+    uint64_t next(uint64_t unixMs);
+
+    // "TXN" followed by 13 Crockford base32 digits. Fixed width, so the
+    // text sorts in the same order as the IDs.
+    static std::string encode(uint64_t id);
+    static bool decode(std::string_view text, uint64_t& id);
+
+    static uint64_t timestampMs(uint64_t id) { return (id >> (NODE_BITS + LANE_BITS + SEQUENCE_BITS)) + EPOCH_MS; }
+    static uint32_t node(uint64_t id) { return static_cast<uint32_t>(id >> (LANE_BITS + SEQUENCE_BITS)) & ((1u << NODE_BITS) - 1); }
+
+    // Times a lane read the wall clock behind its previous reading. IDs
+    // running ahead of the clock after a burst don't count. With more
+    // threads than lanes, two readings racing on one lane may.
+    uint64_t clockRegressions() const { return m_regressions.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Lane {
+        std::atomic<uint64_t> state{0};     // milliseconds << SEQUENCE_BITS | sequence
+        std::atomic<uint64_t> clock{0};     // Milliseconds of the last clock reading
+    };
+
+    static size_t laneForThread();
+
+    uint64_t m_node;
+    Lane m_lanes[LANE_COUNT];
+    std::atomic<uint64_t> m_regressions{0};
+};
@@ -0,0 +1,245 @@
+#include "utf_transcode.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF_TRANSCODE_SSE2 1
+#endif
+
+namespace {
+    const uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+    // Copies the ASCII prefix of in[i..length) and advances i and o past it
+    template <typename Unit>
+    void copyAsciiRun(const unsigned char* in, size_t length, Unit* out, size_t& i, size_t& o) {
+#ifdef UTF_TRANSCODE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        while (i + 16 <= length) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            if (_mm_movemask_epi8(bytes) != 0) {
+                break;
+            }
+            // Zero-extend each byte to a 16-bit unit
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), _mm_unpacklo_epi8(bytes, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o + 8), _mm_unpackhi_epi8(bytes, zero));
+            i += 16;
+            o += 16;
+        }
+#else
+        while (i + 8 <= length) {
+            uint64_t word;
+            std::memcpy(&word, in + i, sizeof(word));
+            if (word & 0x8080808080808080ull) {
+                break;
+            }
+            for (size_t k = 0; k < 8; ++k) {
+                out[o + k] = static_cast<Unit>(in[i + k]);
+            }
+            i += 8;
+            o += 8;
+        }
+#endif
+        while (i < length && in[i] < 0x80) {
+            out[o++] = static_cast<Unit>(in[i++]);
+        }
+    }
+
+    template <typename Unit>
+    void copyAsciiRun(const Unit* in, size_t length, unsigned char* out, size_t& i, size_t& o) {
+#ifdef UTF_TRANSCODE_SSE2
+        static_assert(sizeof(Unit) == 2, "UTF-16 units must be 16 bits");
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+        while (i + 16 <= length) {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+            __m128i bits = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(bits, zero)) != 0xFFFF) {
+                break;
+            }
+            // Every unit is below 0x80, so packing with saturation is exact
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), _mm_packus_epi16(low, high));
+            i += 16;
+            o += 16;
+        }
+#endif
+        while (i < length && static_cast<uint32_t>(in[i]) < 0x80) {
+            out[o++] = static_cast<unsigned char>(in[i++]);
+        }
+    }
+
+    template <typename Unit>
+    size_t decodeUtf8(const unsigned char* in, size_t length, Unit* out, InvalidInput policy) {
+        size_t i = 0;
+        size_t o = 0;
+        while (i < length) {
+            unsigned char lead = in[i];
+            if (lead < 0x80) {
+                copyAsciiRun(in, length, out, i, o);
+                continue;
+            }
+
+            // Allowed range of the second byte depends on the lead byte;
+            // this is what rules out overlong forms, surrogates and values
+            // above U+10FFFF (Unicode table 3-7)
+            size_t trailing = 0;
+            unsigned char low = 0x80;
+            unsigned char high = 0xBF;
+            uint32_t codePoint = 0;
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                trailing = 1;
+                codePoint = lead & 0x1F;
+            } else if (lead >= 0xE0 && lead <= 0xEF) {
+                trailing = 2;
+                codePoint = lead & 0x0F;
+                if (lead == 0xE0) low = 0xA0;
+                if (lead == 0xED) high = 0x9F;
+            } else if (lead >= 0xF0 && lead <= 0xF4) {
+                trailing = 3;
+                codePoint = lead & 0x07;
+                if (lead == 0xF0) low = 0x90;
+                if (lead == 0xF4) high = 0x8F;
+            }
+
+            size_t consumed = 1;
+            bool valid = trailing > 0;
+            for (size_t k = 0; valid && k < trailing; ++k) {
+                if (i + consumed >= length) {
+                    valid = false;
+                    break;
+                }
+                unsigned char next = in[i + consumed];
+                if (next < low || next > high) {
+                    valid = false;
+                    break;
+                }
+                codePoint = (codePoint << 6) | (next & 0x3F);
+                ++consumed;
+                low = 0x80;
+                high = 0xBF;
+            }
+
+            // consumed now covers the maximal ill-formed subpart on failure
+            i += consumed;
+            if (!valid) {
+                if (policy == InvalidInput::Reject) {
+                    return SIZE_MAX;
+                }
+                out[o++] = static_cast<Unit>(REPLACEMENT_CHARACTER);
+            } else if (codePoint >= 0x10000) {
+                codePoint -= 0x10000;
+                out[o++] = static_cast<Unit>(0xD800 + (codePoint >> 10));
+                out[o++] = static_cast<Unit>(0xDC00 + (codePoint & 0x3FF));
+            } else {
+                out[o++] = static_cast<Unit>(codePoint);
+            }
+        }
+        return o;
+    }
+
+    template <typename Unit>
+    size_t encodeUtf8(const Unit* in, size_t length, unsigned char* out, InvalidInput policy) {
+        size_t i = 0;
+        size_t o = 0;
+        while (i < length) {
+            uint32_t unit = static_cast<uint32_t>(in[i]);
+            if (unit < 0x80) {
+                copyAsciiRun(in, length, out, i, o);
+                continue;
+            }
+
+            uint32_t codePoint = unit;
+            ++i;
+            if (unit >= 0xD800 && unit <= 0xDFFF) {
+                uint32_t next = i < length ? static_cast<uint32_t>(in[i]) : 0;
+                if (unit <= 0xDBFF && next >= 0xDC00 && next <= 0xDFFF) {
+                    codePoint = 0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00);
+                    ++i;
+                } else if (policy == InvalidInput::Reject) {
+                    return SIZE_MAX;
+                } else {
+                    // Unpaired surrogate
+                    codePoint = REPLACEMENT_CHARACTER;
+                }
+            }
+
+            if (codePoint < 0x800) {
+                out[o++] = static_cast<unsigned char>(0xC0 | (codePoint >> 6));
+                out[o++] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out[o++] = static_cast<unsigned char>(0xE0 | (codePoint >> 12));
+                out[o++] = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out[o++] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+            } else {
+                out[o++] = static_cast<unsigned char>(0xF0 | (codePoint >> 18));
+                out[o++] = static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out[o++] = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out[o++] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+        return o;
+    }
+
+    // Converts into out starting at offset; on rejection out is cut back to offset
+    template <typename String>
+    bool decodeInto(std::string_view in, String& out, size_t offset, InvalidInput policy) {
+        out.resize(offset + maxUtf16Length(in.size()));
+        size_t written = decodeUtf8(reinterpret_cast<const unsigned char*>(in.data()), in.size(),
+                                    &out[0] + offset, policy);
+        if (written == SIZE_MAX) {
+            out.resize(offset);
+            return false;
+        }
+        out.resize(offset + written);
+        return true;
+    }
+
+    template <typename Unit>
+    bool encodeInto(const Unit* in, size_t length, std::string& out, InvalidInput policy) {
+        out.resize(maxUtf8Length(length));
+        size_t written = encodeUtf8(in, length, reinterpret_cast<unsigned char*>(&out[0]), policy);
+        if (written == SIZE_MAX) {
+            out.clear();
+            return false;
+        }
+        out.resize(written);
+        return true;
+    }
+}
+
+size_t utf8ToUtf16(const char* in, size_t length, char16_t* out, InvalidInput policy) {
+    return decodeUtf8(reinterpret_cast<const unsigned char*>(in), length, out, policy);
+}
+
+size_t utf16ToUtf8(const char16_t* in, size_t length, char* out, InvalidInput policy) {
+    return encodeUtf8(in, length, reinterpret_cast<unsigned char*>(out), policy);
+}
+
+bool utf8ToUtf16(std::string_view in, std::u16string& out, InvalidInput policy) {
+    return decodeInto(in, out, 0, policy);
+}
+
+bool utf16ToUtf8(std::u16string_view in, std::string& out, InvalidInput policy) {
+    return encodeInto(in.data(), in.size(), out, policy);
+}
+
+bool appendUtf8AsUtf16(std::string_view in, std::u16string& out, InvalidInput policy) {
+    return decodeInto(in, out, out.size(), policy);
+}
+
+#ifdef _WIN32
+static_assert(sizeof(wchar_t) == sizeof(char16_t), "wchar_t must be UTF-16");
+
+bool utf8ToWide(std::string_view in, std::wstring& out, InvalidInput policy) {
+    return decodeInto(in, out, 0, policy);
+}
+
+bool wideToUtf8(std::wstring_view in, std::string& out, InvalidInput policy) {
+    return encodeInto(in.data(), in.size(), out, policy);
+}
+
+bool appendUtf8AsWide(std::string_view in, std::wstring& out, InvalidInput policy) {
+    return decodeInto(in, out, out.size(), policy);
+}
+#endif
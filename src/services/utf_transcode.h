@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Validating UTF-8 <-> UTF-16 conversion.
+//
+// Runs of ASCII are converted 16 bytes at a time with SSE2 where the
+// target has it; everything else goes through a scalar decoder that
+// rejects overlong forms, surrogate code points, values past U+10FFFF and
+// truncated sequences. Output goes into caller-owned buffers so repeated
+// conversions reuse one allocation.
+
+// What to do with ill-formed input
+enum class InvalidInput {
+    Replace,    // Write U+FFFD for each maximal ill-formed subpart and go on
+    Reject      // Stop and report failure
+};
+
+// Output sizes that are always large enough
+constexpr size_t maxUtf16Length(size_t utf8Bytes) { return utf8Bytes; }
+constexpr size_t maxUtf8Length(size_t utf16Units) { return utf16Units * 3; }
+
+// Raw conversions. out must hold maxUtf16Length/maxUtf8Length units.
+// Returns the number of units written, or SIZE_MAX when input is rejected.
+size_t utf8ToUtf16(const char* in, size_t length, char16_t* out, InvalidInput policy = InvalidInput::Replace);
+size_t utf16ToUtf8(const char16_t* in, size_t length, char* out, InvalidInput policy = InvalidInput::Replace);
+
+// Replace the contents of out, keeping its capacity. Returns false when
+// the input is rejected; out is then empty.
+bool utf8ToUtf16(std::string_view in, std::u16string& out, InvalidInput policy = InvalidInput::Replace);
+bool utf16ToUtf8(std::u16string_view in, std::string& out, InvalidInput policy = InvalidInput::Replace);
+
+// Append instead of replace, for building up display text
+bool appendUtf8AsUtf16(std::string_view in, std::u16string& out, InvalidInput policy = InvalidInput::Replace);
+
+#ifdef _WIN32
+// wchar_t is UTF-16 on Windows, so these share the char16_t code
+bool utf8ToWide(std::string_view in, std::wstring& out, InvalidInput policy = InvalidInput::Replace);
+bool wideToUtf8(std::wstring_view in, std::string& out, InvalidInput policy = InvalidInput::Replace);
+bool appendUtf8AsWide(std::string_view in, std::wstring& out, InvalidInput policy = InvalidInput::Replace);
+
+inline std::wstring utf8ToWide(std::string_view in) {
+    std::wstring out;
+    utf8ToWide(in, out);
+    return out;
+}
+
+inline std::string wideToUtf8(std::wstring_view in) {
+    std::string out;
+    wideToUtf8(in, out);
+    return out;
+}
+#endif
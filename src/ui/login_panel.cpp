@@ -1,6 +1,7 @@
 #include "login_panel.h"
 #include <commctrl.h>
 #include <windowsx.h>
+#include "../services/utf_transcode.h"
 
 LoginPanel::LoginPanel() 
     : m_hwnd(nullptr)
@@ -172,10 +173,10 @@ void LoginPanel::ValidateAndLogin() {
     int textLength = GetWindowTextLengthW(m_tokenEdit) + 1;
     std::vector<wchar_t> buffer(textLength);
     GetWindowTextW(m_tokenEdit, buffer.data(), textLength);
-    std::wstring token(buffer.data());
 
-    // Convert wstring to string for the auth manager
-    std::string tokenStr(token.begin(), token.end());
+    // The auth manager works in UTF-8
+    std::string tokenStr;
+    wideToUtf8(std::wstring_view(buffer.data()), tokenStr);
 
     // Attempt to login
     if (AuthenticationManager::getInstance().loginWithToken(tokenStr)) {
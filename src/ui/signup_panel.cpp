@@ -2,28 +2,53 @@
 #include <commctrl.h>
 #include <windowsx.h>
 #include <string>
-#include <sstream>
+#include <cwchar>
+#include <functional>
+#include "../services/exchange_rate_service.h"
+#include "../services/payment_service.h"
+#include "../services/utf_transcode.h"
 
 
-// Timer ID for location updates
-const UINT_PTR LOCATION_TIMER_ID = 1001;
-const UINT LOCATION_CHECK_INTERVAL = 1000; // 1 second
+// Posted to the panel to run its queued location updates on the UI thread
+const UINT WM_LOCATION_TASK = WM_APP + 1;
 
 void SignupPanel::InitializeLocation() {
-    // Get initial location info (might be default values)
-    m_locationInfo = LocationService::getInstance().getCachedLocationInfo();
-    UpdateLocationDisplay();
-
-    // Set up timer to check for location updates
-    SetTimer(m_hwnd, LOCATION_TIMER_ID, LOCATION_CHECK_INTERVAL, 
-        [](HWND hwnd, UINT, UINT_PTR timerId, DWORD) {
-            SignupPanel* panel = reinterpret_cast<SignupPanel*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-            if (panel && LocationService::getInstance().isLocationAvailable()) {
-                panel->m_locationInfo = LocationService::getInstance().getCachedLocationInfo();
-                panel->UpdateLocationDisplay();
-                KillTimer(hwnd, timerId); // Stop checking once we have the location
+    // Subscribe to location snapshots; the current one arrives right away
+    // and later ones only when detection or a refresh publishes a change
+    HWND hwnd = m_hwnd;
+    std::shared_ptr<TaskQueue> queue = m_locationTasks;
+    m_locationSubscription = LocationService::getInstance().subscribe(
+        [this](const LocationInfo& info) {
+            m_locationInfo = info;
+            UpdateLocationDisplay();
+        },
+        [hwnd, queue](std::function<void()> task) {
+            // Marshal the update onto the panel's thread; the message only
+            // says there is work, the task stays in the queue
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->tasks.push_back(std::move(task));
             }
-    });
+            PostMessageW(hwnd, WM_LOCATION_TASK, 0, 0);
+        });
+}
+
+void SignupPanel::RunLocationTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_locationTasks->mutex);
+        tasks.swap(m_locationTasks->tasks);
+    }
+    for (const auto& task : tasks) {
+        task();
+    }
+}
+
+void SignupPanel::ReleaseLocation() {
+    if (m_locationSubscription != 0) {
+        LocationService::getInstance().unsubscribe(m_locationSubscription);
+        m_locationSubscription = 0;
+    }
 }
 
 void SignupPanel::UpdateLocationDisplay() {
@@ -31,51 +56,94 @@ void SignupPanel::UpdateLocationDisplay() {
         return;
     }
 
-    // Create location text
-    std::wstring locationText;
-    LocationInfo info = m_locationInfo;
+    // Build both labels into reused buffers; this runs once per snapshot
+    const LocationInfo& info = m_locationInfo;
 
     // Add IP Address
-    locationText = L"IP Address: " + std::wstring(info.ip.begin(), info.ip.end()) + L"\n";
+    m_locationText = L"IP Address: ";
+    if (info.ip.isValid()) {
+        char ip[IpAddress::MAX_TEXT_LENGTH];
+        appendUtf8AsWide(std::string_view(ip, info.ip.format(ip)), m_locationText);
+    } else {
+        m_locationText += L"Detecting...";
+    }
 
     // Add Location
-    locationText += L"Location: ";
-    if (info.city != "Detecting..." && info.city != "Unknown") {
-        locationText += std::wstring(info.city.begin(), info.city.end()) + L", ";
-    }
-    if (info.region != "Detecting..." && info.region != "Unknown") {
-        locationText += std::wstring(info.region.begin(), info.region.end()) + L" ";
-        if (!info.region_code.empty()) {
-            locationText += L"(" + std::wstring(info.region_code.begin(), info.region_code.end()) + L"), ";
-        }
-    }
-    locationText += std::wstring(info.country.begin(), info.country.end());
-    if (!info.country_code.empty()) {
-        locationText += L" (" + std::wstring(info.country_code.begin(), info.country_code.end()) + L")";
+    m_locationText += L"\nLocation: ";
+    switch (info.state) {
+        case LocationState::Detecting:
+        case LocationState::AddressKnown:
+            m_locationText += L"Detecting...";
+            break;
+        case LocationState::Unresolved:
+            m_locationText += L"Unknown";
+            break;
+        case LocationState::Resolved:
+            if (!info.city.empty()) {
+                appendUtf8AsWide(info.city.view(), m_locationText);
+                m_locationText += L", ";
+            }
+            if (!info.region.empty()) {
+                appendUtf8AsWide(info.region.view(), m_locationText);
+                m_locationText += L" ";
+                if (!info.region_code.empty()) {
+                    m_locationText += L"(";
+                    appendUtf8AsWide(info.region_code.view(), m_locationText);
+                    m_locationText += L"), ";
+                }
+            }
+            if (info.country.empty()) {
+                m_locationText += L"Unknown";
+            } else {
+                appendUtf8AsWide(info.country.view(), m_locationText);
+            }
+            if (!info.country_code.empty()) {
+                m_locationText += L" (";
+                appendUtf8AsWide(info.country_code.view(), m_locationText);
+                m_locationText += L")";
+            }
+            break;
     }
 
     // Add Timezone
-    if (info.timezone != "Detecting..." && info.timezone != "Unknown") {
-        locationText += L"\nTimezone: " + std::wstring(info.timezone.begin(), info.timezone.end());
+    if (!info.timezone.empty()) {
+        m_locationText += L"\nTimezone: ";
+        appendUtf8AsWide(info.timezone.view(), m_locationText);
     }
 
     // Add Coordinates
     if (info.latitude != 0.0 || info.longitude != 0.0) {
-        std::wstringstream coords;
-        coords.precision(6);
-        coords << L"\nCoordinates: " << info.latitude << L", " << info.longitude;
-        locationText += coords.str();
+        wchar_t coords[64];
+        swprintf(coords, 64, L"\nCoordinates: %.6g, %.6g", info.latitude, info.longitude);
+        m_locationText += coords;
     }
     
     // Create currency text
-    std::wstring currencyText = L"Currency: ";
-    currencyText += std::wstring(info.currency.begin(), info.currency.end());
+    m_currencyText = L"Currency: ";
+    appendUtf8AsWide(info.currency.view(), m_currencyText);
     if (!info.currency_symbol.empty()) {
-        currencyText += L" (" + std::wstring(info.currency_symbol.begin(), info.currency_symbol.end()) + L")";
+        m_currencyText += L" (";
+        appendUtf8AsWide(info.currency_symbol.view(), m_currencyText);
+        m_currencyText += L")";
+    }
+
+    // Price in the local currency when a rate is known, else in dollars
+    Money price = PaymentService::subscriptionPrice();
+    Money localPrice;
+    m_currencyText += L"  Price: ";
+    if (info.currency.view() != price.currencyCode() &&
+        ExchangeRateService::getInstance().convert(price, info.currency.view(), localPrice)) {
+        appendUtf8AsWide(localPrice.format(), m_currencyText);
+        m_currencyText += L" (";
+        appendUtf8AsWide(price.format(), m_currencyText);
+        m_currencyText += L") / month";
+    } else {
+        appendUtf8AsWide(price.format(), m_currencyText);
+        m_currencyText += L" / month";
     }
     
-    SetWindowTextW(m_locationLabel, locationText.c_str());
-    SetWindowTextW(m_currencyLabel, currencyText.c_str());
+    SetWindowTextW(m_locationLabel, m_locationText.c_str());
+    SetWindowTextW(m_currencyLabel, m_currencyText.c_str());
 }
 
 void SignupPanel::ValidateAndSubmit() {
@@ -83,10 +151,10 @@ void SignupPanel::ValidateAndSubmit() {
     int textLength = GetWindowTextLengthW(m_emailEdit) + 1;
     std::vector<wchar_t> buffer(textLength);
     GetWindowTextW(m_emailEdit, buffer.data(), textLength);
-    std::wstring email(buffer.data());
 
-    // Convert wstring to string for the auth manager
-    std::string emailStr(email.begin(), email.end());
+    // The auth manager works in UTF-8
+    std::string emailStr;
+    wideToUtf8(std::wstring_view(buffer.data()), emailStr);
 
     // Register user
     if (AuthenticationManager::getInstance().registerUser(emailStr)) {
@@ -108,12 +176,14 @@ SignupPanel::SignupPanel()
     , m_locationLabel(nullptr)
     , m_currencyLabel(nullptr)
     , m_isVisible(false)
+    , m_locationSubscription(0)
+    , m_locationTasks(std::make_shared<TaskQueue>())
 {
 }
 
 SignupPanel::~SignupPanel() {
+    ReleaseLocation();
     if (m_hwnd) {
-        KillTimer(m_hwnd, LOCATION_TIMER_ID);
         DestroyWindow(m_hwnd);
     }
 }
@@ -269,8 +339,12 @@ LRESULT SignupPanel::HandleMessage(HWND hwnd, UINT message, WPARAM wParam, LPARA
             break;
         }
 
+        case WM_LOCATION_TASK:
+            RunLocationTasks();
+            return 0;
+
         case WM_DESTROY:
-            KillTimer(hwnd, LOCATION_TIMER_ID);
+            ReleaseLocation();
             break;
     }
     return DefWindowProcW(hwnd, message, wParam, lParam);
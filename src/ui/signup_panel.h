@@ -2,6 +2,11 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <string>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "../auth/auth.h"
 #include "../services/location_service.h"
 
@@ -24,8 +29,19 @@ public:
     // Location handling
     void InitializeLocation();
     void UpdateLocationDisplay();
+    void ReleaseLocation();
 
 private:
+    // Location updates waiting for the panel's thread. Shared with the
+    // dispatcher, so updates still queued when the window goes away are
+    // freed with the queue rather than lost in the message queue.
+    struct TaskQueue {
+        std::mutex mutex;
+        std::vector<std::function<void()>> tasks;
+    };
+
+    void RunLocationTasks();
+
     // Window message handlers
     void OnCommand(WPARAM wParam, LPARAM lParam);
     void ValidateAndSubmit();
@@ -46,6 +62,10 @@ private:
     std::wstring m_statusText;
     bool m_isVisible;
     LocationInfo m_locationInfo;
+    std::wstring m_locationText;
+    std::wstring m_currencyText;
+    uint64_t m_locationSubscription;
+    std::shared_ptr<TaskQueue> m_locationTasks;
 
     // UI Constants
     static const int EDIT_HEIGHT = 25;
@@ -0,0 +1,332 @@
+// CapturePipeline, FramePool and FrameRing driven by a scripted
+// FrameSource that captures, times out, fails or ends exactly when told.
+// Frames must reach every ring in order with their sequence and stats;
+// a full ring must drop its oldest frames and count them; consumers
+// holding the whole pool must stall capture without losing a frame; the
+// source ending must close every ring, including later ones; a ring
+// unsubscribed while frames are published must get nothing afterwards;
+// and stop() must join the capture thread promptly however it is blocked.
+// Built with ThreadSanitizer where the compiler supports it.
+//
+//   capture_pipeline_test [rounds]
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "capture_pipeline.h"
+#include "test_check.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Step {
+        CaptureStatus status;
+        uint32_t missed;
+    };
+
+    Step frame(uint32_t missed = 0) {
+        return Step{CaptureStatus::Captured, missed};
+    }
+
+    // Plays script, then ends, or captures forever if endless. A gated
+    // source only takes a step for each permit the test hands out, and
+    // times out meanwhile. Frame n (from 1) has n in its first pixel and
+    // was presented at n ms.
+    class ScriptedFrameSource : public FrameSource {
+    public:
+        ScriptedFrameSource(std::vector<Step> script, bool endless, bool gated)
+            : m_script(std::move(script)), m_endless(endless), m_gated(gated) {}
+
+        CaptureStatus capture(FrameBuffer& target, FrameInfo& info, std::chrono::milliseconds timeout) override {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_calls;
+            if (m_gated) {
+                if (!m_permitted.wait_for(lock, timeout, [this]() { return m_permits > 0; })) {
+                    return CaptureStatus::Timeout;
+                }
+                --m_permits;
+            }
+            Step step = m_next < m_script.size() ? m_script[m_next] : m_endless ? frame() : Step{CaptureStatus::Ended, 0};
+            ++m_next;
+            if (step.status != CaptureStatus::Captured) {
+                return step.status;
+            }
+
+            uint32_t marker = ++m_frames;
+            target.allocate(8, 4);
+            std::memset(target.data(), 0, target.stride() * target.height());
+            std::memcpy(target.row(0), &marker, sizeof(marker));
+            info.presentTimeUs = int64_t(marker) * 1000;
+            info.missedFrames = step.missed;
+            info.regions.full = true;
+            return CaptureStatus::Captured;
+        }
+
+        void permit(uint32_t steps) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_permits += steps;
+            }
+            m_permitted.notify_one();
+        }
+
+        uint32_t frames() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_frames;
+        }
+
+        uint64_t calls() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_calls;
+        }
+
+    private:
+        std::vector<Step> m_script;
+        bool m_endless;
+        bool m_gated;
+        std::mutex m_mutex;
+        std::condition_variable m_permitted;
+        uint32_t m_permits = 0;
+        size_t m_next = 0;
+        uint32_t m_frames = 0;
+        uint64_t m_calls = 0;
+    };
+
+    uint32_t marker(const FrameHandle& frame) {
+        uint32_t value;
+        std::memcpy(&value, frame.buffer().row(0), sizeof(value));
+        return value;
+    }
+
+    template <typename Condition>
+    bool waitUntil(Condition condition) {
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (!condition() && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return condition();
+    }
+
+    // Pops until the ring is closed and drained
+    std::vector<FrameHandle> drain(FrameRing& ring) {
+        std::vector<FrameHandle> frames;
+        FrameHandle frame;
+        while (ring.pop(frame, std::chrono::seconds(10))) {
+            frames.push_back(std::move(frame));
+        }
+        return frames;
+    }
+
+    struct Pipeline {
+        ScriptedFrameSource* source;
+        std::unique_ptr<CapturePipeline> pipeline;
+    };
+
+    Pipeline makePipeline(std::vector<Step> script, bool endless, bool gated, size_t poolSize,
+                          std::chrono::milliseconds bufferWait = std::chrono::milliseconds(5)) {
+        auto source = std::make_unique<ScriptedFrameSource>(std::move(script), endless, gated);
+        ScriptedFrameSource* raw = source.get();
+        CapturePipelineConfig config;
+        config.poolSize = poolSize;
+        config.captureTimeout = std::chrono::milliseconds(20);
+        config.bufferWait = bufferWait;
+        return Pipeline{raw, std::make_unique<CapturePipeline>(std::move(source), config)};
+    }
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 3;
+
+    // The ring on its own: once full, each push drops the oldest frame and
+    // returns it to the pool straight away
+    {
+        FramePool pool(8);
+        FrameRing ring(3);
+        for (uint32_t n = 1; n <= 5; ++n) {
+            FrameHandle handle = pool.acquire();
+            handle.writableBuffer().allocate(8, 4);
+            std::memcpy(handle.writableBuffer().row(0), &n, sizeof(n));
+            CHECK(ring.push(std::move(handle)));
+        }
+        FrameRingStats stats = ring.stats();
+        CHECK(stats.pushed == 5 && stats.dropped == 2 && stats.popped == 0);
+        CHECK(pool.available() == 5);
+        FrameHandle popped;
+        for (uint32_t n = 3; n <= 5; ++n) {
+            CHECK(ring.pop(popped, std::chrono::milliseconds(0)) && marker(popped) == n);
+        }
+        popped.reset();
+        CHECK(!ring.pop(popped, std::chrono::milliseconds(1)));
+        CHECK(pool.available() == 8);
+        ring.close();
+        CHECK(!ring.push(pool.acquire()));
+        CHECK(pool.available() == 8);
+    }
+
+    // Every status reaches the stats; frames come in order to every ring,
+    // and the end closes them all, even one subscribed afterwards
+    {
+        Pipeline p = makePipeline({frame(), frame(), frame(), {CaptureStatus::Timeout, 0},
+                                   {CaptureStatus::Error, 0}, frame(2), frame(), {CaptureStatus::Ended, 0}},
+                                  false, false, 12);
+        std::shared_ptr<FrameRing> rings[] = {p.pipeline->subscribe(8), p.pipeline->subscribe(8)};
+        CHECK(p.pipeline->start());
+        CHECK(!p.pipeline->start());
+        for (const auto& ring : rings) {
+            std::vector<FrameHandle> frames = drain(*ring);
+            CHECK(frames.size() == 5);
+            for (size_t i = 0; i < frames.size(); ++i) {
+                CHECK(frames[i].info().sequence == i + 1 && marker(frames[i]) == i + 1);
+                CHECK(frames[i].info().presentTimeUs == int64_t(i + 1) * 1000);
+                CHECK(i == 0 || frames[i].info().captureTimeUs >= frames[i - 1].info().captureTimeUs);
+            }
+            CHECK(frames.size() == 5 && frames[3].info().missedFrames == 2);
+            CHECK(ring->closed());
+        }
+        CHECK(waitUntil([&]() { return !p.pipeline->running(); }));
+        CapturePipelineStats stats = p.pipeline->stats();
+        CHECK(stats.captured == 5 && stats.sourceMissed == 2 && stats.timeouts == 1 && stats.errors == 1);
+        CHECK(stats.ended && stats.lastPresentTimeUs == 5000 && stats.consumerDrops == 0 && stats.bufferStalls == 0);
+        CHECK(p.pipeline->subscribe(4)->closed());
+        p.pipeline->stop();
+    }
+
+    // A consumer that never pops keeps the newest frames; the rest are
+    // counted as its drops, and another consumer is unaffected
+    {
+        std::vector<Step> script(9, frame());
+        Pipeline p = makePipeline(script, false, false, 12);
+        std::shared_ptr<FrameRing> slow = p.pipeline->subscribe(2);
+        std::shared_ptr<FrameRing> fast = p.pipeline->subscribe(9);
+        CHECK(p.pipeline->start());
+        CHECK(waitUntil([&]() { return !p.pipeline->running(); }));
+        CapturePipelineStats stats = p.pipeline->stats();
+        CHECK(stats.captured == 9 && stats.consumerDrops == 7);
+        FrameRingStats slowStats = slow->stats();
+        CHECK(slowStats.pushed == 9 && slowStats.dropped == 7);
+        std::vector<FrameHandle> kept = drain(*slow);
+        CHECK(kept.size() == 2 && kept[0].info().sequence == 8 && kept[1].info().sequence == 9);
+        CHECK(drain(*fast).size() == 9 && fast->stats().dropped == 0);
+    }
+
+    // Consumers holding every pooled frame stall capture rather than
+    // dropping: the source is not asked for more until a frame comes back
+    {
+        std::vector<Step> script(10, frame());
+        Pipeline p = makePipeline(script, false, false, 3);
+        std::shared_ptr<FrameRing> ring = p.pipeline->subscribe(3);
+        CHECK(p.pipeline->start());
+        CHECK(waitUntil([&]() { return p.pipeline->stats().bufferStalls >= 3; }));
+        CHECK(p.pipeline->stats().captured == 3 && p.source->calls() == 3);
+        FrameHandle held;
+        CHECK(ring->pop(held, std::chrono::seconds(1)) && held.info().sequence == 1);
+        CHECK(p.pipeline->stats().captured == 3);
+        held.reset();
+        CHECK(waitUntil([&]() { return p.pipeline->stats().captured == 4; }));
+
+        uint64_t expected = 2;
+        FrameHandle next;
+        while (ring->pop(next, std::chrono::seconds(10))) {
+            CHECK(next.info().sequence == expected);
+            ++expected;
+            next.reset();
+        }
+        CHECK(expected == 11);
+        CapturePipelineStats stats = p.pipeline->stats();
+        CHECK(stats.ended && stats.captured == 10 && stats.consumerDrops == 0);
+    }
+
+    // Rings subscribed and unsubscribed while frames are being published.
+    // Once unsubscribe() returns the ring is closed and gets nothing more;
+    // steady consumers keep seeing frames in order.
+    for (int round = 0; round < rounds; ++round) {
+        Pipeline p = makePipeline({}, true, false, 16);
+        std::shared_ptr<FrameRing> steady[] = {p.pipeline->subscribe(4), p.pipeline->subscribe(4)};
+        std::vector<std::thread> consumers;
+        for (const auto& ring : steady) {
+            consumers.emplace_back([ring]() {
+                uint64_t last = 0;
+                FrameHandle frame;
+                while (ring->pop(frame, std::chrono::seconds(10))) {
+                    CHECK(frame.info().sequence > last);
+                    last = frame.info().sequence;
+                }
+            });
+        }
+        CHECK(p.pipeline->start());
+        for (int i = 0; i < 200; ++i) {
+            std::shared_ptr<FrameRing> ring = p.pipeline->subscribe(1 + i % 3);
+            if (i % 2 == 0) {
+                std::this_thread::yield();
+            }
+            FrameHandle frame;
+            ring->pop(frame, std::chrono::milliseconds(0));
+            frame.reset();
+            p.pipeline->unsubscribe(ring);
+            uint64_t pushed = ring->stats().pushed;
+            bool closed = ring->closed();
+            CHECK(closed && !ring->push(FrameHandle()));
+            std::this_thread::yield();
+            CHECK(ring->stats().pushed == pushed);
+            if (closed) {
+                drain(*ring);
+            }
+        }
+        CHECK(p.pipeline->stats().captured > 0);
+        p.pipeline->stop();
+        for (std::thread& consumer : consumers) {
+            consumer.join();
+        }
+        for (const auto& ring : steady) {
+            CHECK(ring->closed());
+        }
+    }
+
+    // stop() joins promptly whether capture is waiting on the source, on
+    // the pool, or running flat out, closes the rings, and may be repeated;
+    // the pipeline can then start again
+    {
+        Pipeline waiting = makePipeline({}, true, true, 4);
+        std::shared_ptr<FrameRing> ring = waiting.pipeline->subscribe(2);
+        CHECK(waiting.pipeline->start());
+        waiting.source->permit(1);
+        FrameHandle first;
+        CHECK(ring->pop(first, std::chrono::seconds(10)) && first.info().sequence == 1);
+        CHECK(waitUntil([&]() { return waiting.pipeline->stats().timeouts >= 2; }));
+        auto stopping = Clock::now();
+        waiting.pipeline->stop();
+        CHECK(Clock::now() - stopping < std::chrono::seconds(1));
+        CHECK(!waiting.pipeline->running() && ring->closed());
+        waiting.pipeline->stop();
+
+        CHECK(waiting.pipeline->start());
+        std::shared_ptr<FrameRing> again = waiting.pipeline->subscribe(2);
+        waiting.source->permit(1);
+        FrameHandle second;
+        CHECK(again->pop(second, std::chrono::seconds(10)) && second.info().sequence == 2);
+        waiting.pipeline->stop();
+
+        Pipeline stalled = makePipeline({}, true, false, 2, std::chrono::milliseconds(200));
+        std::shared_ptr<FrameRing> holder = stalled.pipeline->subscribe(2);
+        CHECK(stalled.pipeline->start());
+        CHECK(waitUntil([&]() { return stalled.pipeline->stats().bufferStalls >= 1; }));
+        stopping = Clock::now();
+        stalled.pipeline->stop();
+        CHECK(Clock::now() - stopping < std::chrono::seconds(1));
+        CHECK(holder->closed() && drain(*holder).size() == 2);
+
+        // With no consumer holding frames, destroying it stops it too
+        Pipeline flatOut = makePipeline({}, true, false, 4);
+        CHECK(flatOut.pipeline->start());
+        CHECK(waitUntil([&]() { return flatOut.source->frames() >= 100; }));
+        stopping = Clock::now();
+        flatOut.pipeline.reset();
+        CHECK(Clock::now() - stopping < std::chrono::seconds(1));
+    }
+    return testResult();
+}
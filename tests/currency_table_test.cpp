@@ -0,0 +1,107 @@
+// Checks the generated currency table against the generator's source data,
+// and the lookup LocationService makes before going to the network.
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include "currency_lookup.h"
+#include "test_check.h"
+
+struct Row {
+    std::string code;
+    std::string symbol;
+    int minorUnits;
+};
+
+// country -> row, from the CSV gen_currency_table.py reads
+static bool loadSource(const char* path, std::map<std::string, Row>& rows) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first = line.find(',');
+        size_t second = line.find(',', first + 1);
+        size_t last = line.rfind(',');
+        if (first == std::string::npos || second == std::string::npos || last <= second) {
+            return false;
+        }
+        rows[line.substr(0, first)] = Row{line.substr(first + 1, second - first - 1),
+                                          line.substr(second + 1, last - second - 1),
+                                          std::stoi(line.substr(last + 1))};
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::map<std::string, Row> rows;
+    if (argc < 2 || !loadSource(argv[1], rows)) {
+        std::fprintf(stderr, "usage: currency_table_test path/to/iso4217.csv\n");
+        return 1;
+    }
+    CHECK(rows.size() == CURRENCY_TABLE_SIZE);
+
+    // Every two-letter code: the ones in the source resolve to their row,
+    // all others to nothing, in either case
+    size_t found = 0;
+    for (char a = 'A'; a <= 'Z'; ++a) {
+        for (char b = 'A'; b <= 'Z'; ++b) {
+            std::string country{a, b};
+            std::string lower{static_cast<char>(a - 'A' + 'a'), static_cast<char>(b - 'A' + 'a')};
+            const CurrencyInfo* info = findCurrencyByCountry(country);
+            CHECK(findCurrencyByCountry(lower) == info);
+            auto row = rows.find(country);
+            if (row == rows.end()) {
+                CHECK(info == nullptr);
+                continue;
+            }
+            ++found;
+            CHECK(info != nullptr);
+            if (!info) {
+                continue;
+            }
+            CHECK(info->countryCode == country);
+            CHECK(info->code == row->second.code);
+            CHECK(info->symbol == row->second.symbol);
+            CHECK(info->minorUnits == row->second.minorUnits);
+            const CurrencyUnit* unit = findCurrencyUnit(row->second.code);
+            CHECK(unit != nullptr && unit->minorUnits == row->second.minorUnits);
+        }
+    }
+    CHECK(found == rows.size());
+
+    // Malformed codes
+    CHECK(findCurrencyByCountry("") == nullptr);
+    CHECK(findCurrencyByCountry("U") == nullptr);
+    CHECK(findCurrencyByCountry("USA") == nullptr);
+    CHECK(findCurrencyByCountry("U1") == nullptr);
+    CHECK(findCurrencyUnit("usd") != nullptr);
+    CHECK(findCurrencyUnit("XYZ") == nullptr);
+
+    // LocationService's no-network path
+    LocationInfo info;
+    CHECK(applyTableCurrency(CountryCode("JP"), info));
+    CHECK(info.currency.view() == "JPY");
+    CHECK(info.currency_symbol.view() == "\xC2\xA5");
+
+    LocationInfo euro;
+    CHECK(applyTableCurrency(CountryCode("de"), euro));
+    CHECK(euro.currency.view() == "EUR");
+
+    // Unknown and empty codes leave the US dollar default for the network
+    // lookup to replace
+    LocationInfo unknown;
+    CHECK(!applyTableCurrency(CountryCode("ZZ"), unknown));
+    CHECK(!applyTableCurrency(CountryCode(), unknown));
+    CHECK(unknown.currency.view() == "USD");
+    CHECK(unknown.currency_symbol.view() == "$");
+
+    return testResult();
+}
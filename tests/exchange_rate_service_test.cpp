@@ -0,0 +1,129 @@
+// ExchangeRateService::convert with rates loaded from JSON: exact results
+// through the base currency and between two others, every rounding mode
+// at a half of a yen, currencies with 0 and 3 decimals, unknown rates,
+// results past int64_t, and files that must be refused without touching
+// the rates in force. Readers then convert while a writer reloads two
+// tables in turn; every result must come from one table or the other,
+// never from a mix. Built with ThreadSanitizer where the compiler
+// supports it.
+//
+//   exchange_rate_service_test [reloads]
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include "exchange_rate_service.h"
+#include "test_check.h"
+
+namespace {
+    ExchangeRateService& service() {
+        return ExchangeRateService::getInstance();
+    }
+
+    // amount converted to currency with mode, as minor units; -1 when the
+    // conversion fails
+    int64_t converted(int64_t minor, const char* from, const char* to, RoundingMode mode = RoundingMode::HalfEven) {
+        Money out(-1, to);
+        return service().convert(Money(minor, from), to, out, mode) ? out.minorUnits() : -1;
+    }
+
+    std::string ratesJson(const std::string& rates) {
+        return "{\"base\": \"USD\", \"timestamp\": 1700000000, \"rates\": {" + rates + "}}";
+    }
+}
+
+int main(int argc, char** argv) {
+    int reloads = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    CHECK(service().loadJson(ratesJson("\"EUR\": 0.9213, \"GBP\": 0.79, \"JPY\": 149.5, \"BHD\": 0.376, "
+                                       "\"XYZ\": 2, \"CHF\": \"n/a\"")));
+    uint64_t loaded = service().version();
+
+    // Through the base and between two other currencies, exactly
+    CHECK(converted(10000, "USD", "EUR") == 9213);
+    CHECK(converted(9213, "EUR", "USD") == 10000);
+    CHECK(converted(9213, "EUR", "GBP") == 7900);
+    CHECK(converted(100, "USD", "BHD") == 376);
+    CHECK(converted(376, "BHD", "USD") == 100);
+    CHECK(converted(12345, "USD", "USD") == 12345);
+
+    // 1.00 USD is 149.5 yen; 1.01 USD is 150.995
+    CHECK(converted(100, "USD", "JPY", RoundingMode::HalfEven) == 150);
+    CHECK(converted(100, "USD", "JPY", RoundingMode::HalfUp) == 150);
+    CHECK(converted(100, "USD", "JPY", RoundingMode::Down) == 149);
+    CHECK(converted(100, "USD", "JPY", RoundingMode::Up) == 150);
+    CHECK(converted(100, "USD", "JPY", RoundingMode::Floor) == 149);
+    CHECK(converted(100, "USD", "JPY", RoundingMode::Ceiling) == 150);
+    CHECK(converted(-100, "USD", "JPY", RoundingMode::HalfEven) == -150);
+    CHECK(converted(-100, "USD", "JPY", RoundingMode::Floor) == -150);
+    CHECK(converted(-100, "USD", "JPY", RoundingMode::Ceiling) == -149);
+    CHECK(converted(-100, "USD", "JPY", RoundingMode::Down) == -149);
+    CHECK(converted(101, "USD", "JPY", RoundingMode::Down) == 150);
+    CHECK(converted(101, "USD", "JPY", RoundingMode::HalfEven) == 151);
+
+    // Rates that are missing, not numbers, or for no currency we know
+    CHECK(!service().hasRate("CHF"));
+    CHECK(!service().hasRate("XYZ"));
+    CHECK(service().hasRate("JPY"));
+    CHECK(converted(100, "USD", "CHF") == -1);
+    CHECK(converted(100, "CHF", "USD") == -1);
+    Money untouched(5, "USD");
+    CHECK(!service().convert(Money(100, "USD"), "XYZ", untouched) && untouched.minorUnits() == 5);
+
+    // Results past int64_t fail instead of wrapping
+    const int64_t MAX = std::numeric_limits<int64_t>::max();
+    CHECK(converted(MAX, "USD", "JPY") == -1);
+    CHECK(converted(std::numeric_limits<int64_t>::min(), "USD", "JPY") == -1);
+    CHECK(converted(MAX, "JPY", "USD") > 0);
+
+    // Refused files leave the rates and version as they were
+    for (const std::string& text : {std::string("{\"base\": \"USD\", \"rates\": {\"EUR\": 0.5"),
+                                    std::string("{\"base\": \"XYZ\", \"rates\": {\"EUR\": 0.5}}"),
+                                    std::string("{\"base\": \"USD\"}"), ratesJson("\"EUR\": 0"),
+                                    ratesJson("\"EUR\": -1"), ratesJson("\"EUR\": 1e300"),
+                                    ratesJson("\"EUR\": 0.5, \"GBP\": 0")}) {
+        CHECK(!service().loadJson(text));
+    }
+    CHECK(service().version() == loaded);
+    CHECK(converted(10000, "USD", "EUR") == 9213);
+
+    // A half yen rounds to even
+    CHECK(service().loadJson(ratesJson("\"JPY\": 148.5")));
+    CHECK(converted(100, "USD", "JPY") == 148);
+    CHECK(!service().hasRate("EUR"));
+    CHECK(service().version() == loaded + 1);
+
+    // Two tables in which a pound is always two euros but a euro is worth
+    // a different number of dollars. A reader that mixed them would get
+    // 1.33 or 3.00 pounds for a euro.
+    const std::string tables[] = {ratesJson("\"EUR\": 2, \"GBP\": 4"), ratesJson("\"EUR\": 3, \"GBP\": 6")};
+    CHECK(service().loadJson(tables[0]));
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> wrong{0};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&]() {
+            while (!done.load(std::memory_order_acquire)) {
+                wrong += converted(100, "EUR", "GBP") == 200 ? 0 : 1;
+                wrong += converted(200, "GBP", "EUR") == 100 ? 0 : 1;
+                ++reads;
+            }
+        });
+    }
+    uint64_t before = service().version();
+    for (int i = 0; i < reloads; ++i) {
+        CHECK(service().loadJson(tables[(i + 1) % 2]));
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    CHECK(wrong == 0);
+    CHECK(service().version() == before + uint64_t(reloads));
+    std::printf("%llu conversions during %d reloads\n", static_cast<unsigned long long>(reads.load()), reloads);
+    return testResult();
+}
@@ -0,0 +1,316 @@
+// FrameEncoder, FrameDecoder, the frame archive and the LZ block coder.
+// Streams of random sizes with random tile sizes, keyframe intervals and
+// dictionary sizes must decode to exactly the frames encoded, in order
+// and from the archive in any order. Corrupted packets must be rejected
+// or decoded without touching memory they don't own, and decoding must
+// recover at the next keyframe. Built with ASan and UBSan.
+//
+//   frame_codec_test [iterations]
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "frame_archive.h"
+#include "frame_codec.h"
+#include "lz_block.h"
+#include "synthetic_frame_source.h"
+#include "test_check.h"
+
+namespace {
+    std::mt19937 rng(20240612);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    struct Recorded {
+        std::unique_ptr<FrameBuffer> frame;
+        FrameInfo info;
+    };
+
+    bool sameFrame(const FrameBuffer& a, const FrameBuffer& b) {
+        if (a.width() != b.width() || a.height() != b.height()) {
+            return false;
+        }
+        for (uint32_t y = 0; y < a.height(); ++y) {
+            if (std::memcmp(a.row(y), b.row(y), size_t(a.width()) * 4) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void copyFrame(const FrameBuffer& from, FrameBuffer& to) {
+        to.allocate(from.width(), from.height());
+        for (uint32_t y = 0; y < from.height(); ++y) {
+            std::memcpy(to.row(y), from.row(y), size_t(from.width()) * 4);
+        }
+    }
+
+    // Noise in a random rectangle, which LZ can't shrink, so its tiles are
+    // Stored
+    void addNoise(FrameBuffer& frame, FrameInfo& info) {
+        uint32_t left = between(0, frame.width() - 1);
+        uint32_t top = between(0, frame.height() - 1);
+        uint32_t right = between(left + 1, frame.width());
+        uint32_t bottom = between(top + 1, frame.height());
+        for (uint32_t y = top; y < bottom; ++y) {
+            for (uint32_t x = left * 4; x < right * 4; ++x) {
+                frame.row(y)[x] = static_cast<uint8_t>(rng());
+            }
+        }
+        info.regions.dirty.push_back(FrameRect{static_cast<int32_t>(left), static_cast<int32_t>(top),
+                                               static_cast<int32_t>(right), static_cast<int32_t>(bottom)});
+    }
+
+    // A presentation that scrolls, gets scribbled on, goes back to earlier
+    // frames, skips sequence numbers and may change size halfway
+    std::vector<Recorded> makeStream(uint32_t tileSize) {
+        std::vector<Recorded> frames;
+        uint32_t count = between(8, 40);
+        uint64_t sequence = 0;
+        for (int part = 0; part < (between(0, 3) == 0 ? 2 : 1); ++part) {
+            SyntheticFrameSourceConfig config;
+            config.width = between(0, 3) == 0 ? between(1, 24) : between(8, 400);
+            config.height = between(0, 3) == 0 ? between(1, 24) : between(8, 300);
+            config.slideFrames = between(3, 12);
+            static const uint32_t SCROLLS[] = {0, 0, 1, 3};
+            config.scrollPixels = between(0, 4) == 0 ? tileSize : SCROLLS[between(0, 3)];
+            config.paced = false;
+            config.seed = rng();
+            SyntheticFrameSource source(config);
+
+            // The source's regions are relative to its own last frame, so
+            // after a frame it didn't render they don't cover the change
+            bool diverged = false;
+            for (uint32_t i = 0; i < count; ++i) {
+                Recorded recorded{std::make_unique<FrameBuffer>(), FrameInfo{}};
+                if (frames.size() > 2 && between(0, 9) == 0) {
+                    // Back to an earlier picture, which the dictionary may hold
+                    const Recorded& earlier = frames[between(0, static_cast<uint32_t>(frames.size()) - 2)];
+                    if (earlier.frame->width() != config.width || earlier.frame->height() != config.height) {
+                        continue;
+                    }
+                    copyFrame(*earlier.frame, *recorded.frame);
+                    recorded.info.regions.clear();
+                    diverged = true;
+                } else {
+                    CHECK(source.capture(*recorded.frame, recorded.info, std::chrono::milliseconds(0))
+                          == CaptureStatus::Captured);
+                    if (diverged) {
+                        recorded.info.regions.clear();
+                    }
+                    diverged = !recorded.info.regions.full && between(0, 7) == 0;
+                    if (diverged) {
+                        addNoise(*recorded.frame, recorded.info);
+                    }
+                }
+                sequence += between(0, 15) == 0 ? 2 : 1;
+                recorded.info.sequence = sequence;
+                recorded.info.captureTimeUs = static_cast<int64_t>(sequence * 33333);
+                frames.push_back(std::move(recorded));
+            }
+        }
+        return frames;
+    }
+
+    FrameCodecConfig randomConfig() {
+        static const uint32_t DICTIONARIES[] = {0, 1, 4, 64, 1024};
+        FrameCodecConfig config;
+        // Sizes outside 8 to 64 are clamped by the encoder
+        config.tileSize = between(0, 9) == 0 ? between(1, 100) : between(8, 64);
+        config.keyframeInterval = between(0, 5) == 0 ? between(0, 2) : between(3, 20);
+        config.dictionaryTiles = DICTIONARIES[between(0, 4)];
+        return config;
+    }
+
+    // Flip, truncate, extend or overwrite part of a packet
+    void corrupt(std::vector<uint8_t>& packet) {
+        switch (between(0, 4)) {
+            case 0:
+                packet[between(0, static_cast<uint32_t>(packet.size()) - 1)] ^= static_cast<uint8_t>(1u << between(0, 7));
+                break;
+            case 1:
+                packet.resize(between(0, static_cast<uint32_t>(packet.size()) - 1));
+                break;
+            case 2:
+                packet.push_back(static_cast<uint8_t>(rng()));
+                break;
+            case 3:
+                // The header: flags, tile size, dictionary, distance, size
+                packet[between(0, std::min<uint32_t>(18, static_cast<uint32_t>(packet.size()) - 1))] = static_cast<uint8_t>(rng());
+                break;
+            default:
+                for (uint32_t n = between(1, 16); n > 0; --n) {
+                    packet[between(0, static_cast<uint32_t>(packet.size()) - 1)] = static_cast<uint8_t>(rng());
+                }
+                break;
+        }
+    }
+
+    void checkStream(FrameEncoderStats& totals) {
+        FrameCodecConfig config = randomConfig();
+        std::vector<Recorded> frames = makeStream(std::min(std::max(config.tileSize, 8u), 64u));
+
+        FrameEncoder encoder(config);
+        std::vector<std::vector<uint8_t>> packets(frames.size());
+        size_t keyframes = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            bool keyframe = encoder.encode(*frames[i].frame, frames[i].info, packets[i]);
+            CHECK(FrameDecoder::isKeyframe(packets[i].data(), packets[i].size()) == keyframe);
+            keyframes += keyframe ? 1 : 0;
+        }
+        CHECK(FrameDecoder::isKeyframe(packets[0].data(), packets[0].size()));
+
+        // In order
+        FrameDecoder decoder;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            CHECK(decoder.decode(packets[i].data(), packets[i].size()));
+            CHECK(sameFrame(decoder.frame(), *frames[i].frame));
+            CHECK(decoder.info().sequence == frames[i].info.sequence);
+            CHECK(decoder.info().presentTimeUs == frames[i].info.presentTimeUs);
+            CHECK(decoder.info().captureTimeUs == frames[i].info.captureTimeUs);
+        }
+
+        // One damaged packet: rejected or decoded within bounds, then
+        // nothing but a keyframe is accepted until decoding is back on track
+        size_t damaged = between(0, static_cast<uint32_t>(frames.size()) - 1);
+        std::vector<uint8_t> bad = packets[damaged];
+        corrupt(bad);
+        FrameDecoder recovering;
+        bool lost = false;
+        bool trusted = true;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const std::vector<uint8_t>& packet = i == damaged ? bad : packets[i];
+            bool keyframe = FrameDecoder::isKeyframe(packets[i].data(), packets[i].size());
+            bool decoded = recovering.decode(packet.data(), packet.size());
+            if (i == damaged) {
+                lost = !decoded;
+                trusted = false;
+                continue;
+            }
+            if (keyframe) {
+                CHECK(decoded);
+                lost = false;
+                trusted = true;
+            } else if (lost) {
+                CHECK(!decoded);
+            }
+            if (trusted) {
+                CHECK(decoded && sameFrame(recovering.frame(), *frames[i].frame));
+            }
+        }
+
+        // Through the archive, in random order
+        std::string path = (std::filesystem::temp_directory_path() / "frame_codec_test.mafa").string();
+        {
+            FrameArchiveWriter writer;
+            CHECK(writer.open(path, config));
+            for (const Recorded& recorded : frames) {
+                CHECK(writer.write(*recorded.frame, recorded.info));
+            }
+        }
+        FrameArchiveReader reader;
+        CHECK(reader.open(path));
+        CHECK(reader.frameCount() == frames.size());
+        CHECK(reader.keyframeCount() == keyframes);
+        FrameBuffer frame;
+        FrameInfo info;
+        for (size_t n = 0; n < frames.size(); ++n) {
+            size_t index = between(0, static_cast<uint32_t>(frames.size()) - 1);
+            CHECK(reader.read(index, frame, info));
+            CHECK(sameFrame(frame, *frames[index].frame));
+            CHECK(info.sequence == frames[index].info.sequence);
+        }
+        CHECK(!reader.read(frames.size(), frame, info));
+        std::filesystem::remove(path);
+
+        const FrameEncoderStats& stats = encoder.stats();
+        totals.frames += stats.frames;
+        totals.keyframes += stats.keyframes;
+        totals.sameTiles += stats.sameTiles;
+        totals.referenceTiles += stats.referenceTiles;
+        totals.literalTiles += stats.literalTiles;
+        totals.storedTiles += stats.storedTiles;
+    }
+
+    void checkLzBlock() {
+        // Runs, repeats and noise in random proportions
+        size_t size = between(0, 3) == 0 ? between(0, 64) : between(0, static_cast<uint32_t>(LZ_MAX_BLOCK));
+        std::vector<uint8_t> input(size);
+        uint32_t noise = between(0, 100);
+        for (size_t i = 0; i < size;) {
+            size_t run = std::min<size_t>(size - i, between(1, 300));
+            uint32_t kind = between(0, 99);
+            if (kind < noise) {
+                for (size_t k = 0; k < run; ++k) {
+                    input[i + k] = static_cast<uint8_t>(rng());
+                }
+            } else if (kind % 2 == 0 || i == 0) {
+                std::memset(&input[i], static_cast<int>(rng() & 0xff), run);
+            } else {
+                size_t from = between(0, static_cast<uint32_t>(i) - 1);
+                for (size_t k = 0; k < run; ++k) {
+                    input[i + k] = input[from + k];   // May overlap, like a match
+                }
+            }
+            i += run;
+        }
+
+        std::vector<uint8_t> block(lzCompressBound(size));
+        size_t compressed = lzCompress(input.data(), size, block.data(), block.size());
+        CHECK(compressed != 0 || size == 0);
+        block.resize(compressed);
+        std::vector<uint8_t> output(size);
+        CHECK(lzDecompress(block.data(), block.size(), output.data(), size));
+        CHECK(output == input);
+
+        // The exact size is required
+        std::vector<uint8_t> larger(size + 1);
+        CHECK(!lzDecompress(block.data(), block.size(), larger.data(), larger.size()));
+        if (size > 0) {
+            CHECK(!lzDecompress(block.data(), block.size(), output.data(), size - 1));
+        }
+        if (compressed > 1) {
+            CHECK(lzCompress(input.data(), size, block.data(), compressed - 1) == 0);
+        }
+
+        // Damage must never read or write out of bounds; ASan checks that
+        if (!block.empty()) {
+            std::vector<uint8_t> damaged = block;
+            for (uint32_t n = between(1, 4); n > 0; --n) {
+                damaged[between(0, static_cast<uint32_t>(damaged.size()) - 1)] = static_cast<uint8_t>(rng());
+            }
+            lzDecompress(damaged.data(), damaged.size(), output.data(), size);
+
+            // A block cut short can only still succeed if all it lost was
+            // a final token with no literals
+            if (lzDecompress(block.data(), block.size() - 1, output.data(), size)) {
+                CHECK(block.back() == 0 && output == input);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    for (int i = 0; i < iterations; ++i) {
+        checkLzBlock();
+    }
+
+    FrameEncoderStats totals = {};
+    for (int i = 0; i < iterations; ++i) {
+        checkStream(totals);
+    }
+    std::printf("%llu frames, %llu keyframes; tiles: %llu same, %llu reference, %llu literal, %llu stored\n",
+                static_cast<unsigned long long>(totals.frames), static_cast<unsigned long long>(totals.keyframes),
+                static_cast<unsigned long long>(totals.sameTiles), static_cast<unsigned long long>(totals.referenceTiles),
+                static_cast<unsigned long long>(totals.literalTiles), static_cast<unsigned long long>(totals.storedTiles));
+    // Every coding must have been exercised for the round trips to mean much
+    CHECK(totals.sameTiles > 0 && totals.referenceTiles > 0 && totals.literalTiles > 0 && totals.storedTiles > 0);
+    return testResult();
+}
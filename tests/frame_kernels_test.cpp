@@ -0,0 +1,167 @@
+// Every SIMD kernel this CPU can run against the scalar reference, over
+// random sizes, strides and buffer alignments. Outputs must match byte for
+// byte, and nothing outside the output rectangle may be written.
+//
+//   frame_kernels_test [iterations]
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+#include "frame_kernels.h"
+#include "test_check.h"
+
+namespace {
+    const uint8_t GUARD = 0xa5;
+    const size_t GUARD_BYTES = 64;
+
+    std::mt19937 rng(20240611);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    // A plane of rows x stride bytes that starts at a random offset inside
+    // its allocation and is surrounded by guard bytes
+    struct Plane {
+        std::vector<uint8_t> storage;
+        uint8_t* data;
+        size_t stride;
+        size_t rows;
+
+        Plane(size_t rowBytes, size_t rows)
+            : stride(rowBytes + between(0, 40))
+            , rows(rows)
+        {
+            size_t offset = GUARD_BYTES + between(0, 63);
+            storage.assign(offset + stride * rows + GUARD_BYTES, GUARD);
+            data = storage.data() + offset;
+        }
+
+        // A copy points into its own storage at the same offset
+        Plane(const Plane& other)
+            : storage(other.storage)
+            , data(storage.data() + (other.data - other.storage.data()))
+            , stride(other.stride)
+            , rows(other.rows)
+        {
+        }
+
+        void fill() {
+            // Mostly random bytes, with runs of extremes that push the
+            // fixed-point arithmetic to its limits
+            for (size_t i = 0; i < stride * rows; ++i) {
+                uint32_t pick = between(0, 15);
+                data[i] = pick == 0 ? 0 : (pick == 1 ? 255 : static_cast<uint8_t>(rng()));
+            }
+        }
+    };
+
+    bool sameBytes(const Plane& a, const Plane& b) {
+        return a.storage.size() == b.storage.size() && a.data - a.storage.data() == b.data - b.storage.data()
+            && std::memcmp(a.storage.data(), b.storage.data(), a.storage.size()) == 0;
+    }
+
+    // An output plane for the reference and a byte-identical copy for the
+    // kernel under test
+    std::pair<Plane, Plane> outputPair(size_t rowBytes, size_t rows) {
+        Plane expected(rowBytes, rows);
+        return {expected, expected};
+    }
+
+    void checkSumAbsDiff(const KernelTable& reference, const KernelTable& simd) {
+        uint32_t rowBytes = between(0, 4) == 0 ? between(1, 70) : between(1, 3000);
+        uint32_t rows = between(1, 24);
+        Plane a(rowBytes, rows);
+        Plane b(rowBytes, rows);
+        a.fill();
+        b.fill();
+        CHECK(simd.sumAbsDiff(a.data, a.stride, b.data, b.stride, rowBytes, rows)
+              == reference.sumAbsDiff(a.data, a.stride, b.data, b.stride, rowBytes, rows));
+    }
+
+    void checkBgraToGray(const KernelTable& reference, const KernelTable& simd) {
+        uint32_t width = between(0, 4) == 0 ? between(1, 40) : between(1, 700);
+        uint32_t height = between(1, 16);
+        Plane src(size_t(width) * 4, height);
+        src.fill();
+        auto out = outputPair(width, height);
+        reference.bgraToGray(src.data, src.stride, out.first.data, out.first.stride, width, height);
+        simd.bgraToGray(src.data, src.stride, out.second.data, out.second.stride, width, height);
+        CHECK(sameBytes(out.first, out.second));
+    }
+
+    void checkBgraToI420(const KernelTable& reference, const KernelTable& simd) {
+        uint32_t width = between(0, 4) == 0 ? between(1, 40) : between(1, 700);
+        uint32_t height = between(1, 17);
+        uint32_t chromaWidth = (width + 1) / 2;
+        uint32_t chromaHeight = (height + 1) / 2;
+        Plane src(size_t(width) * 4, height);
+        src.fill();
+        auto y = outputPair(width, height);
+        auto u = outputPair(chromaWidth, chromaHeight);
+        auto v = u;
+        reference.bgraToI420(src.data, src.stride, y.first.data, y.first.stride,
+                             u.first.data, v.first.data, u.first.stride, width, height);
+        simd.bgraToI420(src.data, src.stride, y.second.data, y.second.stride,
+                        u.second.data, v.second.data, u.second.stride, width, height);
+        CHECK(sameBytes(y.first, y.second));
+        CHECK(sameBytes(u.first, u.second));
+        CHECK(sameBytes(v.first, v.second));
+    }
+
+    void checkBoxDownscale(const KernelTable& reference, const KernelTable& simd) {
+        static const uint32_t FACTORS[] = {2, 4, 8};
+        uint32_t factor = FACTORS[between(0, 2)];
+        uint32_t width = between(factor, between(0, 4) == 0 ? 80 : 1500);
+        uint32_t height = between(factor, 40);
+        Plane src(width, height);
+        src.fill();
+        auto out = outputPair(width / factor, height / factor);
+        reference.boxDownscaleGray(src.data, src.stride, width, height, factor, out.first.data, out.first.stride);
+        simd.boxDownscaleGray(src.data, src.stride, width, height, factor, out.second.data, out.second.stride);
+        CHECK(sameBytes(out.first, out.second));
+    }
+
+    void checkBilinearScale(const KernelTable& reference, const KernelTable& simd) {
+        uint32_t srcWidth = between(1, 600);
+        uint32_t srcHeight = between(1, 60);
+        // Down- and upscales, including to and from a single pixel
+        uint32_t dstWidth = between(1, between(0, 1) ? srcWidth : 2 * srcWidth + 8);
+        uint32_t dstHeight = between(1, between(0, 1) ? srcHeight : 2 * srcHeight + 8);
+        Plane src(srcWidth, srcHeight);
+        src.fill();
+        auto out = outputPair(dstWidth, dstHeight);
+        reference.bilinearScaleGray(src.data, src.stride, srcWidth, srcHeight,
+                                    out.first.data, out.first.stride, dstWidth, dstHeight);
+        simd.bilinearScaleGray(src.data, src.stride, srcWidth, srcHeight,
+                               out.second.data, out.second.stride, dstWidth, dstHeight);
+        CHECK(sameBytes(out.first, out.second));
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 400;
+    const KernelTable& reference = kernelTable(KernelIsa::Scalar);
+    KernelIsa best = detectKernelIsa();
+    std::printf("CPU supports %s\n", kernelIsaName(best));
+
+    for (KernelIsa isa : {KernelIsa::Sse41, KernelIsa::Avx2}) {
+        if (isa > best) {
+            std::printf("%s: not supported, skipped\n", kernelIsaName(isa));
+            continue;
+        }
+        const KernelTable& simd = kernelTable(isa);
+        CHECK(&simd != &reference);
+        int before = testFailures();
+        for (int i = 0; i < iterations; ++i) {
+            checkSumAbsDiff(reference, simd);
+            checkBgraToGray(reference, simd);
+            checkBgraToI420(reference, simd);
+            checkBoxDownscale(reference, simd);
+            checkBilinearScale(reference, simd);
+        }
+        std::printf("%s: %d iterations, %d failure(s)\n", kernelIsaName(isa), iterations, testFailures() - before);
+    }
+    return testResult();
+}
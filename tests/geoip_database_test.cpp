@@ -0,0 +1,253 @@
+// GeoIpDatabase on databases written by geoip_builder from random CSV
+// dumps of IPv4 and IPv6 ranges. Lookups at the first and last address of
+// every range, one either side of it, and random addresses must agree with
+// a binary search over the ranges; gaps and addresses outside every range
+// must miss. Truncated and damaged files must be refused. Built with ASan
+// and UBSan.
+//
+//   geoip_database_test <geoip_builder> [iterations]
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "geoip_database.h"
+#include "test_check.h"
+
+namespace {
+    struct Range {
+        GeoIpKey first;
+        GeoIpKey last;
+        std::string city;
+    };
+
+    std::mt19937_64 rng(20240607);
+
+    uint64_t between(uint64_t low, uint64_t high) {
+        return std::uniform_int_distribution<uint64_t>(low, high)(rng);
+    }
+
+    GeoIpKey plus(GeoIpKey key, uint64_t value) {
+        uint64_t lo = key.lo + value;
+        return GeoIpKey{key.hi + (lo < key.lo ? 1 : 0), lo};
+    }
+
+    GeoIpKey minusOne(GeoIpKey key) {
+        return GeoIpKey{key.hi - (key.lo == 0 ? 1 : 0), key.lo - 1};
+    }
+
+    const GeoIpKey MAX_KEY{~0ull, ~0ull};
+    const uint64_t MAPPED_HI = 0;
+    const uint64_t MAPPED_LO = 0xffff00000000ull;
+
+    std::string text(const GeoIpKey& key) {
+        uint8_t bytes[16];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<uint8_t>(key.hi >> (56 - 8 * i));
+            bytes[8 + i] = static_cast<uint8_t>(key.lo >> (56 - 8 * i));
+        }
+        return IpAddress::fromV6(bytes).toString();
+    }
+
+    // Disjoint ranges of random lengths with random gaps, some touching,
+    // over the IPv4-mapped block and the whole IPv6 space. The first and
+    // last possible addresses are included when edges is set.
+    std::vector<Range> randomRanges(size_t count, bool edges) {
+        std::vector<GeoIpKey> starts;
+        for (size_t i = 0; i < count; ++i) {
+            if (between(0, 1)) {
+                starts.push_back(GeoIpKey{MAPPED_HI, MAPPED_LO | between(0, 0xffffffffull)});
+            } else {
+                starts.push_back(GeoIpKey{between(0, ~0ull), between(0, ~0ull)});
+            }
+        }
+        if (edges) {
+            starts.push_back(GeoIpKey{0, 0});
+            starts.push_back(MAX_KEY);
+        }
+        std::sort(starts.begin(), starts.end());
+        starts.erase(std::unique(starts.begin(), starts.end(), [](const GeoIpKey& a, const GeoIpKey& b) {
+                         return a.hi == b.hi && a.lo == b.lo;
+                     }), starts.end());
+
+        std::vector<Range> ranges;
+        for (size_t i = 0; i < starts.size(); ++i) {
+            GeoIpKey limit = i + 1 < starts.size() ? minusOne(starts[i + 1]) : MAX_KEY;
+            GeoIpKey last = starts[i];
+            uint64_t pick = between(0, 3);
+            if (pick == 0) {
+                last = limit;                                   // Touches the next range
+            } else if (pick == 1 && limit.hi == last.hi) {
+                last.lo += between(0, limit.lo - last.lo) / 2;  // Leaves a gap
+            }
+            ranges.push_back(Range{starts[i], last, "city" + std::to_string(i)});
+        }
+        return ranges;
+    }
+
+    bool build(const std::string& builder, const std::vector<Range>& ranges, const std::string& path) {
+        std::string csv = path + ".csv";
+        {
+            std::ofstream out(csv);
+            out << "# first_ip,last_ip,country_code,country,region_code,region,city,zip,timezone,latitude,longitude\n";
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                out << text(ranges[i].first) << ',' << text(ranges[i].last)
+                    << ",XX,\"Country, of ranges\",R,Region," << ranges[i].city << ",0000,UTC,"
+                    << double(i % 180) - 90 << ',' << double(i % 360) - 180 << '\n';
+            }
+        }
+        std::string command = "\"" + builder + "\" \"" + csv + "\" \"" + path + "\" > " +
+#ifdef _WIN32
+                              "NUL";
+#else
+                              "/dev/null";
+#endif
+        bool built = std::system(command.c_str()) == 0;
+        std::filesystem::remove(csv);
+        return built;
+    }
+
+    // The range holding key, by binary search over the sorted ranges
+    const Range* find(const std::vector<Range>& ranges, const GeoIpKey& key) {
+        auto after = std::upper_bound(ranges.begin(), ranges.end(), key, [](const GeoIpKey& k, const Range& range) {
+            return k < range.first;
+        });
+        if (after == ranges.begin() || std::prev(after)->last < key) {
+            return nullptr;
+        }
+        return &*std::prev(after);
+    }
+
+    void checkLookup(const GeoIpDatabase& database, const std::vector<Range>& ranges, const GeoIpKey& key) {
+        GeoIpLocation location;
+        const Range* expected = find(ranges, key);
+        bool found = database.lookup(key, location);
+        CHECK(found == (expected != nullptr));
+        if (found && expected) {
+            CHECK(location.city == expected->city);
+            CHECK(location.country == "Country, of ranges");
+            CHECK(location.timezone == "UTC");
+        }
+    }
+
+    void checkDatabase(const std::string& builder, const std::string& path, size_t count, bool edges,
+                       size_t randomLookups) {
+        std::vector<Range> ranges = randomRanges(count, edges);
+        CHECK(build(builder, ranges, path));
+        GeoIpDatabase database;
+        CHECK(database.open(path));
+        CHECK(database.rangeCount() == ranges.size());
+
+        for (const Range& range : ranges) {
+            checkLookup(database, ranges, range.first);
+            checkLookup(database, ranges, range.last);
+            checkLookup(database, ranges, plus(range.last, 1));
+            checkLookup(database, ranges, minusOne(range.first));
+        }
+        for (size_t i = 0; i < randomLookups; ++i) {
+            const Range& range = ranges[between(0, ranges.size() - 1)];
+            checkLookup(database, ranges, GeoIpKey{range.first.hi, range.first.lo + between(0, 1000)});
+            checkLookup(database, ranges, GeoIpKey{between(0, ~0ull), between(0, ~0ull)});
+            checkLookup(database, ranges, GeoIpKey{MAPPED_HI, MAPPED_LO | between(0, 0xffffffffull)});
+        }
+
+        // The IpAddress overload agrees with the key one
+        IpAddress address;
+        CHECK(IpAddress::parse(text(ranges[0].first), address));
+        GeoIpLocation location;
+        CHECK(database.lookup(address, location) && location.city == ranges[0].city);
+        CHECK(!database.lookup(IpAddress(), location));
+    }
+
+    void checkDamagedFiles(const std::string& builder, const std::string& path) {
+        std::vector<Range> ranges = randomRanges(300, false);
+        CHECK(build(builder, ranges, path));
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> good((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        std::string damaged = path + ".damaged";
+        auto opens = [&](const std::vector<char>& bytes) {
+            std::ofstream(damaged, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+            GeoIpDatabase database;
+            bool opened = database.open(damaged);
+            CHECK(opened == database.isOpen());
+            GeoIpLocation location;
+            CHECK(opened || !database.lookup(ranges[0].first, location));
+            return opened;
+        };
+
+        // Every section ends inside the file, so any truncation is refused
+        CHECK(opens(good));
+        for (size_t length : {size_t(0), size_t(1), sizeof(GeoIpHeader) - 1, sizeof(GeoIpHeader),
+                              good.size() / 4, good.size() / 2, good.size() - 1}) {
+            CHECK(!opens(std::vector<char>(good.begin(), good.begin() + length)));
+        }
+        for (int i = 0; i < 50; ++i) {
+            CHECK(!opens(std::vector<char>(good.begin(), good.begin() + between(0, good.size() - 1))));
+        }
+
+        // A wrong magic or version, a section past the end, and a rank
+        // outside the records
+        GeoIpHeader header;
+        std::memcpy(&header, good.data(), sizeof(header));
+        auto withHeader = [&](const GeoIpHeader& changed) {
+            std::vector<char> bytes(good);
+            std::memcpy(bytes.data(), &changed, sizeof(changed));
+            return bytes;
+        };
+        GeoIpHeader changed = header;
+        changed.magic[0] = 'X';
+        CHECK(!opens(withHeader(changed)));
+        changed = header;
+        changed.version = GEOIP_FORMAT_VERSION + 1;
+        CHECK(!opens(withHeader(changed)));
+        changed = header;
+        changed.stringsSize += 1;
+        CHECK(!opens(withHeader(changed)));
+        changed = header;
+        changed.recordsOffset = ~0ull - 8;
+        CHECK(!opens(withHeader(changed)));
+        changed = header;
+        changed.rangeCount = 0xffffffffu;
+        CHECK(!opens(withHeader(changed)));
+
+        std::vector<char> badRank(good);
+        uint32_t rank = header.rangeCount;
+        std::memcpy(badRank.data() + header.ranksOffset + sizeof(uint32_t) * (1 + between(0, header.rangeCount - 1)),
+                    &rank, sizeof(rank));
+        CHECK(!opens(badRank));
+        std::filesystem::remove(damaged);
+
+        GeoIpDatabase missing;
+        CHECK(!missing.open(path + ".missing"));
+        GeoIpLocation location;
+        CHECK(!missing.lookup(ranges[0].first, location));
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: geoip_database_test <geoip_builder> [iterations]\n");
+        return 2;
+    }
+    std::string builder = argv[1];
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    std::string path = (std::filesystem::temp_directory_path() / "geoip_database_test.madb").string();
+
+    // Every tree shape up to a few levels, then larger databases
+    for (size_t count = 1; count <= 40; ++count) {
+        checkDatabase(builder, path, count, count % 3 == 0, 20);
+    }
+    for (int i = 0; i < iterations; ++i) {
+        checkDatabase(builder, path, between(100, 5000), i % 2 == 0, 2000);
+    }
+    checkDamagedFiles(builder, path);
+    std::filesystem::remove(path);
+    return testResult();
+}
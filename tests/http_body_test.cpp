@@ -0,0 +1,125 @@
+// HttpBody as LocationService::makeHttpRequest fills it: with and without
+// a Content-Length, in chunks of random sizes. Bodies up to MAX_HTTP_BODY
+// must arrive intact, embedded zero bytes included, and one byte more must
+// be refused without growing past the limit. Built with ASan and UBSan.
+//
+//   http_body_test [iterations]
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include "http_body.h"
+#include "test_check.h"
+
+namespace {
+    std::mt19937 rng(20240601);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    std::string randomBytes(size_t length) {
+        std::string bytes(length, '\0');
+        for (char& c : bytes) {
+            c = between(0, 7) == 0 ? '\0' : static_cast<char>(between(0, 255));
+        }
+        return bytes;
+    }
+
+    // makeHttpRequest's loop: reserve from Content-Length when there is
+    // one, then prepare and commit each chunk as the server delivers it.
+    // Returns false where makeHttpRequest gives up, leaving body empty.
+    bool receive(const std::string& sent, bool contentLength, size_t maxChunk, HttpBody& body) {
+        if (contentLength && !body.reserve(sent.size())) {
+            return false;
+        }
+        for (size_t offset = 0; offset < sent.size();) {
+            size_t available = std::min<size_t>(between(1, static_cast<uint32_t>(maxChunk)), sent.size() - offset);
+            char* dest = body.prepare(available);
+            if (!dest) {
+                body.clear();
+                return false;
+            }
+            std::memcpy(dest, sent.data() + offset, available);
+            body.commit(available);
+            offset += available;
+        }
+        return true;
+    }
+
+    void checkLimit(size_t limit) {
+        // Exactly the limit fits, with or without a Content-Length
+        std::string full = randomBytes(limit);
+        for (bool contentLength : {false, true}) {
+            HttpBody body(limit);
+            CHECK(receive(full, contentLength, 8192, body));
+            CHECK(body.view() == full);
+            CHECK(body.capacity() <= limit);
+            if (contentLength) {
+                CHECK(body.allocationCount() == (limit > 0 ? 1u : 0u));
+            }
+        }
+
+        // One byte more is refused. A Content-Length over the limit
+        // allocates nothing; a body that only turns out too long stops
+        // at the chunk that would cross the limit.
+        std::string over = randomBytes(limit + 1);
+        HttpBody announced(limit);
+        CHECK(!receive(over, true, 8192, announced));
+        CHECK(announced.allocationCount() == 0);
+        CHECK(announced.empty());
+
+        HttpBody streamed(limit);
+        CHECK(!receive(over, false, 8192, streamed));
+        CHECK(streamed.empty());
+        CHECK(streamed.capacity() <= limit);
+    }
+
+    void checkRandomBody() {
+        size_t limit = between(0, 3) == 0 ? MAX_HTTP_BODY : between(1, 70000);
+        size_t length = between(0, 4) == 0 ? limit + between(1, 3) : between(0, static_cast<uint32_t>(limit));
+        std::string sent = randomBytes(length);
+        bool contentLength = between(0, 1) != 0;
+        size_t maxChunk = between(0, 1) ? between(1, 64) : between(1, 16384);
+
+        HttpBody body(limit);
+        bool received = receive(sent, contentLength, maxChunk, body);
+        CHECK(received == (length <= limit));
+        CHECK(received ? body.view() == sent : body.empty());
+        CHECK(body.capacity() <= limit);
+        CHECK(body.size() <= body.capacity());
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 300;
+
+    // The default limit is MAX_HTTP_BODY, and a zero-length body needs no
+    // allocation
+    HttpBody empty;
+    CHECK(empty.limit() == MAX_HTTP_BODY);
+    CHECK(empty.reserve(0));
+    CHECK(!empty.reserve(MAX_HTTP_BODY + 1));
+    CHECK(empty.prepare(MAX_HTTP_BODY + 1) == nullptr);
+    CHECK(empty.allocationCount() == 0);
+
+    // Small bodies live in one minimum-size allocation, and clear() keeps it
+    HttpBody small;
+    std::string greeting("{\"ip\":\"192.0.2.1\"}\0tail", 23);
+    CHECK(receive(greeting, false, 7, small));
+    CHECK(small.view() == greeting);
+    CHECK(small.allocationCount() == 1);
+    small.clear();
+    CHECK(receive(greeting, false, 64, small));
+    CHECK(small.allocationCount() == 1);
+
+    checkLimit(1);
+    checkLimit(1000);
+    checkLimit(4097);
+    checkLimit(MAX_HTTP_BODY);
+    for (int i = 0; i < iterations; ++i) {
+        checkRandomBody();
+    }
+    return testResult();
+}
@@ -0,0 +1,172 @@
+// IpAddress parser and formatter: known cases, a round trip of every
+// corpus input, and a seeded mutation fuzzer over the corpus. On POSIX the
+// parser is also checked against inet_pton. Built with ASan and UBSan.
+//
+//   ip_address_test <corpus dir> [iterations]
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "ip_address.h"
+#include "test_check.h"
+#ifndef _WIN32
+#include <arpa/inet.h>
+#endif
+
+struct Known {
+    const char* text;
+    const char* canonical;  // nullptr when the text must be rejected
+};
+
+static const Known KNOWN[] = {
+    {"192.168.1.10", "192.168.1.10"},
+    {"0.0.0.0", "0.0.0.0"},
+    {"255.255.255.255", "255.255.255.255"},
+    {"1.2.3.256", nullptr},
+    {"01.2.3.4", nullptr},
+    {"1.2.3", nullptr},
+    {"1.2.3.4.", nullptr},
+    {" 1.2.3.4", nullptr},
+    {"::", "::"},
+    {"::1", "::1"},
+    {"2001:0DB8:0000:0000:0000:ff00:0042:8329", "2001:db8::ff00:42:8329"},
+    {"1:2:3:4:5:6:0:8", "1:2:3:4:5:6:0:8"},     // A single zero group stays
+    {"1:0:0:2:0:0:3:4", "1::2:0:0:3:4"},        // Of equal runs the first is compressed
+    {"1:0:0:0:2:0:0:0", "1::2:0:0:0"},
+    {"fe80::", "fe80::"},
+    {"::ffff:192.0.2.128", "::ffff:192.0.2.128"},
+    {"::FFFF:c000:0280", "::ffff:192.0.2.128"},
+    {"64:ff9b::198.51.100.7", "64:ff9b::c633:6407"},
+    {"0000:0000:0000:0000:0000:ffff:255.255.255.255", "::ffff:255.255.255.255"},
+    {"1::2::3", nullptr},
+    {"1:2:3:4:5:6:7:8:9", nullptr},
+    {"1:2:3:4:5:6:7", nullptr},
+    {"1:2:3:4:5:6:7::", "1:2:3:4:5:6:7:0"},
+    {"12345::1", nullptr},
+    {":1:2:3:4:5:6:7", nullptr},
+    {":::1", nullptr},
+    {"fe80::1%eth0", nullptr},
+    {"[::1]", nullptr},
+    {"::1.2.3.4:5", nullptr},
+    {"", nullptr},
+};
+
+static std::string formatted(const IpAddress& address) {
+    char text[IpAddress::MAX_TEXT_LENGTH];
+    return std::string(text, address.format(text));
+}
+
+// Whatever parses must format to text that parses to the same address and
+// formats to itself
+static void checkRoundTrip(const std::string& input) {
+    IpAddress address;
+    if (!IpAddress::parse(input, address)) {
+        return;
+    }
+    CHECK(address.isValid());
+    std::string text = formatted(address);
+    CHECK(text.size() <= IpAddress::MAX_TEXT_LENGTH);
+    IpAddress again;
+    CHECK(IpAddress::parse(text, again));
+    CHECK(again == address);
+    CHECK(formatted(again) == text);
+}
+
+#ifndef _WIN32
+// The parser accepts exactly what inet_pton accepts, with the same bytes
+static void checkAgainstInetPton(const std::string& input) {
+    if (input.find('\0') != std::string::npos) {
+        return;
+    }
+    IpAddress address;
+    bool parsed = IpAddress::parse(input, address);
+    uint8_t bytes[16];
+    bool v6 = input.find(':') != std::string::npos;
+    bool expected = inet_pton(v6 ? AF_INET6 : AF_INET, input.c_str(), bytes) == 1;
+    CHECK(parsed == expected);
+    if (parsed && expected) {
+        CHECK(std::memcmp(address.bytes.data() + (v6 ? 0 : 12), bytes, v6 ? 16 : 4) == 0);
+    }
+}
+#endif
+
+static void checkInput(const std::string& input) {
+    checkRoundTrip(input);
+#ifndef _WIN32
+    checkAgainstInetPton(input);
+#endif
+}
+
+static std::string mutate(std::string text, std::mt19937& random) {
+    static const char ALPHABET[] = "0123456789abcdefABCDEFg:.:.::%[] \0";
+    int edits = 1 + static_cast<int>(random() % 4);
+    for (int i = 0; i < edits; ++i) {
+        char c = ALPHABET[random() % (sizeof(ALPHABET) - 1)];
+        size_t at = text.empty() ? 0 : random() % (text.size() + 1);
+        switch (random() % 4) {
+            case 0:
+                text.insert(text.begin() + at, c);
+                break;
+            case 1:
+                if (at < text.size()) text[at] = c;
+                break;
+            case 2:
+                if (at < text.size()) text.erase(at, 1);
+                break;
+            default:
+                // Splice a piece of the text onto itself, which makes
+                // extra groups and octets
+                if (!text.empty()) {
+                    size_t from = random() % text.size();
+                    text.insert(at, text.substr(from, 1 + random() % 6));
+                }
+                break;
+        }
+    }
+    return text;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: ip_address_test <corpus dir> [iterations]\n");
+        return 1;
+    }
+    size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200000;
+
+    for (const Known& known : KNOWN) {
+        IpAddress address;
+        bool parsed = IpAddress::parse(known.text, address);
+        CHECK(parsed == (known.canonical != nullptr));
+        if (parsed && known.canonical) {
+            CHECK(formatted(address) == known.canonical);
+        }
+        checkInput(known.text);
+    }
+
+    std::vector<std::string> corpus;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        std::ifstream in(entry.path(), std::ios::binary);
+        corpus.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    CHECK(!corpus.empty());
+    for (const std::string& input : corpus) {
+        checkInput(input);
+    }
+
+    std::mt19937 random(20260101);
+    size_t accepted = 0;
+    for (size_t i = 0; i < iterations && !corpus.empty(); ++i) {
+        std::string input = mutate(corpus[random() % corpus.size()], random);
+        IpAddress address;
+        accepted += IpAddress::parse(input, address);
+        checkInput(input);
+        if (testFailures() > 20) {
+            break;
+        }
+    }
+    std::printf("%zu corpus inputs, %zu mutated inputs, %zu accepted\n", corpus.size(), iterations, accepted);
+    return testResult();
+}
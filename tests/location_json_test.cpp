@@ -0,0 +1,173 @@
+// decodeIpApiResponse and decodeRestCountriesCurrency against a DOM parse
+// of the same document with nlohmann::ordered_json, over the ip-api.com
+// and restcountries.com responses in the corpus. Every field the SAX
+// decoders write, and the fields bits, must match what the DOM holds for
+// it. Every prefix of each response must also be reported as incomplete
+// where the DOM parse fails, without giving a wrong currency. Built with
+// ASan and UBSan.
+//
+//   location_json_test <corpus dir>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "location_json.h"
+#include "test_check.h"
+
+using json = nlohmann::ordered_json;
+
+namespace {
+    struct Currency {
+        std::string code;
+        std::string symbol;
+    };
+
+    bool startsWith(const std::string& text, const char* prefix) {
+        return text.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+    }
+
+    // What decodeIpApiResponse should give: the top-level keys of the
+    // document, where they hold a value of the right type that fits
+    LocationDecodeResult domIpApi(const json& data, LocationInfo& info) {
+        LocationDecodeResult result{true, false, 0};
+        if (!data.is_object()) {
+            return result;
+        }
+        auto text = [&](const char* key, uint32_t bit, auto&& assign) {
+            auto it = data.find(key);
+            if (it != data.end() && it->is_string() && assign(it->template get_ref<const std::string&>())) {
+                result.fields |= bit;
+            }
+        };
+        auto interned = [&](InternedString& field) {
+            return [&field](const std::string& value) {
+                field = InternedString::intern(value);
+                return true;
+            };
+        };
+        auto code = [](auto& field) {
+            return [&field](const std::string& value) { return field.assign(value); };
+        };
+        auto number = [&](const char* key, uint32_t bit, double& field) {
+            auto it = data.find(key);
+            if (it != data.end() && it->is_number()) {
+                field = it->template get<double>();
+                result.fields |= bit;
+            }
+        };
+
+        auto status = data.find("status");
+        result.statusSuccess = status != data.end() && *status == "success";
+        text("country", LOCATION_FIELD_COUNTRY, interned(info.country));
+        text("countryCode", LOCATION_FIELD_COUNTRY_CODE, code(info.country_code));
+        text("regionName", LOCATION_FIELD_REGION, interned(info.region));
+        text("region", LOCATION_FIELD_REGION_CODE, code(info.region_code));
+        text("city", LOCATION_FIELD_CITY, interned(info.city));
+        text("zip", LOCATION_FIELD_ZIP, interned(info.zip));
+        text("timezone", LOCATION_FIELD_TIMEZONE, interned(info.timezone));
+        number("lat", LOCATION_FIELD_LATITUDE, info.latitude);
+        number("lon", LOCATION_FIELD_LONGITUDE, info.longitude);
+        return result;
+    }
+
+    // What decodeRestCountriesCurrency should give: the first currency of
+    // the first country, in document order, and its symbol if it is text
+    Currency domCurrency(const json& data) {
+        const json& country = data.is_array() && !data.empty() ? data[0] : data;
+        Currency currency;
+        auto currencies = country.is_object() ? country.find("currencies") : country.end();
+        if (currencies == country.end() || !currencies->is_object() || currencies->empty()) {
+            return currency;
+        }
+        auto first = currencies->begin();
+        currency.code = first.key();
+        if (first->is_object()) {
+            auto symbol = first->find("symbol");
+            if (symbol != first->end() && symbol->is_string()) {
+                currency.symbol = symbol->get<std::string>();
+            }
+        }
+        return currency;
+    }
+
+    bool sameLocation(const LocationInfo& a, const LocationInfo& b) {
+        return a.country == b.country && a.country_code == b.country_code && a.region == b.region &&
+               a.region_code == b.region_code && a.city == b.city && a.zip == b.zip && a.timezone == b.timezone &&
+               a.latitude == b.latitude && a.longitude == b.longitude;
+    }
+
+    void checkIpApi(const std::string& body) {
+        json data = json::parse(body, nullptr, false);
+        CHECK(!data.is_discarded());
+
+        LocationInfo sax;
+        LocationInfo dom;
+        LocationDecodeResult decoded = decodeIpApiResponse(body, sax);
+        LocationDecodeResult expected = domIpApi(data, dom);
+        CHECK(decoded.complete);
+        CHECK(decoded.statusSuccess == expected.statusSuccess);
+        CHECK(decoded.fields == expected.fields);
+        CHECK(sameLocation(sax, dom));
+
+        // A truncated body is never reported as complete
+        for (size_t length = 0; length < body.size(); ++length) {
+            std::string prefix = body.substr(0, length);
+            LocationInfo partial;
+            CHECK(decodeIpApiResponse(prefix, partial).complete == json::accept(prefix));
+        }
+    }
+
+    void checkCurrency(const std::string& body) {
+        json data = json::parse(body, nullptr, false);
+        CHECK(!data.is_discarded());
+
+        Currency expected = domCurrency(data);
+        std::string code = "stale";
+        std::string symbol = "stale";
+        CHECK(decodeRestCountriesCurrency(body, code, symbol) == !expected.code.empty());
+        CHECK(code == expected.code);
+        CHECK(symbol == expected.symbol);
+
+        // A truncated body gives the right currency or none, and a symbol
+        // only with it
+        for (size_t length = 0; length < body.size(); ++length) {
+            decodeRestCountriesCurrency(std::string_view(body).substr(0, length), code, symbol);
+            CHECK(code.empty() || code == expected.code);
+            CHECK(symbol.empty() || (!code.empty() && symbol == expected.symbol));
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: location_json_test <corpus dir>\n");
+        return 2;
+    }
+
+    size_t ipApi = 0;
+    size_t restCountries = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::string body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::string name = entry.path().filename().string();
+        if (startsWith(name, "ip_api_")) {
+            checkIpApi(body);
+            ++ipApi;
+        } else if (startsWith(name, "restcountries_")) {
+            checkCurrency(body);
+            ++restCountries;
+        }
+    }
+    CHECK(ipApi > 0 && restCountries > 0);
+
+    // Not JSON at all
+    LocationInfo info;
+    CHECK(!decodeIpApiResponse("<html>502 Bad Gateway</html>", info).complete);
+    std::string code;
+    std::string symbol;
+    CHECK(!decodeRestCountriesCurrency("", code, symbol));
+    std::printf("%zu ip-api and %zu restcountries responses\n", ipApi, restCountries);
+    return testResult();
+}
@@ -0,0 +1,131 @@
+// LocationRefresher driven by a ManualNetworkChangeSource, the way
+// LocationService uses it. Each burst of changes must give exactly one
+// refresh, and not before the burst has been quiet for the debounce
+// interval; a change during a refresh gives one more. Changes before and
+// after stop() must give none, and the refresher must start again. The
+// system source is started and stopped where the OS allows it. Built with
+// ThreadSanitizer where the compiler supports it.
+//
+//   location_refresher_test [bursts]
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "location_refresher.h"
+#include "test_check.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    // Long enough that the 1 ms gaps inside a burst never reach it
+    const std::chrono::milliseconds DEBOUNCE(200);
+
+    struct Refreshes {
+        std::mutex mutex;
+        std::vector<Clock::time_point> times;
+        std::atomic<int> holdMs{0};     // How long each refresh takes
+
+        void record() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                times.push_back(Clock::now());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(holdMs.load()));
+        }
+
+        size_t count() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return times.size();
+        }
+
+        Clock::time_point last() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return times.back();
+        }
+    };
+
+    // Reports changes 1 ms apart; returns when the last one was reported
+    Clock::time_point burst(ManualNetworkChangeSource& source, int changes) {
+        Clock::time_point last;
+        for (int i = 0; i < changes; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            last = Clock::now();
+            source.trigger();
+        }
+        return last;
+    }
+
+    bool waitFor(Refreshes& refreshes, size_t count) {
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (refreshes.count() < count && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return refreshes.count() == count;
+    }
+}
+
+int main(int argc, char** argv) {
+    int bursts = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    Refreshes refreshes;
+    auto owned = std::make_unique<ManualNetworkChangeSource>();
+    ManualNetworkChangeSource& source = *owned;
+    LocationRefresher refresher(std::move(owned), DEBOUNCE, [&]() { refreshes.record(); });
+    CHECK(refresher.start());
+    CHECK(!refresher.start());
+
+    // One refresh per burst, a full quiet interval after its last change
+    uint64_t changes = 0;
+    for (int i = 0; i < bursts; ++i) {
+        int size = 1 + i * 7;
+        Clock::time_point last = burst(source, size);
+        changes += size;
+        CHECK(waitFor(refreshes, i + 1));
+        CHECK(refreshes.last() - last >= DEBOUNCE);
+        std::this_thread::sleep_for(DEBOUNCE / 2);
+        CHECK(refreshes.count() == size_t(i + 1));
+    }
+    CHECK(refresher.changeCount() == changes);
+    CHECK(refresher.refreshCount() == uint64_t(bursts));
+
+    // A burst while a refresh runs gives exactly one more refresh after it
+    refreshes.holdMs = int(DEBOUNCE.count());
+    burst(source, 3);
+    CHECK(waitFor(refreshes, bursts + 1));
+    burst(source, 10);
+    CHECK(waitFor(refreshes, bursts + 2));
+    std::this_thread::sleep_for(DEBOUNCE * 3 / 2);
+    CHECK(refreshes.count() == size_t(bursts + 2));
+    refreshes.holdMs = 0;
+
+    // A burst cut short by stop() is dropped, stop() does not wait out the
+    // debounce interval, and later changes are not reported at all
+    burst(source, 10);
+    auto stopping = Clock::now();
+    refresher.stop();
+    CHECK(Clock::now() - stopping < DEBOUNCE);
+    burst(source, 10);
+    std::this_thread::sleep_for(DEBOUNCE * 2);
+    CHECK(refreshes.count() == size_t(bursts + 2));
+    CHECK(refresher.refreshCount() == uint64_t(bursts + 2));
+    refresher.stop();
+
+    // Started again it refreshes as before
+    CHECK(refresher.start());
+    burst(source, 5);
+    CHECK(waitFor(refreshes, bursts + 3));
+    refresher.stop();
+
+    // The OS source may be unavailable here, but must stop cleanly if it
+    // started
+    std::atomic<int> systemChanges{0};
+    auto system = createSystemNetworkChangeSource();
+    if (system->start([&]() { ++systemChanges; })) {
+        system->stop();
+    }
+    system->stop();
+    return testResult();
+}
@@ -0,0 +1,288 @@
+// Money::parse against a reference that rounds the decimal text digit by
+// digit, for every rounding mode, over random amounts in currencies with
+// 0, 2 and 3 decimals. The amounts sit on and either side of .5 of a
+// minor unit, carry up to 60 fractional digits, and reach past int64_t.
+// Money::scaled is checked the same way, and every operation that can
+// overflow must throw instead of wrapping.
+//
+//   money_test [iterations]
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "money.h"
+#include "test_check.h"
+
+namespace {
+    const RoundingMode MODES[] = {RoundingMode::HalfEven, RoundingMode::HalfUp, RoundingMode::Down,
+                                  RoundingMode::Up, RoundingMode::Floor, RoundingMode::Ceiling};
+    const char* const CURRENCIES[] = {"JPY", "USD", "BHD"};
+    const int64_t MAX = std::numeric_limits<int64_t>::max();
+    const int64_t MIN = std::numeric_limits<int64_t>::min();
+
+    std::mt19937 rng(20240615);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    // Where the dropped part lies between two minor units
+    enum class Tail { Zero, BelowHalf, Half, AboveHalf };
+
+    bool roundsAway(bool negative, bool odd, Tail tail, RoundingMode mode) {
+        if (tail == Tail::Zero) {
+            return false;
+        }
+        switch (mode) {
+            case RoundingMode::HalfEven:
+                return tail == Tail::AboveHalf || (tail == Tail::Half && odd);
+            case RoundingMode::HalfUp:
+                return tail != Tail::BelowHalf;
+            case RoundingMode::Down:
+                return false;
+            case RoundingMode::Up:
+                return true;
+            case RoundingMode::Floor:
+                return negative;
+            case RoundingMode::Ceiling:
+                return !negative;
+        }
+        return false;
+    }
+
+    // Decimal digits without leading zeros; "0" for zero
+    std::string trimmed(const std::string& digits) {
+        size_t first = digits.find_first_not_of('0');
+        return first == std::string::npos ? "0" : digits.substr(first);
+    }
+
+    std::string increment(std::string digits) {
+        for (size_t i = digits.size(); i-- > 0;) {
+            if (digits[i] != '9') {
+                ++digits[i];
+                return digits;
+            }
+            digits[i] = '0';
+        }
+        return "1" + digits;
+    }
+
+    bool notAbove(const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a <= b;
+    }
+
+    // What parse should give, worked out on the text: split the digits at
+    // the minor unit, classify the rest against a half and round
+    bool referenceParse(const std::string& text, int decimals, RoundingMode mode, int64_t& result) {
+        size_t i = 0;
+        bool negative = false;
+        if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+            negative = text[0] == '-';
+            ++i;
+        }
+        size_t point = text.find('.', i);
+        std::string whole = text.substr(i, point == std::string::npos ? std::string::npos : point - i);
+        std::string fraction = point == std::string::npos ? "" : text.substr(point + 1);
+        if (whole.empty() && fraction.empty()) {
+            return false;
+        }
+        for (char c : whole + fraction) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+        }
+
+        fraction.resize(std::max(fraction.size(), size_t(decimals)), '0');
+        std::string kept = trimmed(whole + fraction.substr(0, decimals));
+        std::string rest = fraction.substr(decimals);
+        Tail tail = Tail::Zero;
+        if (rest.find_first_not_of('0') != std::string::npos) {
+            bool laterDigits = rest.find_first_not_of('0', 1) != std::string::npos;
+            tail = rest[0] < '5' ? Tail::BelowHalf : rest[0] > '5' || laterDigits ? Tail::AboveHalf : Tail::Half;
+        }
+        if (roundsAway(negative, (kept.back() - '0') % 2 == 1, tail, mode)) {
+            kept = increment(kept);
+        }
+        if (!notAbove(kept, negative ? "9223372036854775808" : "9223372036854775807")) {
+            return false;
+        }
+        uint64_t magnitude = std::stoull(kept);
+        result = negative ? static_cast<int64_t>(uint64_t(0) - magnitude) : static_cast<int64_t>(magnitude);
+        return true;
+    }
+
+    void checkParse(const std::string& text) {
+        for (const char* currency : CURRENCIES) {
+            int decimals = findCurrencyUnit(currency)->minorUnits;
+            for (RoundingMode mode : MODES) {
+                int64_t expected = 0;
+                Money parsed(7, currency);
+                bool valid = referenceParse(text, decimals, mode, expected);
+                bool ok = Money::parse(text, currency, parsed, mode);
+                CHECK(ok == valid);
+                CHECK(ok ? parsed.minorUnits() == expected && parsed.currencyCode() == currency
+                         : parsed.minorUnits() == 7);
+                if (ok != valid || (ok && parsed.minorUnits() != expected)) {
+                    std::fprintf(stderr, "  \"%s\" %s mode %d\n", text.c_str(), currency, int(mode));
+                }
+            }
+        }
+    }
+
+    std::string randomDigits(size_t length) {
+        std::string digits;
+        for (size_t i = 0; i < length; ++i) {
+            digits += static_cast<char>('0' + between(0, 9));
+        }
+        return digits;
+    }
+
+    // Amounts up to 20 digits before the point, and fractions whose digits
+    // past the minor unit are often a half, just under or just over it
+    std::string randomAmount() {
+        std::string text = between(0, 2) == 0 ? "-" : between(0, 5) == 0 ? "+" : "";
+        text += between(0, 3) == 0 ? std::string(between(1, 3), '0') : "";
+        text += randomDigits(between(0, 3) == 0 ? between(15, 20) : between(0, 6));
+        if (between(0, 4) == 0) {
+            return text.empty() || text == "-" || text == "+" ? text + "0" : text;
+        }
+        text += '.' + randomDigits(between(0, 3));
+        switch (between(0, 5)) {
+            case 0:
+                text += "5";
+                break;
+            case 1:
+                text += "5" + std::string(between(1, 50), '0');
+                break;
+            case 2:
+                text += "5" + std::string(between(1, 50), '0') + "1";
+                break;
+            case 3:
+                text += "4" + std::string(between(1, 50), '9');
+                break;
+            case 4:
+                text += randomDigits(between(0, 60));
+                break;
+            default:
+                break;
+        }
+        return text;
+    }
+
+    // What scaled should give, for magnitudes small enough that the
+    // product fits in int64_t
+    int64_t referenceScaled(int64_t value, int64_t numerator, int64_t denominator, RoundingMode mode) {
+        int64_t product = value * numerator;
+        bool negative = product < 0;
+        int64_t magnitude = negative ? -product : product;
+        int64_t quotient = magnitude / denominator;
+        int64_t twice = 2 * (magnitude % denominator);
+        Tail tail = twice == 0 ? Tail::Zero : twice < denominator ? Tail::BelowHalf
+                                           : twice == denominator ? Tail::Half : Tail::AboveHalf;
+        quotient += roundsAway(negative, quotient % 2 == 1, tail, mode) ? 1 : 0;
+        return negative ? -quotient : quotient;
+    }
+
+    template <typename Operation>
+    bool throwsOverflow(Operation&& operation) {
+        try {
+            operation();
+        } catch (const std::overflow_error&) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    // Halves of a cent in every mode, and digits far past the 18 that
+    // used to be kept still breaking the tie
+    struct Known {
+        const char* text;
+        RoundingMode mode;
+        int64_t cents;
+    };
+    static const Known KNOWN[] = {
+        {"0.125", RoundingMode::HalfEven, 12},
+        {"0.135", RoundingMode::HalfEven, 14},
+        {"-0.125", RoundingMode::HalfEven, -12},
+        {"0.125", RoundingMode::HalfUp, 13},
+        {"-0.125", RoundingMode::HalfUp, -13},
+        {"0.125", RoundingMode::Down, 12},
+        {"-0.125", RoundingMode::Up, -13},
+        {"-0.001", RoundingMode::Floor, -1},
+        {"-0.001", RoundingMode::Ceiling, 0},
+        {"0.12500000000000000000000000001", RoundingMode::HalfEven, 13},
+        {"0.12499999999999999999999999999", RoundingMode::HalfUp, 12},
+        {"0.00000000000000000000000000001", RoundingMode::Up, 1},
+        {"92233720368547758.07", RoundingMode::HalfEven, MAX},
+        {"92233720368547758.0700000000000000000000000", RoundingMode::Up, MAX},
+        {"-92233720368547758.08", RoundingMode::HalfEven, MIN},
+        {"92233720368547758.069", RoundingMode::HalfUp, MAX},
+    };
+    for (const Known& known : KNOWN) {
+        Money parsed;
+        CHECK(Money::parse(known.text, "USD", parsed, known.mode) && parsed.minorUnits() == known.cents);
+    }
+
+    // Past int64_t, directly or by rounding, and malformed text
+    Money unchanged(5, "EUR");
+    for (const char* text : {"92233720368547758.08", "92233720368547758.071", "-92233720368547758.09",
+                             "100000000000000000000", "", "-", "+", ".", "1.2.3", "1e5", " 1", "1,00", "--1",
+                             "0x10", "1.-5"}) {
+        CHECK(!Money::parse(text, "USD", unchanged, RoundingMode::Up));
+        checkParse(text);
+    }
+    CHECK(!Money::parse("92233720368547758.071", "USD", unchanged, RoundingMode::Ceiling));
+    CHECK(Money::parse("92233720368547758.071", "USD", unchanged, RoundingMode::Floor) &&
+          unchanged.minorUnits() == MAX);
+    CHECK(!Money::parse("1.00", "XYZ", unchanged));
+    for (int i = 0; i < iterations; ++i) {
+        checkParse(randomAmount());
+    }
+
+    // scaled at and around halves, in every mode and sign
+    Money base(0, "USD");
+    for (int i = 0; i < iterations; ++i) {
+        int64_t value = int64_t(between(0, 2000000)) - 1000000;
+        int64_t numerator = int64_t(between(0, 2000)) - 1000;
+        int64_t denominator = between(0, 1) ? 2 * int64_t(between(1, 500)) : int64_t(between(1, 1000));
+        for (RoundingMode mode : MODES) {
+            Money scaled = Money(value, "USD").scaled(numerator, denominator, mode);
+            CHECK(scaled.minorUnits() == referenceScaled(value, numerator, denominator, mode));
+        }
+    }
+    CHECK(Money(MAX, "USD").scaled(MAX, MAX).minorUnits() == MAX);
+    CHECK(Money(MIN, "USD").scaled(1, 1).minorUnits() == MIN);
+
+    // Overflow throws rather than wrapping, and currencies must agree
+    Money max(MAX, "USD");
+    Money min(MIN, "USD");
+    Money cent(1, "USD");
+    CHECK(throwsOverflow([&]() { max + cent; }));
+    CHECK(throwsOverflow([&]() { min - cent; }));
+    CHECK(throwsOverflow([&]() { -min; }));
+    CHECK(throwsOverflow([&]() { max * 2; }));
+    CHECK(throwsOverflow([&]() { min * -1; }));
+    CHECK(throwsOverflow([&]() { max.scaled(3, 2); }));
+    CHECK(throwsOverflow([&]() { max.scaled(MAX, MAX - 1); }));
+
+    // Exactly MAX and a half: only rounding pushes it past int64_t
+    Money nearMax(9223372034707292160, "USD");
+    CHECK(nearMax.scaled(4294967297, 4294967296, RoundingMode::Down).minorUnits() == MAX);
+    CHECK(throwsOverflow([&]() { nearMax.scaled(4294967297, 4294967296, RoundingMode::HalfEven); }));
+    CHECK(throwsOverflow([&]() { nearMax.scaled(4294967297, 4294967296, RoundingMode::Up); }));
+    CHECK((max - cent + cent) == max);
+    CHECK((-max).minorUnits() == MIN + 1);
+    bool mismatch = false;
+    try {
+        base + Money(0, "EUR");
+    } catch (const std::invalid_argument&) {
+        mismatch = true;
+    }
+    CHECK(mismatch);
+    return testResult();
+}
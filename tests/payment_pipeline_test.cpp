@@ -0,0 +1,136 @@
+// PaymentPipeline deadlines, with a gateway that holds each charge until
+// the test lets it go. With the only worker busy, queued requests must
+// fail when their deadline passes, in deadline order and without reaching
+// the gateway, even when a later submission has the earlier deadline. A
+// request queued behind them still goes through once the worker is free,
+// and shutdown() fails whatever is left. Built with ThreadSanitizer where
+// the compiler supports it.
+//
+//   payment_pipeline_test
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "payment_pipeline.h"
+#include "test_check.h"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+namespace {
+    // Approves each charge once released, or times out at its deadline
+    class HeldGateway : public PaymentGateway {
+    public:
+        ChargeResponse charge(const ChargeRequest& request, Clock::time_point deadline) override {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_charges;
+            m_changed.notify_all();
+            if (!m_changed.wait_until(lock, deadline, [this]() { return m_released > 0; })) {
+                return ChargeResponse{ChargeStatus::TimedOut, "", "Gateway timed out"};
+            }
+            --m_released;
+            return ChargeResponse{ChargeStatus::Approved, request.transactionId, ""};
+        }
+
+        void release() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_released;
+            m_changed.notify_all();
+        }
+
+        bool waitForCharges(int count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, std::chrono::seconds(10), [&]() { return m_charges >= count; });
+        }
+
+        int charges() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_charges;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        int m_charges = 0;
+        int m_released = 0;
+    };
+
+    PaymentRequest request(const std::string& key, milliseconds timeout) {
+        PaymentRequest result;
+        result.idempotencyKey = key;
+        result.email = key + "@example.com";
+        result.amount = Money(999, "USD");
+        result.timeout = timeout;
+        return result;
+    }
+
+    // How long after submitted the result was ready, or -1 if it took
+    // longer than limit
+    double readyAfterMs(const std::shared_future<PaymentResult>& result, Clock::time_point submitted,
+                        milliseconds limit) {
+        if (result.wait_until(submitted + limit) != std::future_status::ready) {
+            return -1;
+        }
+        return std::chrono::duration<double, std::milli>(Clock::now() - submitted).count();
+    }
+}
+
+int main() {
+    auto gateway = std::make_shared<HeldGateway>();
+    PaymentPipelineConfig config;
+    config.maxConcurrency = 1;
+    PaymentPipeline pipeline(gateway, 1, config);
+
+    // The worker is held at the gateway by the first charge
+    auto busy = pipeline.submit(request("busy", std::chrono::seconds(30)));
+    CHECK(gateway->waitForCharges(1));
+
+    // Queued behind it: a later submission with an earlier deadline must
+    // not wait for the first one's
+    Clock::time_point submitted = Clock::now();
+    auto slow = pipeline.submit(request("slow", milliseconds(400)));
+    auto fast = pipeline.submit(request("fast", milliseconds(100)));
+    auto waiting = pipeline.submit(request("waiting", std::chrono::seconds(30)));
+
+    double fastMs = readyAfterMs(fast, submitted, milliseconds(5000));
+    CHECK(fastMs >= 100 && fastMs < 350);
+    CHECK(slow.wait_for(milliseconds(0)) != std::future_status::ready);
+    double slowMs = readyAfterMs(slow, submitted, milliseconds(5000));
+    CHECK(slowMs >= 400 && slowMs < 650);
+    for (const auto& expired : {fast, slow}) {
+        PaymentResult result = expired.get();
+        CHECK(!result.success && result.retryable && result.errorMessage.find("timed out") != std::string::npos);
+    }
+    CHECK(pipeline.stats().expired == 2);
+    CHECK(gateway->charges() == 1);
+    CHECK(busy.wait_for(milliseconds(0)) != std::future_status::ready);
+
+    // An expired key can be resubmitted, and queues behind the others
+    auto retried = pipeline.submit(request("fast", std::chrono::seconds(30)));
+    CHECK(retried.wait_for(milliseconds(0)) != std::future_status::ready);
+
+    // The worker is freed and goes on with what is still queued
+    gateway->release();
+    CHECK(busy.get().success);
+    CHECK(gateway->waitForCharges(2));
+    gateway->release();
+    CHECK(waiting.get().success);
+    CHECK(gateway->waitForCharges(3));
+    gateway->release();
+    CHECK(retried.get().success);
+    CHECK(gateway->charges() == 3);
+
+    // shutdown() fails what is queued, and the timer stops with it
+    auto held = pipeline.submit(request("held", std::chrono::seconds(30)));
+    CHECK(gateway->waitForCharges(4));
+    auto abandoned = pipeline.submit(request("abandoned", milliseconds(200)));
+    gateway->release();
+    pipeline.shutdown();
+    CHECK(held.get().success);
+    PaymentResult result = abandoned.get();
+    CHECK(!result.success && result.retryable);
+    PaymentPipelineStats stats = pipeline.stats();
+    CHECK(stats.expired == 2 && stats.approved == 4 && stats.submitted == 7);
+    return testResult();
+}
@@ -0,0 +1,191 @@
+// Drives PaymentService through the simulated gateway from several client
+// threads. Every purchase is double-submitted and retried until it goes
+// through, so dedupe, transient failures and concurrent payments for one
+// address all happen at once. Each address must end up extended by
+// exactly one period per purchase, and a restart must recover the same
+// expiries. Where the platform allows, a second run makes the log fail
+// part way: failed payments, retried or not, must leave no extension
+// behind, and every reported one must survive a restart.
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "payment_service.h"
+#include "test_check.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const int ADDRESSES = 40;
+static const int CLIENTS = 8;
+
+static std::string address(int i) {
+    return "load" + std::to_string(i) + "@example.com";
+}
+
+static std::shared_ptr<SimulatedPaymentGateway> gateway(uint64_t seed) {
+    SimulatedGatewayConfig config;
+    config.medianLatency = std::chrono::microseconds(300);
+    config.failureRate = 0.1;
+    config.seed = seed;
+    return std::make_shared<SimulatedPaymentGateway>(config);
+}
+
+struct Outcome {
+    std::vector<int> paid;      // Successful purchases per address
+    int failed = 0;             // Purchases that gave up
+};
+
+// Each client makes purchases for random addresses, submitting each one
+// twice and retrying retryable failures with the same key
+static Outcome purchase(PaymentService& service, int perClient, int maxAttempts, uint64_t seed) {
+    std::vector<std::vector<int>> paid(CLIENTS, std::vector<int>(ADDRESSES, 0));
+    std::vector<int> failed(CLIENTS, 0);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < CLIENTS; ++c) {
+        clients.emplace_back([&, c]() {
+            std::mt19937 random(static_cast<uint32_t>(seed * 100 + c));
+            for (int p = 0; p < perClient; ++p) {
+                int who = static_cast<int>(random() % ADDRESSES);
+                PaymentRequest request;
+                request.idempotencyKey = "purchase:" + std::to_string(seed) + ":" + std::to_string(c) + ":" +
+                                         std::to_string(p);
+                request.email = address(who);
+                request.amount = PaymentService::subscriptionPrice();
+
+                bool success = false;
+                for (int attempt = 0; attempt < maxAttempts && !success; ++attempt) {
+                    auto first = service.submitPayment(request);
+                    auto second = service.submitPayment(request);
+                    PaymentResult result = first.get();
+                    PaymentResult repeat = second.get();
+                    success = result.success && repeat.success;
+                    if (!result.retryable && !result.success) {
+                        break;
+                    }
+                }
+                if (success) {
+                    ++paid[c][who];
+                } else {
+                    ++failed[c];
+                }
+            }
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+
+    Outcome outcome;
+    outcome.paid.assign(ADDRESSES, 0);
+    for (int c = 0; c < CLIENTS; ++c) {
+        for (int i = 0; i < ADDRESSES; ++i) {
+            outcome.paid[i] += paid[c][i];
+        }
+        outcome.failed += failed[c];
+    }
+    return outcome;
+}
+
+// The first purchase for an address starts its period at its own time,
+// within [before, after]; every later one adds exactly one period
+static bool exactlyPaid(const std::vector<time_t>& recorded, const Outcome& outcome, time_t before, time_t after) {
+    for (int i = 0; i < ADDRESSES; ++i) {
+        time_t start = recorded[i] - outcome.paid[i] * PaymentService::SUBSCRIPTION_PERIOD;
+        if (outcome.paid[i] == 0 ? recorded[i] != 0 : (start < before || start > after)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<time_t> expiries(PaymentService& service) {
+    std::vector<time_t> result;
+    for (int i = 0; i < ADDRESSES; ++i) {
+        result.push_back(service.getSubscriptionExpiry(address(i)));
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const int perClient = argc > 1 ? std::stoi(argv[1]) : 150;
+    fs::path root = fs::temp_directory_path() / ("payment_load_" + std::to_string(std::random_device()()));
+
+    // Every purchase goes through exactly once
+    {
+        fs::path directory = root / "normal";
+        time_t before = std::time(nullptr);
+        auto simulated = gateway(1);
+        std::vector<time_t> recorded;
+        {
+            PaymentService service(simulated, directory.string());
+            auto start = std::chrono::steady_clock::now();
+            Outcome outcome = purchase(service, perClient, 50, 1);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            time_t after = std::time(nullptr);
+            recorded = expiries(service);
+
+            int total = 0;
+            for (int paid : outcome.paid) {
+                total += paid;
+            }
+            std::printf("%d purchases in %.2f s (%.0f/s), %llu gateway charges, %llu approved\n", total, seconds,
+                        total / seconds, static_cast<unsigned long long>(simulated->chargeCount()),
+                        static_cast<unsigned long long>(simulated->approvedCount()));
+            CHECK(outcome.failed == 0);
+            CHECK(total == CLIENTS * perClient);
+            CHECK(simulated->approvedCount() == static_cast<uint64_t>(total));
+            CHECK(exactlyPaid(recorded, outcome, before, after));
+        }
+
+        // The log recovers the same state
+        PaymentService restarted(gateway(2), directory.string());
+        CHECK(expiries(restarted) == recorded);
+    }
+
+#ifndef _WIN32
+    // The log fails part way. Records written ahead of the failure in the
+    // same batch may still be recovered, so the restart can only add.
+    {
+        fs::path directory = root / "failing";
+        time_t before = std::time(nullptr);
+        std::vector<time_t> reported;
+        int failed = 0;
+        {
+            PaymentService service(gateway(3), directory.string());
+            std::signal(SIGXFSZ, SIG_IGN);
+            rlimit previous;
+            getrlimit(RLIMIT_FSIZE, &previous);
+            rlimit limited = previous;
+            limited.rlim_cur = 4096;
+            setrlimit(RLIMIT_FSIZE, &limited);
+
+            Outcome outcome = purchase(service, perClient / 3 + 1, 3, 3);
+            setrlimit(RLIMIT_FSIZE, &previous);
+            failed = outcome.failed;
+            reported = expiries(service);
+            CHECK(exactlyPaid(reported, outcome, before, std::time(nullptr)));
+        }
+        PaymentService restarted(gateway(4), directory.string());
+        std::vector<time_t> recovered = expiries(restarted);
+        bool kept = true;
+        for (int i = 0; i < ADDRESSES; ++i) {
+            kept = kept && recovered[i] >= reported[i];
+        }
+        std::printf("%d purchases failed once the log did\n", failed);
+        CHECK(failed > 0);
+        CHECK(kept);
+    }
+#endif
+
+    std::error_code error;
+    fs::remove_all(root, error);
+    return testResult();
+}
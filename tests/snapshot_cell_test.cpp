@@ -0,0 +1,90 @@
+// Readers hammer a SnapshotCell while writers publish. Built with
+// ThreadSanitizer where the compiler supports it, so any unsynchronised
+// access between publish() and read() fails the test; the checks below
+// catch torn or out-of-order snapshots on any build.
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "snapshot_cell.h"
+#include "test_check.h"
+
+static const int WRITERS = 2;
+static const int READERS = 6;
+static const uint64_t PUBLISHES = 20000;
+
+struct Snapshot {
+    int writer = -1;
+    uint64_t sequence = 0;
+    uint64_t square = 0;    // sequence * sequence
+    std::string text;       // Decimal sequence; heap-allocated past SSO size
+};
+
+static Snapshot make(int writer, uint64_t sequence) {
+    Snapshot snapshot;
+    snapshot.writer = writer;
+    snapshot.sequence = sequence;
+    snapshot.square = sequence * sequence;
+    snapshot.text = "writer " + std::to_string(writer) + " published snapshot " + std::to_string(sequence);
+    return snapshot;
+}
+
+int main() {
+    SnapshotCell<Snapshot> cell;
+    std::atomic<int> writersDone{0};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> backwards{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < READERS; ++r) {
+        threads.emplace_back([&]() {
+            // Each writer's snapshots must appear in the order it made them
+            uint64_t last[WRITERS] = {};
+            uint64_t lastVersion = 0;
+            uint64_t count = 0;
+            while (writersDone.load(std::memory_order_acquire) < WRITERS) {
+                uint64_t version = cell.version();
+                const Snapshot& snapshot = cell.read();
+                ++count;
+                if (version < lastVersion) {
+                    ++backwards;
+                }
+                lastVersion = version;
+                if (snapshot.writer < 0) {
+                    continue;
+                }
+                if (snapshot.writer >= WRITERS || snapshot.square != snapshot.sequence * snapshot.sequence ||
+                    snapshot.text != make(snapshot.writer, snapshot.sequence).text) {
+                    ++torn;
+                    continue;
+                }
+                if (snapshot.sequence < last[snapshot.writer]) {
+                    ++backwards;
+                }
+                last[snapshot.writer] = snapshot.sequence;
+            }
+            reads += count;
+        });
+    }
+    for (int w = 0; w < WRITERS; ++w) {
+        threads.emplace_back([&, w]() {
+            for (uint64_t i = 1; i <= PUBLISHES; ++i) {
+                cell.publish(make(w, i));
+            }
+            writersDone.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::printf("%llu reads during %llu publishes\n", static_cast<unsigned long long>(reads.load()),
+                static_cast<unsigned long long>(WRITERS * PUBLISHES));
+    CHECK(torn.load() == 0);
+    CHECK(backwards.load() == 0);
+    CHECK(reads.load() > 0);
+    CHECK(cell.version() == WRITERS * PUBLISHES + 1);
+    CHECK(cell.read().sequence == PUBLISHES);
+    return testResult();
+}
@@ -0,0 +1,88 @@
+// Subscribers join a SubscriberList while a writer publishes, the way
+// LocationService::subscribe races publishLocation. Every listener must see
+// values in publish order and end on the last one. Built with
+// ThreadSanitizer where the compiler supports it.
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "snapshot_cell.h"
+#include "subscriber_list.h"
+#include "test_check.h"
+
+static const int SUBSCRIBERS = 200;
+static const uint64_t PUBLISHES = 5000;
+
+struct Seen {
+    uint64_t last = 0;
+    uint64_t calls = 0;
+    bool backwards = false;
+};
+
+int main() {
+    // A value older than one already delivered is dropped
+    {
+        SubscriberList<int> list;
+        std::vector<int> values;
+        uint64_t id = list.add([&](const int& value) { values.push_back(value); }, nullptr);
+        int newer = 2;
+        int older = 1;
+        list.notify(newer, 2);
+        list.notifyOne(id, older, 1);
+        list.notifyOne(id, newer, 2);
+        CHECK(values.size() == 1 && values[0] == 2);
+    }
+
+    SnapshotCell<uint64_t> cell;
+    SubscriberList<uint64_t> list;
+    std::vector<Seen> seen(SUBSCRIBERS);
+    std::atomic<bool> started{false};
+
+    std::thread writer([&]() {
+        while (!started.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        for (uint64_t i = 1; i <= PUBLISHES; ++i) {
+            cell.publish(i);
+            uint64_t version = 0;
+            const uint64_t& current = cell.read(version);
+            list.notify(current, version);
+        }
+    });
+
+    std::vector<std::thread> joiners;
+    for (int t = 0; t < 4; ++t) {
+        joiners.emplace_back([&, t]() {
+            started.store(true, std::memory_order_release);
+            for (int s = t; s < SUBSCRIBERS; s += 4) {
+                Seen* target = &seen[s];
+                uint64_t id = list.add([target](const uint64_t& value) {
+                    if (value < target->last) {
+                        target->backwards = true;
+                    }
+                    target->last = value;
+                    ++target->calls;
+                }, nullptr);
+                uint64_t version = 0;
+                const uint64_t& current = cell.read(version);
+                list.notifyOne(id, current, version);
+            }
+        });
+    }
+    for (std::thread& thread : joiners) {
+        thread.join();
+    }
+    writer.join();
+
+    // Reading Seen here is ordered after the last delivery by the joins
+    int stale = 0;
+    int backwards = 0;
+    for (const Seen& s : seen) {
+        stale += s.last != PUBLISHES;
+        backwards += s.backwards;
+    }
+    std::printf("%d subscribers, %d stale, %d out of order\n", SUBSCRIBERS, stale, backwards);
+    CHECK(stale == 0);
+    CHECK(backwards == 0);
+    CHECK(cell.read() == PUBLISHES);
+    return testResult();
+}
@@ -0,0 +1,217 @@
+// SubscriptionLog written by concurrent appenders and read back by
+// recover(). Every acknowledged record must come back. A log cut at any
+// byte of its last records, or with a byte of one record changed, must
+// replay exactly the records before the first damaged one. It must also
+// be truncated there, so new records follow them. Compaction must keep
+// the latest record for each address and drop expired ones. Built with
+// ASan and UBSan.
+//
+//   subscription_log_test [damaged logs]
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "subscription_log.h"
+#include "test_check.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::mt19937 rng(20240620);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    using State = std::map<std::string, SubscriptionEntry>;
+
+    SubscriptionEntry entry(size_t user, size_t payment, time_t expiry) {
+        return SubscriptionEntry{"user" + std::to_string(user) + "@example.com",
+                                 "tx" + std::to_string(user) + "-" + std::to_string(payment), expiry};
+    }
+
+    // Replays directory into a map, the way PaymentService replays it into
+    // its store; order is the list of records replayed
+    bool recover(const std::string& directory, State& state, std::vector<SubscriptionEntry>* order = nullptr) {
+        SubscriptionLog log(directory);
+        state.clear();
+        return log.recover([&](const SubscriptionEntry& e) {
+            state[e.email] = e;
+            if (order) {
+                order->push_back(e);
+            }
+        });
+    }
+
+    bool same(const SubscriptionEntry& a, const SubscriptionEntry& b) {
+        return a.email == b.email && a.transactionId == b.transactionId && a.expiry == b.expiry;
+    }
+
+    std::string readAll(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    void writeAll(const std::string& path, const std::string& data) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size());
+    }
+
+    // A log of records as written by one appender, and where each record
+    // ends in the file
+    void writeLog(const std::string& directory, const std::vector<SubscriptionEntry>& records,
+                  std::vector<size_t>& ends) {
+        fs::remove_all(directory);
+        SubscriptionLog log(directory);
+        CHECK(log.start());
+        std::string path = (fs::path(directory) / "subscriptions.wal").string();
+        for (const SubscriptionEntry& record : records) {
+            CHECK(log.append(record));
+            ends.push_back(fs::file_size(path));
+        }
+        log.stop();
+    }
+
+    // The log's records, then one more appended after recovery, must
+    // replay as the first intact records followed by the new one
+    void checkDamaged(const std::string& directory, const std::string& damaged,
+                      const std::vector<SubscriptionEntry>& records, size_t intact, size_t intactBytes) {
+        std::string path = (fs::path(directory) / "subscriptions.wal").string();
+        writeAll(path, damaged);
+
+        State state;
+        std::vector<SubscriptionEntry> order;
+        CHECK(recover(directory, state, &order));
+        CHECK(order.size() == intact);
+        for (size_t i = 0; i < order.size() && i < intact; ++i) {
+            CHECK(same(order[i], records[i]));
+        }
+        CHECK(fs::file_size(path) == intactBytes);
+
+        SubscriptionLog log(directory);
+        SubscriptionEntry later = entry(999, 0, 4000000000);
+        CHECK(log.start() && log.append(later));
+        log.stop();
+        order.clear();
+        CHECK(recover(directory, state, &order));
+        CHECK(order.size() == intact + 1 && same(order.back(), later));
+    }
+}
+
+int main(int argc, char** argv) {
+    int damagedLogs = argc > 1 ? std::atoi(argv[1]) : 200;
+    std::string directory = (fs::temp_directory_path() / "subscription_log_test").string();
+    const time_t future = std::time(nullptr) + 86400;
+
+    // Concurrent appenders; every acknowledged record is recovered, the
+    // latest per address winning
+    fs::remove_all(directory);
+    {
+        SubscriptionLog log(directory);
+        State empty;
+        CHECK(recover(directory, empty) && empty.empty());
+        CHECK(log.start());
+        std::vector<std::thread> appenders;
+        for (size_t t = 0; t < 4; ++t) {
+            appenders.emplace_back([&, t]() {
+                for (size_t i = 0; i < 100; ++i) {
+                    CHECK(log.append(entry(t * 1000 + i % 50, i, future + time_t(i))));
+                }
+            });
+        }
+        for (std::thread& appender : appenders) {
+            appender.join();
+        }
+        SubscriptionLogStats stats = log.stats();
+        CHECK(stats.records == 400 && stats.commits >= 1 && stats.commits <= 400);
+        log.stop();
+        CHECK(!log.append(entry(0, 0, future)));
+    }
+    State state;
+    CHECK(recover(directory, state));
+    CHECK(state.size() == 200);
+    for (size_t t = 0; t < 4; ++t) {
+        for (size_t user = 0; user < 50; ++user) {
+            SubscriptionEntry last = entry(t * 1000 + user, 50 + user, future + time_t(50 + user));
+            CHECK(state.count(last.email) && same(state[last.email], last));
+        }
+    }
+
+    // Cut at every byte of the last three records and at random points,
+    // and with a byte changed in the frame or payload of a random record
+    std::vector<SubscriptionEntry> records;
+    for (size_t i = 0; i < 40; ++i) {
+        records.push_back(entry(i, i, future + time_t(i)));
+    }
+    std::vector<size_t> ends;
+    writeLog(directory, records, ends);
+    std::string path = (fs::path(directory) / "subscriptions.wal").string();
+    std::string good = readAll(path);
+    CHECK(good.size() == ends.back());
+
+    auto intactBefore = [&](size_t bytes) {
+        size_t count = 0;
+        while (count < ends.size() && ends[count] <= bytes) {
+            ++count;
+        }
+        return count;
+    };
+    for (size_t cut = ends[ends.size() - 4]; cut <= good.size(); ++cut) {
+        size_t intact = intactBefore(cut);
+        checkDamaged(directory, good.substr(0, cut), records, intact, intact ? ends[intact - 1] : 0);
+    }
+    for (int i = 0; i < damagedLogs; ++i) {
+        size_t cut = between(0, static_cast<uint32_t>(good.size()));
+        size_t intact = intactBefore(cut);
+        checkDamaged(directory, good.substr(0, cut), records, intact, intact ? ends[intact - 1] : 0);
+
+        size_t record = between(0, static_cast<uint32_t>(records.size() - 1));
+        size_t start = record ? ends[record - 1] : 0;
+        size_t offset = start + between(0, static_cast<uint32_t>(ends[record] - start - 1));
+        std::string changed = good;
+        changed[offset] = static_cast<char>(changed[offset] ^ (1 << between(0, 7)));
+        checkDamaged(directory, changed, records, record, start);
+    }
+
+    // Compaction folds the log into a snapshot: expired subscriptions are
+    // dropped, the latest record per address kept, and the log emptied
+    fs::remove_all(directory);
+    const size_t users = 1000;
+    {
+        SubscriptionLog log(directory);
+        CHECK(log.start());
+        for (size_t user = users; user < users + 10; ++user) {
+            CHECK(log.append(entry(user, 0, 1000)));
+        }
+        std::vector<std::thread> appenders;
+        const size_t perThread = SubscriptionLog::SNAPSHOT_THRESHOLD / 8 + 50;
+        for (size_t t = 0; t < 8; ++t) {
+            appenders.emplace_back([&, t]() {
+                for (size_t i = 0; i < perThread; ++i) {
+                    size_t n = t * perThread + i;
+                    CHECK(log.append(entry(n % users, n, future + time_t(n % users))));
+                }
+            });
+        }
+        for (std::thread& appender : appenders) {
+            appender.join();
+        }
+        CHECK(log.stats().snapshots >= 1);
+        log.stop();
+    }
+    CHECK(fs::file_size(fs::path(directory) / "subscriptions.wal") < SubscriptionLog::SNAPSHOT_THRESHOLD * 20);
+    CHECK(recover(directory, state));
+    CHECK(state.size() == users);
+    for (size_t user = 0; user < users; ++user) {
+        auto found = state.find(entry(user, 0, 0).email);
+        CHECK(found != state.end() && found->second.expiry == future + time_t(user));
+    }
+
+    fs::remove_all(directory);
+    return testResult();
+}
@@ -0,0 +1,168 @@
+// A million subscriptions run through 65 days of an accelerated clock.
+// Even-numbered customers renew every time they are asked and odd ones
+// never do; new customers keep signing up, and reader threads keep
+// checking subscriptions. Every stage must fire exactly once per period,
+// lapsed subscriptions must be erased, renewed ones must stay active, and
+// the tables replaced as the store grows and sheds records must be freed
+// rather than kept.
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "subscription_scheduler.h"
+#include "test_check.h"
+
+static const time_t DAY = 24 * 60 * 60;
+static const time_t PERIOD = 30 * DAY;
+static const time_t START = 1800000000;
+static const time_t END = START + 65 * DAY;
+
+static std::string email(size_t i) {
+    return "customer" + std::to_string(i) + "@example.com";
+}
+
+static size_t customer(const std::string& email) {
+    return std::stoul(email.substr(8, email.find('@') - 8));
+}
+
+// First expiries are spread over a period, starting a day in
+static time_t firstExpiry(size_t i, size_t count) {
+    return START + DAY + static_cast<time_t>(i * uint64_t(PERIOD) / count);
+}
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    SubscriptionStore store;
+    std::atomic<time_t> now{START};
+    std::vector<uint32_t> reminded(count, 0);
+    std::vector<uint32_t> asked(count, 0);
+    SubscriptionScheduler* scheduler = nullptr;
+
+    SubscriptionScheduler clocked(
+        store,
+        [&](const std::vector<SubscriptionEntry>& batch) {
+            for (const SubscriptionEntry& entry : batch) {
+                ++reminded[customer(entry.email)];
+            }
+        },
+        [&](const std::vector<SubscriptionEntry>& batch) {
+            for (const SubscriptionEntry& entry : batch) {
+                size_t i = customer(entry.email);
+                ++asked[i];
+                if (i % 2 == 0) {
+                    store.put(entry.email, "renewal", entry.expiry + PERIOD);
+                    scheduler->track(entry.email, entry.expiry + PERIOD);
+                }
+            }
+        },
+        SubscriptionSchedulerConfig{}, [&]() { return now.load(); });
+    scheduler = &clocked;
+
+    for (size_t i = 0; i < count; ++i) {
+        std::string address = email(i);
+        store.put(address, "tx" + std::to_string(i), firstExpiry(i, count));
+        clocked.track(address, firstExpiry(i, count));
+    }
+    CHECK(store.size() == count);
+
+    // Readers probe tables while writers replace them
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> wrong{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&, r]() {
+            std::mt19937 random(r);
+            std::vector<std::string> block(256);
+            std::vector<std::string_view> views(block.size());
+            std::vector<uint64_t> mask(block.size() / 64);
+            while (!done.load(std::memory_order_relaxed)) {
+                for (size_t j = 0; j < block.size(); ++j) {
+                    block[j] = email(random() % count);
+                    views[j] = block[j];
+                }
+                store.activeMask(views.data(), views.size(), START, mask.data());
+                // Every subscription, renewed or not, covers the start
+                for (size_t j = 0; j < block.size(); ++j) {
+                    bool active = (mask[j / 64] >> (j % 64)) & 1;
+                    bool odd = customer(block[j]) % 2 == 1;
+                    if (!active && !(odd && store.expiry(views[j]) == 0)) {
+                        ++wrong;
+                    }
+                }
+            }
+        });
+    }
+
+    // Sign-ups grow the shards, so tables are replaced under the readers
+    size_t signups = 0;
+    size_t peakRetired = 0;
+    for (time_t t = START; t <= END; t += 60 * 60) {
+        now.store(t);
+        for (size_t j = 0; j < count / 2500 + 1; ++j, ++signups) {
+            store.put("signup" + std::to_string(signups) + "@example.com", "tx", END + PERIOD);
+        }
+        clocked.runDue();
+        size_t retired = store.retiredTables();
+        peakRetired = retired > peakRetired ? retired : peakRetired;
+    }
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    // Replay the stage rules per customer: a stage is handled at the first
+    // step at or after it is due, and skipped if its moment has passed
+    auto handledAt = [](time_t due) {
+        const time_t step = 60 * 60;
+        return due <= START ? START : START + (due - START + step - 1) / step * step;
+    };
+    uint64_t expectedReminders = 0;
+    uint64_t expectedAsked = 0;
+    bool exact = true;
+    bool stored = true;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t reminders = 0;
+        uint32_t renewals = 0;
+        time_t expiry = firstExpiry(i, count);
+        for (;;) {
+            time_t remind = handledAt(expiry - 3 * DAY);
+            time_t renew = handledAt(expiry - DAY);
+            reminders += remind <= END && remind < expiry - DAY;
+            if (renew > END) {
+                break;
+            }
+            ++renewals;
+            if (i % 2 == 1) {
+                break;
+            }
+            expiry += PERIOD;
+        }
+        exact = exact && reminded[i] == reminders && asked[i] == renewals;
+        stored = stored && store.expiry(email(i)) == (i % 2 == 0 ? expiry : 0);
+        expectedReminders += reminders;
+        expectedAsked += renewals;
+    }
+
+    SubscriptionSchedulerStats stats = clocked.stats();
+    std::printf("%zu subscriptions, %zu sign-ups: %llu reminders, %llu renewal requests, %llu expired, "
+                "%llu stale; at most %zu replaced tables held\n",
+                count, signups, static_cast<unsigned long long>(stats.reminders),
+                static_cast<unsigned long long>(stats.renewals), static_cast<unsigned long long>(stats.expired),
+                static_cast<unsigned long long>(stats.stale), peakRetired);
+    CHECK(wrong.load() == 0);
+    CHECK(exact);
+    CHECK(stored);
+    CHECK(stats.reminders == expectedReminders);
+    CHECK(stats.renewals == expectedAsked);
+    CHECK(stats.expired == count / 2);
+    CHECK(store.size() == count + signups - stats.expired);
+
+    // With no lookup in progress, the next write to a shard frees what it retired
+    for (int i = 0; i < 256; ++i) {
+        store.put("probe" + std::to_string(i) + "@example.com", "tx", END + PERIOD);
+    }
+    CHECK(store.retiredTables() == 0);
+    return testResult();
+}
@@ -0,0 +1,119 @@
+// SubscriptionStore::activeMask against one isActive() per address, over
+// batches of every length around the 64-bit words and the hashing blocks.
+// Batches mix subscribed addresses with unknown, expired, erased and
+// exactly-expiring ones. Bits past the end of a batch must be clear and
+// words past the last must not be written. Built with ASan and UBSan.
+//
+//   subscription_store_test [iterations]
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "subscription_store.h"
+#include "test_check.h"
+
+namespace {
+    const time_t NOW = 1800000000;
+    const size_t SUBSCRIBED = 20000;
+    const uint64_t GUARD = 0xa5a5a5a5a5a5a5a5ull;
+
+    std::mt19937 rng(20240612);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    std::string email(size_t i) {
+        return "customer" + std::to_string(i) + "@example.com";
+    }
+
+    // Expiries an hour either side of NOW, including NOW itself, which is
+    // no longer active, and NOW + 1, which still is
+    time_t expiryFor(size_t i) {
+        switch (i % 5) {
+        case 0:
+            return NOW;
+        case 1:
+            return NOW + 1;
+        case 2:
+            return NOW - 3600;
+        default:
+            return NOW + 3600;
+        }
+    }
+
+    void checkBatch(const SubscriptionStore& store, const std::vector<std::string>& pool, size_t count) {
+        std::vector<std::string_view> batch(count);
+        for (std::string_view& item : batch) {
+            item = pool[between(0, static_cast<uint32_t>(pool.size() - 1))];
+        }
+
+        size_t words = (count + 63) / 64;
+        std::vector<uint64_t> mask(words + 1, GUARD);
+        store.activeMask(batch.data(), count, NOW, mask.data());
+        CHECK(mask[words] == GUARD);
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bool bit = (mask[i / 64] >> (i % 64)) & 1;
+            wrong += bit != store.isActive(batch[i], NOW) ? 1 : 0;
+        }
+        CHECK(wrong == 0);
+        if (count % 64 != 0) {
+            CHECK(mask[words - 1] >> (count % 64) == 0);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 300;
+
+    // Enough subscriptions for every shard's table to have grown a few
+    // times; a tenth are then erased again
+    SubscriptionStore store;
+    for (size_t i = 0; i < SUBSCRIBED; ++i) {
+        CHECK(store.put(email(i), "tx" + std::to_string(i), expiryFor(i)));
+    }
+    for (size_t i = 2; i < SUBSCRIBED; i += 10) {
+        CHECK(store.eraseIfExpired(SubscriptionStore::hashEmail(email(i)), NOW));
+    }
+
+    // Known addresses, addresses never subscribed, and odd strings
+    std::vector<std::string> pool;
+    for (size_t i = 0; i < SUBSCRIBED; ++i) {
+        pool.push_back(email(i));
+        pool.push_back(email(SUBSCRIBED + i));
+    }
+    pool.push_back("");
+    pool.push_back(std::string(300, 'x'));
+    pool.push_back("CUSTOMER1@EXAMPLE.COM");
+
+    // Each known address by itself
+    size_t active = 0;
+    for (size_t i = 0; i < SUBSCRIBED; ++i) {
+        std::string_view one = pool[2 * i];
+        uint64_t bit = 0;
+        store.activeMask(&one, 1, NOW, &bit);
+        CHECK(bit == (store.isActive(one, NOW) ? 1u : 0u));
+        CHECK(store.isActive(one, NOW) == (expiryFor(i) > NOW && i % 10 != 2));
+        active += bit;
+    }
+    CHECK(active == SUBSCRIBED * 3 / 5);
+
+    // An empty batch writes nothing
+    uint64_t untouched = GUARD;
+    store.activeMask(nullptr, 0, NOW, &untouched);
+    CHECK(untouched == GUARD);
+
+    // Every length up to three of activeMask's 256-key blocks and a bit,
+    // then random longer ones
+    const size_t block = 256;
+    for (size_t count = 1; count <= 3 * block + 70; ++count) {
+        checkBatch(store, pool, count);
+    }
+    for (int i = 0; i < iterations; ++i) {
+        checkBatch(store, pool, between(1, 20000));
+    }
+    return testResult();
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdio>
+
+// Just enough of a test framework for the portable modules: CHECK prints
+// the failing condition and keeps going, and main returns testResult().
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                         #condition);                                             \
+            ++testFailures();                                                     \
+        }                                                                         \
+    } while (0)
+
+inline int testResult() {
+    if (testFailures() != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", testFailures());
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
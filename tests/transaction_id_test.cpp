@@ -0,0 +1,160 @@
+// TransactionIdGenerator: uniqueness under contention, ordering per
+// thread, timestamps staying on the clock at the rate the layout is sized
+// for, the text encoding, and which clock readings count as regressions.
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "test_check.h"
+#include "transaction_id.h"
+
+using Generator = TransactionIdGenerator;
+
+static const uint64_t START_MS = Generator::EPOCH_MS + 86400000ull * 365;
+
+// A million IDs a second on every lane, just under the 1024 a lane issues
+// in a millisecond before it runs ahead of the clock
+static const uint64_t IDS_PER_MS_PER_LANE = 1000;
+
+static uint64_t clockMs() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+int main(int argc, char** argv) {
+    const size_t perThread = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    // More threads than lanes on two nodes, all at full speed on the real
+    // clock, so lanes are shared and sequences overflow constantly
+    {
+        const unsigned threads = Generator::LANE_COUNT * 2;
+        Generator first(1);
+        Generator second(2);
+        std::vector<std::vector<uint64_t>> issued(threads);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                Generator& generator = t % 2 ? second : first;
+                issued[t].reserve(perThread);
+                for (size_t i = 0; i < perThread; ++i) {
+                    issued[t].push_back(generator.next());
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        std::vector<uint64_t> all;
+        bool ordered = true;
+        bool nodes = true;
+        for (unsigned t = 0; t < threads; ++t) {
+            ordered = ordered && std::is_sorted(issued[t].begin(), issued[t].end()) &&
+                      std::adjacent_find(issued[t].begin(), issued[t].end()) == issued[t].end();
+            for (uint64_t id : issued[t]) {
+                nodes = nodes && Generator::node(id) == (t % 2 ? 2u : 1u);
+            }
+            all.insert(all.end(), issued[t].begin(), issued[t].end());
+        }
+        std::sort(all.begin(), all.end());
+        CHECK(ordered);
+        CHECK(nodes);
+        CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+        CHECK(all.size() == threads * perThread);
+    }
+
+    // At the target rate on every lane, no timestamp gets ahead of the
+    // millisecond it was issued in. One thread per lane, on a clock that
+    // advances after each thread has issued its share of the millisecond.
+    {
+        Generator generator(3);
+        const uint64_t milliseconds = 2000;
+        std::vector<uint64_t> drift(Generator::LANE_COUNT, 0);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < Generator::LANE_COUNT; ++t) {
+            workers.emplace_back([&, t]() {
+                for (uint64_t ms = 0; ms < milliseconds; ++ms) {
+                    for (uint64_t i = 0; i < IDS_PER_MS_PER_LANE; ++i) {
+                        uint64_t id = generator.next(START_MS + ms);
+                        drift[t] = std::max(drift[t], Generator::timestampMs(id) - (START_MS + ms));
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        CHECK(*std::max_element(drift.begin(), drift.end()) == 0);
+        CHECK(generator.clockRegressions() == 0);
+    }
+
+    // The same on the real clock, at most the target rate in each
+    // millisecond without catching up on time the thread was descheduled:
+    // every timestamp is within a millisecond of the clock read after it
+    {
+        Generator generator(4);
+        uint64_t start = clockMs();
+        uint64_t drift = 0;
+        for (uint64_t now = start, previous = 0; now < start + 200; now = clockMs()) {
+            if (now == previous) {
+                continue;
+            }
+            previous = now;
+            for (uint64_t i = 0; i < IDS_PER_MS_PER_LANE; ++i) {
+                uint64_t timestamp = Generator::timestampMs(generator.next());
+                uint64_t after = clockMs();
+                drift = std::max(drift, timestamp > after ? timestamp - after : 0);
+            }
+        }
+        CHECK(drift <= 1);
+    }
+
+    // A burst that runs ahead of the clock is not a regression
+    {
+        Generator generator(7);
+        uint64_t previous = 0;
+        bool increasing = true;
+        for (size_t i = 0; i < 4 * (size_t(1) << Generator::SEQUENCE_BITS); ++i) {
+            uint64_t id = generator.next(START_MS);
+            increasing = increasing && id > previous;
+            previous = id;
+        }
+        CHECK(increasing);
+        CHECK(generator.clockRegressions() == 0);
+        CHECK(Generator::timestampMs(previous) > START_MS);
+
+        // The clock moving forward while IDs are still ahead of it isn't either
+        generator.next(START_MS + 1);
+        CHECK(generator.clockRegressions() == 0);
+
+        // A step back is counted once, then readings move forward again
+        uint64_t beforeStep = generator.next(START_MS + 5000);
+        uint64_t afterStep = generator.next(START_MS + 4000);
+        generator.next(START_MS + 4001);
+        CHECK(afterStep > beforeStep);
+        CHECK(generator.clockRegressions() == 1);
+        CHECK(Generator::node(afterStep) == 7);
+    }
+
+    // Layout and encoding
+    {
+        CHECK(Generator::TIME_BITS + Generator::NODE_BITS + Generator::LANE_BITS + Generator::SEQUENCE_BITS == 63);
+        Generator generator(0x3FF);
+        uint64_t id = generator.next(START_MS);
+        CHECK(Generator::timestampMs(id) == START_MS);
+        CHECK(Generator::node(id) == 0x3FF);
+        CHECK(Generator(0x1FFFF).next(START_MS) >> 63 == 0);
+
+        std::string text = Generator::encode(id);
+        uint64_t decoded = 0;
+        CHECK(text.size() == Generator::ENCODED_LENGTH);
+        CHECK(Generator::decode(text, decoded) && decoded == id);
+        CHECK(Generator::encode(id + 1) > text);
+        CHECK(!Generator::decode("TXN", decoded));
+        CHECK(!Generator::decode("TXNZ000000000000", decoded));
+        CHECK(Generator::decode("txn0000000000001", decoded) == false);
+        CHECK(Generator::decode("TXN000000000000l", decoded) && decoded == 1);
+    }
+    return testResult();
+}
@@ -0,0 +1,414 @@
+// UTF-8 <-> UTF-16 conversion: the ill-formed sequences the decoder must
+// replace or reject, and random text with runs of ASCII either side of the
+// 16-unit SIMD blocks, checked against a scalar reference. The reference
+// decoder knows nothing of lead-byte tables: it decides what a maximal
+// ill-formed subpart is from the set of prefixes of every well-formed
+// sequence. Built with ASan and UBSan.
+//
+//   utf_transcode_test [iterations]
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "test_check.h"
+#include "utf_transcode.h"
+
+namespace {
+    const char16_t REPLACEMENT = 0xFFFD;
+    const uint64_t COMPLETE = 1ull << 40;
+
+    std::mt19937 rng(20240605);
+
+    uint32_t between(uint32_t low, uint32_t high) {
+        return std::uniform_int_distribution<uint32_t>(low, high)(rng);
+    }
+
+    void appendUtf8(uint32_t codePoint, std::string& out) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    void appendUtf16(uint32_t codePoint, std::u16string& out) {
+        if (codePoint < 0x10000) {
+            out += static_cast<char16_t>(codePoint);
+        } else {
+            out += static_cast<char16_t>(0xD800 + ((codePoint - 0x10000) >> 10));
+            out += static_cast<char16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+        }
+    }
+
+    uint64_t prefixKey(const unsigned char* bytes, size_t length) {
+        uint64_t key = uint64_t(length) << 32;
+        for (size_t k = 0; k < length; ++k) {
+            key |= uint64_t(bytes[k]) << (8 * k);
+        }
+        return key;
+    }
+
+    // Every prefix of the encoding of every scalar value, sorted; complete
+    // encodings carry the COMPLETE bit
+    std::vector<uint64_t> buildPrefixes() {
+        std::vector<uint64_t> prefixes;
+        std::string encoded;
+        for (uint32_t codePoint = 0; codePoint <= 0x10FFFF; ++codePoint) {
+            if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                continue;
+            }
+            encoded.clear();
+            appendUtf8(codePoint, encoded);
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(encoded.data());
+            for (size_t length = 1; length < encoded.size(); ++length) {
+                prefixes.push_back(prefixKey(bytes, length));
+            }
+            prefixes.push_back(prefixKey(bytes, encoded.size()) | COMPLETE);
+        }
+        std::sort(prefixes.begin(), prefixes.end(), [](uint64_t a, uint64_t b) {
+            return (a & ~COMPLETE) < (b & ~COMPLETE);
+        });
+        prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+        return prefixes;
+    }
+
+    const std::vector<uint64_t>& prefixes() {
+        static const std::vector<uint64_t> table = buildPrefixes();
+        return table;
+    }
+
+    // 0 when bytes is no prefix of a well-formed sequence, 1 when it is
+    // one, 2 when it is a whole sequence
+    int prefixKind(const unsigned char* bytes, size_t length) {
+        uint64_t key = prefixKey(bytes, length);
+        auto found = std::lower_bound(prefixes().begin(), prefixes().end(), key, [](uint64_t entry, uint64_t value) {
+            return (entry & ~COMPLETE) < value;
+        });
+        if (found == prefixes().end() || (*found & ~COMPLETE) != key) {
+            return 0;
+        }
+        return (*found & COMPLETE) ? 2 : 1;
+    }
+
+    uint32_t decodeSequence(const unsigned char* bytes, size_t length) {
+        if (length == 1) {
+            return bytes[0];
+        }
+        uint32_t codePoint = bytes[0] & (0x7F >> length);
+        for (size_t k = 1; k < length; ++k) {
+            codePoint = (codePoint << 6) | (bytes[k] & 0x3F);
+        }
+        return codePoint;
+    }
+
+    // Longest prefix that could still become well-formed: a whole sequence
+    // is decoded, anything else is one maximal ill-formed subpart. Returns
+    // false at the first subpart when rejecting.
+    bool referenceUtf8ToUtf16(const std::string& in, std::u16string& out, InvalidInput policy) {
+        out.clear();
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(in.data());
+        size_t i = 0;
+        while (i < in.size()) {
+            size_t length = 0;
+            int kind = 0;
+            while (length < 4 && i + length < in.size()) {
+                int next = prefixKind(bytes + i, length + 1);
+                if (next == 0) {
+                    break;
+                }
+                kind = next;
+                ++length;
+                if (kind == 2) {
+                    break;
+                }
+            }
+            if (kind == 2) {
+                appendUtf16(decodeSequence(bytes + i, length), out);
+            } else if (policy == InvalidInput::Reject) {
+                out.clear();
+                return false;
+            } else {
+                out += REPLACEMENT;
+            }
+            i += std::max<size_t>(length, 1);
+        }
+        return true;
+    }
+
+    bool referenceUtf16ToUtf8(const std::u16string& in, std::string& out, InvalidInput policy) {
+        out.clear();
+        for (size_t i = 0; i < in.size(); ++i) {
+            uint32_t unit = in[i];
+            if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < in.size() && in[i + 1] >= 0xDC00 && in[i + 1] <= 0xDFFF) {
+                appendUtf8(0x10000 + ((unit - 0xD800) << 10) + (in[i + 1] - 0xDC00), out);
+                ++i;
+            } else if (unit >= 0xD800 && unit <= 0xDFFF) {
+                if (policy == InvalidInput::Reject) {
+                    out.clear();
+                    return false;
+                }
+                appendUtf8(REPLACEMENT, out);
+            } else {
+                appendUtf8(unit, out);
+            }
+        }
+        return true;
+    }
+
+    std::u16string decoded(const std::string& in) {
+        std::u16string out;
+        utf8ToUtf16(in, out);
+        return out;
+    }
+
+    struct KnownUtf8 {
+        const char* bytes;
+        std::u16string expected;    // With one U+FFFD per maximal ill-formed subpart
+    };
+
+    void checkKnownUtf8() {
+        const KnownUtf8 known[] = {
+            {"", u""},
+            {"abc", u"abc"},
+            {"\xC3\xA9", u"\u00E9"},
+            {"\xE2\x82\xAC", u"\u20AC"},
+            {"\xEF\xBF\xBD", u"\uFFFD"},
+            {"\xF0\x9F\x98\x80", u"\U0001F600"},
+            {"\xF4\x8F\xBF\xBF", u"\U0010FFFF"},
+            {"\xED\x9F\xBF", u"\uD7FF"},
+            {"\xEE\x80\x80", u"\uE000"},
+            // Overlong forms
+            {"\xC0\xAF", u"\uFFFD\uFFFD"},
+            {"\xC1\xBF", u"\uFFFD\uFFFD"},
+            {"\xE0\x80\xAF", u"\uFFFD\uFFFD\uFFFD"},
+            {"\xE0\x9F\xBF", u"\uFFFD\uFFFD\uFFFD"},
+            {"\xF0\x80\x80\xAF", u"\uFFFD\uFFFD\uFFFD\uFFFD"},
+            {"\xF0\x8F\xBF\xBF", u"\uFFFD\uFFFD\uFFFD\uFFFD"},
+            // Encoded surrogates
+            {"\xED\xA0\x80", u"\uFFFD\uFFFD\uFFFD"},
+            {"\xED\xBF\xBF", u"\uFFFD\uFFFD\uFFFD"},
+            {"\xED\xA0\xBD\xED\xB8\x80", u"\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD"},
+            // Past U+10FFFF, and lead bytes that can never start a sequence
+            {"\xF4\x90\x80\x80", u"\uFFFD\uFFFD\uFFFD\uFFFD"},
+            {"\xF5\x80\x80\x80", u"\uFFFD\uFFFD\uFFFD\uFFFD"},
+            {"\xF8\x88\x80\x80\x80", u"\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD"},
+            {"\xFE\xFF", u"\uFFFD\uFFFD"},
+            // Truncated: each incomplete prefix is a single subpart
+            {"\xC3", u"\uFFFD"},
+            {"\xE2\x82", u"\uFFFD"},
+            {"\xF0\x9F\x98", u"\uFFFD"},
+            {"\xF0\x9F\x98z", u"\uFFFDz"},
+            {"\xE2\x82\xC3\xA9", u"\uFFFD\u00E9"},
+            {"\x80", u"\uFFFD"},
+            {"\x80\xBF\x80", u"\uFFFD\uFFFD\uFFFD"},
+            // The example of table 3-8 in the Unicode standard
+            {"\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64",
+             u"a\uFFFD\uFFFD\uFFFDb\uFFFDc\uFFFD\uFFFDd"},
+        };
+        for (const KnownUtf8& item : known) {
+            std::string in(item.bytes);
+            std::u16string out = decoded(in);
+            CHECK(out == item.expected);
+
+            std::u16string reference;
+            referenceUtf8ToUtf16(in, reference, InvalidInput::Replace);
+            CHECK(reference == item.expected);
+
+            bool wellFormed = item.expected.find(REPLACEMENT) == std::u16string::npos || in == "\xEF\xBF\xBD";
+            std::u16string rejected = u"left over";
+            CHECK(utf8ToUtf16(in, rejected, InvalidInput::Reject) == wellFormed);
+            CHECK(wellFormed ? rejected == item.expected : rejected.empty());
+        }
+    }
+
+    void checkKnownUtf16() {
+        struct KnownUtf16 {
+            std::u16string units;
+            const char* expected;
+        };
+        const KnownUtf16 known[] = {
+            {u"abc", "abc"},
+            {u"\u00E9\u20AC", "\xC3\xA9\xE2\x82\xAC"},
+            {u"\U0001F600", "\xF0\x9F\x98\x80"},
+            {std::u16string(1, char16_t(0xD83D)), "\xEF\xBF\xBD"},
+            {std::u16string(1, char16_t(0xDE00)), "\xEF\xBF\xBD"},
+            {std::u16string{char16_t(0xDE00), char16_t(0xD83D)}, "\xEF\xBF\xBD\xEF\xBF\xBD"},
+            {std::u16string{char16_t(0xD83D), u'a'}, "\xEF\xBF\xBD" "a"},
+            {std::u16string{char16_t(0xD83D), char16_t(0xD83D), char16_t(0xDE00)}, "\xEF\xBF\xBD\xF0\x9F\x98\x80"},
+        };
+        for (const KnownUtf16& item : known) {
+            std::string out;
+            CHECK(utf16ToUtf8(item.units, out));
+            CHECK(out == item.expected);
+
+            bool wellFormed = std::string(item.expected).find("\xEF\xBF\xBD") == std::string::npos;
+            std::string rejected = "left over";
+            CHECK(utf16ToUtf8(item.units, rejected, InvalidInput::Reject) == wellFormed);
+            CHECK(wellFormed ? rejected == item.expected : rejected.empty());
+        }
+    }
+
+    void checkRawAndAppend() {
+        std::string bad = "ok\xC0\xAF";
+        std::vector<char16_t> units(maxUtf16Length(bad.size()));
+        CHECK(utf8ToUtf16(bad.data(), bad.size(), units.data(), InvalidInput::Reject) == SIZE_MAX);
+        CHECK(utf8ToUtf16(bad.data(), bad.size(), units.data()) == 4);
+
+        std::u16string lone(1, char16_t(0xDC00));
+        std::vector<char> bytes(maxUtf8Length(lone.size()));
+        CHECK(utf16ToUtf8(lone.data(), lone.size(), bytes.data(), InvalidInput::Reject) == SIZE_MAX);
+        CHECK(utf16ToUtf8(lone.data(), lone.size(), bytes.data()) == 3);
+
+        // A rejected append keeps what was there before
+        std::u16string text = u"Hello, ";
+        CHECK(appendUtf8AsUtf16("w\xC3\xB6rld", text));
+        CHECK(text == u"Hello, w\u00F6rld");
+        CHECK(!appendUtf8AsUtf16("!\xFF", text, InvalidInput::Reject));
+        CHECK(text == u"Hello, w\u00F6rld");
+        CHECK(appendUtf8AsUtf16("!\xFF", text));
+        CHECK(text == u"Hello, w\u00F6rld!\uFFFD");
+
+        // The output string's buffer is reused
+        std::u16string reused;
+        reused.reserve(256);
+        const char16_t* buffer = reused.data();
+        CHECK(utf8ToUtf16(std::string(100, 'x'), reused));
+        CHECK(reused.data() == buffer);
+    }
+
+    // A piece of text that is not ASCII: well-formed, ill-formed, or a
+    // truncated sequence
+    void appendOdd(std::string& out) {
+        static const char* const ILL_FORMED[] = {
+            "\x80", "\xBF", "\xC0\x80", "\xC2", "\xE0\x9F\x80", "\xE1\x80", "\xED\xA0\x80",
+            "\xF0\x8F\x80\x80", "\xF1\x80\x80", "\xF4\x90\x80\x80", "\xF5", "\xFF",
+        };
+        switch (between(0, 5)) {
+        case 0:
+            out += ILL_FORMED[between(0, sizeof(ILL_FORMED) / sizeof(ILL_FORMED[0]) - 1)];
+            break;
+        case 1:
+            out += static_cast<char>(between(0x80, 0xFF));
+            break;
+        case 2:
+            appendUtf8(between(0x80, 0x7FF), out);
+            break;
+        case 3:
+            appendUtf8(between(0x800, 0xD7FF), out);
+            break;
+        case 4:
+            appendUtf8(between(0xE000, 0xFFFF), out);
+            break;
+        default:
+            appendUtf8(between(0x10000, 0x10FFFF), out);
+            break;
+        }
+    }
+
+    // Runs of ASCII whose lengths sit around multiples of 16, broken up by
+    // odd pieces, so the SIMD loop both completes blocks and stops partway
+    std::string randomUtf8() {
+        std::string text;
+        uint32_t pieces = between(0, 6);
+        for (uint32_t p = 0; p < pieces; ++p) {
+            uint32_t run = between(0, 3) == 0 ? between(0, 70) : 16 * between(1, 3) + between(0, 2) - 1;
+            for (uint32_t k = 0; k < run; ++k) {
+                text += static_cast<char>(between(1, 0x7F));
+            }
+            if (between(0, 3) != 0) {
+                appendOdd(text);
+            }
+        }
+        return text;
+    }
+
+    std::u16string randomUtf16() {
+        std::u16string text;
+        uint32_t pieces = between(0, 6);
+        for (uint32_t p = 0; p < pieces; ++p) {
+            uint32_t run = between(0, 3) == 0 ? between(0, 70) : 16 * between(1, 3) + between(0, 2) - 1;
+            for (uint32_t k = 0; k < run; ++k) {
+                text += static_cast<char16_t>(between(1, 0x7F));
+            }
+            switch (between(0, 4)) {
+            case 0:
+                text += static_cast<char16_t>(between(0xD800, 0xDFFF));
+                break;
+            case 1:
+                text += static_cast<char16_t>(between(0x80, 0xD7FF));
+                break;
+            case 2:
+                appendUtf16(between(0x10000, 0x10FFFF), text);
+                break;
+            case 3:
+                // Units like 0x0141 and 0xFF41 whose low byte is ASCII
+                text += static_cast<char16_t>((between(1, 0xFF) << 8) | between(1, 0x7F));
+                break;
+            default:
+                break;
+            }
+        }
+        return text;
+    }
+
+    void checkRandomUtf8() {
+        // Start at an arbitrary offset, so blocks are misaligned too
+        size_t offset = between(0, 15);
+        std::string in = randomUtf8();
+        std::string storage = std::string(offset, '#') + in;
+        std::string_view view = std::string_view(storage).substr(offset);
+
+        for (InvalidInput policy : {InvalidInput::Replace, InvalidInput::Reject}) {
+            std::u16string expected;
+            bool accepted = referenceUtf8ToUtf16(in, expected, policy);
+            std::u16string out = u"stale";
+            CHECK(utf8ToUtf16(view, out, policy) == accepted);
+            CHECK(out == expected);
+        }
+
+        // Whatever comes out is well-formed and survives the way back
+        std::u16string units = decoded(in);
+        std::string again;
+        CHECK(utf16ToUtf8(units, again, InvalidInput::Reject));
+        CHECK(decoded(again) == units);
+    }
+
+    void checkRandomUtf16() {
+        std::u16string in = randomUtf16();
+        for (InvalidInput policy : {InvalidInput::Replace, InvalidInput::Reject}) {
+            std::string expected;
+            bool accepted = referenceUtf16ToUtf8(in, expected, policy);
+            std::string out = "stale";
+            CHECK(utf16ToUtf8(in, out, policy) == accepted);
+            CHECK(out == expected);
+            if (accepted && policy == InvalidInput::Reject) {
+                CHECK(decoded(out) == in);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+    checkKnownUtf8();
+    checkKnownUtf16();
+    checkRawAndAppend();
+    for (int i = 0; i < iterations; ++i) {
+        checkRandomUtf8();
+        checkRandomUtf16();
+    }
+    std::printf("%d random inputs each way\n", iterations);
+    return testResult();
+}
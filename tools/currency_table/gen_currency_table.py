@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""Generate src/services/currency_table.h from iso4217.csv.
+
+Usage: python gen_currency_table.py [input.csv] [output.h]
+"""
+import csv
+import os
+import string
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_INPUT = os.path.join(HERE, "iso4217.csv")
+DEFAULT_OUTPUT = os.path.join(HERE, "..", "..", "src", "services", "currency_table.h")
+
+
+def c_string(text):
+    """Encode text as a C++ literal with non-ASCII bytes escaped, so the
+    header compiles the same regardless of the compiler's source charset."""
+    parts = []
+    current = ""
+    escaped = False
+    for byte in text.encode("utf-8"):
+        ch = chr(byte)
+        if byte >= 0x80:
+            current += "\\x%02X" % byte
+            escaped = True
+            continue
+        if escaped and ch in string.hexdigits:
+            # Split the literal so the digit is not read as part of the escape
+            parts.append(current)
+            current = ""
+        if ch in "\\\"":
+            current += "\\"
+        current += ch
+        escaped = False
+    parts.append(current)
+    return " ".join('"%s"' % part for part in parts)
+
+
+def load(path):
+    rows = []
+    with open(path, encoding="utf-8", newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].startswith("#"):
+                continue
+            country, code, symbol, minor = (field.strip() for field in row)
+            if len(country) != 2 or len(code) != 3 or not minor.isdigit():
+                sys.exit("bad row: %r" % row)
+            rows.append((country, code, symbol, int(minor)))
+
+    countries = [row[0] for row in rows]
+    if len(set(countries)) != len(countries):
+        sys.exit("duplicate country codes in %s" % path)
+    return sorted(rows)
+
+
+def units(rows):
+    """One entry per currency code, with the symbol of its first country."""
+    found = {}
+    for country, code, symbol, minor in rows:
+        if code not in found:
+            found[code] = (code, symbol, minor)
+        elif found[code][2] != minor:
+            sys.exit("%s has conflicting minor units" % code)
+    return sorted(found.values())
+
+
+def main():
+    source = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_INPUT
+    target = sys.argv[2] if len(sys.argv) > 2 else DEFAULT_OUTPUT
+    rows = load(source)
+
+    lines = []
+    for country, code, symbol, minor in rows:
+        comment = "  // %s" % symbol if any(ord(c) > 0x7F for c in symbol) else ""
+        lines.append('    {"%s", "%s", %s, %d},%s' % (country, code, c_string(symbol), minor, comment))
+
+    unit_rows = units(rows)
+    unit_lines = []
+    for code, symbol, minor in unit_rows:
+        comment = "  // %s" % symbol if any(ord(c) > 0x7F for c in symbol) else ""
+        unit_lines.append('    {"%s", %s, %d},%s' % (code, c_string(symbol), minor, comment))
+
+    text = (HEADER.replace("@ENTRIES@", "\n".join(lines))
+                  .replace("@COUNT@", str(len(rows)))
+                  .replace("@UNITS@", "\n".join(unit_lines))
+                  .replace("@UNIT_COUNT@", str(len(unit_rows))))
+    with open(os.path.normpath(target), "w", encoding="utf-8", newline="\r\n") as out:
+        out.write(text)
+
+
+HEADER = """\
+// Generated by tools/currency_table/gen_currency_table.py from iso4217.csv.
+// Do not edit by hand.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+struct CurrencyInfo {
+    std::string_view countryCode;   // ISO 3166-1 alpha-2
+    std::string_view code;          // ISO 4217
+    std::string_view symbol;        // UTF-8
+    uint8_t minorUnits;
+};
+
+inline constexpr CurrencyInfo CURRENCY_TABLE[] = {
+@ENTRIES@
+};
+
+inline constexpr size_t CURRENCY_TABLE_SIZE = @COUNT@;
+
+// Each currency once, sorted by code
+struct CurrencyUnit {
+    std::string_view code;          // ISO 4217
+    std::string_view symbol;        // UTF-8
+    uint8_t minorUnits;
+};
+
+inline constexpr CurrencyUnit CURRENCY_UNITS[] = {
+@UNITS@
+};
+
+inline constexpr size_t CURRENCY_UNIT_COUNT = @UNIT_COUNT@;
+
+namespace currency_detail {
+    // Two upper-case letters map one-to-one onto 26 * 26 slots, which makes
+    // the slot number a collision-free hash of the country code; three
+    // letters do the same for currency codes
+    constexpr size_t SLOT_COUNT = 26 * 26;
+    constexpr size_t CODE_SLOT_COUNT = 26 * 26 * 26;
+
+    constexpr int slotOf(std::string_view code, size_t length = 2) {
+        if (code.size() != length) {
+            return -1;
+        }
+        int slot = 0;
+        for (char c : code) {
+            if (c >= 'a' && c <= 'z') {
+                c = static_cast<char>(c - 'a' + 'A');
+            }
+            if (c < 'A' || c > 'Z') {
+                return -1;
+            }
+            slot = slot * 26 + (c - 'A');
+        }
+        return slot;
+    }
+
+    static_assert(CURRENCY_TABLE_SIZE < 255, "slot index entries are 8-bit");
+
+    struct SlotIndex {
+        uint8_t entries[SLOT_COUNT];  // Table index + 1, zero when unassigned
+    };
+
+    constexpr SlotIndex buildIndex() {
+        SlotIndex index{};
+        for (size_t i = 0; i < CURRENCY_TABLE_SIZE; ++i) {
+            index.entries[slotOf(CURRENCY_TABLE[i].countryCode)] = static_cast<uint8_t>(i + 1);
+        }
+        return index;
+    }
+
+    inline constexpr SlotIndex INDEX = buildIndex();
+
+    static_assert(CURRENCY_UNIT_COUNT < 255, "code index entries are 8-bit");
+
+    struct CodeIndex {
+        uint8_t entries[CODE_SLOT_COUNT];  // Unit index + 1, zero when unassigned
+    };
+
+    constexpr CodeIndex buildCodeIndex() {
+        CodeIndex index{};
+        for (size_t i = 0; i < CURRENCY_UNIT_COUNT; ++i) {
+            index.entries[slotOf(CURRENCY_UNITS[i].code, 3)] = static_cast<uint8_t>(i + 1);
+        }
+        return index;
+    }
+
+    inline constexpr CodeIndex CODE_INDEX = buildCodeIndex();
+}
+
+// Currency for a two-letter country code, or nullptr when unknown
+constexpr const CurrencyInfo* findCurrencyByCountry(std::string_view countryCode) {
+    int slot = currency_detail::slotOf(countryCode);
+    if (slot < 0) {
+        return nullptr;
+    }
+    uint8_t entry = currency_detail::INDEX.entries[slot];
+    return entry == 0 ? nullptr : &CURRENCY_TABLE[entry - 1];
+}
+
+// Currency for a three-letter ISO 4217 code, or nullptr when unknown
+constexpr const CurrencyUnit* findCurrencyUnit(std::string_view code) {
+    int slot = currency_detail::slotOf(code, 3);
+    if (slot < 0) {
+        return nullptr;
+    }
+    uint8_t entry = currency_detail::CODE_INDEX.entries[slot];
+    return entry == 0 ? nullptr : &CURRENCY_UNITS[entry - 1];
+}
+
+// Position of unit in CURRENCY_UNITS, for tables indexed by currency
+constexpr size_t currencyUnitIndex(const CurrencyUnit* unit) {
+    return static_cast<size_t>(unit - CURRENCY_UNITS);
+}
+
+namespace currency_detail {
+    constexpr bool isUpperAlpha(std::string_view text, size_t length) {
+        if (text.size() != length) {
+            return false;
+        }
+        for (char c : text) {
+            if (c < 'A' || c > 'Z') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Every entry must be well-formed and reachable through its own code
+    constexpr bool validateTable() {
+        static_assert(sizeof(CURRENCY_TABLE) / sizeof(CURRENCY_TABLE[0]) == CURRENCY_TABLE_SIZE,
+                      "table size mismatch");
+        for (size_t i = 0; i < CURRENCY_TABLE_SIZE; ++i) {
+            const CurrencyInfo& entry = CURRENCY_TABLE[i];
+            if (!isUpperAlpha(entry.countryCode, 2) || !isUpperAlpha(entry.code, 3) ||
+                entry.symbol.empty() || entry.minorUnits > 3 ||
+                findCurrencyByCountry(entry.countryCode) != &entry) {
+                return false;
+            }
+            const CurrencyUnit* unit = findCurrencyUnit(entry.code);
+            if (unit == nullptr || unit->minorUnits != entry.minorUnits) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < CURRENCY_UNIT_COUNT; ++i) {
+            if (findCurrencyUnit(CURRENCY_UNITS[i].code) != &CURRENCY_UNITS[i]) {
+                return false;
+            }
+        }
+        return findCurrencyByCountry("") == nullptr && findCurrencyByCountry("A1") == nullptr &&
+               findCurrencyUnit("US") == nullptr;
+    }
+}
+
+static_assert(currency_detail::validateTable(), "currency table is inconsistent");
+"""
+
+
+if __name__ == "__main__":
+    main()
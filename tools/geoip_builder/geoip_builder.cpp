@@ -0,0 +1,230 @@
+// Converts a CSV range dump into the binary GeoIP database read by
+// GeoIpDatabase.
+//
+// Usage: geoip_builder <input.csv> <output.madb>
+//
+// Each CSV line holds:
+//   first_ip,last_ip,country_code,country,region_code,region,city,zip,timezone,latitude,longitude
+// Fields may be double-quoted. Lines starting with '#' are ignored.
+
+#include "../../src/services/geoip_database.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct Range {
+        GeoIpKey first;
+        GeoIpRecord record;
+    };
+
+    class StringPool {
+    public:
+        uint32_t add(const std::string& value) {
+            std::string text = value.substr(0, 0xFFFF);
+            auto it = m_offsets.find(text);
+            if (it != m_offsets.end()) {
+                return it->second;
+            }
+
+            uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+            uint16_t length = static_cast<uint16_t>(text.size());
+            m_bytes.push_back(static_cast<char>(length & 0xFF));
+            m_bytes.push_back(static_cast<char>(length >> 8));
+            m_bytes.insert(m_bytes.end(), text.begin(), text.end());
+            m_offsets.emplace(text, offset);
+            return offset;
+        }
+
+        const std::vector<char>& bytes() const { return m_bytes; }
+
+    private:
+        std::vector<char> m_bytes;
+        std::unordered_map<std::string, uint32_t> m_offsets;
+    };
+
+    std::vector<std::string> splitCsvLine(const std::string& line) {
+        std::vector<std::string> fields;
+        std::string field;
+        bool quoted = false;
+
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    field += '"';
+                    ++i;
+                } else if (c == '"') {
+                    quoted = false;
+                } else {
+                    field += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.push_back(field);
+                field.clear();
+            } else if (c != '\r') {
+                field += c;
+            }
+        }
+        fields.push_back(field);
+        return fields;
+    }
+
+    // Fill eytzinger[1..n] from sorted[0..n) with an in-order walk
+    void buildEytzinger(const std::vector<Range>& sorted, std::vector<GeoIpKey>& keys,
+                        std::vector<uint32_t>& ranks, size_t& next, size_t k) {
+        if (k >= keys.size()) {
+            return;
+        }
+        buildEytzinger(sorted, keys, ranks, next, 2 * k);
+        keys[k] = sorted[next].first;
+        ranks[k] = static_cast<uint32_t>(next);
+        ++next;
+        buildEytzinger(sorted, keys, ranks, next, 2 * k + 1);
+    }
+
+    void padTo(std::ofstream& out, uint64_t& position, uint64_t alignment) {
+        while (position % alignment != 0) {
+            out.put('\0');
+            ++position;
+        }
+    }
+
+    template <typename T>
+    void writeArray(std::ofstream& out, uint64_t& position, const std::vector<T>& items) {
+        out.write(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+        position += items.size() * sizeof(T);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: geoip_builder <input.csv> <output.madb>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input.is_open()) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    StringPool strings;
+    std::vector<Range> ranges;
+    std::string line;
+    size_t lineNumber = 0;
+    size_t skipped = 0;
+
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> fields = splitCsvLine(line);
+        Range range = {};
+        IpAddress first;
+        IpAddress last;
+        if (fields.size() < 11 ||
+            !IpAddress::parse(fields[0], first) ||
+            !IpAddress::parse(fields[1], last) ||
+            geoIpKeyFor(last) < geoIpKeyFor(first)) {
+            std::cerr << "Skipping malformed line " << lineNumber << std::endl;
+            ++skipped;
+            continue;
+        }
+        range.first = geoIpKeyFor(first);
+        range.record.last = geoIpKeyFor(last);
+
+        try {
+            range.record.latitude = std::stof(fields[9]);
+            range.record.longitude = std::stof(fields[10]);
+        }
+        catch (const std::exception&) {
+            range.record.latitude = 0.0f;
+            range.record.longitude = 0.0f;
+        }
+
+        range.record.countryCode = strings.add(fields[2]);
+        range.record.country = strings.add(fields[3]);
+        range.record.regionCode = strings.add(fields[4]);
+        range.record.region = strings.add(fields[5]);
+        range.record.city = strings.add(fields[6]);
+        range.record.zip = strings.add(fields[7]);
+        range.record.timezone = strings.add(fields[8]);
+        ranges.push_back(range);
+    }
+
+    std::sort(ranges.begin(), ranges.end(),
+        [](const Range& a, const Range& b) { return a.first < b.first; });
+
+    // Lookups assume disjoint ranges, keep the first of any overlapping pair
+    std::vector<Range> disjoint;
+    disjoint.reserve(ranges.size());
+    for (const Range& range : ranges) {
+        if (!disjoint.empty() && range.first <= disjoint.back().record.last) {
+            ++skipped;
+            continue;
+        }
+        disjoint.push_back(range);
+    }
+
+    size_t count = disjoint.size();
+    std::vector<GeoIpKey> keys(count + 1, GeoIpKey{0, 0});
+    std::vector<uint32_t> ranks(count + 1, 0);
+    size_t next = 0;
+    buildEytzinger(disjoint, keys, ranks, next, 1);
+
+    std::vector<GeoIpRecord> records;
+    records.reserve(count);
+    for (const Range& range : disjoint) {
+        records.push_back(range.record);
+    }
+
+    std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        std::cerr << "Cannot create " << argv[2] << std::endl;
+        return 1;
+    }
+
+    GeoIpHeader header = {};
+    std::memcpy(header.magic, GEOIP_MAGIC, sizeof(GEOIP_MAGIC));
+    header.version = GEOIP_FORMAT_VERSION;
+    header.rangeCount = static_cast<uint32_t>(count);
+
+    uint64_t position = sizeof(header);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    padTo(output, position, 64);
+    header.keysOffset = position;
+    writeArray(output, position, keys);
+
+    header.ranksOffset = position;
+    writeArray(output, position, ranks);
+
+    padTo(output, position, 8);
+    header.recordsOffset = position;
+    writeArray(output, position, records);
+
+    header.stringsOffset = position;
+    header.stringsSize = strings.bytes().size();
+    writeArray(output, position, strings.bytes());
+
+    // Rewrite the header now that the offsets are known
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!output.good()) {
+        std::cerr << "Failed writing " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << count << " ranges (" << skipped << " skipped) to "
+              << argv[2] << std::endl;
+    return 0;
+}